@@ -119,6 +119,7 @@ blhandler(PG_FUNCTION_ARGS)
 	amroutine->amstorage = false;
 	amroutine->amclusterable = false;
 	amroutine->ampredlocks = false;
+	amroutine->amsummarizing = false;
 	amroutine->amkeytype = InvalidOid;
 
 	amroutine->ambuild = blbuild;
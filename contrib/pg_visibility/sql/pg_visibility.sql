@@ -0,0 +1,36 @@
+CREATE EXTENSION pg_visibility;
+
+--
+-- VACUUM freezing all-visible pages eagerly
+--
+
+-- Without vacuum_eager_freeze, VACUUM marks new pages all-visible only
+CREATE TABLE vacfreeze_off (a int, b text) WITH (autovacuum_enabled = off);
+INSERT INTO vacfreeze_off SELECT i, repeat('x', 500) FROM generate_series(1, 1500) i;
+SET vacuum_eager_freeze = off;
+VACUUM vacfreeze_off;
+SELECT * FROM pg_visibility_map_summary('vacfreeze_off');
+
+-- With it, VACUUM freezes the pages it marks all-visible
+CREATE TABLE vacfreeze_on (a int, b text) WITH (autovacuum_enabled = off);
+INSERT INTO vacfreeze_on SELECT i, repeat('x', 500) FROM generate_series(1, 1500) i;
+SET vacuum_eager_freeze = on;
+VACUUM vacfreeze_on;
+SELECT * FROM pg_visibility_map_summary('vacfreeze_on');
+SELECT * FROM pg_check_frozen('vacfreeze_on');
+
+-- A non-aggressive VACUUM also scans some of the all-visible pages to freeze
+-- them, depending on how close relfrozenxid is to vacuum_freeze_table_age.
+-- The table's relfrozenxid is a few transactions old by now, so with a table
+-- age of 100 a few of its 100 pages are scanned, beginning with the first.
+SET vacuum_freeze_table_age = 100;
+VACUUM vacfreeze_off;
+SELECT all_visible, all_frozen FROM pg_visibility_map('vacfreeze_off', 0);
+SELECT all_visible, all_frozen > 0 AND all_frozen < 100 AS some_frozen
+  FROM pg_visibility_map_summary('vacfreeze_off');
+SELECT * FROM pg_check_frozen('vacfreeze_off');
+RESET vacuum_freeze_table_age;
+RESET vacuum_eager_freeze;
+
+DROP TABLE vacfreeze_off;
+DROP TABLE vacfreeze_on;
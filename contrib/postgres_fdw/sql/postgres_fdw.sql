@@ -1683,3 +1683,32 @@ WHERE ftrelid = 'table30000'::regclass
 AND ftoptions @> array['fetch_size=60000'];
 
 ROLLBACK;
+
+-- ===================================================================
+-- test asynchronous execution under Append
+-- ===================================================================
+CREATE TABLE async_p1 (a int, b text);
+CREATE TABLE async_p2 (a int, b text);
+INSERT INTO async_p1 SELECT i, to_char(i, 'FM0000') FROM generate_series(1, 1000) i;
+INSERT INTO async_p2 SELECT i, to_char(i, 'FM0000') FROM generate_series(1001, 2000) i;
+CREATE FOREIGN TABLE async_f1 (a int, b text)
+  SERVER loopback OPTIONS (table_name 'async_p1', async_capable 'true');
+CREATE FOREIGN TABLE async_f2 (a int, b text)
+  SERVER loopback2 OPTIONS (table_name 'async_p2', async_capable 'true');
+
+-- scans on different connections
+SELECT count(*) FROM (SELECT * FROM async_f1 UNION ALL SELECT * FROM async_f2) s;
+SELECT count(*) FROM (SELECT * FROM async_f1 UNION ALL SELECT * FROM async_f2) s
+  WHERE a % 7 = 0;
+-- scans sharing a connection must take turns
+SELECT count(*) FROM (SELECT * FROM async_f1 UNION ALL SELECT * FROM async_f1) s;
+-- stopping early must absorb any FETCH still in flight
+SELECT count(*) FROM
+  (SELECT * FROM async_f1 UNION ALL SELECT * FROM async_f2 LIMIT 150) s;
+-- results must not change when async execution is disabled
+SET enable_async_append TO off;
+SELECT count(*) FROM (SELECT * FROM async_f1 UNION ALL SELECT * FROM async_f2) s;
+RESET enable_async_append;
+
+DROP FOREIGN TABLE async_f1, async_f2;
+DROP TABLE async_p1, async_p2;
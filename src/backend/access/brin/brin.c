@@ -93,6 +93,7 @@ brinhandler(PG_FUNCTION_ARGS)
 	amroutine->amstorage = true;
 	amroutine->amclusterable = false;
 	amroutine->ampredlocks = false;
+	amroutine->amsummarizing = true;
 	amroutine->amkeytype = InvalidOid;
 
 	amroutine->ambuild = brinbuild;
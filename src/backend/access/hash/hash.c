@@ -67,6 +67,7 @@ hashhandler(PG_FUNCTION_ARGS)
 	amroutine->amstorage = false;
 	amroutine->amclusterable = false;
 	amroutine->ampredlocks = false;
+	amroutine->amsummarizing = false;
 	amroutine->amkeytype = INT4OID;
 
 	amroutine->ambuild = hashbuild;
@@ -101,6 +101,9 @@ static void HeapSatisfiesHOTandKeyUpdate(Relation relation,
 							 bool *satisfies_hot, bool *satisfies_key,
 							 bool *satisfies_id,
 							 HeapTuple oldtup, HeapTuple newtup);
+static bool HeapSummarizedColumnsChanged(Relation relation,
+							 Bitmapset *sum_attrs,
+							 HeapTuple oldtup, HeapTuple newtup);
 static bool heap_acquire_tuplock(Relation relation, ItemPointer tid,
 					 LockTupleMode mode, LockWaitPolicy wait_policy,
 					 bool *have_tuple_lock);
@@ -1609,13 +1612,21 @@ heap_endscan(HeapScanDesc scan)
  *
  *		Sadly, this doesn't reduce to a constant, because the size required
  *		to serialize the snapshot can vary.
+ *
+ *		SnapshotAny is accepted too (for index builds); it needs no space.
  * ----------------
  */
 Size
 heap_parallelscan_estimate(Snapshot snapshot)
 {
-	return add_size(offsetof(ParallelHeapScanDescData, phs_snapshot_data),
-					EstimateSnapshotSpace(snapshot));
+	Size		sz = offsetof(ParallelHeapScanDescData, phs_snapshot_data);
+
+	if (IsMVCCSnapshot(snapshot))
+		sz = add_size(sz, EstimateSnapshotSpace(snapshot));
+	else
+		Assert(snapshot == SnapshotAny);
+
+	return sz;
 }
 
 /* ----------------
@@ -1639,7 +1650,16 @@ heap_parallelscan_initialize(ParallelHeapScanDesc target, Relation relation,
 	SpinLockInit(&target->phs_mutex);
 	target->phs_cblock = InvalidBlockNumber;
 	target->phs_startblock = InvalidBlockNumber;
-	SerializeSnapshot(snapshot, target->phs_snapshot_data);
+	if (IsMVCCSnapshot(snapshot))
+	{
+		SerializeSnapshot(snapshot, target->phs_snapshot_data);
+		target->phs_snapshot_any = false;
+	}
+	else
+	{
+		Assert(snapshot == SnapshotAny);
+		target->phs_snapshot_any = true;
+	}
 }
 
 /* ----------------
@@ -1654,11 +1674,22 @@ heap_beginscan_parallel(Relation relation, ParallelHeapScanDesc parallel_scan)
 	Snapshot	snapshot;
 
 	Assert(RelationGetRelid(relation) == parallel_scan->phs_relid);
-	snapshot = RestoreSnapshot(parallel_scan->phs_snapshot_data);
-	RegisterSnapshot(snapshot);
+
+	if (!parallel_scan->phs_snapshot_any)
+	{
+		/* Snapshot was serialized -- restore it */
+		snapshot = RestoreSnapshot(parallel_scan->phs_snapshot_data);
+		RegisterSnapshot(snapshot);
+	}
+	else
+	{
+		/* SnapshotAny passed by caller (not serialized) */
+		snapshot = SnapshotAny;
+	}
 
 	return heap_beginscan_internal(relation, snapshot, 0, NULL, parallel_scan,
-								   true, true, true, false, false, true);
+								   true, true, true, false, false,
+								   !parallel_scan->phs_snapshot_any);
 }
 
 /* ----------------
@@ -3426,6 +3457,8 @@ simple_heap_delete(Relation relation, ItemPointer tid)
  *	wait - true if should wait for any conflicting update to commit/abort
  *	hufd - output parameter, filled in failure cases (see below)
  *	lockmode - output parameter, filled with lock mode acquired on tuple
+ *	update_summarized - output parameter, set to true if a HOT update was done
+ *		but a column covered by a summarizing index was modified
  *
  * Normal, successful return value is HeapTupleMayBeUpdated, which
  * actually means we *did* update it.  Failure return codes are
@@ -3436,7 +3469,10 @@ simple_heap_delete(Relation relation, ItemPointer tid)
  * stored tuple; in particular, newtup->t_self is set to the TID where the
  * new tuple was inserted, and its HEAP_ONLY_TUPLE flag is set iff a HOT
  * update was done.  However, any TOAST changes in the new tuple's
- * data are not reflected into *newtup.
+ * data are not reflected into *newtup.  A HOT update only needs new index
+ * entries in the relation's summarizing indexes (such as BRIN), and only if
+ * *update_summarized is set; otherwise, if the new tuple is not heap-only,
+ * the caller must insert index entries into all indexes.
  *
  * In the failure cases, the routine fills *hufd with the tuple's t_ctid,
  * t_xmax (resolving a possible MultiXact, if necessary), and t_cmax
@@ -3447,11 +3483,13 @@ simple_heap_delete(Relation relation, ItemPointer tid)
 HTSU_Result
 heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 			CommandId cid, Snapshot crosscheck, bool wait,
-			HeapUpdateFailureData *hufd, LockTupleMode *lockmode)
+			HeapUpdateFailureData *hufd, LockTupleMode *lockmode,
+			bool *update_summarized)
 {
 	HTSU_Result result;
 	TransactionId xid = GetCurrentTransactionId();
 	Bitmapset  *hot_attrs;
+	Bitmapset  *sum_attrs;
 	Bitmapset  *key_attrs;
 	Bitmapset  *id_attrs;
 	ItemId		lp;
@@ -3474,6 +3512,7 @@ heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 	bool		satisfies_hot;
 	bool		satisfies_key;
 	bool		satisfies_id;
+	bool		summarized_changed;
 	bool		use_hot_update = false;
 	bool		key_intact;
 	bool		all_visible_cleared = false;
@@ -3489,6 +3528,8 @@ heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 
 	Assert(ItemPointerIsValid(otid));
 
+	*update_summarized = false;
+
 	/*
 	 * Forbid this during a parallel operation, lest it allocate a combocid.
 	 * Other workers might need that combocid for visibility checks, and we
@@ -3510,8 +3551,16 @@ heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 	 *
 	 * Note that we get a copy here, so we need not worry about relcache flush
 	 * happening midway through.
-	 */
-	hot_attrs = RelationGetIndexAttrBitmap(relation, INDEX_ATTR_BITMAP_ALL);
+	 *
+	 * Columns that are covered only by summarizing indexes don't block a HOT
+	 * update, since such indexes don't reference individual tuples; we only
+	 * need to know whether any of them changed, so that the caller can update
+	 * the summaries.
+	 */
+	hot_attrs = RelationGetIndexAttrBitmap(relation,
+										   INDEX_ATTR_BITMAP_HOT_BLOCKING);
+	sum_attrs = RelationGetIndexAttrBitmap(relation,
+										   INDEX_ATTR_BITMAP_SUMMARIZED);
 	key_attrs = RelationGetIndexAttrBitmap(relation, INDEX_ATTR_BITMAP_KEY);
 	id_attrs = RelationGetIndexAttrBitmap(relation,
 										  INDEX_ATTR_BITMAP_IDENTITY_KEY);
@@ -3575,6 +3624,8 @@ heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 	HeapSatisfiesHOTandKeyUpdate(relation, hot_attrs, key_attrs, id_attrs,
 								 &satisfies_hot, &satisfies_key,
 								 &satisfies_id, &oldtup, newtup);
+	summarized_changed = HeapSummarizedColumnsChanged(relation, sum_attrs,
+													  &oldtup, newtup);
 	if (satisfies_key)
 	{
 		*lockmode = LockTupleNoKeyExclusive;
@@ -3812,6 +3863,7 @@ l2:
 		if (vmbuffer != InvalidBuffer)
 			ReleaseBuffer(vmbuffer);
 		bms_free(hot_attrs);
+		bms_free(sum_attrs);
 		bms_free(key_attrs);
 		bms_free(id_attrs);
 		return result;
@@ -4116,10 +4168,15 @@ l2:
 		/*
 		 * Since the new tuple is going into the same page, we might be able
 		 * to do a HOT update.  Check if any of the index columns have been
-		 * changed.  If not, then HOT update is possible.
+		 * changed.  If not, then HOT update is possible.  Summarizing
+		 * indexes don't count here, but if any of their columns changed, the
+		 * caller has to insert into them.
 		 */
 		if (satisfies_hot)
+		{
 			use_hot_update = true;
+			*update_summarized = summarized_changed;
+		}
 	}
 	else
 	{
@@ -4279,6 +4336,7 @@ l2:
 		heap_freetuple(old_key_tuple);
 
 	bms_free(hot_attrs);
+	bms_free(sum_attrs);
 	bms_free(key_attrs);
 	bms_free(id_attrs);
 
@@ -4287,7 +4345,8 @@ l2:
 
 /*
  * Check if the specified attribute's value is same in both given tuples.
- * Subroutine for HeapSatisfiesHOTandKeyUpdate.
+ * Subroutine for HeapSatisfiesHOTandKeyUpdate and
+ * HeapSummarizedColumnsChanged.
  */
 static bool
 heap_tuple_attr_equals(TupleDesc tupdesc, int attrnum,
@@ -4476,6 +4535,27 @@ HeapSatisfiesHOTandKeyUpdate(Relation relation, Bitmapset *hot_attrs,
 	*satisfies_id = id_result;
 }
 
+/*
+ * Check whether any of the columns in sum_attrs, the columns covered by the
+ * relation's summarizing indexes, was modified by the update.
+ */
+static bool
+HeapSummarizedColumnsChanged(Relation relation, Bitmapset *sum_attrs,
+							 HeapTuple oldtup, HeapTuple newtup)
+{
+	int			attnum = -1;
+
+	while ((attnum = bms_next_member(sum_attrs, attnum)) >= 0)
+	{
+		if (!heap_tuple_attr_equals(RelationGetDescr(relation),
+									attnum + FirstLowInvalidHeapAttributeNumber,
+									oldtup, newtup))
+			return true;
+	}
+
+	return false;
+}
+
 /*
  *	simple_heap_update - replace a tuple
  *
@@ -4485,7 +4565,8 @@ HeapSatisfiesHOTandKeyUpdate(Relation relation, Bitmapset *hot_attrs,
  * via ereport().
  */
 void
-simple_heap_update(Relation relation, ItemPointer otid, HeapTuple tup)
+simple_heap_update(Relation relation, ItemPointer otid, HeapTuple tup,
+				   bool *update_summarized)
 {
 	HTSU_Result result;
 	HeapUpdateFailureData hufd;
@@ -4494,7 +4575,7 @@ simple_heap_update(Relation relation, ItemPointer otid, HeapTuple tup)
 	result = heap_update(relation, otid, tup,
 						 GetCurrentCommandId(true), InvalidSnapshot,
 						 true /* wait for commit */ ,
-						 &hufd, &lockmode);
+						 &hufd, &lockmode, update_summarized);
 	switch (result)
 	{
 		case HeapTupleSelfUpdated:
@@ -125,6 +125,8 @@ RelationGetIndexScan(Relation indexRelation, int nkeys, int norderbys)
 	scan->xs_cbuf = InvalidBuffer;
 	scan->xs_continue_hot = false;
 
+	scan->xs_prefetch = NULL;	/* may be set later */
+
 	return scan;
 }
 
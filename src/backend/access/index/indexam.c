@@ -24,6 +24,8 @@
  *		index_parallelscan_initialize - initialize parallel scan
  *		index_parallelrescan  - (re)start a parallel scan of an index
  *		index_beginscan_parallel - join parallel index scan
+ *		index_setprefetch - enable prefetching of heap pages
+ *		index_prefetch_heap - prefetch the heap page of an upcoming TID
  *		index_getnext_tid	- get the next TID from a scan
  *		index_fetch_heap		- get the scan's next heap tuple
  *		index_getnext	- get the next heap tuple from a scan
@@ -69,9 +71,12 @@
 
 #include "postgres.h"
 
+#include <math.h>
+
 #include "access/amapi.h"
 #include "access/relscan.h"
 #include "access/transam.h"
+#include "access/visibilitymap.h"
 #include "access/xlog.h"
 #include "catalog/catalog.h"
 #include "catalog/index.h"
@@ -80,6 +85,7 @@
 #include "storage/lmgr.h"
 #include "storage/predicate.h"
 #include "utils/snapmgr.h"
+#include "utils/spccache.h"
 #include "utils/tqual.h"
 
 
@@ -351,6 +357,15 @@ index_endscan(IndexScanDesc scan)
 	/* End the AM's scan */
 	scan->indexRelation->rd_amroutine->amendscan(scan);
 
+	/* Release the visibility map pin held for prefetching, if any */
+	if (scan->xs_prefetch != NULL)
+	{
+		if (BufferIsValid(scan->xs_prefetch->vmbuffer))
+			ReleaseBuffer(scan->xs_prefetch->vmbuffer);
+		pfree(scan->xs_prefetch);
+		scan->xs_prefetch = NULL;
+	}
+
 	/* Release index refcount acquired by index_beginscan */
 	RelationDecrementReferenceCount(scan->indexRelation);
 
@@ -514,6 +529,85 @@ index_beginscan_parallel(Relation heaprel, Relation indexrel, int nkeys,
 	return scan;
 }
 
+/* ----------------
+ * index_setprefetch - enable prefetching of heap pages
+ *
+ * Plain and index-only scans fetch heap tuples one at a time, so without
+ * help each heap page not already cached costs a synchronous read.  After
+ * this call, an index AM that knows which TIDs it will return next may
+ * pass them to index_prefetch_heap(), as far as effective_io_concurrency
+ * for the heap's tablespace allows, so that the reads are issued early.
+ * Index AMs that can't see ahead simply don't.
+ *
+ * For an index-only scan, call this after setting xs_want_itup, so that we
+ * know to skip the pages that the visibility map says need no visit.
+ * ----------------
+ */
+void
+index_setprefetch(IndexScanDesc scan)
+{
+	int			distance = target_prefetch_pages;
+	int			io_concurrency;
+	IndexPrefetchData *prefetch;
+
+	Assert(scan->heapRelation != NULL);
+
+	/* Use the tablespace's setting, if it has its own */
+	io_concurrency =
+		get_tablespace_io_concurrency(scan->heapRelation->rd_rel->reltablespace);
+	if (io_concurrency != effective_io_concurrency)
+	{
+		double		maximum;
+
+		if (ComputeIoConcurrency(io_concurrency, &maximum))
+			distance = rint(maximum);
+	}
+
+	if (distance <= 0)
+		return;
+
+	prefetch = (IndexPrefetchData *) palloc(sizeof(IndexPrefetchData));
+	prefetch->distance = distance;
+	prefetch->skip_visible = scan->xs_want_itup;
+	prefetch->vmbuffer = InvalidBuffer;
+	prefetch->next = 0;
+	memset(prefetch->recent, 0xFF, sizeof(prefetch->recent));	/* invalid */
+
+	scan->xs_prefetch = prefetch;
+}
+
+/* ----------------
+ * index_prefetch_heap - prefetch the heap page of an upcoming TID
+ *
+ * Called by index AMs, for TIDs that the scan will return soon, if
+ * scan->xs_prefetch is set.  Pages that were prefetched recently are
+ * skipped, and so are all-visible pages in an index-only scan.
+ * ----------------
+ */
+void
+index_prefetch_heap(IndexScanDesc scan, ItemPointer tid)
+{
+	IndexPrefetchData *prefetch = scan->xs_prefetch;
+	BlockNumber blkno = ItemPointerGetBlockNumber(tid);
+	int			i;
+
+	Assert(prefetch != NULL);
+
+	for (i = 0; i < INDEX_PREFETCH_HISTORY; i++)
+	{
+		if (prefetch->recent[i] == blkno)
+			return;
+	}
+	prefetch->recent[prefetch->next] = blkno;
+	prefetch->next = (prefetch->next + 1) % INDEX_PREFETCH_HISTORY;
+
+	if (prefetch->skip_visible &&
+		VM_ALL_VISIBLE(scan->heapRelation, blkno, &prefetch->vmbuffer))
+		return;
+
+	PrefetchBuffer(scan->heapRelation, MAIN_FORKNUM, blkno);
+}
+
 /* ----------------
  * index_getnext_tid - get the next TID from a scan
  *
@@ -23,6 +23,7 @@
 #include "access/xlog.h"
 #include "catalog/index.h"
 #include "commands/vacuum.h"
+#include "optimizer/planner.h"
 #include "storage/indexfsm.h"
 #include "storage/ipc.h"
 #include "storage/lmgr.h"
@@ -99,6 +100,7 @@ bthandler(PG_FUNCTION_ARGS)
 	amroutine->amstorage = false;
 	amroutine->amclusterable = true;
 	amroutine->ampredlocks = true;
+	amroutine->amsummarizing = false;
 	amroutine->amkeytype = InvalidOid;
 
 	amroutine->ambuild = btbuild;
@@ -133,6 +135,7 @@ btbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 {
 	IndexBuildResult *result;
 	double		reltuples;
+	int			nworkers = 0;
 	BTBuildState buildstate;
 
 	buildstate.isUnique = indexInfo->ii_Unique;
@@ -155,36 +158,51 @@ btbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 		elog(ERROR, "index \"%s\" already contains data",
 			 RelationGetRelationName(index));
 
-	buildstate.spool = _bt_spoolinit(heap, index, indexInfo->ii_Unique, false);
-
 	/*
-	 * If building a unique index, put dead tuples in a second spool to keep
-	 * them out of the uniqueness check.
+	 * A non-unique index may be built with the help of parallel workers, if
+	 * the planner thinks that's worthwhile.  See nbtsort.c.
 	 */
-	if (indexInfo->ii_Unique)
-		buildstate.spool2 = _bt_spoolinit(heap, index, false, true);
-
-	/* do the heap scan */
-	reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
-								   btbuildCallback, (void *) &buildstate);
+	if (!indexInfo->ii_Unique)
+		nworkers = plan_create_index_workers(RelationGetRelid(heap),
+											 RelationGetRelid(index));
 
-	/* okay, all heap tuples are indexed */
-	if (buildstate.spool2 && !buildstate.haveDead)
+	if (nworkers > 0)
+		reltuples = _bt_parallel_build(heap, index, indexInfo, nworkers,
+									   &buildstate.indtuples);
+	else
 	{
-		/* spool2 turns out to be unnecessary */
-		_bt_spooldestroy(buildstate.spool2);
-		buildstate.spool2 = NULL;
-	}
+		buildstate.spool = _bt_spoolinit(heap, index, indexInfo->ii_Unique,
+										 false);
 
-	/*
-	 * Finish the build by (1) completing the sort of the spool file, (2)
-	 * inserting the sorted tuples into btree pages and (3) building the upper
-	 * levels.
-	 */
-	_bt_leafbuild(buildstate.spool, buildstate.spool2);
-	_bt_spooldestroy(buildstate.spool);
-	if (buildstate.spool2)
-		_bt_spooldestroy(buildstate.spool2);
+		/*
+		 * If building a unique index, put dead tuples in a second spool to
+		 * keep them out of the uniqueness check.
+		 */
+		if (indexInfo->ii_Unique)
+			buildstate.spool2 = _bt_spoolinit(heap, index, false, true);
+
+		/* do the heap scan */
+		reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
+									   btbuildCallback, (void *) &buildstate);
+
+		/* okay, all heap tuples are indexed */
+		if (buildstate.spool2 && !buildstate.haveDead)
+		{
+			/* spool2 turns out to be unnecessary */
+			_bt_spooldestroy(buildstate.spool2);
+			buildstate.spool2 = NULL;
+		}
+
+		/*
+		 * Finish the build by (1) completing the sort of the spool file, (2)
+		 * inserting the sorted tuples into btree pages and (3) building the
+		 * upper levels.
+		 */
+		_bt_leafbuild(buildstate.spool, buildstate.spool2);
+		_bt_spooldestroy(buildstate.spool);
+		if (buildstate.spool2)
+			_bt_spooldestroy(buildstate.spool2);
+	}
 
 #ifdef BTREE_BUILD_STATS
 	if (log_btree_build_stats)
@@ -30,6 +30,7 @@ static bool _bt_readpage(IndexScanDesc scan, ScanDirection dir,
 static void _bt_saveitem(BTScanOpaque so, int itemIndex,
 			 OffsetNumber offnum, IndexTuple itup);
 static bool _bt_steppage(IndexScanDesc scan, ScanDirection dir);
+static void _bt_prefetch_heap(IndexScanDesc scan, ScanDirection dir);
 static Buffer _bt_walk_left(Relation rel, Buffer buf, Snapshot snapshot);
 static bool _bt_endpoint(IndexScanDesc scan, ScanDirection dir);
 static void _bt_drop_lock_and_maybe_pin(IndexScanDesc scan, BTScanPos sp);
@@ -1066,6 +1067,8 @@ _bt_first(IndexScanDesc scan, ScanDirection dir)
 	if (scan->xs_want_itup)
 		scan->xs_itup = (IndexTuple) (so->currTuples + currItem->tupleOffset);
 
+	_bt_prefetch_heap(scan, dir);
+
 	return true;
 }
 
@@ -1116,6 +1119,8 @@ _bt_next(IndexScanDesc scan, ScanDirection dir)
 	if (scan->xs_want_itup)
 		scan->xs_itup = (IndexTuple) (so->currTuples + currItem->tupleOffset);
 
+	_bt_prefetch_heap(scan, dir);
+
 	return true;
 }
 
@@ -1216,6 +1221,7 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 		so->currPos.firstItem = 0;
 		so->currPos.lastItem = itemIndex - 1;
 		so->currPos.itemIndex = 0;
+		so->currPos.prefetchItem = 0;
 	}
 	else
 	{
@@ -1247,11 +1253,52 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 		so->currPos.firstItem = itemIndex;
 		so->currPos.lastItem = MaxIndexTuplesPerPage - 1;
 		so->currPos.itemIndex = MaxIndexTuplesPerPage - 1;
+		so->currPos.prefetchItem = MaxIndexTuplesPerPage - 1;
 	}
 
 	return (so->currPos.firstItem <= so->currPos.lastItem);
 }
 
+/*
+ *	_bt_prefetch_heap() -- Prefetch the heap pages of upcoming items
+ *
+ * Called whenever we're about to return so->currPos.itemIndex.  If the scan
+ * does heap prefetching, pass the heap TIDs of the items following it on
+ * the current page, up to the prefetch distance, to index_prefetch_heap().
+ * prefetchItem remembers how far we've got, so that each item is considered
+ * just once; we can't see beyond the current page, so the distance is
+ * regained only gradually after stepping to the next one.
+ */
+static void
+_bt_prefetch_heap(IndexScanDesc scan, ScanDirection dir)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTScanPos	pos = &so->currPos;
+	int			distance;
+
+	if (scan->xs_prefetch == NULL)
+		return;
+	distance = scan->xs_prefetch->distance;
+
+	/* the current item is about to be fetched anyway, so skip it */
+	if (ScanDirectionIsForward(dir))
+	{
+		int			last = Min(pos->itemIndex + distance, pos->lastItem);
+
+		pos->prefetchItem = Max(pos->prefetchItem, pos->itemIndex + 1);
+		while (pos->prefetchItem <= last)
+			index_prefetch_heap(scan, &pos->items[pos->prefetchItem++].heapTid);
+	}
+	else
+	{
+		int			first = Max(pos->itemIndex - distance, pos->firstItem);
+
+		pos->prefetchItem = Min(pos->prefetchItem, pos->itemIndex - 1);
+		while (pos->prefetchItem >= first)
+			index_prefetch_heap(scan, &pos->items[pos->prefetchItem--].heapTid);
+	}
+}
+
 /* Save an index item into so->currPos.items[itemIndex] */
 static void
 _bt_saveitem(BTScanOpaque so, int itemIndex,
@@ -1751,5 +1798,7 @@ _bt_endpoint(IndexScanDesc scan, ScanDirection dir)
 	if (scan->xs_want_itup)
 		scan->xs_itup = (IndexTuple) (so->currTuples + currItem->tupleOffset);
 
+	_bt_prefetch_heap(scan, dir);
+
 	return true;
 }
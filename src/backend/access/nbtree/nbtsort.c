@@ -55,6 +55,16 @@
  * This code isn't concerned about the FSM at all. The caller is responsible
  * for initializing that.
  *
+ * A non-unique index may also be built in parallel (see _bt_parallel_build).
+ * The leader and each worker process scan part of the heap, through a
+ * parallel heap scan, and sort the index tuples they find in a local
+ * tuplesort.  Each participant exports its output as a sorted run in a
+ * shared file set (see tuplesort_export_run); the leader then imports all
+ * the runs into one final tuplesort, and loads the leaf pages from its merged
+ * output exactly as above.  Unique indexes are always built
+ * serially, because the uniqueness check is done by the sort itself and
+ * would miss duplicates found by different processes.
+ *
  * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -67,16 +77,27 @@
 #include "postgres.h"
 
 #include "access/nbtree.h"
+#include "access/parallel.h"
+#include "access/relscan.h"
+#include "access/xact.h"
 #include "access/xlog.h"
 #include "access/xloginsert.h"
+#include "catalog/index.h"
 #include "miscadmin.h"
 #include "storage/smgr.h"
+#include "storage/spin.h"
 #include "tcop/tcopprot.h"
 #include "utils/rel.h"
+#include "utils/snapmgr.h"
 #include "utils/sortsupport.h"
 #include "utils/tuplesort.h"
 
 
+/* Magic numbers for parallel state sharing */
+#define PARALLEL_KEY_BTREE_SHARED		UINT64CONST(0xA000000000000001)
+#define PARALLEL_KEY_TUPLESORT			UINT64CONST(0xA000000000000002)
+
+
 /*
  * Status record for spooling/sorting phase.  (Note we may have two of
  * these due to the special requirements for uniqueness-checking with
@@ -90,6 +111,35 @@ struct BTSpool
 	bool		isunique;
 };
 
+/*
+ * Status record for a parallel index build, in the DSM segment.  The
+ * ParallelHeapScanDesc for the heap scan follows it.
+ */
+typedef struct BTShared
+{
+	/* Immutable state */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	bool		isconcurrent;
+	int			sortmem;		/* work memory per worker, in kilobytes */
+
+	/* Results reported by the workers, protected by mutex */
+	slock_t		mutex;
+	double		reltuples;		/* # heap tuples scanned */
+	double		indtuples;		/* # index tuples sorted */
+	bool		brokenhotchain; /* did any worker see a broken HOT chain? */
+} BTShared;
+
+#define ParallelHeapScanFromBTShared(shared) \
+	((ParallelHeapScanDesc) ((char *) (shared) + BUFFERALIGN(sizeof(BTShared))))
+
+/* Working state for the heap scan callback of a parallel build */
+typedef struct BTParallelScanState
+{
+	BTSpool    *spool;
+	double		indtuples;
+} BTParallelScanState;
+
 /*
  * Status record for a btree page being built.  We have one of these
  * for each active tree level.
@@ -138,6 +188,13 @@ static void _bt_buildadd(BTWriteState *wstate, BTPageState *state,
 static void _bt_uppershutdown(BTWriteState *wstate, BTPageState *state);
 static void _bt_load(BTWriteState *wstate,
 		 BTSpool *btspool, BTSpool *btspool2);
+static void _bt_loadsorted(BTSpool *btspool, BTSpool *btspool2);
+static BTSpool *_bt_parallel_spoolinit(Relation heap, Relation index,
+					   int sortmem);
+static void _bt_parallel_scan_callback(Relation index, HeapTuple htup,
+						   Datum *values, bool *isnull,
+						   bool tupleIsAlive, void *state);
+static void _bt_parallel_build_main(dsm_segment *seg, shm_toc *toc);
 
 
 /*
@@ -200,8 +257,6 @@ _bt_spool(BTSpool *btspool, ItemPointer self, Datum *values, bool *isnull)
 void
 _bt_leafbuild(BTSpool *btspool, BTSpool *btspool2)
 {
-	BTWriteState wstate;
-
 #ifdef BTREE_BUILD_STATS
 	if (log_btree_build_stats)
 	{
@@ -214,6 +269,23 @@ _bt_leafbuild(BTSpool *btspool, BTSpool *btspool2)
 	if (btspool2)
 		tuplesort_performsort(btspool2->sortstate);
 
+	_bt_loadsorted(btspool, btspool2);
+}
+
+
+/*
+ * Internal routines.
+ */
+
+
+/*
+ * create an entire btree from spools whose sorts have been completed.
+ */
+static void
+_bt_loadsorted(BTSpool *btspool, BTSpool *btspool2)
+{
+	BTWriteState wstate;
+
 	wstate.heap = btspool->heap;
 	wstate.index = btspool->index;
 
@@ -231,12 +303,6 @@ _bt_leafbuild(BTSpool *btspool, BTSpool *btspool2)
 	_bt_load(&wstate, btspool, btspool2);
 }
 
-
-/*
- * Internal routines.
- */
-
-
 /*
  * allocate workspace for a new, clean btree page, not linked to any siblings.
  */
@@ -819,3 +885,237 @@ _bt_load(BTWriteState *wstate, BTSpool *btspool, BTSpool *btspool2)
 		smgrimmedsync(wstate->index->rd_smgr, MAIN_FORKNUM);
 	}
 }
+
+/*
+ * Create a spool for one participant of a parallel build, with the given
+ * amount of sort memory.
+ */
+static BTSpool *
+_bt_parallel_spoolinit(Relation heap, Relation index, int sortmem)
+{
+	BTSpool    *btspool = (BTSpool *) palloc0(sizeof(BTSpool));
+
+	btspool->heap = heap;
+	btspool->index = index;
+	btspool->isunique = false;
+	btspool->sortstate = tuplesort_begin_index_btree(heap, index, false,
+													 sortmem, false);
+
+	return btspool;
+}
+
+/*
+ * Per-tuple callback from IndexBuildHeapParallelScan
+ */
+static void
+_bt_parallel_scan_callback(Relation index,
+						   HeapTuple htup,
+						   Datum *values,
+						   bool *isnull,
+						   bool tupleIsAlive,
+						   void *state)
+{
+	BTParallelScanState *scanstate = (BTParallelScanState *) state;
+
+	_bt_spool(scanstate->spool, &htup->t_self, values, isnull);
+	scanstate->indtuples += 1;
+}
+
+/*
+ * Build a non-unique btree index using parallel workers.
+ *
+ * The leader and up to nworkers workers scan the heap together, each sorting
+ * the index tuples it finds and exporting the result as a sorted run in a
+ * shared file set.  The leader then imports all the runs into a final sort,
+ * merges them and builds the index.  maintenance_work_mem is divided between
+ * the participants while scanning.  If no workers can be launched, the leader
+ * does all the work.
+ *
+ * Returns the number of heap tuples scanned, and sets *indtuples to the
+ * number of index tuples created.
+ */
+double
+_bt_parallel_build(Relation heap, Relation index, IndexInfo *indexInfo,
+				   int nworkers, double *indtuples)
+{
+	ParallelContext *pcxt;
+	Snapshot	snapshot;
+	Size		estsharedsize;
+	Size		estsortsize;
+	BTShared   *btshared;
+	Sharedsort *sharedsort;
+	ParallelHeapScanDesc pscan;
+	BTSpool    *spool;
+	BTParallelScanState scanstate;
+	HeapScanDesc scan;
+	int			sortmem;
+	int			leadermem;
+	int			nruns;
+	double		reltuples;
+
+	Assert(!indexInfo->ii_Unique);
+	Assert(nworkers > 0);
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext(_bt_parallel_build_main, nworkers);
+
+	/*
+	 * A concurrent build indexes whatever is live according to an MVCC
+	 * snapshot, which all participants must share; otherwise everybody scans
+	 * with SnapshotAny, as IndexBuildHeapScan would.
+	 */
+	if (indexInfo->ii_Concurrent)
+		snapshot = RegisterSnapshot(GetTransactionSnapshot());
+	else
+		snapshot = SnapshotAny;
+
+	/*
+	 * Estimate space for the shared state, and for a shared sort with room
+	 * for a run from each worker plus one of our own.
+	 */
+	estsharedsize = add_size(BUFFERALIGN(sizeof(BTShared)),
+							 heap_parallelscan_estimate(snapshot));
+	shm_toc_estimate_chunk(&pcxt->estimator, estsharedsize);
+	estsortsize = tuplesort_estimate_shared(nworkers + 1);
+	shm_toc_estimate_chunk(&pcxt->estimator, estsortsize);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	InitializeParallelDSM(pcxt);
+
+	/* Set up the shared state */
+	sortmem = Max(maintenance_work_mem / (nworkers + 1), 64);
+
+	btshared = (BTShared *) shm_toc_allocate(pcxt->toc, estsharedsize);
+	btshared->heaprelid = RelationGetRelid(heap);
+	btshared->indexrelid = RelationGetRelid(index);
+	btshared->isconcurrent = indexInfo->ii_Concurrent;
+	btshared->sortmem = sortmem;
+	SpinLockInit(&btshared->mutex);
+	btshared->reltuples = 0;
+	btshared->indtuples = 0;
+	btshared->brokenhotchain = false;
+	pscan = ParallelHeapScanFromBTShared(btshared);
+	heap_parallelscan_initialize(pscan, heap, snapshot);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_BTREE_SHARED, btshared);
+
+	sharedsort = (Sharedsort *) shm_toc_allocate(pcxt->toc, estsortsize);
+	tuplesort_initialize_shared(sharedsort, nworkers + 1, pcxt->seg);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLESORT, sharedsort);
+
+	/*
+	 * We may get fewer workers than we asked for, or none at all, if we're
+	 * running with the parallel infrastructure unavailable.  The workers
+	 * that did start export runs numbered from 0; ours comes after theirs.
+	 */
+	LaunchParallelWorkers(pcxt);
+	nruns = pcxt->nworkers_launched + 1;
+
+	/*
+	 * Join the scan ourselves, using whatever sort memory the launched
+	 * workers have left us.
+	 */
+	leadermem = Max(maintenance_work_mem -
+					pcxt->nworkers_launched * sortmem, 64);
+	spool = _bt_parallel_spoolinit(heap, index, leadermem);
+	tuplesort_set_export(spool->sortstate, sharedsort, nruns - 1);
+	scanstate.spool = spool;
+	scanstate.indtuples = 0;
+
+	scan = heap_beginscan_parallel(heap, pscan);
+	reltuples = IndexBuildHeapParallelScan(heap, index, indexInfo, scan,
+										   _bt_parallel_scan_callback,
+										   (void *) &scanstate);
+
+	tuplesort_export_run(spool->sortstate);
+	_bt_spooldestroy(spool);
+
+	/* Wait for the workers to export their runs, and collect their results */
+	WaitForParallelWorkersToFinish(pcxt);
+
+	reltuples += btshared->reltuples;
+	*indtuples = scanstate.indtuples + btshared->indtuples;
+	if (btshared->brokenhotchain)
+		indexInfo->ii_BrokenHotChain = true;
+
+	/* Merge everybody's runs, with all of our memory, and build the index */
+	spool = _bt_parallel_spoolinit(heap, index, maintenance_work_mem);
+	tuplesort_import_runs(spool->sortstate, sharedsort, nruns);
+	_bt_loadsorted(spool, NULL);
+	_bt_spooldestroy(spool);
+
+	/* Destroying the context deletes the runs' files, too */
+	if (IsMVCCSnapshot(snapshot))
+		UnregisterSnapshot(snapshot);
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+
+	return reltuples;
+}
+
+/*
+ * Main entry point for a parallel btree build worker.
+ *
+ * Scans its share of the heap, sorts the resulting index tuples, and exports
+ * them as a sorted run for the leader to merge.
+ */
+static void
+_bt_parallel_build_main(dsm_segment *seg, shm_toc *toc)
+{
+	BTShared   *btshared;
+	Sharedsort *sharedsort;
+	Relation	heapRel;
+	Relation	indexRel;
+	LOCKMODE	heapLockmode;
+	LOCKMODE	indexLockmode;
+	IndexInfo  *indexInfo;
+	BTSpool    *spool;
+	BTParallelScanState scanstate;
+	HeapScanDesc scan;
+	double		reltuples;
+
+	btshared = shm_toc_lookup(toc, PARALLEL_KEY_BTREE_SHARED);
+	sharedsort = shm_toc_lookup(toc, PARALLEL_KEY_TUPLESORT);
+	tuplesort_attach_shared(sharedsort, seg);
+
+	/* Take the same locks the leader holds, as in index_build callers */
+	if (!btshared->isconcurrent)
+	{
+		heapLockmode = ShareLock;
+		indexLockmode = AccessExclusiveLock;
+	}
+	else
+	{
+		heapLockmode = ShareUpdateExclusiveLock;
+		indexLockmode = RowExclusiveLock;
+	}
+
+	heapRel = heap_open(btshared->heaprelid, heapLockmode);
+	indexRel = index_open(btshared->indexrelid, indexLockmode);
+
+	indexInfo = BuildIndexInfo(indexRel);
+	indexInfo->ii_Concurrent = btshared->isconcurrent;
+
+	spool = _bt_parallel_spoolinit(heapRel, indexRel, btshared->sortmem);
+	tuplesort_set_export(spool->sortstate, sharedsort, ParallelWorkerNumber);
+	scanstate.spool = spool;
+	scanstate.indtuples = 0;
+
+	scan = heap_beginscan_parallel(heapRel, ParallelHeapScanFromBTShared(btshared));
+	reltuples = IndexBuildHeapParallelScan(heapRel, indexRel, indexInfo, scan,
+										   _bt_parallel_scan_callback,
+										   (void *) &scanstate);
+
+	tuplesort_export_run(spool->sortstate);
+	_bt_spooldestroy(spool);
+
+	/* Report our results */
+	SpinLockAcquire(&btshared->mutex);
+	btshared->reltuples += reltuples;
+	btshared->indtuples += scanstate.indtuples;
+	if (indexInfo->ii_BrokenHotChain)
+		btshared->brokenhotchain = true;
+	SpinLockRelease(&btshared->mutex);
+
+	index_close(indexRel, indexLockmode);
+	heap_close(heapRel, heapLockmode);
+}
@@ -0,0 +1,724 @@
+/*-------------------------------------------------------------------------
+ *
+ * parallelredo.c
+ *	  Replay of WAL records by background worker processes
+ *
+ * When max_parallel_redo_workers is set, the startup process launches that
+ * many background workers at the start of redo, and hands off to them the
+ * records that can safely be replayed out of order with respect to records
+ * for other pages.  Each such record touches a single page, and all records
+ * for a given page go to the same worker, through a shm_mq, so that they
+ * are replayed in WAL order.  All other records act as barriers: before
+ * replaying one, the startup process waits for the workers to finish every
+ * record handed to them so far.  Transaction commits and aborts are among
+ * the barriers, so a hot standby query never sees the effects of a committed
+ * transaction only partially applied.
+ *
+ * Only a small set of record types is handed off, chosen so that replaying
+ * them needs nothing but the page itself (and possibly the free space map):
+ * heap inserts, deletes, same-page updates and tuple locks that don't clear
+ * visibility map bits, and btree leaf inserts.  A record that clears a
+ * visibility map bit must be replayed before any index insertion that
+ * follows it, or an index-only scan on a hot standby could return a tuple
+ * whose heap page change isn't visible yet; so those are barriers too.
+ *
+ * The startup process advances lastReplayedEndRecPtr past a record as soon
+ * as it has handed the record off, before the worker has replayed it; it
+ * would have to wait for the workers after every record otherwise.  That's
+ * safe because every record we hand off belongs to a transaction that is
+ * still in progress as far as the standby is concerned: it was written
+ * before that transaction's commit or abort record, which is a barrier.  So
+ * until the worker gets to it, its change is one that no hot standby
+ * snapshot could see anyway.  In particular, once lastReplayedEndRecPtr
+ * reaches the end of a commit record, everything the transaction did has
+ * really been applied, which is what synchronous_commit = remote_apply
+ * relies on.  The places that need every record up to lastReplayedEndRecPtr
+ * to be applied call ParallelRedoSync() first: reaching a consistent state
+ * or the end of a base backup, pausing recovery, and the end of redo.
+ *
+ * Restartpoints don't depend on lastReplayedEndRecPtr for correctness.  The
+ * checkpoint record that a restartpoint is based on is a barrier, so every
+ * change before it is in shared buffers by the time RecoveryRestartPoint()
+ * records it, and the checkpointer flushes those buffers as usual.  Changes
+ * that workers apply afterwards are after the restartpoint's redo pointer,
+ * and will be replayed again after a crash.  When the checkpointer or a
+ * backend writes out a page a worker has modified, XLogFlush() advances
+ * minRecoveryPoint to replayEndRecPtr, which the startup process set before
+ * handing the record off, so minRecoveryPoint never falls behind a change
+ * that has reached disk.  The workers get records through shared memory,
+ * not from WAL files, so WAL segments recycled after a restartpoint don't
+ * matter to them either.
+ *
+ * The invalid-page table of xlogutils.c lives in the startup process, since
+ * the records that resolve invalid pages (truncations, drops) are all
+ * barriers.  Workers remember the invalid pages they find, and send them
+ * to the startup process when it waits for them.
+ *
+ * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/transam/parallelredo.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/heapam_xlog.h"
+#include "access/nbtree.h"
+#include "access/parallelredo.h"
+#include "access/xact.h"
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xlogutils.h"
+#include "miscadmin.h"
+#include "nodes/pg_list.h"
+#include "postmaster/bgworker.h"
+#include "storage/dsm.h"
+#include "storage/ipc.h"
+#include "storage/proc.h"
+#include "storage/shm_mq.h"
+#include "storage/shm_toc.h"
+#include "storage/smgr.h"
+#include "tcop/tcopprot.h"
+#include "utils/memutils.h"
+#include "utils/resowner.h"
+
+
+/*
+ * Size of the queue carrying records to each worker.  It should be large
+ * enough that the startup process can usually run well ahead of the worker
+ * without blocking.
+ */
+#define PARALLEL_REDO_QUEUE_SIZE		(256 * 1024)
+
+/* Size of the queue carrying replies back from each worker. */
+#define PARALLEL_REDO_REPLY_QUEUE_SIZE	8192
+
+/* Magic number and key for the parallel redo TOC. */
+#define PARALLEL_REDO_MAGIC				0x50524544
+#define PARALLEL_REDO_KEY_QUEUES		UINT64CONST(0xFFFFFFFFFFFF0001)
+
+/* Message types */
+#define PARALLEL_REDO_MSG_RECORD		1	/* a record to replay */
+#define PARALLEL_REDO_MSG_SYNC			2	/* reply when done with records */
+#define PARALLEL_REDO_MSG_INVALID_PAGE	3	/* reference to an invalid page */
+#define PARALLEL_REDO_MSG_SYNC_DONE		4	/* done with all records */
+
+/*
+ * Message from the startup process to a worker.  For PARALLEL_REDO_MSG_RECORD,
+ * the record itself follows.
+ */
+typedef struct ParallelRedoMessage
+{
+	uint8		type;			/* PARALLEL_REDO_MSG_RECORD or _SYNC */
+	bool		reachedConsistency; /* startup process's reachedConsistency */
+	bool		closeFiles;		/* close all files before proceeding */
+	XLogRecPtr	ReadRecPtr;		/* start of the record */
+	XLogRecPtr	EndRecPtr;		/* end+1 of the record */
+} ParallelRedoMessage;
+
+/*
+ * Message from a worker to the startup process.
+ */
+typedef struct ParallelRedoReply
+{
+	uint8		type;			/* PARALLEL_REDO_MSG_INVALID_PAGE or
+								 * _SYNC_DONE */
+	bool		present;		/* see log_invalid_page() */
+	RelFileNode node;
+	ForkNumber	forkno;
+	BlockNumber blkno;
+} ParallelRedoReply;
+
+/* Startup process's state for each worker */
+typedef struct ParallelRedoWorkerInfo
+{
+	BackgroundWorkerHandle *bgwhandle;
+	shm_mq_handle *mqh;			/* queue for records to replay */
+	shm_mq_handle *reply_mqh;	/* queue for replies */
+	bool		busy;			/* sent anything since the last sync? */
+	bool		closeFiles;		/* must close files before next record */
+} ParallelRedoWorkerInfo;
+
+/* GUC variable */
+int			max_parallel_redo_workers = 0;
+
+/* Is this process a parallel redo worker? */
+bool		IsParallelRedoWorker = false;
+
+/* Startup process state */
+static dsm_segment *redo_seg = NULL;
+static ParallelRedoWorkerInfo *redo_workers = NULL;
+static int	nredo_workers = 0;
+
+/* Worker state: invalid page references not yet sent to the startup process */
+static List *pending_invalid_pages = NIL;
+
+static bool ParallelRedoRecordIsSafe(XLogReaderState *record);
+static bool ParallelRedoRecordDropsFiles(XLogReaderState *record);
+static void ParallelRedoSend(ParallelRedoWorkerInfo *w, uint8 type,
+				 XLogReaderState *record);
+static void parallel_redo_error_callback(void *arg);
+
+
+/*
+ * Launch the parallel redo workers, if configured.  Called by the startup
+ * process just before it starts replaying records.
+ *
+ * If fewer workers than requested can be registered, we go on with the ones
+ * we got, and with none at all, every record is replayed by the startup
+ * process as usual.
+ */
+void
+ParallelRedoStart(void)
+{
+	shm_toc_estimator e;
+	shm_toc    *toc;
+	Size		segsize;
+	Size		queuesize;
+	char	   *queuespace;
+	ResourceOwner owner;
+	BackgroundWorker worker;
+	int			i;
+
+	Assert(nredo_workers == 0);
+
+	if (max_parallel_redo_workers == 0 || !IsUnderPostmaster)
+		return;
+
+	queuesize = PARALLEL_REDO_QUEUE_SIZE + PARALLEL_REDO_REPLY_QUEUE_SIZE;
+	shm_toc_initialize_estimator(&e);
+	shm_toc_estimate_chunk(&e, mul_size(max_parallel_redo_workers, queuesize));
+	shm_toc_estimate_keys(&e, 1);
+	segsize = shm_toc_estimate(&e);
+
+	/*
+	 * The startup process has no resource owner, but dsm_create() insists on
+	 * one.  Create the segment under a temporary one, and then keep the
+	 * mapping for the life of the process.
+	 */
+	owner = CurrentResourceOwner;
+	CurrentResourceOwner = ResourceOwnerCreate(NULL, "parallel redo");
+	redo_seg = dsm_create(segsize, 0);
+	dsm_pin_mapping(redo_seg);
+	ResourceOwnerDelete(CurrentResourceOwner);
+	CurrentResourceOwner = owner;
+
+	toc = shm_toc_create(PARALLEL_REDO_MAGIC, dsm_segment_address(redo_seg),
+						 segsize);
+	queuespace = shm_toc_allocate(toc,
+								  mul_size(max_parallel_redo_workers,
+										   queuesize));
+	shm_toc_insert(toc, PARALLEL_REDO_KEY_QUEUES, queuespace);
+
+	redo_workers = (ParallelRedoWorkerInfo *)
+		MemoryContextAllocZero(TopMemoryContext,
+							   sizeof(ParallelRedoWorkerInfo) *
+							   max_parallel_redo_workers);
+
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	worker.bgw_main = ParallelRedoWorkerMain;
+	worker.bgw_main_arg = UInt32GetDatum(dsm_segment_handle(redo_seg));
+	worker.bgw_notify_pid = MyProcPid;
+
+	for (i = 0; i < max_parallel_redo_workers; i++)
+	{
+		ParallelRedoWorkerInfo *w = &redo_workers[i];
+		char	   *space = queuespace + i * queuesize;
+		shm_mq	   *mq;
+		shm_mq	   *reply_mq;
+
+		mq = shm_mq_create(space, PARALLEL_REDO_QUEUE_SIZE);
+		shm_mq_set_sender(mq, MyProc);
+		reply_mq = shm_mq_create(space + PARALLEL_REDO_QUEUE_SIZE,
+								 PARALLEL_REDO_REPLY_QUEUE_SIZE);
+		shm_mq_set_receiver(reply_mq, MyProc);
+
+		snprintf(worker.bgw_name, BGW_MAXLEN, "parallel redo worker %d", i);
+		memcpy(worker.bgw_extra, &i, sizeof(int));
+		if (!RegisterDynamicBackgroundWorker(&worker, &w->bgwhandle))
+			break;
+
+		w->mqh = shm_mq_attach(mq, redo_seg, w->bgwhandle);
+		w->reply_mqh = shm_mq_attach(reply_mq, redo_seg, w->bgwhandle);
+		nredo_workers++;
+	}
+
+	if (nredo_workers == 0)
+	{
+		dsm_detach(redo_seg);
+		redo_seg = NULL;
+		ereport(LOG,
+				(errmsg("could not register parallel redo workers, replaying WAL serially"),
+				 errhint("You might need to increase max_worker_processes.")));
+		return;
+	}
+
+	ereport(LOG,
+			(errmsg("replaying WAL with %d parallel redo workers",
+					nredo_workers)));
+}
+
+/*
+ * Hand off a record to a parallel redo worker, if it can be replayed by one.
+ *
+ * Returns true if the record was handed off.  Otherwise, the caller must
+ * replay it itself; all records handed off earlier have been replayed by
+ * the time we return.
+ */
+bool
+ParallelRedoDispatch(XLogReaderState *record)
+{
+	RelFileNode rnode;
+	ForkNumber	forknum;
+	BlockNumber blkno;
+	struct
+	{
+		RelFileNode rnode;
+		ForkNumber	forknum;
+		BlockNumber blkno;
+	}			key;
+	uint32		hash;
+
+	if (nredo_workers == 0)
+		return false;
+
+	if (!ParallelRedoRecordIsSafe(record))
+	{
+		int			i;
+
+		ParallelRedoSync();
+
+		/*
+		 * If replaying the record might truncate or unlink files, the
+		 * workers must not keep using the file descriptors they have open;
+		 * they're idle until we send them something, so tell them then.
+		 */
+		if (ParallelRedoRecordDropsFiles(record))
+		{
+			for (i = 0; i < nredo_workers; i++)
+				redo_workers[i].closeFiles = true;
+		}
+		return false;
+	}
+
+	/* Pick the worker by the page the record touches */
+	XLogRecGetBlockTag(record, 0, &rnode, &forknum, &blkno);
+	memset(&key, 0, sizeof(key));
+	key.rnode = rnode;
+	key.forknum = forknum;
+	key.blkno = blkno;
+	hash = DatumGetUInt32(hash_any((unsigned char *) &key, sizeof(key)));
+
+	ParallelRedoSend(&redo_workers[hash % nredo_workers],
+					 PARALLEL_REDO_MSG_RECORD, record);
+
+	return true;
+}
+
+/*
+ * Wait for the parallel redo workers to replay all the records handed off
+ * so far, and collect the invalid-page references they found.
+ */
+void
+ParallelRedoSync(void)
+{
+	int			i;
+
+	for (i = 0; i < nredo_workers; i++)
+	{
+		if (redo_workers[i].busy)
+			ParallelRedoSend(&redo_workers[i], PARALLEL_REDO_MSG_SYNC, NULL);
+	}
+
+	for (i = 0; i < nredo_workers; i++)
+	{
+		ParallelRedoWorkerInfo *w = &redo_workers[i];
+
+		if (!w->busy)
+			continue;
+
+		for (;;)
+		{
+			shm_mq_result res;
+			Size		nbytes;
+			void	   *data;
+			ParallelRedoReply reply;
+
+			res = shm_mq_receive(w->reply_mqh, &nbytes, &data, false);
+			if (res != SHM_MQ_SUCCESS)
+				ereport(FATAL,
+						(errmsg("parallel redo worker exited unexpectedly")));
+			if (nbytes != sizeof(reply))
+				elog(FATAL, "invalid message size %zu from parallel redo worker",
+					 nbytes);
+			memcpy(&reply, data, sizeof(reply));
+
+			if (reply.type == PARALLEL_REDO_MSG_SYNC_DONE)
+				break;
+			if (reply.type != PARALLEL_REDO_MSG_INVALID_PAGE)
+				elog(FATAL, "invalid message type %d from parallel redo worker",
+					 reply.type);
+
+			XLogRememberInvalidPage(reply.node, reply.forkno, reply.blkno,
+									reply.present);
+		}
+		w->busy = false;
+	}
+}
+
+/*
+ * Wait for the parallel redo workers to finish, and let them exit.  Called
+ * by the startup process at the end of redo.
+ */
+void
+ParallelRedoEnd(void)
+{
+	if (nredo_workers == 0)
+		return;
+
+	ParallelRedoSync();
+
+	/* Detaching from the queues tells the workers to exit */
+	dsm_detach(redo_seg);
+	redo_seg = NULL;
+	nredo_workers = 0;
+}
+
+/*
+ * Can this record be replayed by a parallel redo worker?
+ */
+static bool
+ParallelRedoRecordIsSafe(XLogReaderState *record)
+{
+	uint8		info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
+
+	/* Records touching more than one page are barriers */
+	if (record->max_block_id != 0 || !XLogRecHasBlockRef(record, 0))
+		return false;
+
+	switch (XLogRecGetRmid(record))
+	{
+		case RM_HEAP_ID:
+			switch (info & XLOG_HEAP_OPMASK)
+			{
+				case XLOG_HEAP_INSERT:
+					return (((xl_heap_insert *) XLogRecGetData(record))->flags &
+							XLH_INSERT_ALL_VISIBLE_CLEARED) == 0;
+				case XLOG_HEAP_DELETE:
+					return (((xl_heap_delete *) XLogRecGetData(record))->flags &
+							XLH_DELETE_ALL_VISIBLE_CLEARED) == 0;
+				case XLOG_HEAP_UPDATE:
+				case XLOG_HEAP_HOT_UPDATE:
+					return (((xl_heap_update *) XLogRecGetData(record))->flags &
+							(XLH_UPDATE_OLD_ALL_VISIBLE_CLEARED |
+							 XLH_UPDATE_NEW_ALL_VISIBLE_CLEARED)) == 0;
+				case XLOG_HEAP_LOCK:
+					return (((xl_heap_lock *) XLogRecGetData(record))->flags &
+							XLH_LOCK_ALL_FROZEN_CLEARED) == 0;
+				case XLOG_HEAP_CONFIRM:
+					return true;
+				default:
+					return false;
+			}
+
+		case RM_BTREE_ID:
+			return info == XLOG_BTREE_INSERT_LEAF;
+
+		default:
+			return false;
+	}
+}
+
+/*
+ * Might replaying this record truncate or unlink relation files?
+ */
+static bool
+ParallelRedoRecordDropsFiles(XLogReaderState *record)
+{
+	uint8		info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
+
+	switch (XLogRecGetRmid(record))
+	{
+		case RM_SMGR_ID:
+		case RM_DBASE_ID:
+		case RM_TBLSPC_ID:
+			return true;
+
+		case RM_XACT_ID:
+			switch (info & XLOG_XACT_OPMASK)
+			{
+				case XLOG_XACT_COMMIT:
+				case XLOG_XACT_COMMIT_PREPARED:
+					{
+						xl_xact_parsed_commit parsed;
+
+						ParseCommitRecord(XLogRecGetInfo(record),
+									(xl_xact_commit *) XLogRecGetData(record),
+										  &parsed);
+						return parsed.nrels > 0;
+					}
+				case XLOG_XACT_ABORT:
+				case XLOG_XACT_ABORT_PREPARED:
+					{
+						xl_xact_parsed_abort parsed;
+
+						ParseAbortRecord(XLogRecGetInfo(record),
+									 (xl_xact_abort *) XLogRecGetData(record),
+										 &parsed);
+						return parsed.nrels > 0;
+					}
+				default:
+					return false;
+			}
+
+		default:
+			return false;
+	}
+}
+
+/*
+ * Send a message to a parallel redo worker.
+ */
+static void
+ParallelRedoSend(ParallelRedoWorkerInfo *w, uint8 type,
+				 XLogReaderState *record)
+{
+	ParallelRedoMessage msg;
+	shm_mq_iovec iov[2];
+	int			iovcnt = 1;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = type;
+	msg.reachedConsistency = reachedConsistency;
+	msg.closeFiles = w->closeFiles;
+	iov[0].data = (char *) &msg;
+	iov[0].len = sizeof(msg);
+
+	if (record != NULL)
+	{
+		msg.ReadRecPtr = record->ReadRecPtr;
+		msg.EndRecPtr = record->EndRecPtr;
+		iov[1].data = (char *) record->decoded_record;
+		iov[1].len = record->decoded_record->xl_tot_len;
+		iovcnt++;
+	}
+
+	if (shm_mq_sendv(w->mqh, iov, iovcnt, false) != SHM_MQ_SUCCESS)
+		ereport(FATAL,
+				(errmsg("parallel redo worker exited unexpectedly")));
+
+	w->closeFiles = false;
+	w->busy = true;
+}
+
+/*
+ * Remember a reference to an invalid page found by this worker, to be sent
+ * to the startup process at the next sync.  Called from log_invalid_page().
+ */
+void
+ParallelRedoReportInvalidPage(RelFileNode node, ForkNumber forkno,
+							  BlockNumber blkno, bool present)
+{
+	MemoryContext oldcxt;
+	ParallelRedoReply *reply;
+
+	Assert(IsParallelRedoWorker);
+
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	reply = palloc0(sizeof(ParallelRedoReply));
+	reply->type = PARALLEL_REDO_MSG_INVALID_PAGE;
+	reply->present = present;
+	reply->node = node;
+	reply->forkno = forkno;
+	reply->blkno = blkno;
+	pending_invalid_pages = lappend(pending_invalid_pages, reply);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * Main entry point for parallel redo workers.
+ */
+void
+ParallelRedoWorkerMain(Datum main_arg)
+{
+	int			workerno;
+	dsm_segment *seg;
+	shm_toc    *toc;
+	char	   *space;
+	shm_mq	   *mq;
+	shm_mq	   *reply_mq;
+	shm_mq_handle *mqh;
+	shm_mq_handle *reply_mqh;
+	XLogReaderState *reader;
+	MemoryContext redo_cxt;
+	char	   *recbuf = NULL;
+	Size		recbufsize = 0;
+
+	/* Establish signal handlers. */
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	memcpy(&workerno, MyBgworkerEntry->bgw_extra, sizeof(int));
+
+	/* Set up a resource owner, and a memory context for replaying records. */
+	CurrentResourceOwner = ResourceOwnerCreate(NULL, "parallel redo worker");
+	redo_cxt = AllocSetContextCreate(TopMemoryContext,
+									 "parallel redo",
+									 ALLOCSET_DEFAULT_SIZES);
+
+	seg = dsm_attach(DatumGetUInt32(main_arg));
+	if (seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment")));
+	toc = shm_toc_attach(PARALLEL_REDO_MAGIC, dsm_segment_address(seg));
+	if (toc == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+		   errmsg("invalid magic number in dynamic shared memory segment")));
+
+	space = shm_toc_lookup(toc, PARALLEL_REDO_KEY_QUEUES);
+	space += workerno * (PARALLEL_REDO_QUEUE_SIZE +
+						 PARALLEL_REDO_REPLY_QUEUE_SIZE);
+	mq = (shm_mq *) space;
+	shm_mq_set_receiver(mq, MyProc);
+	mqh = shm_mq_attach(mq, seg, NULL);
+	reply_mq = (shm_mq *) (space + PARALLEL_REDO_QUEUE_SIZE);
+	shm_mq_set_sender(reply_mq, MyProc);
+	reply_mqh = shm_mq_attach(reply_mq, seg, NULL);
+
+	/* From here on, act like the startup process does while replaying. */
+	IsParallelRedoWorker = true;
+	InRecovery = true;
+
+	reader = XLogReaderAllocate(NULL, NULL);
+	if (reader == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+		   errdetail("Failed while allocating an XLog reading processor.")));
+
+	for (;;)
+	{
+		shm_mq_result res;
+		Size		nbytes;
+		void	   *data;
+		ParallelRedoMessage msg;
+		ErrorContextCallback errcallback;
+		char	   *errormsg;
+		MemoryContext oldcxt;
+
+		CHECK_FOR_INTERRUPTS();
+
+		res = shm_mq_receive(mqh, &nbytes, &data, false);
+		if (res != SHM_MQ_SUCCESS)
+			break;				/* the startup process is done with us */
+		if (nbytes < sizeof(msg))
+			elog(ERROR, "invalid message size %zu in parallel redo queue",
+				 nbytes);
+		memcpy(&msg, data, sizeof(msg));
+
+		if (msg.closeFiles)
+			smgrcloseall();
+		reachedConsistency = msg.reachedConsistency;
+
+		if (msg.type == PARALLEL_REDO_MSG_SYNC)
+		{
+			ParallelRedoReply reply;
+			ListCell   *lc;
+
+			foreach(lc, pending_invalid_pages)
+			{
+				if (shm_mq_send(reply_mqh, sizeof(ParallelRedoReply),
+								lfirst(lc), false) != SHM_MQ_SUCCESS)
+					proc_exit(0);
+			}
+			list_free_deep(pending_invalid_pages);
+			pending_invalid_pages = NIL;
+
+			memset(&reply, 0, sizeof(reply));
+			reply.type = PARALLEL_REDO_MSG_SYNC_DONE;
+			if (shm_mq_send(reply_mqh, sizeof(reply), &reply,
+							false) != SHM_MQ_SUCCESS)
+				proc_exit(0);
+			continue;
+		}
+
+		if (msg.type != PARALLEL_REDO_MSG_RECORD)
+			elog(ERROR, "invalid message type %d in parallel redo queue",
+				 msg.type);
+
+		/*
+		 * Copy the record out of the queue, so that it's suitably aligned,
+		 * and stays put while we replay it.
+		 */
+		nbytes -= sizeof(msg);
+		if (nbytes > recbufsize)
+		{
+			if (recbuf)
+				pfree(recbuf);
+			recbufsize = Max(nbytes, BLCKSZ);
+			recbuf = MemoryContextAlloc(TopMemoryContext, recbufsize);
+		}
+		memcpy(recbuf, (char *) data + sizeof(msg), nbytes);
+
+		reader->ReadRecPtr = msg.ReadRecPtr;
+		reader->EndRecPtr = msg.EndRecPtr;
+		if (!DecodeXLogRecord(reader, (XLogRecord *) recbuf, &errormsg))
+			elog(ERROR, "could not decode WAL record at %X/%X: %s",
+				 (uint32) (msg.ReadRecPtr >> 32), (uint32) msg.ReadRecPtr,
+				 errormsg);
+
+		/* Setup error traceback support for ereport() */
+		errcallback.callback = parallel_redo_error_callback;
+		errcallback.arg = (void *) reader;
+		errcallback.previous = error_context_stack;
+		error_context_stack = &errcallback;
+
+		oldcxt = MemoryContextSwitchTo(redo_cxt);
+		RmgrTable[XLogRecGetRmid(reader)].rm_redo(reader);
+		MemoryContextSwitchTo(oldcxt);
+		MemoryContextReset(redo_cxt);
+
+		error_context_stack = errcallback.previous;
+	}
+
+	proc_exit(0);
+}
+
+/*
+ * Error context callback for errors occurring during redo in a worker.
+ */
+static void
+parallel_redo_error_callback(void *arg)
+{
+	XLogReaderState *record = (XLogReaderState *) arg;
+	RmgrId		rmid = XLogRecGetRmid(record);
+	uint8		info = XLogRecGetInfo(record);
+	const char *id;
+	StringInfoData buf;
+
+	initStringInfo(&buf);
+	appendStringInfoString(&buf, RmgrTable[rmid].rm_name);
+	appendStringInfoChar(&buf, '/');
+	id = RmgrTable[rmid].rm_identify(info);
+	if (id == NULL)
+		appendStringInfo(&buf, "UNKNOWN (%X): ", info & ~XLR_INFO_MASK);
+	else
+		appendStringInfo(&buf, "%s: ", id);
+	RmgrTable[rmid].rm_desc(&buf, record);
+
+	/* translator: %s is an XLog record description */
+	errcontext("xlog redo at %X/%X for %s",
+			   (uint32) (record->ReadRecPtr >> 32),
+			   (uint32) record->ReadRecPtr,
+			   buf.data);
+
+	pfree(buf.data);
+}
@@ -24,6 +24,7 @@
 #include "access/clog.h"
 #include "access/commit_ts.h"
 #include "access/multixact.h"
+#include "access/parallelredo.h"
 #include "access/rewriteheap.h"
 #include "access/subtrans.h"
 #include "access/timeline.h"
@@ -33,6 +34,7 @@
 #include "access/xact.h"
 #include "access/xlog_internal.h"
 #include "access/xloginsert.h"
+#include "access/xlogprefetch.h"
 #include "access/xlogreader.h"
 #include "access/xlogutils.h"
 #include "catalog/catversion.h"
@@ -42,6 +44,7 @@
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/atomics.h"
+#include "portability/instr_time.h"
 #include "postmaster/bgwriter.h"
 #include "postmaster/walwriter.h"
 #include "postmaster/startup.h"
@@ -95,10 +98,11 @@ bool		EnableHotStandby = false;
 bool		fullPageWrites = true;
 bool		wal_log_hints = false;
 bool		wal_compression = false;
+bool		wal_record_compression = false;
 bool		log_checkpoints = false;
 int			sync_method = DEFAULT_SYNC_METHOD;
 int			wal_level = WAL_LEVEL_MINIMAL;
-int			CommitDelay = 0;	/* precommit delay in microseconds */
+int			CommitDelay = 0;	/* precommit delay in microseconds, or -1 */
 int			CommitSiblings = 5; /* # concurrent xacts needed to sleep */
 int			wal_retrieve_retry_interval = 5000;
 
@@ -107,11 +111,19 @@ bool		XLOG_DEBUG = false;
 #endif
 
 /*
- * Number of WAL insertion locks to use. A higher value allows more insertions
- * to happen concurrently, but adds some CPU overhead to flushing the WAL,
- * which needs to iterate all the locks.
+ * Number of WAL insertion locks to use (wal_insert_locks). A higher value
+ * allows more insertions to happen concurrently, but adds some CPU overhead
+ * to flushing the WAL, which needs to iterate all the locks.
  */
-#define NUM_XLOGINSERT_LOCKS  8
+int			wal_insert_locks = 8;
+
+/*
+ * Limits for the adaptive commit delay: never sleep longer than the largest
+ * commit_delay that can be set, and after a run of delays that no other
+ * backend took advantage of, shrink the delay by up to 2^4.
+ */
+#define MAX_COMMIT_DELAY			100000
+#define MAX_FRUITLESS_COMMIT_DELAYS	4
 
 /*
  * Max distance from last checkpoint, before triggering a new xlog-based
@@ -580,12 +592,30 @@ typedef struct XLogCtlData
 	pg_time_t	lastSegSwitchTime;
 	XLogRecPtr	lastSegSwitchLSN;
 
+	/*
+	 * State of the adaptive commit delay, used with commit_delay = -1.
+	 * Protected by WALWriteLock.  avgFlushTime is a moving average of the
+	 * time a group commit leader takes to write and flush WAL, in
+	 * microseconds; fruitlessDelays counts recent delays during which no
+	 * other backend inserted WAL, and shrinks the delay.
+	 */
+	double		avgFlushTime;
+	int			fruitlessDelays;
+
 	/*
 	 * Protected by info_lck and WALWriteLock (you must hold either lock to
 	 * read it, but both to update)
 	 */
 	XLogwrtResult LogwrtResult;
 
+	/*
+	 * All WAL insertions up to this point are known to have finished.  This
+	 * is the highest value any WaitXLogInsertionsToFinish() call has
+	 * returned, and lets later calls that wait for less return without
+	 * scanning the insertion locks.  Only ever advances.
+	 */
+	pg_atomic_uint64 insertsFinishedUpto;
+
 	/*
 	 * Latest initialized page in the cache (last byte position + 1).
 	 *
@@ -867,6 +897,7 @@ static void UpdateLastRemovedPtr(char *filename);
 static void ValidateXLOGDirectoryStructure(void);
 static void CleanupBackupHistory(void);
 static void UpdateMinRecoveryPoint(XLogRecPtr lsn, bool force);
+static int	AdaptiveCommitDelay(void);
 static XLogRecord *ReadRecord(XLogReaderState *xlogreader, XLogRecPtr RecPtr,
 		   int emode, bool fetching_ckpt);
 static void CheckRecoveryConsistency(void);
@@ -975,7 +1006,7 @@ XLogInsertRecord(XLogRecData *rdata,
 	 * inserter acquires an insertion lock. In addition to just indicating that
 	 * an insertion is in progress, the lock tells others how far the inserter
 	 * has progressed. There is a small fixed number of insertion locks,
-	 * determined by NUM_XLOGINSERT_LOCKS. When an inserter crosses a page
+	 * determined by wal_insert_locks. When an inserter crosses a page
 	 * boundary, it updates the value stored in the lock to the how far it has
 	 * inserted, to allow the previous buffer to be flushed.
 	 *
@@ -1461,7 +1492,7 @@ WALInsertLockAcquire(void)
 	static int	lockToTry = -1;
 
 	if (lockToTry == -1)
-		lockToTry = MyProc->pgprocno % NUM_XLOGINSERT_LOCKS;
+		lockToTry = MyProc->pgprocno % wal_insert_locks;
 	MyLockNo = lockToTry;
 
 	/*
@@ -1479,7 +1510,7 @@ WALInsertLockAcquire(void)
 		 * than locks, it still helps to distribute the inserters evenly
 		 * across the locks.
 		 */
-		lockToTry = (lockToTry + 1) % NUM_XLOGINSERT_LOCKS;
+		lockToTry = (lockToTry + 1) % wal_insert_locks;
 	}
 }
 
@@ -1497,7 +1528,7 @@ WALInsertLockAcquireExclusive(void)
 	 * indicator is set to 0xFFFFFFFFFFFFFFFF, which is higher than any real
 	 * XLogRecPtr value, to make sure that no-one blocks waiting on those.
 	 */
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS - 1; i++)
+	for (i = 0; i < wal_insert_locks - 1; i++)
 	{
 		LWLockAcquire(&WALInsertLocks[i].l.lock, LW_EXCLUSIVE);
 		LWLockUpdateVar(&WALInsertLocks[i].l.lock,
@@ -1523,7 +1554,7 @@ WALInsertLockRelease(void)
 	{
 		int			i;
 
-		for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+		for (i = 0; i < wal_insert_locks; i++)
 			LWLockReleaseClearVar(&WALInsertLocks[i].l.lock,
 								  &WALInsertLocks[i].l.insertingAt,
 								  0);
@@ -1551,8 +1582,8 @@ WALInsertLockUpdateInsertingAt(XLogRecPtr insertingAt)
 		 * We use the last lock to mark our actual position, see comments in
 		 * WALInsertLockAcquireExclusive.
 		 */
-		LWLockUpdateVar(&WALInsertLocks[NUM_XLOGINSERT_LOCKS - 1].l.lock,
-					 &WALInsertLocks[NUM_XLOGINSERT_LOCKS - 1].l.insertingAt,
+		LWLockUpdateVar(&WALInsertLocks[wal_insert_locks - 1].l.lock,
+					 &WALInsertLocks[wal_insert_locks - 1].l.insertingAt,
 						insertingAt);
 	}
 	else
@@ -1581,12 +1612,25 @@ WaitXLogInsertionsToFinish(XLogRecPtr upto)
 	uint64		bytepos;
 	XLogRecPtr	reservedUpto;
 	XLogRecPtr	finishedUpto;
+	uint64		oldFinishedUpto;
 	XLogCtlInsert *Insert = &XLogCtl->Insert;
 	int			i;
 
 	if (MyProc == NULL)
 		elog(PANIC, "cannot wait without a PGPROC structure");
 
+	/*
+	 * If someone has already established that all insertions up to 'upto'
+	 * have finished, we're done.  The barrier pairs with the one in the
+	 * compare-and-exchange below, making the inserted data visible to us.
+	 */
+	finishedUpto = pg_atomic_read_u64(&XLogCtl->insertsFinishedUpto);
+	if (upto <= finishedUpto)
+	{
+		pg_memory_barrier();
+		return finishedUpto;
+	}
+
 	/* Read the current insert position */
 	SpinLockAcquire(&Insert->insertpos_lck);
 	bytepos = Insert->CurrBytePos;
@@ -1619,7 +1663,7 @@ WaitXLogInsertionsToFinish(XLogRecPtr upto)
 	 * out for any insertion that's still in progress.
 	 */
 	finishedUpto = reservedUpto;
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < wal_insert_locks; i++)
 	{
 		XLogRecPtr	insertingat = InvalidXLogRecPtr;
 
@@ -1655,6 +1699,16 @@ WaitXLogInsertionsToFinish(XLogRecPtr upto)
 		if (insertingat != InvalidXLogRecPtr && insertingat < finishedUpto)
 			finishedUpto = insertingat;
 	}
+
+	/* Advertise the result, unless someone got further already */
+	oldFinishedUpto = pg_atomic_read_u64(&XLogCtl->insertsFinishedUpto);
+	while (oldFinishedUpto < finishedUpto)
+	{
+		if (pg_atomic_compare_exchange_u64(&XLogCtl->insertsFinishedUpto,
+										   &oldFinishedUpto, finishedUpto))
+			break;
+	}
+
 	return finishedUpto;
 }
 
@@ -1924,7 +1978,29 @@ AdvanceXLInsertBuffer(XLogRecPtr upto, bool opportunistic)
 	XLogPageHeader NewPage;
 	int			npages = 0;
 
-	LWLockAcquire(WALBufMappingLock, LW_EXCLUSIVE);
+	/*
+	 * When several backends need the same new page at once, only one of them
+	 * needs to initialize it.  Rather than queuing up for WALBufMappingLock
+	 * only to find that the page is ready, the others wait for the lock to
+	 * be released and then check, like group commit followers in XLogFlush.
+	 */
+	if (opportunistic)
+		LWLockAcquire(WALBufMappingLock, LW_EXCLUSIVE);
+	else
+	{
+		XLogRecPtr	expectedEndPtr = upto + XLOG_BLCKSZ - upto % XLOG_BLCKSZ;
+		int			idx = XLogRecPtrToBufIdx(upto);
+
+		while (!LWLockAcquireOrWait(WALBufMappingLock, LW_EXCLUSIVE))
+		{
+			if (*((volatile XLogRecPtr *) &XLogCtl->xlblocks[idx]) == expectedEndPtr)
+			{
+				/* see GetXLogBuffer() */
+				pg_memory_barrier();
+				return;
+			}
+		}
+	}
 
 	/*
 	 * Now that we have the lock, check if someone initialized the page
@@ -2620,6 +2696,21 @@ UpdateMinRecoveryPoint(XLogRecPtr lsn, bool force)
 	LWLockRelease(ControlFileLock);
 }
 
+/*
+ * Compute the commit delay to use with commit_delay = -1, in microseconds.
+ *
+ * Caller must hold WALWriteLock.
+ */
+static int
+AdaptiveCommitDelay(void)
+{
+	double		delay;
+
+	delay = (XLogCtl->avgFlushTime / 2) / (1 << XLogCtl->fruitlessDelays);
+
+	return (int) Min(delay, MAX_COMMIT_DELAY);
+}
+
 /*
  * Ensure that all XLOG data through the given position is flushed to disk.
  *
@@ -2631,6 +2722,7 @@ XLogFlush(XLogRecPtr record)
 {
 	XLogRecPtr	WriteRqstPtr;
 	XLogwrtRqst WriteRqst;
+	int			delay;
 
 	/*
 	 * During REDO, we are reading not writing WAL.  Therefore, instead of
@@ -2728,11 +2820,22 @@ XLogFlush(XLogRecPtr record)
 		 *
 		 * We do not sleep if enableFsync is not turned on, nor if there are
 		 * fewer than CommitSiblings other backends with active transactions.
+		 *
+		 * With commit_delay = -1, the delay is half the average time a flush
+		 * has taken recently, which is the setting the documentation
+		 * recommends starting from, scaled down if recent delays didn't let
+		 * anyone else join the group.
 		 */
-		if (CommitDelay > 0 && enableFsync &&
+		if (CommitDelay < 0)
+			delay = AdaptiveCommitDelay();
+		else
+			delay = CommitDelay;
+		if (delay > 0 && enableFsync &&
 			MinimumActiveBackends(CommitSiblings))
 		{
-			pg_usleep(CommitDelay);
+			XLogRecPtr	before = insertpos;
+
+			pg_usleep(delay);
 
 			/*
 			 * Re-check how far we can now flush the WAL. It's generally not
@@ -2745,13 +2848,38 @@ XLogFlush(XLogRecPtr record)
 			 * further forward, not to actually wait for anyone.
 			 */
 			insertpos = WaitXLogInsertionsToFinish(insertpos);
+
+			if (CommitDelay < 0)
+			{
+				if (insertpos > before)
+					XLogCtl->fruitlessDelays = Max(XLogCtl->fruitlessDelays - 1, 0);
+				else
+					XLogCtl->fruitlessDelays = Min(XLogCtl->fruitlessDelays + 1,
+												   MAX_FRUITLESS_COMMIT_DELAYS);
+			}
 		}
 
 		/* try to write/flush later additions to XLOG as well */
 		WriteRqst.Write = insertpos;
 		WriteRqst.Flush = insertpos;
 
-		XLogWrite(WriteRqst, false);
+		if (CommitDelay < 0 && enableFsync)
+		{
+			instr_time	start;
+			instr_time	duration;
+
+			INSTR_TIME_SET_CURRENT(start);
+			XLogWrite(WriteRqst, false);
+			INSTR_TIME_SET_CURRENT(duration);
+			INSTR_TIME_SUBTRACT(duration, start);
+
+			/* exponential moving average, weighting the new sample 1/8 */
+			XLogCtl->avgFlushTime +=
+				((double) INSTR_TIME_GET_MICROSEC(duration) -
+				 XLogCtl->avgFlushTime) / 8.0;
+		}
+		else
+			XLogWrite(WriteRqst, false);
 
 		LWLockRelease(WALWriteLock);
 		/* done */
@@ -4688,7 +4816,7 @@ XLOGShmemSize(void)
 	size = sizeof(XLogCtlData);
 
 	/* WAL insertion locks, plus alignment */
-	size = add_size(size, mul_size(sizeof(WALInsertLockPadded), NUM_XLOGINSERT_LOCKS + 1));
+	size = add_size(size, mul_size(sizeof(WALInsertLockPadded), wal_insert_locks + 1));
 	/* xlblocks array */
 	size = add_size(size, mul_size(sizeof(XLogRecPtr), XLOGbuffers));
 	/* extra alignment padding for XLOG I/O buffers */
@@ -4746,6 +4874,7 @@ XLOGShmemInit(void)
 		return;
 	}
 	memset(XLogCtl, 0, sizeof(XLogCtlData));
+	pg_atomic_init_u64(&XLogCtl->insertsFinishedUpto, InvalidXLogRecPtr);
 
 	/*
 	 * Since XLogCtlData contains XLogRecPtr fields, its sizeof should be a
@@ -4763,10 +4892,10 @@ XLOGShmemInit(void)
 		((uintptr_t) allocptr) %sizeof(WALInsertLockPadded);
 	WALInsertLocks = XLogCtl->Insert.WALInsertLocks =
 		(WALInsertLockPadded *) allocptr;
-	allocptr += sizeof(WALInsertLockPadded) * NUM_XLOGINSERT_LOCKS;
+	allocptr += sizeof(WALInsertLockPadded) * wal_insert_locks;
 
 	LWLockRegisterTranche(LWTRANCHE_WAL_INSERT, "wal_insert");
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < wal_insert_locks; i++)
 	{
 		LWLockInitialize(&WALInsertLocks[i].l.lock, LWTRANCHE_WAL_INSERT);
 		WALInsertLocks[i].l.insertingAt = InvalidXLogRecPtr;
@@ -5764,6 +5893,9 @@ recoveryPausesHere(void)
 	if (!LocalHotStandbyActive)
 		return;
 
+	/* Let users see everything up to the pause point */
+	ParallelRedoSync();
+
 	ereport(LOG,
 			(errmsg("recovery has paused"),
 			 errhint("Execute pg_xlog_replay_resume() to continue.")));
@@ -6837,6 +6969,7 @@ StartupXLOG(void)
 		{
 			ErrorContextCallback errcallback;
 			TimestampTz xtime;
+			XLogPrefetcher *prefetcher;
 
 			InRedo = true;
 
@@ -6844,6 +6977,12 @@ StartupXLOG(void)
 					(errmsg("redo starts at %X/%X",
 						 (uint32) (ReadRecPtr >> 32), (uint32) ReadRecPtr)));
 
+			/* Launch parallel redo workers, if enabled */
+			ParallelRedoStart();
+
+			/* Prepare to prefetch blocks referenced by upcoming records */
+			prefetcher = XLogPrefetcherAllocate();
+
 			/*
 			 * main redo apply loop
 			 */
@@ -6997,8 +7136,18 @@ StartupXLOG(void)
 					TransactionIdIsValid(record->xl_xid))
 					RecordKnownAssignedTransactionIds(record->xl_xid);
 
-				/* Now apply the WAL record itself */
-				RmgrTable[record->xl_rmid].rm_redo(xlogreader);
+				/* Start reading blocks that later records will need */
+				XLogPrefetcherReadAhead(prefetcher, xlogreader);
+
+				/*
+				 * Now apply the WAL record itself, or hand it off to a
+				 * parallel redo worker.  In the latter case, we treat the
+				 * record as replayed below, even though the worker may not
+				 * have got to it yet; see the header comment of
+				 * parallelredo.c for why that's OK.
+				 */
+				if (!ParallelRedoDispatch(xlogreader))
+					RmgrTable[record->xl_rmid].rm_redo(xlogreader);
 
 				/* Pop the error context stack */
 				error_context_stack = errcallback.previous;
@@ -7062,6 +7211,11 @@ StartupXLOG(void)
 			 * end of main redo apply loop
 			 */
 
+			/* Wait for the parallel redo workers to finish, if any */
+			ParallelRedoEnd();
+
+			XLogPrefetcherFree(prefetcher);
+
 			if (reachedStopPoint)
 			{
 				if (!reachedConsistency)
@@ -7625,6 +7779,9 @@ CheckRecoveryConsistency(void)
 		 */
 		elog(DEBUG1, "end of backup reached");
 
+		/* Make sure all records up to here have really been replayed */
+		ParallelRedoSync();
+
 		LWLockAcquire(ControlFileLock, LW_EXCLUSIVE);
 
 		if (ControlFile->minRecoveryPoint < lastReplayedEndRecPtr)
@@ -7649,6 +7806,12 @@ CheckRecoveryConsistency(void)
 		minRecoveryPoint <= lastReplayedEndRecPtr &&
 		XLogRecPtrIsInvalid(ControlFile->backupStartPoint))
 	{
+		/*
+		 * Wait for any parallel redo workers to catch up, so that we're
+		 * really consistent, and know all their invalid-page references.
+		 */
+		ParallelRedoSync();
+
 		/*
 		 * Check to see if the XLOG sequence contained any unresolved
 		 * references to uninitialized pages.
@@ -8064,7 +8227,7 @@ GetLastImportantRecPtr(void)
 	XLogRecPtr	res = InvalidXLogRecPtr;
 	int			i;
 
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < wal_insert_locks; i++)
 	{
 		XLogRecPtr	last_important;
 
@@ -9801,9 +9964,17 @@ get_sync_bit(int method)
 {
 	int			o_direct_flag = 0;
 
+	/*
+	 * With direct_io = wal or all, always bypass the kernel cache, whatever
+	 * the sync method; the fsync methods still flush.  But never in
+	 * walreceiver, for the reasons explained below.
+	 */
+	if ((direct_io & DIRECT_IO_WAL) && !AmWalReceiverProcess())
+		o_direct_flag = PG_O_DIRECT;
+
 	/* If fsync is disabled, never open in sync mode */
 	if (!enableFsync)
-		return 0;
+		return o_direct_flag;
 
 	/*
 	 * Optimize writes by bypassing kernel cache with O_DIRECT when using
@@ -9819,7 +9990,7 @@ get_sync_bit(int method)
 	 * after its written. Also, walreceiver performs unaligned writes, which
 	 * don't work with O_DIRECT, so it is required for correctness too.
 	 */
-	if (!XLogIsNeeded() && !AmWalReceiverProcess())
+	else if (!XLogIsNeeded() && !AmWalReceiverProcess())
 		o_direct_flag = PG_O_DIRECT;
 
 	switch (method)
@@ -9833,7 +10004,7 @@ get_sync_bit(int method)
 		case SYNC_METHOD_FSYNC:
 		case SYNC_METHOD_FSYNC_WRITETHROUGH:
 		case SYNC_METHOD_FDATASYNC:
-			return 0;
+			return (direct_io & DIRECT_IO_WAL) ? o_direct_flag : 0;
 #ifdef OPEN_SYNC_FLAG
 		case SYNC_METHOD_OPEN:
 			return OPEN_SYNC_FLAG | o_direct_flag;
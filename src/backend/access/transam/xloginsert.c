@@ -25,6 +25,7 @@
 #include "access/xloginsert.h"
 #include "catalog/pg_control.h"
 #include "common/pg_lzcompress.h"
+#include "common/pg_lzfast.h"
 #include "miscadmin.h"
 #include "replication/origin.h"
 #include "storage/bufmgr.h"
@@ -87,6 +88,18 @@ static uint8 curinsert_flags = 0;
 static XLogRecData hdr_rdt;
 static char *hdr_scratch = NULL;
 
+/*
+ * Working areas for compressing a whole record with wal_record_compression:
+ * 'compress_raw' holds the record flattened into one piece, and
+ * 'compress_out' the compressed result, which 'compress_rdt' points to.
+ * Both are XLR_MAX_COMPRESS_LEN bytes.  They are allocated at
+ * initialization, since XLogInsert() is usually called in a critical
+ * section.
+ */
+static XLogRecData compress_rdt;
+static char *compress_raw = NULL;
+static char *compress_out = NULL;
+
 #define SizeOfXlogOrigin	(sizeof(RepOriginId) + sizeof(char))
 
 #define HEADER_SCRATCH_SIZE \
@@ -111,6 +124,7 @@ static XLogRecData *XLogRecordAssemble(RmgrId rmid, uint8 info,
 				   XLogRecPtr *fpw_lsn);
 static bool XLogCompressBackupBlock(char *page, uint16 hole_offset,
 						uint16 hole_length, char *dest, uint16 *dlen);
+static bool XLogCompressRecord(uint32 *total_len);
 
 /*
  * Begin constructing a WAL record. This must be called before the
@@ -490,6 +504,7 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 	XLogRecData *rdt_datas_last;
 	XLogRecord *rechdr;
 	char	   *scratch = hdr_scratch;
+	bool		has_image = false;
 
 	/*
 	 * Note: this function can be called multiple times for the same record.
@@ -616,6 +631,7 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 			 * struct
 			 */
 			bkpb.fork_flags |= BKPBLOCK_HAS_IMAGE;
+			has_image = true;
 
 			/*
 			 * Construct XLogRecData entries for the page content.
@@ -739,6 +755,21 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 	hdr_rdt.len = (scratch - hdr_scratch);
 	total_len += hdr_rdt.len;
 
+	/*
+	 * Compress the record as a whole, if enabled.  Records carrying
+	 * full-page images are left alone: the images make up most of such a
+	 * record, and wal_compression takes care of them.  XLOG records are left
+	 * alone too, since some of them are inspected in raw form, and they're
+	 * rare anyway.
+	 */
+	if (wal_record_compression && !has_image && rmid != RM_XLOG_ID &&
+		total_len - SizeOfXLogRecord >= XLR_MIN_COMPRESS_LEN &&
+		total_len - SizeOfXLogRecord <= XLR_MAX_COMPRESS_LEN)
+	{
+		if (XLogCompressRecord(&total_len))
+			info |= XLR_COMPRESSED;
+	}
+
 	/*
 	 * Calculate CRC of the data
 	 *
@@ -817,6 +848,60 @@ XLogCompressBackupBlock(char *page, uint16 hole_offset, uint16 hole_length,
 	return false;
 }
 
+/*
+ * Replace the rdata chain of the record being assembled with a compressed
+ * version of it, if compression saves some space.
+ *
+ * Everything but the fixed-size XLogRecord header is compressed; see
+ * XLR_COMPRESSED.  On success, *total_len is updated to the length of the
+ * compressed record, and the caller must set XLR_COMPRESSED in xl_info.
+ */
+static bool
+XLogCompressRecord(uint32 *total_len)
+{
+	uint32		raw_len = *total_len - SizeOfXLogRecord;
+	char	   *ptr = compress_raw;
+	XLogRecData *rdt;
+	int32		len;
+
+	Assert(raw_len <= XLR_MAX_COMPRESS_LEN);
+
+	/* Flatten the headers and data into one piece */
+	memcpy(ptr, hdr_scratch + SizeOfXLogRecord, hdr_rdt.len - SizeOfXLogRecord);
+	ptr += hdr_rdt.len - SizeOfXLogRecord;
+	for (rdt = hdr_rdt.next; rdt != NULL; rdt = rdt->next)
+	{
+		memcpy(ptr, rdt->data, rdt->len);
+		ptr += rdt->len;
+	}
+	Assert(ptr - compress_raw == raw_len);
+
+	/*
+	 * The compressed data must be smaller than the original by more than the
+	 * length word we have to add, or it's not worth it.
+	 */
+	len = lzfast_compress(compress_raw, raw_len, compress_out,
+						  raw_len - sizeof(uint32) - 1);
+	if (len < 0)
+		return false;
+
+	/*
+	 * Put the length word after the record header, followed by the
+	 * compressed data.  The registered rdata chains are left unchanged, in
+	 * case the record has to be assembled again.
+	 */
+	memcpy(hdr_scratch + SizeOfXLogRecord, &raw_len, sizeof(uint32));
+	hdr_rdt.len = SizeOfXLogRecord + sizeof(uint32);
+	hdr_rdt.next = &compress_rdt;
+
+	compress_rdt.data = compress_out;
+	compress_rdt.len = len;
+	compress_rdt.next = NULL;
+
+	*total_len = hdr_rdt.len + len;
+	return true;
+}
+
 /*
  * Determine whether the buffer referenced has to be backed up.
  *
@@ -1028,4 +1113,14 @@ InitXLogInsert(void)
 	if (hdr_scratch == NULL)
 		hdr_scratch = MemoryContextAllocZero(xloginsert_cxt,
 											 HEADER_SCRATCH_SIZE);
+
+	/*
+	 * Allocate buffers for compressing whole records.  We need them even if
+	 * wal_record_compression is off now, since it can be turned on later.
+	 */
+	if (compress_raw == NULL)
+	{
+		compress_raw = MemoryContextAlloc(xloginsert_cxt, XLR_MAX_COMPRESS_LEN);
+		compress_out = MemoryContextAlloc(xloginsert_cxt, XLR_MAX_COMPRESS_LEN);
+	}
 }
@@ -0,0 +1,480 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogprefetch.c
+ *	  Prefetching of data blocks referenced by WAL during recovery
+ *
+ * Replaying a WAL record usually means reading the pages it modifies, and on
+ * storage with high latency, recovery spends most of its time waiting for
+ * those reads one at a time.  To avoid that, the startup process can decode
+ * the WAL ahead of the record being replayed, with a separate xlogreader,
+ * and initiate reads of the blocks referenced there with posix_fadvise(), so
+ * that they are likely to be in the kernel's cache by the time the redo
+ * routine asks for them.  recovery_prefetch_distance sets how far ahead, in
+ * bytes of WAL, we look.
+ *
+ * We don't prefetch blocks that are already in shared buffers, nor blocks
+ * that the record restores from a full-page image or initializes from
+ * scratch, since their old contents aren't needed.  We also skip blocks we
+ * prefetched very recently, since a series of records often touches the same
+ * page over and over.
+ *
+ * The look-ahead reader reads WAL segment files directly from pg_xlog,
+ * including the segment most recently restored from the archive, which is
+ * named RECOVERYXLOG there.  It stops when it runs out of WAL: at the end of
+ * what the WAL receiver has written, at the end of the restored segment, or
+ * at a timeline switch.  It then waits for replay to catch up with it, and
+ * starts again from the record being replayed.
+ *
+ * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/transam/xlogprefetch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <unistd.h>
+
+#include "access/htup_details.h"
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xlogprefetch.h"
+#include "funcapi.h"
+#include "port/atomics.h"
+#include "replication/walreceiver.h"
+#include "storage/bufmgr.h"
+#include "storage/fd.h"
+#include "storage/shmem.h"
+#include "storage/smgr.h"
+#include "utils/builtins.h"
+#include "utils/hsearch.h"
+
+
+/* Number of recently prefetched blocks to remember */
+#define XLOGPREFETCHER_RECENT_SIZE	16
+
+/* Counters, kept locally and copied to shared memory */
+typedef struct XLogPrefetchCounters
+{
+	uint64		prefetch;		/* blocks prefetched */
+	uint64		hit;			/* blocks already in shared buffers */
+	uint64		skip_fpw;		/* blocks restored or initialized by redo */
+	uint64		skip_repeat;	/* blocks prefetched recently */
+} XLogPrefetchCounters;
+
+/* Shared memory state, for pg_stat_recovery_prefetch */
+typedef struct XLogPrefetchStats
+{
+	pg_atomic_uint64 prefetch;
+	pg_atomic_uint64 hit;
+	pg_atomic_uint64 skip_fpw;
+	pg_atomic_uint64 skip_repeat;
+	pg_atomic_uint32 wal_distance;	/* bytes of WAL decoded ahead of replay */
+} XLogPrefetchStats;
+
+typedef struct XLogPrefetcherRecent
+{
+	RelFileNode rnode;
+	ForkNumber	forknum;
+	BlockNumber blkno;
+} XLogPrefetcherRecent;
+
+struct XLogPrefetcher
+{
+	XLogReaderState *reader;	/* look-ahead reader, or NULL if not started */
+	TimeLineID	tli;			/* timeline we're reading */
+	bool		stalled;		/* ran out of WAL to read? */
+	XLogRecPtr	stall_lsn;		/* if so, where */
+
+	/* WAL segment file open for reading */
+	int			file;
+	XLogSegNo	segno;
+
+	/* ring of recently prefetched blocks */
+	XLogPrefetcherRecent recent[XLOGPREFETCHER_RECENT_SIZE];
+	int			next_recent;
+
+	/* relations we've opened with smgropen(), to close at the end */
+	HTAB	   *smgr_opened;
+
+	XLogPrefetchCounters counters;
+};
+
+/* GUC variable, in kB */
+int			recovery_prefetch_distance = 0;
+
+static XLogPrefetchStats *Stats = NULL;
+
+static void XLogPrefetcherStop(XLogPrefetcher *prefetcher);
+static void XLogPrefetcherScanBlocks(XLogPrefetcher *prefetcher);
+static int XLogPrefetcherReadPage(XLogReaderState *state,
+					   XLogRecPtr targetPagePtr, int reqLen,
+					   XLogRecPtr targetRecPtr, char *readBuf,
+					   TimeLineID *pageTLI);
+
+
+/*
+ * Report shared-memory space needed by XLogPrefetchShmemInit.
+ */
+Size
+XLogPrefetchShmemSize(void)
+{
+	return sizeof(XLogPrefetchStats);
+}
+
+/*
+ * Allocate and initialize shared memory for the statistics.
+ */
+void
+XLogPrefetchShmemInit(void)
+{
+	bool		found;
+
+	Stats = (XLogPrefetchStats *)
+		ShmemInitStruct("XLog Prefetch Stats", sizeof(XLogPrefetchStats),
+						&found);
+	if (!found)
+	{
+		pg_atomic_init_u64(&Stats->prefetch, 0);
+		pg_atomic_init_u64(&Stats->hit, 0);
+		pg_atomic_init_u64(&Stats->skip_fpw, 0);
+		pg_atomic_init_u64(&Stats->skip_repeat, 0);
+		pg_atomic_init_u32(&Stats->wal_distance, 0);
+	}
+}
+
+/*
+ * Create a prefetcher, at the start of redo.  The statistics start from zero.
+ */
+XLogPrefetcher *
+XLogPrefetcherAllocate(void)
+{
+	XLogPrefetcher *prefetcher;
+	HASHCTL		ctl;
+
+	prefetcher = palloc0(sizeof(XLogPrefetcher));
+	prefetcher->file = -1;
+
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(RelFileNode);
+	ctl.entrysize = sizeof(RelFileNode);
+	prefetcher->smgr_opened = hash_create("XLog prefetcher relations", 64,
+										  &ctl, HASH_ELEM | HASH_BLOBS);
+
+	pg_atomic_write_u64(&Stats->prefetch, 0);
+	pg_atomic_write_u64(&Stats->hit, 0);
+	pg_atomic_write_u64(&Stats->skip_fpw, 0);
+	pg_atomic_write_u64(&Stats->skip_repeat, 0);
+	pg_atomic_write_u32(&Stats->wal_distance, 0);
+
+	return prefetcher;
+}
+
+/*
+ * Free a prefetcher, at the end of redo.  We also close the relations we
+ * opened; redo may still have some of them open too, but it's done with
+ * them by now.
+ */
+void
+XLogPrefetcherFree(XLogPrefetcher *prefetcher)
+{
+	HASH_SEQ_STATUS status;
+	RelFileNode *rnode;
+
+	XLogPrefetcherStop(prefetcher);
+
+	hash_seq_init(&status, prefetcher->smgr_opened);
+	while ((rnode = (RelFileNode *) hash_seq_search(&status)) != NULL)
+	{
+		RelFileNodeBackend rbnode;
+
+		rbnode.node = *rnode;
+		rbnode.backend = InvalidBackendId;
+		smgrclosenode(rbnode);
+	}
+	hash_destroy(prefetcher->smgr_opened);
+
+	pfree(prefetcher);
+}
+
+/*
+ * Shut down the look-ahead reader, if running.
+ */
+static void
+XLogPrefetcherStop(XLogPrefetcher *prefetcher)
+{
+	if (prefetcher->reader != NULL)
+	{
+		XLogReaderFree(prefetcher->reader);
+		prefetcher->reader = NULL;
+	}
+	if (prefetcher->file >= 0)
+	{
+		close(prefetcher->file);
+		prefetcher->file = -1;
+	}
+	prefetcher->stalled = false;
+	pg_atomic_write_u32(&Stats->wal_distance, 0);
+}
+
+/*
+ * Prefetch blocks referenced by WAL records up to recovery_prefetch_distance
+ * ahead of the record that 'replay' has just read, which is about to be
+ * replayed.
+ */
+void
+XLogPrefetcherReadAhead(XLogPrefetcher *prefetcher, XLogReaderState *replay)
+{
+	XLogRecPtr	replay_lsn = replay->EndRecPtr;
+	XLogRecPtr	target_lsn;
+	bool		restart = false;
+	uint64		distance;
+
+#ifdef USE_PREFETCH
+	distance = (uint64) recovery_prefetch_distance * 1024;
+#else
+	distance = 0;
+#endif
+
+	if (distance == 0)
+	{
+		/* Prefetching is disabled, perhaps just now */
+		if (prefetcher->reader != NULL)
+			XLogPrefetcherStop(prefetcher);
+		return;
+	}
+
+	if (prefetcher->reader == NULL)
+	{
+		prefetcher->reader = XLogReaderAllocate(XLogPrefetcherReadPage,
+												prefetcher);
+		if (prefetcher->reader == NULL)
+			return;				/* out of memory; just don't prefetch */
+		restart = true;
+	}
+	else if (prefetcher->stalled)
+	{
+		/*
+		 * Don't try again until replay has caught up with where we stopped,
+		 * or switched timelines.
+		 */
+		if (replay_lsn < prefetcher->stall_lsn &&
+			prefetcher->tli == ThisTimeLineID)
+			return;
+		restart = true;
+	}
+	else if (prefetcher->reader->EndRecPtr <= replay_lsn ||
+			 prefetcher->tli != ThisTimeLineID)
+	{
+		/* replay has overtaken us */
+		restart = true;
+	}
+
+	if (restart)
+	{
+		/*
+		 * Continue from the end of the record being replayed.  That might be
+		 * at a page boundary, so rather than passing it to XLogReadRecord()
+		 * as a starting point, make it look like the end of the previously
+		 * read record, and clear ReadRecPtr so that the reader doesn't
+		 * insist on the previous-record link.
+		 */
+		prefetcher->reader->ReadRecPtr = InvalidXLogRecPtr;
+		prefetcher->reader->EndRecPtr = replay_lsn;
+		prefetcher->stalled = false;
+		prefetcher->tli = ThisTimeLineID;
+
+		/*
+		 * Reopen the segment file, too.  If we got RECOVERYXLOG while it
+		 * still held an older segment, the one we wanted may be there now.
+		 */
+		if (prefetcher->file >= 0)
+		{
+			close(prefetcher->file);
+			prefetcher->file = -1;
+		}
+	}
+
+	target_lsn = replay_lsn + distance;
+	while (prefetcher->reader->EndRecPtr < target_lsn)
+	{
+		XLogRecPtr	last_end = prefetcher->reader->EndRecPtr;
+		char	   *errormsg;
+
+		if (XLogReadRecord(prefetcher->reader, InvalidXLogRecPtr,
+						   &errormsg) == NULL)
+		{
+			/* out of WAL for now; try again when replay gets here */
+			prefetcher->stalled = true;
+			prefetcher->stall_lsn = Max(last_end, replay_lsn);
+			break;
+		}
+
+		XLogPrefetcherScanBlocks(prefetcher);
+	}
+
+	/* Publish the statistics */
+	pg_atomic_write_u64(&Stats->prefetch, prefetcher->counters.prefetch);
+	pg_atomic_write_u64(&Stats->hit, prefetcher->counters.hit);
+	pg_atomic_write_u64(&Stats->skip_fpw, prefetcher->counters.skip_fpw);
+	pg_atomic_write_u64(&Stats->skip_repeat, prefetcher->counters.skip_repeat);
+	if (prefetcher->stalled || prefetcher->reader->EndRecPtr <= replay_lsn)
+		pg_atomic_write_u32(&Stats->wal_distance, 0);
+	else
+		pg_atomic_write_u32(&Stats->wal_distance,
+							(uint32) (prefetcher->reader->EndRecPtr - replay_lsn));
+}
+
+/*
+ * Prefetch the blocks referenced by the record the look-ahead reader has
+ * just decoded.
+ */
+static void
+XLogPrefetcherScanBlocks(XLogPrefetcher *prefetcher)
+{
+	XLogReaderState *reader = prefetcher->reader;
+	int			block_id;
+
+	for (block_id = 0; block_id <= reader->max_block_id; block_id++)
+	{
+		DecodedBkpBlock *blk = &reader->blocks[block_id];
+		XLogPrefetcherRecent *recent;
+		SMgrRelation smgr;
+		int			i;
+
+		if (!blk->in_use)
+			continue;
+
+		/* Redo won't read the block if it overwrites it anyway */
+		if (blk->has_image || (blk->flags & BKPBLOCK_WILL_INIT) != 0)
+		{
+			prefetcher->counters.skip_fpw++;
+			continue;
+		}
+
+		/* Did we just do this one? */
+		for (i = 0; i < XLOGPREFETCHER_RECENT_SIZE; i++)
+		{
+			recent = &prefetcher->recent[i];
+			if (recent->blkno == blk->blkno &&
+				recent->forknum == blk->forknum &&
+				RelFileNodeEquals(recent->rnode, blk->rnode))
+				break;
+		}
+		if (i < XLOGPREFETCHER_RECENT_SIZE)
+		{
+			prefetcher->counters.skip_repeat++;
+			continue;
+		}
+		recent = &prefetcher->recent[prefetcher->next_recent];
+		recent->rnode = blk->rnode;
+		recent->forknum = blk->forknum;
+		recent->blkno = blk->blkno;
+		prefetcher->next_recent =
+			(prefetcher->next_recent + 1) % XLOGPREFETCHER_RECENT_SIZE;
+
+		/*
+		 * The relation might not exist yet, or anymore; smgrprefetch() copes
+		 * with that.  We don't keep the SMgrRelation around, since replay
+		 * might close it, but we remember to close it when we're done.
+		 */
+		smgr = smgropen(blk->rnode, InvalidBackendId);
+		(void) hash_search(prefetcher->smgr_opened, &blk->rnode, HASH_ENTER,
+						   NULL);
+		if (PrefetchSharedBuffer(smgr, blk->forknum, blk->blkno))
+			prefetcher->counters.hit++;
+		else
+			prefetcher->counters.prefetch++;
+	}
+}
+
+/*
+ * xlogreader page-read callback for the look-ahead reader.  Reads WAL from
+ * segment files in pg_xlog, but not beyond what the WAL receiver has
+ * written, if it's active.  Returns -1 if the WAL isn't there (yet).
+ *
+ * In archive recovery, the segment being replayed may not be in pg_xlog
+ * under its own name, but as RECOVERYXLOG, so we look there next.  That file
+ * holds whichever segment was restored last, which need not be the one we
+ * want; if it isn't, the xlogreader rejects its page headers, and we stall
+ * until replay moves on.  Once we have a segment open we keep reading from
+ * it, even if the startup process restores another one over it.
+ */
+static int
+XLogPrefetcherReadPage(XLogReaderState *state, XLogRecPtr targetPagePtr,
+					   int reqLen, XLogRecPtr targetRecPtr, char *readBuf,
+					   TimeLineID *pageTLI)
+{
+	XLogPrefetcher *prefetcher = (XLogPrefetcher *) state->private_data;
+	int			readLen = XLOG_BLCKSZ;
+	XLogSegNo	segno;
+	uint32		offset;
+
+	if (WalRcvStreaming())
+	{
+		XLogRecPtr	written = GetWalRcvWriteRecPtr(NULL, NULL);
+
+		if (targetPagePtr + reqLen > written)
+			return -1;
+		if (targetPagePtr + readLen > written)
+			readLen = written - targetPagePtr;
+	}
+
+	XLByteToSeg(targetPagePtr, segno);
+	if (prefetcher->file >= 0 && prefetcher->segno != segno)
+	{
+		close(prefetcher->file);
+		prefetcher->file = -1;
+	}
+	if (prefetcher->file < 0)
+	{
+		char		path[MAXPGPATH];
+
+		XLogFilePath(path, prefetcher->tli, segno);
+		prefetcher->file = BasicOpenFile(path, O_RDONLY | PG_BINARY, 0);
+		if (prefetcher->file < 0 && errno == ENOENT &&
+			ArchiveRecoveryRequested)
+		{
+			snprintf(path, MAXPGPATH, XLOGDIR "/RECOVERYXLOG");
+			prefetcher->file = BasicOpenFile(path, O_RDONLY | PG_BINARY, 0);
+		}
+		if (prefetcher->file < 0)
+			return -1;
+		prefetcher->segno = segno;
+	}
+
+	offset = targetPagePtr % XLogSegSize;
+	if (lseek(prefetcher->file, (off_t) offset, SEEK_SET) < 0 ||
+		read(prefetcher->file, readBuf, XLOG_BLCKSZ) != XLOG_BLCKSZ)
+		return -1;
+
+	*pageTLI = prefetcher->tli;
+	return readLen;
+}
+
+/*
+ * pg_stat_get_recovery_prefetch -- report on WAL prefetching in recovery
+ */
+Datum
+pg_stat_get_recovery_prefetch(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_RECOVERY_PREFETCH_COLS	5
+	TupleDesc	tupdesc;
+	Datum		values[PG_STAT_GET_RECOVERY_PREFETCH_COLS];
+	bool		nulls[PG_STAT_GET_RECOVERY_PREFETCH_COLS];
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum((int64) pg_atomic_read_u64(&Stats->prefetch));
+	values[1] = Int64GetDatum((int64) pg_atomic_read_u64(&Stats->hit));
+	values[2] = Int64GetDatum((int64) pg_atomic_read_u64(&Stats->skip_fpw));
+	values[3] = Int64GetDatum((int64) pg_atomic_read_u64(&Stats->skip_repeat));
+	values[4] = Int32GetDatum((int32) pg_atomic_read_u32(&Stats->wal_distance));
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
@@ -23,6 +23,7 @@
 #include "access/xlogreader.h"
 #include "catalog/pg_control.h"
 #include "common/pg_lzcompress.h"
+#include "common/pg_lzfast.h"
 #include "replication/origin.h"
 
 static bool allocate_recordbuf(XLogReaderState *state, uint32 reclength);
@@ -137,6 +138,8 @@ XLogReaderFree(XLogReaderState *state)
 	pfree(state->errormsg_buf);
 	if (state->readRecordBuf)
 		pfree(state->readRecordBuf);
+	if (state->decompressBuf)
+		pfree(state->decompressBuf);
 	pfree(state->readBuf);
 	pfree(state);
 }
@@ -989,6 +992,7 @@ ResetDecoder(XLogReaderState *state)
 	int			block_id;
 
 	state->decoded_record = NULL;
+	state->decoded_len = 0;
 
 	state->main_data_len = 0;
 
@@ -1037,6 +1041,51 @@ DecodeXLogRecord(XLogReaderState *state, XLogRecord *record, char **errormsg)
 	ptr += SizeOfXLogRecord;
 	remaining = record->xl_tot_len - SizeOfXLogRecord;
 
+	/*
+	 * If the record is compressed, decompress the rest of it into a separate
+	 * buffer, and decode from there.
+	 */
+	if (record->xl_info & XLR_COMPRESSED)
+	{
+		uint32		raw_len;
+
+		COPY_HEADER_FIELD(&raw_len, sizeof(uint32));
+		if (raw_len > XLR_MAX_COMPRESS_LEN)
+		{
+			report_invalid_record(state,
+								  "invalid uncompressed length %u in compressed record at %X/%X",
+								  raw_len,
+								  (uint32) (state->ReadRecPtr >> 32),
+								  (uint32) state->ReadRecPtr);
+			goto err;
+		}
+		if (state->decompressBuf == NULL)
+		{
+			state->decompressBuf = palloc_extended(XLR_MAX_COMPRESS_LEN,
+												   MCXT_ALLOC_NO_OOM);
+			if (state->decompressBuf == NULL)
+			{
+				report_invalid_record(state,
+									  "out of memory while decompressing record at %X/%X",
+									  (uint32) (state->ReadRecPtr >> 32),
+									  (uint32) state->ReadRecPtr);
+				goto err;
+			}
+		}
+		if (lzfast_decompress(ptr, remaining, state->decompressBuf,
+							  raw_len) < 0)
+		{
+			report_invalid_record(state,
+								  "invalid compressed record at %X/%X",
+								  (uint32) (state->ReadRecPtr >> 32),
+								  (uint32) state->ReadRecPtr);
+			goto err;
+		}
+		ptr = state->decompressBuf;
+		remaining = raw_len;
+	}
+	state->decoded_len = SizeOfXLogRecord + remaining;
+
 	/* Decode the headers */
 	datatotal = 0;
 	while (remaining > datatotal)
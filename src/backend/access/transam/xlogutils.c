@@ -19,11 +19,13 @@
 
 #include <unistd.h>
 
+#include "access/parallelredo.h"
 #include "access/xlog.h"
 #include "access/xlog_internal.h"
 #include "access/xlogutils.h"
 #include "catalog/catalog.h"
 #include "miscadmin.h"
+#include "storage/lwlock.h"
 #include "storage/smgr.h"
 #include "utils/guc.h"
 #include "utils/hsearch.h"
@@ -103,6 +105,16 @@ log_invalid_page(RelFileNode node, ForkNumber forkno, BlockNumber blkno,
 	if (log_min_messages <= DEBUG1 || client_min_messages <= DEBUG1)
 		report_invalid_page(DEBUG1, node, forkno, blkno, present);
 
+	/*
+	 * A parallel redo worker passes the reference on to the startup process,
+	 * which replays the records that could resolve it.
+	 */
+	if (IsParallelRedoWorker)
+	{
+		ParallelRedoReportInvalidPage(node, forkno, blkno, present);
+		return;
+	}
+
 	if (invalid_page_tab == NULL)
 	{
 		/* create hash table when first needed */
@@ -204,6 +216,18 @@ forget_invalid_pages_db(Oid dbid)
 	}
 }
 
+/*
+ * Log a reference to an invalid page found by a parallel redo worker.  Only
+ * the startup process calls this.
+ */
+void
+XLogRememberInvalidPage(RelFileNode node, ForkNumber forkno,
+						BlockNumber blkno, bool present)
+{
+	Assert(!IsParallelRedoWorker);
+	log_invalid_page(node, forkno, blkno, present);
+}
+
 /* Are there any unresolved references to invalid pages? */
 bool
 XLogHaveInvalidPages(void)
@@ -472,31 +496,46 @@ XLogReadBufferExtended(RelFileNode rnode, ForkNumber forknum,
 		}
 		if (mode == RBM_NORMAL_NO_LOG)
 			return InvalidBuffer;
-		/* OK to extend the file */
-		/* we do this in recovery only - no rel-extension lock needed */
+		/*
+		 * OK to extend the file.  We do this in recovery only, so there's no
+		 * rel-extension lock, but parallel redo workers might try to extend
+		 * the same relation at the same time; RedoExtensionLock serializes
+		 * them.  Recheck the size once we have it.
+		 */
 		Assert(InRecovery);
-		buffer = InvalidBuffer;
-		do
+		LWLockAcquire(RedoExtensionLock, LW_EXCLUSIVE);
+		if (blkno < smgrnblocks(smgr, forknum))
 		{
-			if (buffer != InvalidBuffer)
+			/* somebody else extended it already */
+			buffer = ReadBufferWithoutRelcache(rnode, forknum, blkno,
+											   mode, NULL);
+		}
+		else
+		{
+			buffer = InvalidBuffer;
+			do
+			{
+				if (buffer != InvalidBuffer)
+				{
+					if (mode == RBM_ZERO_AND_LOCK || mode == RBM_ZERO_AND_CLEANUP_LOCK)
+						LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
+					ReleaseBuffer(buffer);
+				}
+				buffer = ReadBufferWithoutRelcache(rnode, forknum,
+												   P_NEW, mode, NULL);
+			}
+			while (BufferGetBlockNumber(buffer) < blkno);
+			/* Handle the corner case that P_NEW returns non-consecutive pages */
+			if (BufferGetBlockNumber(buffer) != blkno)
 			{
 				if (mode == RBM_ZERO_AND_LOCK || mode == RBM_ZERO_AND_CLEANUP_LOCK)
 					LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
 				ReleaseBuffer(buffer);
+				buffer = ReadBufferWithoutRelcache(rnode, forknum, blkno,
+												   mode, NULL);
 			}
-			buffer = ReadBufferWithoutRelcache(rnode, forknum,
-											   P_NEW, mode, NULL);
-		}
-		while (BufferGetBlockNumber(buffer) < blkno);
-		/* Handle the corner case that P_NEW returns non-consecutive pages */
-		if (BufferGetBlockNumber(buffer) != blkno)
-		{
-			if (mode == RBM_ZERO_AND_LOCK || mode == RBM_ZERO_AND_CLEANUP_LOCK)
-				LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
-			ReleaseBuffer(buffer);
-			buffer = ReadBufferWithoutRelcache(rnode, forknum, blkno,
-											   mode, NULL);
 		}
+		LWLockRelease(RedoExtensionLock);
 	}
 
 	if (mode == RBM_NORMAL)
@@ -109,6 +109,16 @@ static void UpdateIndexRelation(Oid indexoid, Oid heapoid,
 static void index_update_stats(Relation rel,
 				   bool hasindex, bool isprimary,
 				   double reltuples);
+static double IndexBuildHeapScanInternal(Relation heapRelation,
+						   Relation indexRelation,
+						   IndexInfo *indexInfo,
+						   bool allow_sync,
+						   bool anyvisible,
+						   BlockNumber start_blockno,
+						   BlockNumber numblocks,
+						   IndexBuildCallback callback,
+						   void *callback_state,
+						   HeapScanDesc scan);
 static void IndexCheckExclusion(Relation heapRelation,
 					Relation indexRelation,
 					IndexInfo *indexInfo);
@@ -2196,10 +2206,51 @@ IndexBuildHeapRangeScan(Relation heapRelation,
 						BlockNumber numblocks,
 						IndexBuildCallback callback,
 						void *callback_state)
+{
+	return IndexBuildHeapScanInternal(heapRelation, indexRelation, indexInfo,
+									  allow_sync, anyvisible,
+									  start_blockno, numblocks,
+									  callback, callback_state, NULL);
+}
+
+/*
+ * As IndexBuildHeapScan, except that the caller supplies a scan that it has
+ * already begun with heap_beginscan_parallel, and which several processes
+ * may be consuming at once; each process indexes only the blocks it is
+ * handed.  The scan's snapshot must be SnapshotAny for a normal build, or
+ * an MVCC snapshot for a concurrent one.  The scan is ended on return.
+ */
+double
+IndexBuildHeapParallelScan(Relation heapRelation,
+						   Relation indexRelation,
+						   IndexInfo *indexInfo,
+						   HeapScanDesc scan,
+						   IndexBuildCallback callback,
+						   void *callback_state)
+{
+	Assert(scan->rs_parallel != NULL);
+
+	return IndexBuildHeapScanInternal(heapRelation, indexRelation, indexInfo,
+									  true, false,
+									  0, InvalidBlockNumber,
+									  callback, callback_state, scan);
+}
+
+static double
+IndexBuildHeapScanInternal(Relation heapRelation,
+						   Relation indexRelation,
+						   IndexInfo *indexInfo,
+						   bool allow_sync,
+						   bool anyvisible,
+						   BlockNumber start_blockno,
+						   BlockNumber numblocks,
+						   IndexBuildCallback callback,
+						   void *callback_state,
+						   HeapScanDesc scan)
 {
 	bool		is_system_catalog;
 	bool		checking_uniqueness;
-	HeapScanDesc scan;
+	bool		need_unregister_snapshot = false;
 	HeapTuple	heapTuple;
 	Datum		values[INDEX_MAX_KEYS];
 	bool		isnull[INDEX_MAX_KEYS];
@@ -2253,37 +2304,55 @@ IndexBuildHeapRangeScan(Relation heapRelation,
 	 * qual checks (because we have to index RECENTLY_DEAD tuples). In a
 	 * concurrent build, or during bootstrap, we take a regular MVCC snapshot
 	 * and index whatever's live according to that.
+	 *
+	 * A parallel scan has been set up by the caller with the appropriate
+	 * snapshot already; we only need to compute our own OldestXmin.
 	 */
-	if (IsBootstrapProcessingMode() || indexInfo->ii_Concurrent)
+	if (scan != NULL)
 	{
-		snapshot = RegisterSnapshot(GetTransactionSnapshot());
-		OldestXmin = InvalidTransactionId;		/* not used */
-
-		/* "any visible" mode is not compatible with this */
-		Assert(!anyvisible);
+		snapshot = scan->rs_snapshot;
+		Assert(!IsBootstrapProcessingMode());
+		Assert(indexInfo->ii_Concurrent ?
+			   IsMVCCSnapshot(snapshot) : snapshot == SnapshotAny);
+		if (indexInfo->ii_Concurrent)
+			OldestXmin = InvalidTransactionId;	/* not used */
+		else
+			OldestXmin = GetOldestXmin(heapRelation, true);
 	}
 	else
 	{
-		snapshot = SnapshotAny;
-		/* okay to ignore lazy VACUUMs here */
-		OldestXmin = GetOldestXmin(heapRelation, true);
-	}
+		if (IsBootstrapProcessingMode() || indexInfo->ii_Concurrent)
+		{
+			snapshot = RegisterSnapshot(GetTransactionSnapshot());
+			need_unregister_snapshot = true;
+			OldestXmin = InvalidTransactionId;	/* not used */
 
-	scan = heap_beginscan_strat(heapRelation,	/* relation */
-								snapshot,		/* snapshot */
-								0,		/* number of keys */
-								NULL,	/* scan key */
-								true,	/* buffer access strategy OK */
-								allow_sync);	/* syncscan OK? */
+			/* "any visible" mode is not compatible with this */
+			Assert(!anyvisible);
+		}
+		else
+		{
+			snapshot = SnapshotAny;
+			/* okay to ignore lazy VACUUMs here */
+			OldestXmin = GetOldestXmin(heapRelation, true);
+		}
 
-	/* set our scan endpoints */
-	if (!allow_sync)
-		heap_setscanlimits(scan, start_blockno, numblocks);
-	else
-	{
-		/* syncscan can only be requested on whole relation */
-		Assert(start_blockno == 0);
-		Assert(numblocks == InvalidBlockNumber);
+		scan = heap_beginscan_strat(heapRelation,	/* relation */
+									snapshot,	/* snapshot */
+									0,	/* number of keys */
+									NULL,		/* scan key */
+									true,		/* buffer access strategy OK */
+									allow_sync);		/* syncscan OK? */
+
+		/* set our scan endpoints */
+		if (!allow_sync)
+			heap_setscanlimits(scan, start_blockno, numblocks);
+		else
+		{
+			/* syncscan can only be requested on whole relation */
+			Assert(start_blockno == 0);
+			Assert(numblocks == InvalidBlockNumber);
+		}
 	}
 
 	reltuples = 0;
@@ -2605,8 +2674,8 @@ IndexBuildHeapRangeScan(Relation heapRelation,
 
 	heap_endscan(scan);
 
-	/* we can now forget our snapshot, if set */
-	if (IsBootstrapProcessingMode() || indexInfo->ii_Concurrent)
+	/* we can now forget our snapshot, if set and registered by us */
+	if (need_unregister_snapshot)
 		UnregisterSnapshot(snapshot);
 
 	ExecDropSingleTupleTableSlot(slot);
@@ -209,10 +209,13 @@ void
 CatalogTupleUpdate(Relation heapRel, ItemPointer otid, HeapTuple tup)
 {
 	CatalogIndexState indstate;
+	bool		update_summarized;
 
 	indstate = CatalogOpenIndexes(heapRel);
 
-	simple_heap_update(heapRel, otid, tup);
+	simple_heap_update(heapRel, otid, tup, &update_summarized);
+	/* system catalogs have no summarizing indexes */
+	Assert(!update_summarized);
 
 	CatalogIndexInsert(indstate, tup);
 	CatalogCloseIndexes(indstate);
@@ -230,7 +233,11 @@ void
 CatalogTupleUpdateWithInfo(Relation heapRel, ItemPointer otid, HeapTuple tup,
 						   CatalogIndexState indstate)
 {
-	simple_heap_update(heapRel, otid, tup);
+	bool		update_summarized;
+
+	simple_heap_update(heapRel, otid, tup, &update_summarized);
+	/* system catalogs have no summarizing indexes */
+	Assert(!update_summarized);
 
 	CatalogIndexInsert(indstate, tup);
 }
@@ -465,6 +465,9 @@ CREATE VIEW pg_hba_file_rules AS
 REVOKE ALL on pg_hba_file_rules FROM PUBLIC;
 REVOKE EXECUTE ON FUNCTION pg_hba_file_rules() FROM PUBLIC;
 
+CREATE VIEW pg_shmem_numa AS
+   SELECT * FROM pg_get_shmem_numa() AS A;
+
 CREATE VIEW pg_timezone_abbrevs AS
     SELECT * FROM pg_timezone_abbrevs();
 
@@ -723,6 +726,15 @@ CREATE VIEW pg_stat_wal_receiver AS
     FROM pg_stat_get_wal_receiver() s
     WHERE s.pid IS NOT NULL;
 
+CREATE VIEW pg_stat_recovery_prefetch AS
+    SELECT
+            s.prefetch,
+            s.hit,
+            s.skip_fpw,
+            s.skip_repeat,
+            s.wal_distance
+    FROM pg_stat_get_recovery_prefetch() s;
+
 CREATE VIEW pg_stat_subscription AS
     SELECT
             su.oid AS subid,
@@ -789,6 +801,17 @@ CREATE VIEW pg_stat_database AS
             pg_stat_get_db_stat_reset_time(D.oid) AS stats_reset
     FROM pg_database D;
 
+CREATE VIEW pg_stat_buffer_replacement AS
+    SELECT
+        current_setting('buffer_replacement_policy') AS policy,
+        (SELECT sum(blks_hit) FROM pg_stat_database) AS blks_hit,
+        (SELECT sum(blks_read) FROM pg_stat_database) AS blks_read,
+        s.evictions,
+        s.probation_evictions,
+        s.promotions,
+        s.clean_evictions
+    FROM pg_stat_get_buffer_replacement() s;
+
 CREATE VIEW pg_stat_database_conflicts AS
     SELECT
             D.oid AS datid,
@@ -847,6 +870,10 @@ CREATE VIEW pg_stat_bgwriter AS
         pg_stat_get_buf_written_backend() AS buffers_backend,
         pg_stat_get_buf_fsync_backend() AS buffers_backend_fsync,
         pg_stat_get_buf_alloc() AS buffers_alloc,
+        pg_stat_get_checkpoint_sync_percentile(0.5) AS checkpoint_sync_p50,
+        pg_stat_get_checkpoint_sync_percentile(0.9) AS checkpoint_sync_p90,
+        pg_stat_get_checkpoint_sync_percentile(0.99) AS checkpoint_sync_p99,
+        pg_stat_get_checkpoint_sync_max() AS checkpoint_sync_max,
         pg_stat_get_bgwriter_stat_reset_time() AS stats_reset;
 
 CREATE VIEW pg_stat_progress_vacuum AS
@@ -58,6 +58,15 @@ int			vacuum_freeze_min_age;
 int			vacuum_freeze_table_age;
 int			vacuum_multixact_freeze_min_age;
 int			vacuum_multixact_freeze_table_age;
+bool		vacuum_eager_freeze = false;
+
+/*
+ * Cost-based delay state shared by the processes of a parallel vacuum, or
+ * NULL when not in one.  See compute_parallel_delay.
+ */
+pg_atomic_uint32 *VacuumSharedCostBalance = NULL;
+pg_atomic_uint32 *VacuumActiveNWorkers = NULL;
+int			VacuumCostBalanceLocal = 0;
 
 
 /* A few variables that don't seem worth passing around as parameters */
@@ -73,6 +82,7 @@ static void vac_truncate_clog(TransactionId frozenXID,
 				  MultiXactId lastSaneMinMulti);
 static bool vacuum_rel(Oid relid, RangeVar *relation, int options,
 		   VacuumParams *params);
+static int	compute_parallel_delay(void);
 
 /*
  * Primary entry point for manual VACUUM and ANALYZE commands
@@ -117,6 +127,8 @@ ExecVacuum(VacuumStmt *vacstmt, bool isTopLevel)
 	/* user-invoked vacuum never uses this parameter */
 	params.log_min_duration = -1;
 
+	params.nworkers = vacstmt->nworkers;
+
 	/* Now go through the common routine */
 	vacuum(vacstmt->options, vacstmt->relation, InvalidOid, &params,
 		   vacstmt->va_cols, NULL, isTopLevel);
@@ -194,6 +206,14 @@ vacuum(int options, RangeVar *relation, Oid relid, VacuumParams *params,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("VACUUM option DISABLE_PAGE_SKIPPING cannot be used with FULL")));
 
+	/*
+	 * Likewise the PARALLEL option, which only lazy vacuum implements.
+	 */
+	if ((options & VACOPT_FULL) != 0 && params->nworkers > 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("VACUUM option PARALLEL cannot be used with FULL")));
+
 	/*
 	 * Send info about dead objects to the statistics collector, unless we are
 	 * in autovacuum --- autovacuum.c does this for itself.
@@ -287,6 +307,8 @@ vacuum(int options, RangeVar *relation, Oid relid, VacuumParams *params,
 		in_vacuum = true;
 		VacuumCostActive = (VacuumCostDelay > 0);
 		VacuumCostBalance = 0;
+		VacuumSharedCostBalance = NULL;
+		VacuumActiveNWorkers = NULL;
 		VacuumPageHit = 0;
 		VacuumPageMiss = 0;
 		VacuumPageDirty = 0;
@@ -332,6 +354,8 @@ vacuum(int options, RangeVar *relation, Oid relid, VacuumParams *params,
 	{
 		in_vacuum = false;
 		VacuumCostActive = false;
+		VacuumSharedCostBalance = NULL;
+		VacuumActiveNWorkers = NULL;
 		PG_RE_THROW();
 	}
 	PG_END_TRY();
@@ -1514,16 +1538,22 @@ vac_close_indexes(int nindexes, Relation *Irel, LOCKMODE lockmode)
 void
 vacuum_delay_point(void)
 {
+	int			msec = 0;
+
 	/* Always check for interrupts */
 	CHECK_FOR_INTERRUPTS();
 
-	/* Nap if appropriate */
-	if (VacuumCostActive && !InterruptPending &&
-		VacuumCostBalance >= VacuumCostLimit)
-	{
-		int			msec;
+	if (!VacuumCostActive || InterruptPending)
+		return;
 
+	/* Nap if appropriate */
+	if (VacuumSharedCostBalance != NULL)
+		msec = compute_parallel_delay();
+	else if (VacuumCostBalance >= VacuumCostLimit)
 		msec = VacuumCostDelay * VacuumCostBalance / VacuumCostLimit;
+
+	if (msec > 0)
+	{
 		if (msec > VacuumCostDelay * 4)
 			msec = VacuumCostDelay * 4;
 
@@ -1538,3 +1568,42 @@ vacuum_delay_point(void)
 		CHECK_FOR_INTERRUPTS();
 	}
 }
+
+/*
+ * compute_parallel_delay --- cost-based delay for a parallel vacuum process
+ *
+ * The leader and workers of a parallel vacuum add the cost they incur to a
+ * shared balance, so that together they stay within VacuumCostLimit.  Once
+ * the shared balance reaches the limit, a process sleeps if it has done more
+ * than half of its fair share of the I/O behind it, for a time proportional
+ * to its own part, which it then takes off the shared balance.  Processes
+ * doing little I/O therefore aren't held up by the ones doing a lot.
+ *
+ * Returns the time to sleep in milliseconds, or 0 for none.
+ */
+static int
+compute_parallel_delay(void)
+{
+	int			msec = 0;
+	uint32		shared_balance;
+	int			nworkers;
+
+	/* Count ourselves, even if we haven't registered yet */
+	nworkers = Max(pg_atomic_read_u32(VacuumActiveNWorkers), 1);
+
+	shared_balance = pg_atomic_add_fetch_u32(VacuumSharedCostBalance,
+											 VacuumCostBalance);
+	VacuumCostBalanceLocal += VacuumCostBalance;
+	VacuumCostBalance = 0;
+
+	if (shared_balance >= VacuumCostLimit &&
+		VacuumCostBalanceLocal > 0.5 * ((double) VacuumCostLimit / nworkers))
+	{
+		msec = VacuumCostDelay * VacuumCostBalanceLocal / VacuumCostLimit;
+		pg_atomic_sub_fetch_u32(VacuumSharedCostBalance,
+								VacuumCostBalanceLocal);
+		VacuumCostBalanceLocal = 0;
+	}
+
+	return msec;
+}
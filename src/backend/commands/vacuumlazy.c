@@ -4,24 +4,34 @@
  *	  Concurrent ("lazy") vacuuming.
  *
  *
- * The major space usage for LAZY VACUUM is storage for the array of dead
- * tuple TIDs, with the next biggest need being storage for per-disk-page
- * free space info.  We want to ensure we can vacuum even the very largest
- * relations with finite memory space usage.  To do that, we set upper bounds
- * on the number of tuples and pages we will keep track of at once.
+ * The major space usage for LAZY VACUUM is storage for the dead tuple TIDs,
+ * with the next biggest need being storage for per-disk-page free space
+ * info.  We want to ensure we can vacuum even the very largest relations
+ * with finite memory space usage.  To do that, we set upper bounds on the
+ * number of tuples and pages we will keep track of at once.
  *
  * We are willing to use at most maintenance_work_mem (or perhaps
  * autovacuum_work_mem) memory space to keep track of dead tuples.  We
- * initially allocate an array of TIDs of that size, with an upper limit that
- * depends on table size (this limit ensures we don't allocate a huge area
- * uselessly for vacuuming small tables).  If the array threatens to overflow,
- * we suspend the heap scan phase and perform a pass of index cleanup and page
- * compaction, then resume the heap scan with an empty TID array.
+ * initially allocate a dead tuple store of that size, with an upper limit
+ * that depends on table size (this limit ensures we don't allocate a huge
+ * area uselessly for vacuuming small tables).  If the store threatens to
+ * overflow, we suspend the heap scan phase and perform a pass of index
+ * cleanup and page compaction, then resume the heap scan with an empty store.
+ *
+ * The store keeps the dead tuples of each heap page together, as either a
+ * list or a bitmap of their offset numbers, so a page full of dead tuples
+ * takes only a few bytes per tuple rather than six; see lazy_space_alloc.
+ * It isn't subject to the 1GB limit on ordinary allocations either, so that
+ * a large maintenance_work_mem can usually cover a whole vacuum.
+ *
+ * When parallel workers are to help with the indexes, the store is put in
+ * a dynamic shared memory segment instead, where they can read it; see
+ * begin_parallel_vacuum.
  *
  * If we're processing a table with no indexes, we can just vacuum each page
  * as we go; there's no need to save up multiple tuples to minimize the number
  * of index scans performed.  So we don't use maintenance_work_mem memory for
- * the TID array, just enough to hold as many heap tuples as fit on one page.
+ * the store, just enough to hold the dead tuples of one page.
  *
  *
  * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
@@ -42,8 +52,10 @@
 #include "access/heapam_xlog.h"
 #include "access/htup_details.h"
 #include "access/multixact.h"
+#include "access/parallel.h"
 #include "access/transam.h"
 #include "access/visibilitymap.h"
+#include "access/xact.h"
 #include "access/xlog.h"
 #include "catalog/catalog.h"
 #include "catalog/storage.h"
@@ -57,6 +69,7 @@
 #include "storage/bufmgr.h"
 #include "storage/freespace.h"
 #include "storage/lmgr.h"
+#include "storage/proc.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
@@ -74,6 +87,12 @@
 #define REL_TRUNCATE_MINIMUM	1000
 #define REL_TRUNCATE_FRACTION	16
 
+/*
+ * To bypass index vacuuming, fewer than BYPASS_THRESHOLD_PAGES of the heap's
+ * pages may have dead tuples; see should_bypass_index_vacuum.
+ */
+#define BYPASS_THRESHOLD_PAGES	0.02	/* i.e. 2% of rel_pages */
+
 /*
  * Timing parameters for truncate locking heuristics.
  *
@@ -86,11 +105,39 @@
 #define VACUUM_TRUNCATE_LOCK_TIMEOUT			5000	/* ms */
 
 /*
- * Guesstimation of number of dead tuples per page.  This is used to
- * provide an upper limit to memory allocated when vacuuming small
- * tables.
+ * The dead tuple store consists of a directory of the heap pages with dead
+ * tuples, in block number order, and a data area holding each page's offset
+ * numbers.  The directory grows upwards from the start of the allocated
+ * space and the data area downwards from its end.
+ *
+ * A page with a single dead tuple keeps its offset number right in its
+ * directory entry.  For other pages, the entry gives the location of the
+ * page's data, in units of LVDB_UNIT bytes from the start of the space.  The
+ * data starts with a uint16 header: either the number of offset numbers that
+ * follow, in ascending order, or, with LVDB_BITMAP set, the length of the
+ * bitmap that follows, in which bit N-1 stands for offset number N.  We use
+ * whichever is smaller.
  */
-#define LAZY_ALLOC_TUPLES		MaxHeapTuplesPerPage
+typedef struct LVDeadBlock
+{
+	BlockNumber blkno;			/* heap page */
+	uint32		data;			/* data location, or LVDB_SINGLE | offnum */
+} LVDeadBlock;
+
+#define LVDB_SINGLE				0xFFFF0000
+#define LVDB_BITMAP				0x8000
+#define LVDB_UNIT				8
+
+#define LVDB_IS_SINGLE(data)	(((data) & LVDB_SINGLE) == LVDB_SINGLE)
+
+/*
+ * Most space the store can need for one heap page.  Every page must be able
+ * to record this much; this is also the upper limit on memory allocated for
+ * each page when vacuuming small tables.
+ */
+#define LAZY_DEAD_BLOCK_MAX_SPACE \
+	(sizeof(LVDeadBlock) + \
+	 TYPEALIGN(LVDB_UNIT, sizeof(uint16) + (MaxHeapTuplesPerPage + 7) / 8))
 
 /*
  * Before we consider skipping a page that's marked as clean in
@@ -114,6 +161,9 @@ typedef struct LVRelStats
 	BlockNumber scanned_pages;	/* number of pages we examined */
 	BlockNumber pinskipped_pages;		/* # of pages we skipped due to a pin */
 	BlockNumber frozenskipped_pages;	/* # of frozen pages we skipped */
+	BlockNumber eager_scan_pages;	/* # of all-visible pages we may still
+									 * scan just to freeze them */
+	BlockNumber eagerfrozen_pages;	/* # of pages we froze early */
 	double		scanned_tuples; /* counts only tuples on scanned pages */
 	double		old_rel_tuples; /* previous value of pg_class.reltuples */
 	double		new_rel_tuples; /* new estimated total # of tuples */
@@ -121,16 +171,75 @@ typedef struct LVRelStats
 	BlockNumber pages_removed;
 	double		tuples_deleted;
 	BlockNumber nonempty_pages; /* actually, last nonempty page + 1 */
-	/* List of TIDs of tuples we intend to delete */
-	/* NB: this list is ordered by TID address */
-	int			num_dead_tuples;	/* current # of entries */
-	int			max_dead_tuples;	/* # slots allocated in array */
-	ItemPointer dead_tuples;	/* array of ItemPointerData */
+	/* Store of TIDs of tuples we intend to delete, see LVDeadBlock */
+	/* NB: this is ordered by TID address */
+	int64		num_dead_tuples;	/* current # of tuples */
+	int64		num_unpruned_tuples;	/* # of those still having storage */
+	int64		max_dead_tuples;	/* # of tuples that surely fit */
+	char	   *dead_space;		/* space for the store */
+	Size		dead_space_size;	/* size of dead_space */
+	BlockNumber num_dead_blocks;	/* # of directory entries */
+	Size		dead_data_start;	/* start of the data area */
+	BlockNumber dead_lookup_hint;	/* entry found by last lookup */
 	int			num_index_scans;
 	TransactionId latestRemovedXid;
 	bool		lock_waiter_detected;
 } LVRelStats;
 
+/*
+ * Parallel index vacuuming.  When the VACUUM command or autovacuum asks for
+ * parallel workers and the table has more than one index, the dead tuple
+ * store is put in a dynamic shared memory segment, and each round of index
+ * vacuuming or cleanup is divided between the leader and the workers.  Each
+ * index is processed entirely by whichever process claims it first.  That
+ * matters, because group locking would let two members of the group extend
+ * the same index at once.  The heap itself is only ever touched by the
+ * leader.
+ *
+ * The segment holding the dead tuple store lives for the whole vacuum, but
+ * a parallel context, and parallel mode, are only set up for each round of
+ * index processing; the heap passes run under the normal rules.
+ *
+ * The participants share a single cost-based delay balance, so that a
+ * parallel vacuum as a whole stays within vacuum_cost_limit (or the share of
+ * autovacuum_vacuum_cost_limit that autovacuum balanced to the leader),
+ * rather than each process doing that much I/O.  See vacuum_delay_point.
+ */
+#define PARALLEL_VACUUM_KEY_SHARED		1
+
+/* Statistics of one index, handed between leader and workers */
+typedef struct LVIndStats
+{
+	bool		valid;			/* does stats hold anything yet? */
+	IndexBulkDeleteResult stats;
+} LVIndStats;
+
+typedef struct LVShared
+{
+	Oid			relid;			/* table being vacuumed */
+	int			elevel;
+	uint8		vacuum_flags;	/* leader's PGXACT->vacuumFlags */
+	int			cost_delay;		/* leader's VacuumCostDelay */
+	int			cost_limit;		/* leader's VacuumCostLimit */
+	pg_atomic_uint32 cost_balance;	/* shared VacuumCostBalance */
+	pg_atomic_uint32 active_nworkers;	/* # of processes doing indexes */
+	bool		for_cleanup;	/* amvacuumcleanup rather than ambulkdelete? */
+	dsm_handle	dead_space_handle;	/* segment holding dead tuple store */
+	LVRelStats	vacrelstats;	/* leader's, except that dead_space is not
+								 * valid in workers */
+	pg_atomic_uint32 nextindex; /* next index to claim */
+	int			nindexes;
+	LVIndStats	indstats[FLEXIBLE_ARRAY_MEMBER];
+} LVShared;
+
+typedef struct LVParallelState
+{
+	Oid			relid;			/* table being vacuumed */
+	int			nrequested;		/* # of workers to ask for in each round */
+	dsm_segment *seg;			/* segment holding the dead tuple store */
+	char	   *dead_space;		/* dead tuple store in the segment */
+} LVParallelState;
+
 
 /* A few variables that don't seem worth passing around as parameters */
 static int	elevel = -1;
@@ -145,26 +254,55 @@ static BufferAccessStrategy vac_strategy;
 /* non-export function prototypes */
 static void lazy_scan_heap(Relation onerel, int options,
 			   LVRelStats *vacrelstats, Relation *Irel, int nindexes,
-			   bool aggressive);
+			   bool aggressive, int nworkers);
 static void lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats);
 static bool lazy_check_needs_freeze(Buffer buf, bool *hastup);
 static void lazy_vacuum_index(Relation indrel,
 				  IndexBulkDeleteResult **stats,
-				  LVRelStats *vacrelstats);
-static void lazy_cleanup_index(Relation indrel,
+				  LVRelStats *vacrelstats, bool report);
+static IndexBulkDeleteResult *lazy_cleanup_index(Relation indrel,
 				   IndexBulkDeleteResult *stats,
-				   LVRelStats *vacrelstats);
+				   LVRelStats *vacrelstats, bool report);
+static void lazy_report_index(Relation indrel, IndexBulkDeleteResult *stats,
+				  LVRelStats *vacrelstats, bool for_cleanup,
+				  PGRUsage *ru0);
+static void lazy_update_index_stats(Relation indrel,
+						IndexBulkDeleteResult *stats);
+static void lazy_vacuum_all_indexes(Relation *Irel,
+						IndexBulkDeleteResult **stats,
+						LVRelStats *vacrelstats, int nindexes,
+						LVParallelState *lps);
+static LVParallelState *begin_parallel_vacuum(Relation onerel, int nindexes,
+					  int nrequested, Size space);
+static void end_parallel_vacuum(LVParallelState *lps);
+static void lazy_parallel_vacuum_indexes(Relation *Irel,
+							 IndexBulkDeleteResult **stats,
+							 LVRelStats *vacrelstats, int nindexes,
+							 LVParallelState *lps, bool for_cleanup);
+static void lazy_vacuum_claimed_indexes(Relation *Irel, int nindexes,
+							LVShared *lvshared, LVRelStats *vacrelstats);
+static void lazy_parallel_vacuum_main(dsm_segment *seg, shm_toc *toc);
 static int lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer);
+				 BlockNumber blockindex, LVRelStats *vacrelstats,
+				 Buffer *vmbuffer);
+static BlockNumber lazy_eager_scan_budget(Relation onerel,
+					   TransactionId xidFullScanLimit);
+static bool should_bypass_index_vacuum(LVRelStats *vacrelstats);
 static bool should_attempt_truncation(LVRelStats *vacrelstats);
 static void lazy_truncate_heap(Relation onerel, LVRelStats *vacrelstats);
 static BlockNumber count_nondeletable_pages(Relation onerel,
 						 LVRelStats *vacrelstats);
-static void lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks);
-static void lazy_record_dead_tuple(LVRelStats *vacrelstats,
-					   ItemPointer itemptr);
+static Size lazy_space_needed(LVRelStats *vacrelstats, BlockNumber relblocks);
+static void lazy_space_alloc(LVRelStats *vacrelstats, Size space,
+				 char *dead_space);
+static void lazy_record_dead_tuples(LVRelStats *vacrelstats,
+						BlockNumber blkno, OffsetNumber *offsets,
+						int noffsets);
+static void lazy_forget_dead_tuples(LVRelStats *vacrelstats);
+static bool lazy_dead_tuples_full(LVRelStats *vacrelstats);
+static int lazy_dead_block_offsets(LVRelStats *vacrelstats,
+						BlockNumber blockindex, OffsetNumber *offsets);
 static bool lazy_tid_reaped(ItemPointer itemptr, void *state);
-static int	vac_cmp_itemptr(const void *left, const void *right);
 static bool heap_page_is_all_visible(Relation rel, Buffer buf,
 					 TransactionId *visibility_cutoff_xid, bool *all_frozen);
 
@@ -250,12 +388,22 @@ lazy_vacuum_rel(Relation onerel, int options, VacuumParams *params,
 	vacrelstats->pages_removed = 0;
 	vacrelstats->lock_waiter_detected = false;
 
+	/*
+	 * Unless this is an aggressive vacuum anyway, plan to scan some of the
+	 * pages that are all-visible but not all-frozen, and freeze them.
+	 */
+	if (vacuum_eager_freeze && !aggressive &&
+		(options & VACOPT_DISABLE_PAGE_SKIPPING) == 0)
+		vacrelstats->eager_scan_pages =
+			lazy_eager_scan_budget(onerel, xidFullScanLimit);
+
 	/* Open all indexes of the relation */
 	vac_open_indexes(onerel, RowExclusiveLock, &nindexes, &Irel);
 	vacrelstats->hasindex = (nindexes > 0);
 
 	/* Do the vacuuming */
-	lazy_scan_heap(onerel, options, vacrelstats, Irel, nindexes, aggressive);
+	lazy_scan_heap(onerel, options, vacrelstats, Irel, nindexes, aggressive,
+				   params->nworkers);
 
 	/* Done with indexes */
 	vac_close_indexes(nindexes, Irel, NoLock);
@@ -374,11 +522,12 @@ lazy_vacuum_rel(Relation onerel, int options, VacuumParams *params,
 							 get_namespace_name(RelationGetNamespace(onerel)),
 							 RelationGetRelationName(onerel),
 							 vacrelstats->num_index_scans);
-			appendStringInfo(&buf, _("pages: %u removed, %u remain, %u skipped due to pins, %u skipped frozen\n"),
+			appendStringInfo(&buf, _("pages: %u removed, %u remain, %u skipped due to pins, %u skipped frozen, %u frozen early\n"),
 							 vacrelstats->pages_removed,
 							 vacrelstats->rel_pages,
 							 vacrelstats->pinskipped_pages,
-							 vacrelstats->frozenskipped_pages);
+							 vacrelstats->frozenskipped_pages,
+							 vacrelstats->eagerfrozen_pages);
 			appendStringInfo(&buf,
 							 _("tuples: %.0f removed, %.0f remain, %.0f are dead but not yet removable\n"),
 							 vacrelstats->tuples_deleted,
@@ -448,10 +597,13 @@ vacuum_log_cleanup_info(Relation rel, LVRelStats *vacrelstats)
  *		If there are no indexes then we can reclaim line pointers on the fly;
  *		dead line pointers need only be retained until all index pointers that
  *		reference them have been killed.
+ *
+ *		nworkers is the number of parallel workers requested for index
+ *		vacuuming, or 0.
  */
 static void
 lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
-			   Relation *Irel, int nindexes, bool aggressive)
+			   Relation *Irel, int nindexes, bool aggressive, int nworkers)
 {
 	BlockNumber nblocks,
 				blkno;
@@ -464,12 +616,18 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 				nkeep,
 				nunused;
 	IndexBulkDeleteResult **indstats;
+	LVParallelState *lps = NULL;
+	bool		bypass_indexes;
+	Size		space;
 	int			i;
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
 	BlockNumber next_unskippable_block;
+	bool		next_unskippable_eager = false;
 	bool		skipping_blocks;
 	xl_heap_freeze_tuple *frozen;
+	OffsetNumber deadoffsets[MaxHeapTuplesPerPage];
+	int			ndeadoffsets;
 	StringInfoData buf;
 	const int	initprog_index[] = {
 		PROGRESS_VACUUM_PHASE,
@@ -498,7 +656,18 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	vacrelstats->nonempty_pages = 0;
 	vacrelstats->latestRemovedXid = InvalidTransactionId;
 
-	lazy_space_alloc(vacrelstats, nblocks);
+	/*
+	 * Set up parallel index vacuuming if requested, and if there's more than
+	 * one index to share out.  Parallel workers can't see the leader's local
+	 * buffers, so temporary tables are always done serially.  Without
+	 * dynamic shared memory, there can be no workers.
+	 */
+	space = lazy_space_needed(vacrelstats, nblocks);
+	if (nworkers > 0 && nindexes > 1 && !RelationUsesLocalBuffers(onerel) &&
+		IsUnderPostmaster && dynamic_shared_memory_type != DSM_IMPL_NONE)
+		lps = begin_parallel_vacuum(onerel, nindexes,
+									Min(nworkers, nindexes - 1), space);
+	lazy_space_alloc(vacrelstats, space, lps ? lps->dead_space : NULL);
 	frozen = palloc(sizeof(xl_heap_freeze_tuple) * MaxHeapTuplesPerPage);
 
 	/* Report that we're scanning the heap, advertising total # of blocks */
@@ -569,6 +738,13 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			{
 				if ((vmstatus & VISIBILITYMAP_ALL_VISIBLE) == 0)
 					break;
+				if ((vmstatus & VISIBILITYMAP_ALL_FROZEN) == 0 &&
+					vacrelstats->eager_scan_pages > 0)
+				{
+					vacrelstats->eager_scan_pages--;
+					next_unskippable_eager = true;
+					break;
+				}
 			}
 			vacuum_delay_point();
 			next_unskippable_block++;
@@ -588,14 +764,17 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 					maxoff;
 		bool		tupgone,
 					hastup;
-		int			prev_dead_count;
+		int64		prev_dead_count;
 		int			nfrozen;
 		Size		freespace;
 		bool		all_visible_according_to_vm = false;
 		bool		all_visible;
 		bool		all_frozen = true;	/* provided all_visible is also true */
 		bool		has_dead_tuples;
+		bool		eager_scan = false;
+		int			npruned;
 		TransactionId visibility_cutoff_xid = InvalidTransactionId;
+		TransactionId freeze_cutoff_xid = FreezeLimit;
 
 		/* see note above about forcing scanning of last page */
 #define FORCE_CHECK_PAGE() \
@@ -605,6 +784,9 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 
 		if (blkno == next_unskippable_block)
 		{
+			eager_scan = next_unskippable_eager;
+			next_unskippable_eager = false;
+
 			/* Time to advance next_unskippable_block */
 			next_unskippable_block++;
 			if ((options & VACOPT_DISABLE_PAGE_SKIPPING) == 0)
@@ -625,6 +807,13 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 					{
 						if ((vmskipflags & VISIBILITYMAP_ALL_VISIBLE) == 0)
 							break;
+						if ((vmskipflags & VISIBILITYMAP_ALL_FROZEN) == 0 &&
+							vacrelstats->eager_scan_pages > 0)
+						{
+							vacrelstats->eager_scan_pages--;
+							next_unskippable_eager = true;
+							break;
+						}
 					}
 					vacuum_delay_point();
 					next_unskippable_block++;
@@ -644,9 +833,11 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			/*
 			 * Normally, the fact that we can't skip this block must mean that
 			 * it's not all-visible.  But in an aggressive vacuum we know only
-			 * that it's not all-frozen, so it might still be all-visible.
+			 * that it's not all-frozen, so it might still be all-visible; and
+			 * we scan some all-visible blocks just to freeze them.
 			 */
-			if (aggressive && VM_ALL_VISIBLE(onerel, blkno, &vmbuffer))
+			if ((aggressive || eager_scan) &&
+				VM_ALL_VISIBLE(onerel, blkno, &vmbuffer))
 				all_visible_according_to_vm = true;
 		}
 		else
@@ -683,8 +874,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 * If we are close to overrunning the available space for dead-tuple
 		 * TIDs, pause and do a cycle of vacuuming before we tackle this page.
 		 */
-		if ((vacrelstats->max_dead_tuples - vacrelstats->num_dead_tuples) < MaxHeapTuplesPerPage &&
-			vacrelstats->num_dead_tuples > 0)
+		if (lazy_dead_tuples_full(vacrelstats))
 		{
 			const int	hvp_index[] = {
 				PROGRESS_VACUUM_PHASE,
@@ -712,10 +902,8 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 										 PROGRESS_VACUUM_PHASE_VACUUM_INDEX);
 
 			/* Remove index entries */
-			for (i = 0; i < nindexes; i++)
-				lazy_vacuum_index(Irel[i],
-								  &indstats[i],
-								  vacrelstats);
+			lazy_vacuum_all_indexes(Irel, indstats, vacrelstats, nindexes,
+									lps);
 
 			/*
 			 * Report that we are now vacuuming the heap.  We also increase
@@ -735,7 +923,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
-			vacrelstats->num_dead_tuples = 0;
+			lazy_forget_dead_tuples(vacrelstats);
 			vacrelstats->num_index_scans++;
 
 			/* Report that we are once again scanning the heap */
@@ -906,8 +1094,9 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 *
 		 * We count tuples removed by the pruning step as removed by VACUUM.
 		 */
-		tups_vacuumed += heap_page_prune(onerel, buf, OldestXmin, false,
-										 &vacrelstats->latestRemovedXid);
+		npruned = heap_page_prune(onerel, buf, OldestXmin, false,
+								  &vacrelstats->latestRemovedXid);
+		tups_vacuumed += npruned;
 
 		/*
 		 * Now scan the page to collect vacuumable items and check for tuples
@@ -917,6 +1106,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		has_dead_tuples = false;
 		nfrozen = 0;
 		hastup = false;
+		ndeadoffsets = 0;
 		prev_dead_count = vacrelstats->num_dead_tuples;
 		maxoff = PageGetMaxOffsetNumber(page);
 
@@ -956,7 +1146,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			 */
 			if (ItemIdIsDead(itemid))
 			{
-				lazy_record_dead_tuple(vacrelstats, &(tuple.t_self));
+				deadoffsets[ndeadoffsets++] = offnum;
 				all_visible = false;
 				continue;
 			}
@@ -1061,9 +1251,10 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 
 			if (tupgone)
 			{
-				lazy_record_dead_tuple(vacrelstats, &(tuple.t_self));
+				deadoffsets[ndeadoffsets++] = offnum;
 				HeapTupleHeaderAdvanceLatestRemovedXid(tuple.t_data,
 											 &vacrelstats->latestRemovedXid);
+				vacrelstats->num_unpruned_tuples += 1;
 				tups_vacuumed += 1;
 				has_dead_tuples = true;
 			}
@@ -1088,6 +1279,61 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			}
 		}						/* scan along page */
 
+		/* Remember the dead tuples we found */
+		if (ndeadoffsets > 0)
+			lazy_record_dead_tuples(vacrelstats, blkno, deadoffsets,
+									ndeadoffsets);
+
+		/*
+		 * If every tuple on the page is visible to everyone, but some are too
+		 * young for FreezeLimit, consider freezing them all anyway, so that
+		 * the page can be marked all-frozen and an aggressive vacuum need not
+		 * visit it again.  We do that if we're about to dirty the page
+		 * regardless, by pruning, freezing or marking it all-visible, since
+		 * then the extra cost is only a small WAL record; and on pages we
+		 * scanned precisely to freeze them.
+		 *
+		 * This is just what VACUUM FREEZE does, with OldestXmin as the cutoff.
+		 * But the freezing only needs to conflict with hot standby queries
+		 * that can't see the newest xmin being frozen, the same ones that
+		 * marking the page all-visible conflicts with.
+		 */
+		if (all_visible && !all_frozen &&
+			(eager_scan ||
+			 (vacuum_eager_freeze &&
+			  (npruned > 0 || nfrozen > 0 || !PageIsAllVisible(page)))))
+		{
+			nfrozen = 0;
+			all_frozen = true;
+			for (offnum = FirstOffsetNumber;
+				 offnum <= maxoff;
+				 offnum = OffsetNumberNext(offnum))
+			{
+				ItemId		itemid = PageGetItemId(page, offnum);
+				bool		tuple_totally_frozen;
+
+				if (!ItemIdIsNormal(itemid))
+					continue;
+
+				if (heap_prepare_freeze_tuple((HeapTupleHeader) PageGetItem(page, itemid),
+											  OldestXmin, MultiXactCutoff,
+											  &frozen[nfrozen],
+											  &tuple_totally_frozen))
+					frozen[nfrozen++].offset = offnum;
+
+				if (!tuple_totally_frozen)
+					all_frozen = false;
+			}
+
+			if (TransactionIdIsNormal(visibility_cutoff_xid))
+			{
+				freeze_cutoff_xid = visibility_cutoff_xid;
+				TransactionIdAdvance(freeze_cutoff_xid);
+			}
+			if (all_frozen)
+				vacrelstats->eagerfrozen_pages++;
+		}
+
 		/*
 		 * If we froze any tuples, mark the buffer dirty, and write a WAL
 		 * record recording the changes.  We must log the changes to be
@@ -1116,7 +1362,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			{
 				XLogRecPtr	recptr;
 
-				recptr = log_heap_freeze(onerel, buf, FreezeLimit,
+				recptr = log_heap_freeze(onerel, buf, freeze_cutoff_xid,
 										 frozen, nfrozen);
 				PageSetLSN(page, recptr);
 			}
@@ -1140,7 +1386,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
-			vacrelstats->num_dead_tuples = 0;
+			lazy_forget_dead_tuples(vacrelstats);
 			vacuumed_pages++;
 		}
 
@@ -1272,9 +1518,20 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		vmbuffer = InvalidBuffer;
 	}
 
-	/* If any tuples need to be deleted, perform final vacuum cycle */
-	/* XXX put a threshold on min number of tuples here? */
-	if (vacrelstats->num_dead_tuples > 0)
+	/*
+	 * If any tuples need to be deleted, perform final vacuum cycle, unless
+	 * there are so few that it's better to leave them for a later VACUUM.
+	 * We never bypass while some of them still have storage, so then
+	 * tups_vacuumed counts only the tuples that pruning really removed.
+	 */
+	bypass_indexes = should_bypass_index_vacuum(vacrelstats);
+	if (bypass_indexes)
+		ereport(elevel,
+				(errmsg("\"%s\": bypassing index vacuuming, %u of %u pages have " INT64_FORMAT " dead row versions",
+						RelationGetRelationName(onerel),
+						vacrelstats->num_dead_blocks, nblocks,
+						vacrelstats->num_dead_tuples)));
+	else if (vacrelstats->num_dead_tuples > 0)
 	{
 		const int	hvp_index[] = {
 			PROGRESS_VACUUM_PHASE,
@@ -1290,10 +1547,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 									 PROGRESS_VACUUM_PHASE_VACUUM_INDEX);
 
 		/* Remove index entries */
-		for (i = 0; i < nindexes; i++)
-			lazy_vacuum_index(Irel[i],
-							  &indstats[i],
-							  vacrelstats);
+		lazy_vacuum_all_indexes(Irel, indstats, vacrelstats, nindexes, lps);
 
 		/* Report that we are now vacuuming the heap */
 		hvp_val[0] = PROGRESS_VACUUM_PHASE_VACUUM_HEAP;
@@ -1312,9 +1566,31 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	pgstat_progress_update_param(PROGRESS_VACUUM_PHASE,
 								 PROGRESS_VACUUM_PHASE_INDEX_CLEANUP);
 
-	/* Do post-vacuum cleanup and statistics update for each index */
+	/*
+	 * Do post-vacuum cleanup for each index.  We do that even if we bypassed
+	 * index vacuuming, just as when there were no dead tuples at all: some
+	 * AMs do real work there, such as flushing GIN's pending list or
+	 * summarizing new BRIN ranges, and it keeps the index statistics current.
+	 */
+	if (lps)
+	{
+		lazy_parallel_vacuum_indexes(Irel, indstats, vacrelstats,
+									 nindexes, lps, true);
+
+		/* The dead tuple store goes away with the segment */
+		end_parallel_vacuum(lps);
+		vacrelstats->dead_space = NULL;
+	}
+	else
+	{
+		for (i = 0; i < nindexes; i++)
+			indstats[i] = lazy_cleanup_index(Irel[i], indstats[i],
+											 vacrelstats, true);
+	}
+
+	/* ... and update their statistics */
 	for (i = 0; i < nindexes; i++)
-		lazy_cleanup_index(Irel[i], indstats[i], vacrelstats);
+		lazy_update_index_stats(Irel[i], indstats[i]);
 
 	/* If no indexes, make log report that lazy_vacuum_heap would've made */
 	if (vacuumed_pages)
@@ -1341,6 +1617,10 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 									"%u pages are entirely empty.\n",
 									empty_pages),
 					 empty_pages);
+	appendStringInfo(&buf, ngettext("%u page was frozen early.\n",
+									"%u pages were frozen early.\n",
+									vacrelstats->eagerfrozen_pages),
+					 vacrelstats->eagerfrozen_pages);
 	appendStringInfo(&buf, _("%s."),
 					 pg_rusage_show(&ru0));
 
@@ -1368,34 +1648,40 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 static void
 lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 {
-	int			tupindex;
+	LVDeadBlock *dir = (LVDeadBlock *) vacrelstats->dead_space;
+	BlockNumber blockindex;
+	double		ntuples;
 	int			npages;
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
 
 	pg_rusage_init(&ru0);
 	npages = 0;
+	ntuples = 0;
 
-	tupindex = 0;
-	while (tupindex < vacrelstats->num_dead_tuples)
+	for (blockindex = 0; blockindex < vacrelstats->num_dead_blocks; blockindex++)
 	{
-		BlockNumber tblk;
+		BlockNumber tblk = dir[blockindex].blkno;
 		Buffer		buf;
 		Page		page;
 		Size		freespace;
 
 		vacuum_delay_point();
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
 		buf = ReadBufferExtended(onerel, MAIN_FORKNUM, tblk, RBM_NORMAL,
 								 vac_strategy);
+
+		/*
+		 * If somebody else has the page pinned, leave its dead tuples for
+		 * the next vacuum; their index entries are gone, so they take up no
+		 * more than a line pointer each meanwhile.
+		 */
 		if (!ConditionalLockBufferForCleanup(buf))
 		{
 			ReleaseBuffer(buf);
-			++tupindex;
 			continue;
 		}
-		tupindex = lazy_vacuum_page(onerel, tblk, buf, tupindex, vacrelstats,
+		ntuples += lazy_vacuum_page(onerel, tblk, buf, blockindex, vacrelstats,
 									&vmbuffer);
 
 		/* Now that we've compacted the page, record its available space */
@@ -1414,9 +1700,9 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 	}
 
 	ereport(elevel,
-			(errmsg("\"%s\": removed %d row versions in %d pages",
+			(errmsg("\"%s\": removed %.0f row versions in %d pages",
 					RelationGetRelationName(onerel),
-					tupindex, npages),
+					ntuples, npages),
 			 errdetail("%s.",
 					   pg_rusage_show(&ru0))));
 }
@@ -1427,37 +1713,34 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
  *
  * Caller must hold pin and buffer cleanup lock on the buffer.
  *
- * tupindex is the index in vacrelstats->dead_tuples of the first dead
- * tuple for this page.  We assume the rest follow sequentially.
- * The return value is the first tupindex after the tuples of this page.
+ * blockindex is the page's entry in the directory of the dead tuple store.
+ * The return value is the number of dead tuples removed.
  */
 static int
 lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer)
+				 BlockNumber blockindex, LVRelStats *vacrelstats,
+				 Buffer *vmbuffer)
 {
 	Page		page = BufferGetPage(buffer);
 	OffsetNumber unused[MaxOffsetNumber];
-	int			uncnt = 0;
+	int			uncnt;
+	int			i;
 	TransactionId visibility_cutoff_xid;
 	bool		all_frozen;
 
+	Assert(((LVDeadBlock *) vacrelstats->dead_space)[blockindex].blkno == blkno);
+
 	pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_VACUUMED, blkno);
 
+	uncnt = lazy_dead_block_offsets(vacrelstats, blockindex, unused);
+
 	START_CRIT_SECTION();
 
-	for (; tupindex < vacrelstats->num_dead_tuples; tupindex++)
+	for (i = 0; i < uncnt; i++)
 	{
-		BlockNumber tblk;
-		OffsetNumber toff;
-		ItemId		itemid;
+		ItemId		itemid = PageGetItemId(page, unused[i]);
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
-		if (tblk != blkno)
-			break;				/* past end of tuples for this block */
-		toff = ItemPointerGetOffsetNumber(&vacrelstats->dead_tuples[tupindex]);
-		itemid = PageGetItemId(page, toff);
 		ItemIdSetUnused(itemid);
-		unused[uncnt++] = toff;
 	}
 
 	PageRepairFragmentation(page);
@@ -1519,7 +1802,7 @@ lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
 							  *vmbuffer, visibility_cutoff_xid, flags);
 	}
 
-	return tupindex;
+	return uncnt;
 }
 
 /*
@@ -1578,13 +1861,13 @@ lazy_check_needs_freeze(Buffer buf, bool *hastup)
 /*
  *	lazy_vacuum_index() -- vacuum one index relation.
  *
- *		Delete all the index entries pointing to tuples listed in
- *		vacrelstats->dead_tuples, and update running statistics.
+ *		Delete all the index entries pointing to tuples in the dead tuple
+ *		store, and update running statistics.
  */
 static void
 lazy_vacuum_index(Relation indrel,
 				  IndexBulkDeleteResult **stats,
-				  LVRelStats *vacrelstats)
+				  LVRelStats *vacrelstats, bool report)
 {
 	IndexVacuumInfo ivinfo;
 	PGRUsage	ru0;
@@ -1602,20 +1885,20 @@ lazy_vacuum_index(Relation indrel,
 	*stats = index_bulk_delete(&ivinfo, *stats,
 							   lazy_tid_reaped, (void *) vacrelstats);
 
-	ereport(elevel,
-			(errmsg("scanned index \"%s\" to remove %d row versions",
-					RelationGetRelationName(indrel),
-					vacrelstats->num_dead_tuples),
-			 errdetail("%s.", pg_rusage_show(&ru0))));
+	if (report)
+		lazy_report_index(indrel, *stats, vacrelstats, false, &ru0);
 }
 
 /*
  *	lazy_cleanup_index() -- do post-vacuum cleanup for one index relation.
+ *
+ *		Returns the index's final statistics, which the caller must pass to
+ *		lazy_update_index_stats.
  */
-static void
+static IndexBulkDeleteResult *
 lazy_cleanup_index(Relation indrel,
 				   IndexBulkDeleteResult *stats,
-				   LVRelStats *vacrelstats)
+				   LVRelStats *vacrelstats, bool report)
 {
 	IndexVacuumInfo ivinfo;
 	PGRUsage	ru0;
@@ -1631,12 +1914,59 @@ lazy_cleanup_index(Relation indrel,
 
 	stats = index_vacuum_cleanup(&ivinfo, stats);
 
+	if (report)
+		lazy_report_index(indrel, stats, vacrelstats, true, &ru0);
+
+	return stats;
+}
+
+/*
+ *	lazy_report_index() -- report the result of vacuuming or cleaning up
+ *		one index, at elevel.
+ *
+ *		This is separate from lazy_vacuum_index and lazy_cleanup_index so that
+ *		in a parallel vacuum, the leader can report on all indexes in order,
+ *		whichever process did the work.  ru0 is when the work started.
+ */
+static void
+lazy_report_index(Relation indrel, IndexBulkDeleteResult *stats,
+				  LVRelStats *vacrelstats, bool for_cleanup, PGRUsage *ru0)
+{
+	if (!for_cleanup)
+		ereport(elevel,
+				(errmsg("scanned index \"%s\" to remove %.0f row versions",
+						RelationGetRelationName(indrel),
+						(double) vacrelstats->num_dead_tuples),
+				 errdetail("%s.", pg_rusage_show(ru0))));
+	else if (stats)
+		ereport(elevel,
+				(errmsg("index \"%s\" now contains %.0f row versions in %u pages",
+						RelationGetRelationName(indrel),
+						stats->num_index_tuples,
+						stats->num_pages),
+				 errdetail("%.0f index row versions were removed.\n"
+			 "%u index pages have been deleted, %u are currently reusable.\n"
+						   "%s.",
+						   stats->tuples_removed,
+						   stats->pages_deleted, stats->pages_free,
+						   pg_rusage_show(ru0))));
+}
+
+/*
+ *	lazy_update_index_stats() -- update pg_class after cleaning up an index.
+ *
+ *		This is separate from lazy_cleanup_index because a parallel worker
+ *		may have done the cleanup, and workers can't update catalogs.
+ */
+static void
+lazy_update_index_stats(Relation indrel, IndexBulkDeleteResult *stats)
+{
 	if (!stats)
 		return;
 
 	/*
-	 * Now update statistics in pg_class, but only if the index says the count
-	 * is accurate.
+	 * Update statistics in pg_class, but only if the index says the count is
+	 * accurate.
 	 */
 	if (!stats->estimated_count)
 		vac_update_relstats(indrel,
@@ -1648,21 +1978,386 @@ lazy_cleanup_index(Relation indrel,
 							InvalidMultiXactId,
 							false);
 
-	ereport(elevel,
-			(errmsg("index \"%s\" now contains %.0f row versions in %u pages",
-					RelationGetRelationName(indrel),
-					stats->num_index_tuples,
-					stats->num_pages),
-			 errdetail("%.0f index row versions were removed.\n"
-			 "%u index pages have been deleted, %u are currently reusable.\n"
-					   "%s.",
-					   stats->tuples_removed,
-					   stats->pages_deleted, stats->pages_free,
-					   pg_rusage_show(&ru0))));
-
 	pfree(stats);
 }
 
+/*
+ *	lazy_vacuum_all_indexes() -- remove dead tuples' entries from all indexes.
+ */
+static void
+lazy_vacuum_all_indexes(Relation *Irel, IndexBulkDeleteResult **stats,
+						LVRelStats *vacrelstats, int nindexes,
+						LVParallelState *lps)
+{
+	int			i;
+
+	if (lps)
+	{
+		lazy_parallel_vacuum_indexes(Irel, stats, vacrelstats, nindexes,
+									 lps, false);
+		return;
+	}
+
+	for (i = 0; i < nindexes; i++)
+		lazy_vacuum_index(Irel[i], &stats[i], vacrelstats, true);
+}
+
+/*
+ * begin_parallel_vacuum - set up for parallel index vacuuming
+ *
+ * Creates the dynamic shared memory segment for a dead tuple store of the
+ * given size.  Returns NULL if no segment could be had, in which case the
+ * vacuum is done serially.  The parallel context for each round of index
+ * processing is set up by lazy_parallel_vacuum_indexes.
+ */
+static LVParallelState *
+begin_parallel_vacuum(Relation onerel, int nindexes, int nrequested,
+					  Size space)
+{
+	LVParallelState *lps;
+	dsm_segment *seg;
+
+	seg = dsm_create(space, DSM_CREATE_NULL_IF_MAXSEGMENTS);
+	if (seg == NULL)
+		return NULL;
+
+	lps = (LVParallelState *) palloc0(sizeof(LVParallelState));
+	lps->relid = RelationGetRelid(onerel);
+	lps->nrequested = nrequested;
+	lps->seg = seg;
+	lps->dead_space = dsm_segment_address(seg);
+
+	return lps;
+}
+
+/*
+ * end_parallel_vacuum - shut down parallel index vacuuming
+ *
+ * This frees the dead tuple store, along with the rest of the segment.
+ */
+static void
+end_parallel_vacuum(LVParallelState *lps)
+{
+	dsm_detach(lps->seg);
+	pfree(lps);
+}
+
+/*
+ *	lazy_parallel_vacuum_indexes() -- vacuum or clean up all indexes, with
+ *		the help of parallel workers.
+ *
+ *		The statistics in stats[] are handed over to whichever process claims
+ *		each index, and handed back when all are done.  The results are
+ *		reported here, in index order, rather than by the workers.
+ */
+static void
+lazy_parallel_vacuum_indexes(Relation *Irel, IndexBulkDeleteResult **stats,
+							 LVRelStats *vacrelstats, int nindexes,
+							 LVParallelState *lps, bool for_cleanup)
+{
+	ParallelContext *pcxt;
+	LVShared   *lvshared;
+	Size		est_shared;
+	bool		shared_cost;
+	PGRUsage	ru0;
+	int			i;
+
+	pg_rusage_init(&ru0);
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext(lazy_parallel_vacuum_main, lps->nrequested);
+
+	est_shared = add_size(offsetof(LVShared, indstats),
+						  mul_size(nindexes, sizeof(LVIndStats)));
+	shm_toc_estimate_chunk(&pcxt->estimator, est_shared);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+
+	InitializeParallelDSM(pcxt);
+
+	lvshared = (LVShared *) shm_toc_allocate(pcxt->toc, est_shared);
+	MemSet(lvshared, 0, est_shared);
+	lvshared->relid = lps->relid;
+	lvshared->elevel = elevel;
+	lvshared->vacuum_flags = MyPgXact->vacuumFlags;
+
+	/*
+	 * Workers take the cost-based delay parameters in effect now, which
+	 * autovacuum may have rebalanced since the last round.  What we have
+	 * accumulated so far carries over into the shared balance.
+	 */
+	lvshared->cost_delay = VacuumCostDelay;
+	lvshared->cost_limit = VacuumCostLimit;
+	pg_atomic_init_u32(&lvshared->cost_balance, VacuumCostBalance);
+	pg_atomic_init_u32(&lvshared->active_nworkers, 0);
+	lvshared->for_cleanup = for_cleanup;
+	lvshared->dead_space_handle = dsm_segment_handle(lps->seg);
+	memcpy(&lvshared->vacrelstats, vacrelstats, sizeof(LVRelStats));
+	pg_atomic_init_u32(&lvshared->nextindex, 0);
+	lvshared->nindexes = nindexes;
+
+	for (i = 0; i < nindexes; i++)
+	{
+		LVIndStats *indstats = &lvshared->indstats[i];
+
+		indstats->valid = (stats[i] != NULL);
+		if (stats[i] != NULL)
+		{
+			memcpy(&indstats->stats, stats[i], sizeof(IndexBulkDeleteResult));
+			pfree(stats[i]);
+			stats[i] = NULL;
+		}
+	}
+	shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_SHARED, lvshared);
+
+	LaunchParallelWorkers(pcxt);
+
+	if (for_cleanup)
+		ereport(elevel,
+				(errmsg(ngettext("launched %d parallel vacuum worker for index cleanup (planned: %d)",
+								 "launched %d parallel vacuum workers for index cleanup (planned: %d)",
+								 pcxt->nworkers_launched),
+						pcxt->nworkers_launched, pcxt->nworkers)));
+	else
+		ereport(elevel,
+				(errmsg(ngettext("launched %d parallel vacuum worker for index vacuuming (planned: %d)",
+								 "launched %d parallel vacuum workers for index vacuuming (planned: %d)",
+								 pcxt->nworkers_launched),
+						pcxt->nworkers_launched, pcxt->nworkers)));
+
+	/*
+	 * If any workers are running, switch over to the shared cost balance
+	 * until they're done.
+	 */
+	shared_cost = (VacuumCostActive && pcxt->nworkers_launched > 0);
+	if (shared_cost)
+	{
+		VacuumSharedCostBalance = &lvshared->cost_balance;
+		VacuumActiveNWorkers = &lvshared->active_nworkers;
+		VacuumCostBalance = 0;
+		VacuumCostBalanceLocal = 0;
+	}
+
+	/*
+	 * Take our share of the indexes, which is all of them if no workers
+	 * could be launched, then wait for the workers to finish theirs.
+	 */
+	lazy_vacuum_claimed_indexes(Irel, nindexes, lvshared, vacrelstats);
+	WaitForParallelWorkersToFinish(pcxt);
+
+	if (shared_cost)
+	{
+		VacuumCostBalance = pg_atomic_read_u32(&lvshared->cost_balance);
+		VacuumCostBalanceLocal = 0;
+		VacuumSharedCostBalance = NULL;
+		VacuumActiveNWorkers = NULL;
+	}
+
+	for (i = 0; i < nindexes; i++)
+	{
+		LVIndStats *indstats = &lvshared->indstats[i];
+
+		if (indstats->valid)
+		{
+			stats[i] = (IndexBulkDeleteResult *)
+				palloc(sizeof(IndexBulkDeleteResult));
+			memcpy(stats[i], &indstats->stats, sizeof(IndexBulkDeleteResult));
+		}
+	}
+
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+
+	for (i = 0; i < nindexes; i++)
+		lazy_report_index(Irel[i], stats[i], vacrelstats, for_cleanup, &ru0);
+}
+
+/*
+ *	lazy_vacuum_claimed_indexes() -- process indexes until none are left
+ *
+ *		Used by the leader and the workers alike.  Each index's statistics are
+ *		read from and written back to shared memory.
+ */
+static void
+lazy_vacuum_claimed_indexes(Relation *Irel, int nindexes, LVShared *lvshared,
+							LVRelStats *vacrelstats)
+{
+	/* Count ourselves in for the cost-based delay while we're at it */
+	if (VacuumActiveNWorkers)
+		pg_atomic_add_fetch_u32(VacuumActiveNWorkers, 1);
+
+	for (;;)
+	{
+		uint32		idx = pg_atomic_fetch_add_u32(&lvshared->nextindex, 1);
+		LVIndStats *indstats;
+		IndexBulkDeleteResult *stats;
+
+		if (idx >= nindexes)
+			break;
+
+		indstats = &lvshared->indstats[idx];
+		stats = indstats->valid ? &indstats->stats : NULL;
+
+		if (lvshared->for_cleanup)
+			stats = lazy_cleanup_index(Irel[idx], stats, vacrelstats, false);
+		else
+			lazy_vacuum_index(Irel[idx], &stats, vacrelstats, false);
+
+		/* The index AM allocates the statistics locally if we passed none */
+		if (stats != NULL && stats != &indstats->stats)
+		{
+			memcpy(&indstats->stats, stats, sizeof(IndexBulkDeleteResult));
+			pfree(stats);
+		}
+		indstats->valid = (stats != NULL);
+	}
+
+	if (VacuumActiveNWorkers)
+		pg_atomic_sub_fetch_u32(VacuumActiveNWorkers, 1);
+}
+
+/*
+ * lazy_parallel_vacuum_main - main entry point for parallel vacuum workers
+ */
+static void
+lazy_parallel_vacuum_main(dsm_segment *seg, shm_toc *toc)
+{
+	LVShared   *lvshared;
+	LVRelStats	vacrelstats;
+	dsm_segment *dead_seg;
+	Relation	onerel;
+	Relation   *Irel;
+	int			nindexes;
+
+	lvshared = (LVShared *) shm_toc_lookup(toc, PARALLEL_VACUUM_KEY_SHARED);
+
+	/* Use the leader's view of the relation and its dead tuple store */
+	dead_seg = dsm_attach(lvshared->dead_space_handle);
+	if (dead_seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment")));
+	memcpy(&vacrelstats, &lvshared->vacrelstats, sizeof(LVRelStats));
+	vacrelstats.dead_space = dsm_segment_address(dead_seg);
+	vacrelstats.dead_lookup_hint = 0;
+
+	/*
+	 * Like the leader, let other vacuums ignore our snapshot when computing
+	 * their OldestXmin.
+	 */
+	LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+	MyPgXact->vacuumFlags |= lvshared->vacuum_flags;
+	LWLockRelease(ProcArrayLock);
+
+	/* The leader holds these locks already; group locking lets us share */
+	onerel = heap_open(lvshared->relid, ShareUpdateExclusiveLock);
+	vac_open_indexes(onerel, RowExclusiveLock, &nindexes, &Irel);
+	if (nindexes != lvshared->nindexes)
+		elog(ERROR, "parallel vacuum worker found %d indexes, expected %d",
+			 nindexes, lvshared->nindexes);
+
+	elevel = lvshared->elevel;
+	vac_strategy = GetAccessStrategy(BAS_VACUUM);
+
+	/* Draw on the same cost-based delay balance as the leader */
+	VacuumCostDelay = lvshared->cost_delay;
+	VacuumCostLimit = lvshared->cost_limit;
+	VacuumCostActive = (VacuumCostDelay > 0);
+	VacuumCostBalance = 0;
+	VacuumCostBalanceLocal = 0;
+	VacuumSharedCostBalance = &lvshared->cost_balance;
+	VacuumActiveNWorkers = &lvshared->active_nworkers;
+	VacuumPageHit = 0;
+	VacuumPageMiss = 0;
+	VacuumPageDirty = 0;
+
+	lazy_vacuum_claimed_indexes(Irel, nindexes, lvshared, &vacrelstats);
+
+	/* Hand back whatever we didn't get to sleep off */
+	if (VacuumCostActive && VacuumCostBalance > 0)
+		pg_atomic_add_fetch_u32(VacuumSharedCostBalance, VacuumCostBalance);
+	VacuumSharedCostBalance = NULL;
+	VacuumActiveNWorkers = NULL;
+
+	vac_close_indexes(nindexes, Irel, RowExclusiveLock);
+	heap_close(onerel, ShareUpdateExclusiveLock);
+	dsm_detach(dead_seg);
+}
+
+/*
+ * lazy_eager_scan_budget - how many all-visible pages to scan to freeze them?
+ *
+ * A regular vacuum skips all-visible pages, so pages that became all-visible
+ * without being frozen are left for the next aggressive vacuum, which then
+ * has to read and rewrite all of them at once.  To spread that work out, each
+ * regular vacuum scans and freezes some of them too.  The share it takes on
+ * grows with the table's relfrozenxid age, from nothing just after an
+ * aggressive vacuum to nearly all of them as the next one approaches.  The
+ * pages we freeze are skipped from then on, so successive vacuums work their
+ * way through the table.
+ */
+static BlockNumber
+lazy_eager_scan_budget(Relation onerel, TransactionId xidFullScanLimit)
+{
+	TransactionId nextXid = ReadNewTransactionId();
+	TransactionId relfrozenxid = onerel->rd_rel->relfrozenxid;
+	int32		table_age;
+	int32		age;
+	BlockNumber all_visible;
+	BlockNumber all_frozen;
+
+	if (!TransactionIdIsNormal(relfrozenxid))
+		return 0;
+
+	/* xidFullScanLimit is vacuum_freeze_table_age (or less) before nextXid */
+	table_age = (int32) (nextXid - xidFullScanLimit);
+	age = (int32) (nextXid - relfrozenxid);
+	if (table_age <= 0 || age <= 0)
+		return 0;
+
+	visibilitymap_count(onerel, &all_visible, &all_frozen);
+	if (all_visible <= all_frozen)
+		return 0;
+
+	return (BlockNumber) ((all_visible - all_frozen) *
+						  Min((double) age / table_age, 1.0));
+}
+
+/*
+ * should_bypass_index_vacuum - should we leave the dead tuples for later?
+ *
+ * Removing dead tuples' index entries means reading every index in full,
+ * however few tuples are dead.  When only a small fraction of the heap's
+ * pages have dead tuples, that I/O buys back very little space, so we skip
+ * the bulk-delete pass over the indexes, along with the second heap pass.
+ * The AMs' cleanup pass still runs, as it would with no dead tuples at all.  Dead line
+ * pointers stay that way; the next VACUUM finds them again, so they
+ * accumulate until enough pages are affected to make an index pass
+ * worthwhile.  Pages holding dead line pointers are never marked all-visible,
+ * nor truncated away, so leaving them is safe.
+ *
+ * But lazy_scan_heap also records tuples that became DEAD after
+ * heap_page_prune() looked at the page, typically because the inserter
+ * aborted in the meantime.  Those still have storage, and weren't frozen,
+ * so only the second heap pass may get rid of them; left behind, their xmin
+ * could precede the relfrozenxid we're about to set.  If there are any, we
+ * don't bypass.
+ *
+ * Once the dead tuple store has overflowed and the indexes have been vacuumed
+ * anyway, we finish the job in the usual way.
+ */
+static bool
+should_bypass_index_vacuum(LVRelStats *vacrelstats)
+{
+	if (!vacrelstats->hasindex ||
+		vacrelstats->num_index_scans > 0 ||
+		vacrelstats->num_dead_tuples == 0 ||
+		vacrelstats->num_unpruned_tuples > 0)
+		return false;
+
+	return vacrelstats->num_dead_blocks <
+		(double) vacrelstats->rel_pages * BYPASS_THRESHOLD_PAGES;
+}
+
 /*
  * should_attempt_truncation - should we attempt to truncate the heap?
  *
@@ -1966,61 +2661,199 @@ count_nondeletable_pages(Relation onerel, LVRelStats *vacrelstats)
 }
 
 /*
- * lazy_space_alloc - space allocation decisions for lazy vacuum
+ * lazy_space_needed - space allocation decisions for lazy vacuum
  *
  * See the comments at the head of this file for rationale.
  */
-static void
-lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks)
+static Size
+lazy_space_needed(LVRelStats *vacrelstats, BlockNumber relblocks)
 {
-	long		maxtuples;
+	Size		space;
 	int			vac_work_mem = IsAutoVacuumWorkerProcess() &&
 	autovacuum_work_mem != -1 ?
 	autovacuum_work_mem : maintenance_work_mem;
 
 	if (vacrelstats->hasindex)
 	{
-		maxtuples = (vac_work_mem * 1024L) / sizeof(ItemPointerData);
-		maxtuples = Min(maxtuples, INT_MAX);
-		maxtuples = Min(maxtuples, MaxAllocSize / sizeof(ItemPointerData));
+		space = (Size) vac_work_mem * 1024;
+
+		/* data locations must stay below LVDB_SINGLE */
+		if (space / LVDB_UNIT >= LVDB_SINGLE)
+			space = (Size) (LVDB_SINGLE - 1) * LVDB_UNIT;
 
 		/* curious coding here to ensure the multiplication can't overflow */
-		if ((BlockNumber) (maxtuples / LAZY_ALLOC_TUPLES) > relblocks)
-			maxtuples = relblocks * LAZY_ALLOC_TUPLES;
+		if ((BlockNumber) (space / LAZY_DEAD_BLOCK_MAX_SPACE) > relblocks)
+			space = (Size) relblocks * LAZY_DEAD_BLOCK_MAX_SPACE;
 
 		/* stay sane if small maintenance_work_mem */
-		maxtuples = Max(maxtuples, MaxHeapTuplesPerPage);
+		space = Max(space, LAZY_DEAD_BLOCK_MAX_SPACE);
 	}
 	else
 	{
-		maxtuples = MaxHeapTuplesPerPage;
+		space = LAZY_DEAD_BLOCK_MAX_SPACE;
 	}
 
-	vacrelstats->num_dead_tuples = 0;
-	vacrelstats->max_dead_tuples = (int) maxtuples;
-	vacrelstats->dead_tuples = (ItemPointer)
-		palloc(maxtuples * sizeof(ItemPointerData));
+	/* the data area is allocated from the end, in units of LVDB_UNIT */
+	return space - space % LVDB_UNIT;
 }
 
 /*
- * lazy_record_dead_tuple - remember one deletable tuple
+ * lazy_space_alloc - set up an empty dead tuple store
+ *
+ * dead_space is where to put it, if the caller has already allocated the
+ * space; otherwise we allocate it here.
  */
 static void
-lazy_record_dead_tuple(LVRelStats *vacrelstats,
-					   ItemPointer itemptr)
+lazy_space_alloc(LVRelStats *vacrelstats, Size space, char *dead_space)
 {
+	if (dead_space == NULL)
+		dead_space = MemoryContextAllocHuge(CurrentMemoryContext, space);
+
+	vacrelstats->dead_space = dead_space;
+	vacrelstats->dead_space_size = space;
+
 	/*
-	 * The array shouldn't overflow under normal behavior, but perhaps it
-	 * could if we are given a really small maintenance_work_mem. In that
-	 * case, just forget the last few tuples (we'll get 'em next time).
+	 * For progress reporting, the number of dead tuples that will fit even if
+	 * each is alone on its page.  Usually many more do.
 	 */
-	if (vacrelstats->num_dead_tuples < vacrelstats->max_dead_tuples)
+	vacrelstats->max_dead_tuples = space / sizeof(LVDeadBlock);
+
+	lazy_forget_dead_tuples(vacrelstats);
+}
+
+/*
+ * lazy_forget_dead_tuples - empty the dead tuple store
+ */
+static void
+lazy_forget_dead_tuples(LVRelStats *vacrelstats)
+{
+	vacrelstats->num_dead_tuples = 0;
+	vacrelstats->num_unpruned_tuples = 0;
+	vacrelstats->num_dead_blocks = 0;
+	vacrelstats->dead_data_start = vacrelstats->dead_space_size;
+	vacrelstats->dead_lookup_hint = 0;
+}
+
+/*
+ * lazy_dead_tuples_full - is the dead tuple store too full for another page?
+ */
+static bool
+lazy_dead_tuples_full(LVRelStats *vacrelstats)
+{
+	Size		used = vacrelstats->num_dead_blocks * sizeof(LVDeadBlock);
+
+	return vacrelstats->num_dead_tuples > 0 &&
+		vacrelstats->dead_data_start - used < LAZY_DEAD_BLOCK_MAX_SPACE;
+}
+
+/*
+ * lazy_record_dead_tuples - remember the deletable tuples of one page
+ *
+ * offsets[] must be in ascending order, and pages must be recorded in
+ * ascending block number order.  The caller must have made sure there's
+ * room, with lazy_dead_tuples_full.
+ */
+static void
+lazy_record_dead_tuples(LVRelStats *vacrelstats, BlockNumber blkno,
+						OffsetNumber *offsets, int noffsets)
+{
+	LVDeadBlock *entry;
+	OffsetNumber maxoff = offsets[noffsets - 1];
+	Size		bitmaplen = (maxoff + 7) / 8;
+	Size		datalen;
+	uint16	   *header;
+	int			i;
+
+	Assert(noffsets > 0);
+	Assert(vacrelstats->num_dead_blocks == 0 ||
+		   ((LVDeadBlock *) vacrelstats->dead_space)
+		   [vacrelstats->num_dead_blocks - 1].blkno < blkno);
+
+	entry = &((LVDeadBlock *) vacrelstats->dead_space)[vacrelstats->num_dead_blocks];
+	entry->blkno = blkno;
+
+	if (noffsets == 1)
+		entry->data = LVDB_SINGLE | offsets[0];
+	else
 	{
-		vacrelstats->dead_tuples[vacrelstats->num_dead_tuples] = *itemptr;
-		vacrelstats->num_dead_tuples++;
-		pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
-									 vacrelstats->num_dead_tuples);
+		if (bitmaplen < noffsets * sizeof(OffsetNumber))
+			datalen = sizeof(uint16) + bitmaplen;
+		else
+			datalen = sizeof(uint16) + noffsets * sizeof(OffsetNumber);
+		datalen = TYPEALIGN(LVDB_UNIT, datalen);
+
+		vacrelstats->dead_data_start -= datalen;
+		Assert(vacrelstats->dead_data_start >=
+			   (vacrelstats->num_dead_blocks + 1) * sizeof(LVDeadBlock));
+
+		entry->data = vacrelstats->dead_data_start / LVDB_UNIT;
+		header = (uint16 *) (vacrelstats->dead_space +
+							 vacrelstats->dead_data_start);
+
+		if (bitmaplen < noffsets * sizeof(OffsetNumber))
+		{
+			uint8	   *bitmap = (uint8 *) (header + 1);
+
+			*header = LVDB_BITMAP | bitmaplen;
+			memset(bitmap, 0, bitmaplen);
+			for (i = 0; i < noffsets; i++)
+				bitmap[(offsets[i] - 1) / 8] |= 1 << ((offsets[i] - 1) % 8);
+		}
+		else
+		{
+			*header = noffsets;
+			memcpy(header + 1, offsets, noffsets * sizeof(OffsetNumber));
+		}
 	}
+
+	vacrelstats->num_dead_blocks++;
+	vacrelstats->num_dead_tuples += noffsets;
+	pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
+								 vacrelstats->num_dead_tuples);
+}
+
+/*
+ * lazy_dead_block_offsets - get the dead tuples of one page of the store
+ *
+ * Fills offsets[], which must have room for MaxHeapTuplesPerPage entries,
+ * with the offset numbers recorded for the page with the given directory
+ * entry, in ascending order, and returns how many there are.
+ */
+static int
+lazy_dead_block_offsets(LVRelStats *vacrelstats, BlockNumber blockindex,
+						OffsetNumber *offsets)
+{
+	LVDeadBlock *entry = &((LVDeadBlock *) vacrelstats->dead_space)[blockindex];
+	uint16	   *header;
+	int			n = 0;
+
+	if (LVDB_IS_SINGLE(entry->data))
+	{
+		offsets[0] = (OffsetNumber) (entry->data & ~LVDB_SINGLE);
+		return 1;
+	}
+
+	header = (uint16 *) (vacrelstats->dead_space +
+						 (Size) entry->data * LVDB_UNIT);
+	if (*header & LVDB_BITMAP)
+	{
+		uint8	   *bitmap = (uint8 *) (header + 1);
+		int			bitmaplen = *header & ~LVDB_BITMAP;
+		int			i;
+
+		for (i = 0; i < bitmaplen * 8; i++)
+		{
+			if (bitmap[i / 8] & (1 << (i % 8)))
+				offsets[n++] = (OffsetNumber) (i + 1);
+		}
+	}
+	else
+	{
+		n = *header;
+		memcpy(offsets, header + 1, n * sizeof(OffsetNumber));
+	}
+
+	return n;
 }
 
 /*
@@ -2028,51 +2861,83 @@ lazy_record_dead_tuple(LVRelStats *vacrelstats,
  *
  *		This has the right signature to be an IndexBulkDeleteCallback.
  *
- *		Assumes dead_tuples array is in sorted order.
+ *		We binary-search the directory for the page, unless it's the page we
+ *		found last time, or the next one, which is common since index
+ *		entries are often correlated with the heap.  Then we look for the
+ *		offset number in the page's list or bitmap.
  */
 static bool
 lazy_tid_reaped(ItemPointer itemptr, void *state)
 {
 	LVRelStats *vacrelstats = (LVRelStats *) state;
-	ItemPointer res;
+	LVDeadBlock *dir = (LVDeadBlock *) vacrelstats->dead_space;
+	BlockNumber blkno = ItemPointerGetBlockNumber(itemptr);
+	OffsetNumber offnum = ItemPointerGetOffsetNumber(itemptr);
+	BlockNumber nblocks = vacrelstats->num_dead_blocks;
+	BlockNumber hint = vacrelstats->dead_lookup_hint;
+	LVDeadBlock *entry;
+	uint16	   *header;
+
+	if (nblocks == 0 ||
+		blkno < dir[0].blkno || blkno > dir[nblocks - 1].blkno)
+		return false;
 
-	res = (ItemPointer) bsearch((void *) itemptr,
-								(void *) vacrelstats->dead_tuples,
-								vacrelstats->num_dead_tuples,
-								sizeof(ItemPointerData),
-								vac_cmp_itemptr);
+	if (hint < nblocks && dir[hint].blkno == blkno)
+		entry = &dir[hint];
+	else if (hint + 1 < nblocks && dir[hint + 1].blkno == blkno)
+		entry = &dir[++hint];
+	else
+	{
+		BlockNumber lo = 0;
+		BlockNumber hi = nblocks;
 
-	return (res != NULL);
-}
+		while (lo < hi)
+		{
+			BlockNumber mid = lo + (hi - lo) / 2;
 
-/*
- * Comparator routines for use with qsort() and bsearch().
- */
-static int
-vac_cmp_itemptr(const void *left, const void *right)
-{
-	BlockNumber lblk,
-				rblk;
-	OffsetNumber loff,
-				roff;
+			if (dir[mid].blkno < blkno)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo >= nblocks || dir[lo].blkno != blkno)
+			return false;
+		hint = lo;
+		entry = &dir[lo];
+	}
+	vacrelstats->dead_lookup_hint = hint;
 
-	lblk = ItemPointerGetBlockNumber((ItemPointer) left);
-	rblk = ItemPointerGetBlockNumber((ItemPointer) right);
+	if (LVDB_IS_SINGLE(entry->data))
+		return offnum == (OffsetNumber) (entry->data & ~LVDB_SINGLE);
 
-	if (lblk < rblk)
-		return -1;
-	if (lblk > rblk)
-		return 1;
+	header = (uint16 *) (vacrelstats->dead_space +
+						 (Size) entry->data * LVDB_UNIT);
+	if (*header & LVDB_BITMAP)
+	{
+		uint8	   *bitmap = (uint8 *) (header + 1);
+		int			bitmaplen = *header & ~LVDB_BITMAP;
 
-	loff = ItemPointerGetOffsetNumber((ItemPointer) left);
-	roff = ItemPointerGetOffsetNumber((ItemPointer) right);
+		if (offnum < FirstOffsetNumber || offnum > bitmaplen * 8)
+			return false;
+		return (bitmap[(offnum - 1) / 8] & (1 << ((offnum - 1) % 8))) != 0;
+	}
+	else
+	{
+		OffsetNumber *offsets = (OffsetNumber *) (header + 1);
+		int			lo = 0;
+		int			hi = *header;
 
-	if (loff < roff)
-		return -1;
-	if (loff > roff)
-		return 1;
+		while (lo < hi)
+		{
+			int			mid = (lo + hi) / 2;
 
-	return 0;
+			if (offsets[mid] < offnum)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo < *header && offsets[lo] == offnum;
+	}
 }
 
 /*
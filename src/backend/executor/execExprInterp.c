@@ -0,0 +1,1015 @@
+/*-------------------------------------------------------------------------
+ *
+ * execExprInterp.c
+ *	  Flattened, opcode-dispatched evaluation of simple expressions
+ *
+ * Most expressions are evaluated by walking the ExprState tree built by
+ * ExecInitExpr, calling each node's evalfunc recursively.  For the very
+ * common case of quals and targetlist entries made only of Vars, Consts,
+ * plain function/operator calls and boolean connectives, that walk is
+ * dominated by indirect calls, argument list traversal and repeated
+ * per-node checks.  ExecCompileExpr instead flattens such a subtree into a
+ * linear array of ExprEvalSteps, which ExecInterpExpr then runs in a
+ * single loop:
+ *
+ * - Arguments are evaluated directly into the FunctionCallInfo of the
+ *   function consuming them, so no intermediate list walking is needed.
+ *
+ * - The tuple slots referenced by the expression are deformed once, up
+ *   front, and Vars are then fetched straight out of tts_values/tts_isnull.
+ *
+ * - Boolean AND/OR short-circuit by jumping forward in the step array, so
+ *   there is no recursion at all.
+ *
+ * - Where the compiler supports it ("computed goto"), each step's opcode is
+ *   replaced by the address of the code implementing it, so dispatch costs
+ *   a single indirect jump; otherwise a plain switch is used.
+ *
+ * Expressions containing anything else are left to the tree-walking code
+ * in execQual.c; ExecCompileExpr returns NULL for them.
+ *
+ * As with the tree-walking code, catalog lookups for functions are deferred
+ * until the first evaluation (see ExecInterpExprFirst), and each Var is
+ * checked against its input slot the first time it is fetched (see the
+ * EEOP_*_VAR_FIRST steps).
+ *
+ *
+ * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execExprInterp.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/objectaccess.h"
+#include "catalog/pg_type.h"
+#include "executor/execExpr.h"
+#include "executor/executor.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "pgstat.h"
+#include "utils/acl.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+
+
+/*
+ * Use computed-goto-based opcode dispatch when computed gotos are available.
+ * But allow it to be disabled for testing purposes.
+ */
+#if defined(__GNUC__) && !defined(EEO_DISABLE_COMPUTED_GOTO)
+#define EEO_USE_COMPUTED_GOTO
+#endif
+
+/*
+ * Macros for opcode dispatch.
+ *
+ * EEO_SWITCH - just hides the switch if not in use.
+ * EEO_CASE - labels the implementation of named expression step type.
+ * EEO_DISPATCH - jump to the implementation of the step type for 'op'.
+ * EEO_NEXT - increment 'op' and jump to correct next step type.
+ * EEO_JUMP - jump to the specified step number within the current expression.
+ * EEO_OPCODE - compute the op->opcode value representing a step type; only
+ *		usable within ExecInterpExpr.
+ */
+#if defined(EEO_USE_COMPUTED_GOTO)
+
+#define EEO_SWITCH()
+#define EEO_CASE(name)		CASE_##name:
+#define EEO_DISPATCH()		goto *((void *) op->opcode)
+#define EEO_OPCODE(opcode)	((intptr_t) dispatch_table[opcode])
+
+#else							/* !EEO_USE_COMPUTED_GOTO */
+
+#define EEO_SWITCH()		starteval: switch ((ExprEvalOp) op->opcode)
+#define EEO_CASE(name)		case name:
+#define EEO_DISPATCH()		goto starteval
+#define EEO_OPCODE(opcode)	(opcode)
+
+#endif   /* EEO_USE_COMPUTED_GOTO */
+
+#define EEO_NEXT() \
+	do { \
+		op++; \
+		EEO_DISPATCH(); \
+	} while (0)
+
+#define EEO_JUMP(stepno) \
+	do { \
+		op = &state->steps[stepno]; \
+		EEO_DISPATCH(); \
+	} while (0)
+
+
+/*
+ * Highest user attribute number referenced in each input slot; used to emit
+ * the initial EEOP_*_FETCHSOME steps.
+ */
+typedef struct LastAttnumInfo
+{
+	AttrNumber	last_inner;
+	AttrNumber	last_outer;
+	AttrNumber	last_scan;
+} LastAttnumInfo;
+
+static bool ExprIsCompilable(Node *node, LastAttnumInfo *info);
+static void ExprEvalPushStep(CompiledExprState *state, ExprEvalStep *s);
+static void ExecCompileExprRec(Expr *node, CompiledExprState *state,
+				   Datum *resv, bool *resnull);
+static void ExecCompileFunc(Expr *node, List *args, CompiledExprState *state,
+				Datum *resv, bool *resnull);
+static void ExecCompileBool(BoolExpr *boolexpr, CompiledExprState *state,
+				Datum *resv, bool *resnull);
+static Datum ExecInterpExprFirst(CompiledExprState *state,
+					ExprContext *econtext, bool *isNull);
+static Datum ExecInterpExpr(CompiledExprState *state,
+			   ExprContext *econtext, bool *isNull);
+static void ExecReadyFuncStep(ExprEvalStep *op, ExprContext *econtext);
+static bool CheckVarSlotCompatibility(ExprEvalStep *op, TupleTableSlot *slot);
+
+
+/*
+ * ExecCompileExpr: try to flatten an expression tree into a step program
+ *
+ * Returns a CompiledExprState ready to be handed to ExecEvalExpr, or NULL if
+ * the tree contains node types that the interpreter doesn't handle, in which
+ * case the caller should build an ordinary ExprState tree.  The caller is
+ * responsible for filling in the result's xprstate.expr.
+ *
+ * Like ExecInitExpr, this must be called in a memory context that will last
+ * as long as repeated executions of the expression are needed.
+ */
+ExprState *
+ExecCompileExpr(Expr *node)
+{
+	CompiledExprState *state;
+	LastAttnumInfo info;
+	ExprEvalStep scratch;
+
+	if (node == NULL)
+		return NULL;
+
+	/*
+	 * Bare Vars and Consts already have cheap evalfuncs, so only bother with
+	 * expressions that would otherwise recurse.
+	 */
+	if (!IsA(node, FuncExpr) && !IsA(node, OpExpr) && !IsA(node, BoolExpr))
+		return NULL;
+
+	/*
+	 * A function returning RECORD at the top of a table function reference
+	 * relies on ExecMakeTableFunctionResult passing it a ReturnSetInfo
+	 * describing the expected result, which requires a FuncExprState.
+	 */
+	if (IsA(node, FuncExpr) &&
+		((FuncExpr *) node)->funcresulttype == RECORDOID)
+		return NULL;
+
+	info.last_inner = 0;
+	info.last_outer = 0;
+	info.last_scan = 0;
+	if (!ExprIsCompilable((Node *) node, &info))
+		return NULL;
+
+	state = makeNode(CompiledExprState);
+	state->xprstate.evalfunc = (ExprStateEvalFunc) ExecInterpExprFirst;
+	state->steps_alloc = 16;
+	state->steps_len = 0;
+	state->steps = palloc(sizeof(ExprEvalStep) * state->steps_alloc);
+
+	/* Deform the input slots as far as needed, once per evaluation */
+	scratch.resvalue = NULL;
+	scratch.resnull = NULL;
+	if (info.last_inner > 0)
+	{
+		scratch.opcode = EEOP_INNER_FETCHSOME;
+		scratch.d.fetch.last_var = info.last_inner;
+		ExprEvalPushStep(state, &scratch);
+	}
+	if (info.last_outer > 0)
+	{
+		scratch.opcode = EEOP_OUTER_FETCHSOME;
+		scratch.d.fetch.last_var = info.last_outer;
+		ExprEvalPushStep(state, &scratch);
+	}
+	if (info.last_scan > 0)
+	{
+		scratch.opcode = EEOP_SCAN_FETCHSOME;
+		scratch.d.fetch.last_var = info.last_scan;
+		ExprEvalPushStep(state, &scratch);
+	}
+
+	ExecCompileExprRec(node, state, &state->resvalue, &state->resnull);
+
+	scratch.opcode = EEOP_DONE;
+	ExprEvalPushStep(state, &scratch);
+
+	return (ExprState *) state;
+}
+
+/*
+ * Check whether every node in the tree is one the interpreter handles, and
+ * accumulate the highest attribute number referenced from each slot.
+ */
+static bool
+ExprIsCompilable(Node *node, LastAttnumInfo *info)
+{
+	ListCell   *lc;
+	List	   *args;
+
+	if (node == NULL)
+		return false;
+
+	switch (nodeTag(node))
+	{
+		case T_Var:
+			{
+				Var		   *variable = (Var *) node;
+
+				/* whole-row and system Vars are left to execQual.c */
+				if (variable->varattno <= 0)
+					return false;
+
+				switch (variable->varno)
+				{
+					case INNER_VAR:
+						info->last_inner = Max(info->last_inner,
+											   variable->varattno);
+						break;
+					case OUTER_VAR:
+						info->last_outer = Max(info->last_outer,
+											   variable->varattno);
+						break;
+						/* INDEX_VAR is handled by default case */
+					default:
+						info->last_scan = Max(info->last_scan,
+											  variable->varattno);
+						break;
+				}
+				return true;
+			}
+		case T_Const:
+			return true;
+		case T_RelabelType:
+			return ExprIsCompilable((Node *) ((RelabelType *) node)->arg,
+									info);
+		case T_FuncExpr:
+			if (((FuncExpr *) node)->funcretset)
+				return false;
+			args = ((FuncExpr *) node)->args;
+			break;
+		case T_OpExpr:
+			if (((OpExpr *) node)->opretset)
+				return false;
+			args = ((OpExpr *) node)->args;
+			break;
+		case T_BoolExpr:
+			args = ((BoolExpr *) node)->args;
+			if (((BoolExpr *) node)->boolop != NOT_EXPR &&
+				list_length(args) < 2)
+				return false;
+			break;
+		default:
+			return false;
+	}
+
+	/* let init_fcache-equivalent code complain about this at runtime */
+	if (list_length(args) > FUNC_MAX_ARGS)
+		return false;
+
+	foreach(lc, args)
+	{
+		if (!ExprIsCompilable((Node *) lfirst(lc), info))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Add another expression evaluation step to state->steps.
+ *
+ * Note that this potentially re-allocates state->steps, therefore no pointer
+ * into that array may be used while the expression is still being built.
+ */
+static void
+ExprEvalPushStep(CompiledExprState *state, ExprEvalStep *s)
+{
+	if (state->steps_len == state->steps_alloc)
+	{
+		state->steps_alloc *= 2;
+		state->steps = repalloc(state->steps,
+								sizeof(ExprEvalStep) * state->steps_alloc);
+	}
+
+	memcpy(&state->steps[state->steps_len++], s, sizeof(ExprEvalStep));
+}
+
+/*
+ * Append the steps necessary to evaluate node to state->steps, with the
+ * result going to *resv and *resnull.  ExprIsCompilable must already have
+ * accepted node.
+ */
+static void
+ExecCompileExprRec(Expr *node, CompiledExprState *state,
+				   Datum *resv, bool *resnull)
+{
+	ExprEvalStep scratch;
+
+	scratch.resvalue = resv;
+	scratch.resnull = resnull;
+
+	switch (nodeTag(node))
+	{
+		case T_Var:
+			{
+				Var		   *variable = (Var *) node;
+
+				switch (variable->varno)
+				{
+					case INNER_VAR:
+						scratch.opcode = EEOP_INNER_VAR_FIRST;
+						break;
+					case OUTER_VAR:
+						scratch.opcode = EEOP_OUTER_VAR_FIRST;
+						break;
+						/* INDEX_VAR is handled by default case */
+					default:
+						scratch.opcode = EEOP_SCAN_VAR_FIRST;
+						break;
+				}
+				scratch.d.var.attnum = variable->varattno - 1;
+				scratch.d.var.var = variable;
+				ExprEvalPushStep(state, &scratch);
+				break;
+			}
+		case T_Const:
+			{
+				Const	   *con = (Const *) node;
+
+				scratch.opcode = EEOP_CONST;
+				scratch.d.constval.value = con->constvalue;
+				scratch.d.constval.isnull = con->constisnull;
+				ExprEvalPushStep(state, &scratch);
+				break;
+			}
+		case T_RelabelType:
+			/* relabeling doesn't need to do anything at runtime */
+			ExecCompileExprRec(((RelabelType *) node)->arg, state,
+							   resv, resnull);
+			break;
+		case T_FuncExpr:
+			ExecCompileFunc(node, ((FuncExpr *) node)->args, state,
+							resv, resnull);
+			break;
+		case T_OpExpr:
+			ExecCompileFunc(node, ((OpExpr *) node)->args, state,
+							resv, resnull);
+			break;
+		case T_BoolExpr:
+			ExecCompileBool((BoolExpr *) node, state, resv, resnull);
+			break;
+		default:
+			elog(ERROR, "unrecognized node type: %d",
+				 (int) nodeTag(node));
+			break;
+	}
+}
+
+/*
+ * Append the steps for a FuncExpr or OpExpr.  Each argument is evaluated
+ * straight into the function's FunctionCallInfo.
+ */
+static void
+ExecCompileFunc(Expr *node, List *args, CompiledExprState *state,
+				Datum *resv, bool *resnull)
+{
+	ExprEvalStep scratch;
+	FunctionCallInfo fcinfo;
+	ListCell   *lc;
+	int			argno;
+
+	fcinfo = palloc0(sizeof(FunctionCallInfoData));
+
+	argno = 0;
+	foreach(lc, args)
+	{
+		ExecCompileExprRec((Expr *) lfirst(lc), state,
+						   &fcinfo->arg[argno], &fcinfo->argnull[argno]);
+		argno++;
+	}
+
+	scratch.opcode = EEOP_FUNCEXPR;
+	scratch.resvalue = resv;
+	scratch.resnull = resnull;
+	scratch.d.func.expr = node;
+	scratch.d.func.finfo = palloc0(sizeof(FmgrInfo));
+	scratch.d.func.fcinfo_data = fcinfo;
+	scratch.d.func.nargs = argno;
+	ExprEvalPushStep(state, &scratch);
+}
+
+/*
+ * Append the steps for a BoolExpr.  AND and OR evaluate each argument into
+ * the BoolExpr's own result location, followed by a step that either jumps
+ * to the end (result determined) or continues with the next argument.
+ */
+static void
+ExecCompileBool(BoolExpr *boolexpr, CompiledExprState *state,
+				Datum *resv, bool *resnull)
+{
+	ExprEvalStep scratch;
+	List	   *adjust_jumps = NIL;
+	ListCell   *lc;
+	bool	   *anynull;
+	int			nargs = list_length(boolexpr->args);
+	int			off;
+
+	scratch.resvalue = resv;
+	scratch.resnull = resnull;
+
+	if (boolexpr->boolop == NOT_EXPR)
+	{
+		ExecCompileExprRec((Expr *) linitial(boolexpr->args), state,
+						   resv, resnull);
+		scratch.opcode = EEOP_BOOL_NOT_STEP;
+		ExprEvalPushStep(state, &scratch);
+		return;
+	}
+
+	Assert(nargs >= 2);
+
+	/* allocate scratch memory used by all steps of AND/OR */
+	anynull = (bool *) palloc0(sizeof(bool));
+
+	off = 0;
+	foreach(lc, boolexpr->args)
+	{
+		ExecCompileExprRec((Expr *) lfirst(lc), state, resv, resnull);
+
+		if (boolexpr->boolop == AND_EXPR)
+		{
+			if (off == 0)
+				scratch.opcode = EEOP_BOOL_AND_STEP_FIRST;
+			else if (off + 1 == nargs)
+				scratch.opcode = EEOP_BOOL_AND_STEP_LAST;
+			else
+				scratch.opcode = EEOP_BOOL_AND_STEP;
+		}
+		else
+		{
+			Assert(boolexpr->boolop == OR_EXPR);
+			if (off == 0)
+				scratch.opcode = EEOP_BOOL_OR_STEP_FIRST;
+			else if (off + 1 == nargs)
+				scratch.opcode = EEOP_BOOL_OR_STEP_LAST;
+			else
+				scratch.opcode = EEOP_BOOL_OR_STEP;
+		}
+		scratch.d.boolexpr.anynull = anynull;
+		scratch.d.boolexpr.jumpdone = -1;
+		ExprEvalPushStep(state, &scratch);
+		adjust_jumps = lappend_int(adjust_jumps, state->steps_len - 1);
+		off++;
+	}
+
+	/* adjust jump targets, now that we know where the expression ends */
+	foreach(lc, adjust_jumps)
+	{
+		ExprEvalStep *as = &state->steps[lfirst_int(lc)];
+
+		Assert(as->d.boolexpr.jumpdone == -1);
+		as->d.boolexpr.jumpdone = state->steps_len;
+	}
+	list_free(adjust_jumps);
+}
+
+
+/*
+ * ExecInterpExprFirst
+ *
+ * Evalfunc used for the first evaluation of a compiled expression.  Does the
+ * work that the tree-walking code does in init_fcache: look up each function.
+ * Then switches to ExecInterpExpr for this and all further evaluations.
+ *
+ * Vars are not checked here, since an input slot may not be set up yet if
+ * the Var is never reached on this evaluation; the EEOP_*_VAR_FIRST steps
+ * do that check the first time they actually fetch from the slot.
+ */
+static Datum
+ExecInterpExprFirst(CompiledExprState *state, ExprContext *econtext,
+					bool *isNull)
+{
+	int			i;
+
+	for (i = 0; i < state->steps_len; i++)
+	{
+		ExprEvalStep *op = &state->steps[i];
+
+		switch ((ExprEvalOp) op->opcode)
+		{
+			case EEOP_FUNCEXPR:
+				ExecReadyFuncStep(op, econtext);
+				break;
+			default:
+				break;
+		}
+	}
+
+#if defined(EEO_USE_COMPUTED_GOTO)
+	{
+		const void *const *dispatch_table;
+
+		/* Calling ExecInterpExpr with a NULL state fetches its jump table */
+		dispatch_table = (const void *const *)
+			DatumGetPointer(ExecInterpExpr(NULL, NULL, NULL));
+
+		for (i = 0; i < state->steps_len; i++)
+		{
+			ExprEvalStep *op = &state->steps[i];
+
+			op->opcode = (intptr_t) dispatch_table[op->opcode];
+		}
+	}
+#endif
+
+	/* Skip the checking on future executions of the expression */
+	state->xprstate.evalfunc = (ExprStateEvalFunc) ExecInterpExpr;
+
+	return ExecInterpExpr(state, econtext, isNull);
+}
+
+/*
+ * ExecInterpExpr
+ *
+ * Evaluate a compiled expression, returning its value and null flag.
+ *
+ * When called with state == NULL, returns the array of jump targets used for
+ * computed-goto dispatch instead (or nothing, if that isn't in use).
+ */
+static Datum
+ExecInterpExpr(CompiledExprState *state, ExprContext *econtext, bool *isNull)
+{
+	ExprEvalStep *op;
+	TupleTableSlot *innerslot;
+	TupleTableSlot *outerslot;
+	TupleTableSlot *scanslot;
+
+	/*
+	 * This array has to be in the same order as enum ExprEvalOp.
+	 */
+#if defined(EEO_USE_COMPUTED_GOTO)
+	static const void *const dispatch_table[] = {
+		&&CASE_EEOP_DONE,
+		&&CASE_EEOP_INNER_FETCHSOME,
+		&&CASE_EEOP_OUTER_FETCHSOME,
+		&&CASE_EEOP_SCAN_FETCHSOME,
+		&&CASE_EEOP_INNER_VAR_FIRST,
+		&&CASE_EEOP_INNER_VAR,
+		&&CASE_EEOP_OUTER_VAR_FIRST,
+		&&CASE_EEOP_OUTER_VAR,
+		&&CASE_EEOP_SCAN_VAR_FIRST,
+		&&CASE_EEOP_SCAN_VAR,
+		&&CASE_EEOP_CONST,
+		&&CASE_EEOP_FUNCEXPR,
+		&&CASE_EEOP_FUNCEXPR_STRICT,
+		&&CASE_EEOP_BOOL_AND_STEP_FIRST,
+		&&CASE_EEOP_BOOL_AND_STEP,
+		&&CASE_EEOP_BOOL_AND_STEP_LAST,
+		&&CASE_EEOP_BOOL_OR_STEP_FIRST,
+		&&CASE_EEOP_BOOL_OR_STEP,
+		&&CASE_EEOP_BOOL_OR_STEP_LAST,
+		&&CASE_EEOP_BOOL_NOT_STEP,
+		&&CASE_EEOP_LAST
+	};
+
+	StaticAssertStmt(EEOP_LAST + 1 == lengthof(dispatch_table),
+					 "dispatch_table out of whack with ExprEvalOp");
+
+	if (state == NULL)
+		return PointerGetDatum(dispatch_table);
+#else
+	Assert(state != NULL);
+#endif   /* EEO_USE_COMPUTED_GOTO */
+
+	/* setup state */
+	op = state->steps;
+	innerslot = econtext->ecxt_innertuple;
+	outerslot = econtext->ecxt_outertuple;
+	scanslot = econtext->ecxt_scantuple;
+
+	EEO_DISPATCH();
+
+	EEO_SWITCH()
+	{
+		EEO_CASE(EEOP_DONE)
+		{
+			*isNull = state->resnull;
+			return state->resvalue;
+		}
+
+		EEO_CASE(EEOP_INNER_FETCHSOME)
+		{
+			slot_getsomeattrs(innerslot, op->d.fetch.last_var);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_OUTER_FETCHSOME)
+		{
+			slot_getsomeattrs(outerslot, op->d.fetch.last_var);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_SCAN_FETCHSOME)
+		{
+			slot_getsomeattrs(scanslot, op->d.fetch.last_var);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_INNER_VAR_FIRST)
+		{
+			/* one-time type check, then re-dispatch as the checked step */
+			if (CheckVarSlotCompatibility(op, innerslot))
+				op->opcode = EEO_OPCODE(EEOP_INNER_VAR);
+			else
+				op->opcode = EEO_OPCODE(EEOP_CONST);
+
+			EEO_DISPATCH();
+		}
+
+		EEO_CASE(EEOP_INNER_VAR)
+		{
+			int			attnum = op->d.var.attnum;
+
+			/*
+			 * Since we already extracted all referenced columns from the
+			 * tuple with a FETCHSOME step, we can just grab the value
+			 * directly out of the slot's decomposed-data arrays.
+			 */
+			Assert(innerslot->tts_nvalid > attnum);
+			*op->resvalue = innerslot->tts_values[attnum];
+			*op->resnull = innerslot->tts_isnull[attnum];
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_OUTER_VAR_FIRST)
+		{
+			/* See EEOP_INNER_VAR_FIRST comments */
+			if (CheckVarSlotCompatibility(op, outerslot))
+				op->opcode = EEO_OPCODE(EEOP_OUTER_VAR);
+			else
+				op->opcode = EEO_OPCODE(EEOP_CONST);
+
+			EEO_DISPATCH();
+		}
+
+		EEO_CASE(EEOP_OUTER_VAR)
+		{
+			int			attnum = op->d.var.attnum;
+
+			/* See EEOP_INNER_VAR comments */
+			Assert(outerslot->tts_nvalid > attnum);
+			*op->resvalue = outerslot->tts_values[attnum];
+			*op->resnull = outerslot->tts_isnull[attnum];
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_SCAN_VAR_FIRST)
+		{
+			/* See EEOP_INNER_VAR_FIRST comments */
+			if (CheckVarSlotCompatibility(op, scanslot))
+				op->opcode = EEO_OPCODE(EEOP_SCAN_VAR);
+			else
+				op->opcode = EEO_OPCODE(EEOP_CONST);
+
+			EEO_DISPATCH();
+		}
+
+		EEO_CASE(EEOP_SCAN_VAR)
+		{
+			int			attnum = op->d.var.attnum;
+
+			/* See EEOP_INNER_VAR comments */
+			Assert(scanslot->tts_nvalid > attnum);
+			*op->resvalue = scanslot->tts_values[attnum];
+			*op->resnull = scanslot->tts_isnull[attnum];
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_CONST)
+		{
+			*op->resnull = op->d.constval.isnull;
+			*op->resvalue = op->d.constval.value;
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR)
+		{
+			FunctionCallInfo fcinfo = op->d.func.fcinfo_data;
+			PgStat_FunctionCallUsage fcusage;
+
+			pgstat_init_function_usage(fcinfo, &fcusage);
+
+			fcinfo->isnull = false;
+			*op->resvalue = FunctionCallInvoke(fcinfo);
+			*op->resnull = fcinfo->isnull;
+
+			pgstat_end_function_usage(&fcusage, true);
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT)
+		{
+			FunctionCallInfo fcinfo = op->d.func.fcinfo_data;
+			PgStat_FunctionCallUsage fcusage;
+			int			argno;
+
+			/* strict function, so check for NULL args */
+			for (argno = 0; argno < op->d.func.nargs; argno++)
+			{
+				if (fcinfo->argnull[argno])
+				{
+					*op->resnull = true;
+					goto strictfail;
+				}
+			}
+
+			pgstat_init_function_usage(fcinfo, &fcusage);
+
+			fcinfo->isnull = false;
+			*op->resvalue = FunctionCallInvoke(fcinfo);
+			*op->resnull = fcinfo->isnull;
+
+			pgstat_end_function_usage(&fcusage, true);
+
+	strictfail:
+			EEO_NEXT();
+		}
+
+		/*
+		 * If any of its clauses is FALSE, an AND's result is FALSE regardless
+		 * of the states of the rest of the clauses, so we can stop evaluating
+		 * and return FALSE immediately.  If none are FALSE and one or more is
+		 * NULL, we return NULL; otherwise we return TRUE.  This makes sense
+		 * when you interpret NULL as "don't know": perhaps one of the "don't
+		 * knows" would have been FALSE if we'd known its value.  Only when
+		 * all the inputs are known to be TRUE can we state confidently that
+		 * the AND's result is TRUE.
+		 */
+		EEO_CASE(EEOP_BOOL_AND_STEP_FIRST)
+		{
+			*op->d.boolexpr.anynull = false;
+
+			/*
+			 * EEOP_BOOL_AND_STEP_FIRST resets anynull, otherwise it's the
+			 * same as EEOP_BOOL_AND_STEP - so fall through to that.
+			 */
+
+			/* FALL THROUGH */
+		}
+
+		EEO_CASE(EEOP_BOOL_AND_STEP)
+		{
+			if (*op->resnull)
+			{
+				*op->d.boolexpr.anynull = true;
+			}
+			else if (!DatumGetBool(*op->resvalue))
+			{
+				/* result is already set to FALSE, need not change it */
+				/* bail out early */
+				EEO_JUMP(op->d.boolexpr.jumpdone);
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_BOOL_AND_STEP_LAST)
+		{
+			if (*op->resnull)
+			{
+				/* result is already set to NULL, need not change it */
+			}
+			else if (!DatumGetBool(*op->resvalue))
+			{
+				/* result is already set to FALSE, need not change it */
+
+				/*
+				 * No point jumping early to jumpdone - would be same target
+				 * (as this is the last argument to the AND expression),
+				 * except more expensive.
+				 */
+			}
+			else if (*op->d.boolexpr.anynull)
+			{
+				*op->resvalue = (Datum) 0;
+				*op->resnull = true;
+			}
+			else
+			{
+				/* result is already set to TRUE, need not change it */
+			}
+
+			EEO_NEXT();
+		}
+
+		/*
+		 * If any of its clauses is TRUE, an OR's result is TRUE regardless of
+		 * the states of the rest of the clauses, so we can stop evaluating
+		 * and return TRUE immediately.  If none are TRUE and one or more is
+		 * NULL, we return NULL; otherwise we return FALSE.  This makes sense
+		 * when you interpret NULL as "don't know": perhaps one of the "don't
+		 * knows" would have been TRUE if we'd known its value.  Only when all
+		 * the inputs are known to be FALSE can we state confidently that the
+		 * OR's result is FALSE.
+		 */
+		EEO_CASE(EEOP_BOOL_OR_STEP_FIRST)
+		{
+			*op->d.boolexpr.anynull = false;
+
+			/*
+			 * EEOP_BOOL_OR_STEP_FIRST resets anynull, otherwise it's the same
+			 * as EEOP_BOOL_OR_STEP - so fall through to that.
+			 */
+
+			/* FALL THROUGH */
+		}
+
+		EEO_CASE(EEOP_BOOL_OR_STEP)
+		{
+			if (*op->resnull)
+			{
+				*op->d.boolexpr.anynull = true;
+			}
+			else if (DatumGetBool(*op->resvalue))
+			{
+				/* result is already set to TRUE, need not change it */
+				/* bail out early */
+				EEO_JUMP(op->d.boolexpr.jumpdone);
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_BOOL_OR_STEP_LAST)
+		{
+			if (*op->resnull)
+			{
+				/* result is already set to NULL, need not change it */
+			}
+			else if (DatumGetBool(*op->resvalue))
+			{
+				/* result is already set to TRUE, need not change it */
+
+				/*
+				 * No point jumping to jumpdone - would be same target (as
+				 * this is the last argument to the OR expression), except
+				 * more expensive.
+				 */
+			}
+			else if (*op->d.boolexpr.anynull)
+			{
+				*op->resvalue = (Datum) 0;
+				*op->resnull = true;
+			}
+			else
+			{
+				/* result is already set to FALSE, need not change it */
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_BOOL_NOT_STEP)
+		{
+			/*
+			 * Evaluation of 'not' is simple...  if expr is false, then return
+			 * 'true' and vice versa.  It's safe to do this even on a
+			 * nominally null value, so we ignore resnull; that means that
+			 * NULL in produces NULL out, which is what we want.
+			 */
+			*op->resvalue = BoolGetDatum(!DatumGetBool(*op->resvalue));
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_LAST)
+		{
+			/* unreachable */
+			Assert(false);
+			goto out;
+		}
+	}
+
+out:
+	*isNull = state->resnull;
+	return state->resvalue;
+}
+
+/*
+ * Look up the function called by an EEOP_FUNCEXPR step and prepare its
+ * FunctionCallInfo; switch the step to EEOP_FUNCEXPR_STRICT if appropriate.
+ * This mirrors init_fcache in execQual.c.
+ */
+static void
+ExecReadyFuncStep(ExprEvalStep *op, ExprContext *econtext)
+{
+	Expr	   *node = op->d.func.expr;
+	Oid			funcid;
+	Oid			inputcollid;
+	AclResult	aclresult;
+
+	if (IsA(node, FuncExpr))
+	{
+		funcid = ((FuncExpr *) node)->funcid;
+		inputcollid = ((FuncExpr *) node)->inputcollid;
+	}
+	else
+	{
+		Assert(IsA(node, OpExpr));
+		funcid = ((OpExpr *) node)->opfuncid;
+		inputcollid = ((OpExpr *) node)->inputcollid;
+	}
+
+	/* Check permission to call function */
+	aclresult = pg_proc_aclcheck(funcid, GetUserId(), ACL_EXECUTE);
+	if (aclresult != ACLCHECK_OK)
+		aclcheck_error(aclresult, ACL_KIND_PROC, get_func_name(funcid));
+	InvokeFunctionExecuteHook(funcid);
+
+	/* Set up the primary fmgr lookup information */
+	fmgr_info_cxt(funcid, op->d.func.finfo, econtext->ecxt_per_query_memory);
+	fmgr_info_set_expr((Node *) node, op->d.func.finfo);
+
+	/* Initialize the function call parameter struct as well */
+	InitFunctionCallInfoData(*op->d.func.fcinfo_data, op->d.func.finfo,
+							 op->d.func.nargs, inputcollid, NULL, NULL);
+
+	/* ExprIsCompilable rejected set-returning calls */
+	if (op->d.func.finfo->fn_retset)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+
+	if (op->d.func.finfo->fn_strict)
+		op->opcode = EEOP_FUNCEXPR_STRICT;
+}
+
+/*
+ * Check that a Var's type still matches the slot it will be fetched from.
+ * This is the same one-time check ExecEvalScalarVar performs; see the
+ * comments there.
+ *
+ * A reference to a dropped attribute is allowed, and yields NULL just as
+ * slot_getattr would; in that case we fill in the step's constval with a
+ * NULL and return false, and the caller turns the step into an EEOP_CONST.
+ */
+static bool
+CheckVarSlotCompatibility(ExprEvalStep *op, TupleTableSlot *slot)
+{
+	Var		   *variable = op->d.var.var;
+	AttrNumber	attnum = variable->varattno;
+	TupleDesc	slot_tupdesc;
+	Form_pg_attribute attr;
+
+	Assert(attnum > 0);
+
+	Assert(slot != NULL);
+	slot_tupdesc = slot->tts_tupleDescriptor;
+
+	if (attnum > slot_tupdesc->natts)	/* should never happen */
+		elog(ERROR, "attribute number %d exceeds number of columns %d",
+			 attnum, slot_tupdesc->natts);
+
+	attr = slot_tupdesc->attrs[attnum - 1];
+
+	/* can't check type if dropped, since atttypid is probably 0 */
+	if (attr->attisdropped)
+	{
+		op->d.constval.value = (Datum) 0;
+		op->d.constval.isnull = true;
+		return false;
+	}
+
+	if (variable->vartype != attr->atttypid)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATATYPE_MISMATCH),
+				 errmsg("attribute %d has wrong type", attnum),
+				 errdetail("Table has type %s, but query expects %s.",
+						   format_type_be(attr->atttypid),
+						   format_type_be(variable->vartype))));
+
+	return true;
+}
@@ -106,6 +106,7 @@
  */
 #include "postgres.h"
 
+#include "access/amapi.h"
 #include "access/relscan.h"
 #include "access/xact.h"
 #include "catalog/index.h"
@@ -262,9 +263,13 @@ ExecCloseIndices(ResultRelInfo *resultRelInfo)
  *		If 'arbiterIndexes' is nonempty, noDupErr applies only to
  *		those indexes.  NIL means noDupErr applies to all indexes.
  *
- *		CAUTION: this must not be called for a HOT update.
- *		We can't defend against that here for lack of info.
- *		Should we change the API to make it safer?
+ *		If 'onlySummarizing' is true, only summarizing indexes (such
+ *		as BRIN) are updated.  This is what a HOT update that modified
+ *		a summarized column needs; see heap_update.
+ *
+ *		CAUTION: this must not be called for a HOT update, except
+ *		with onlySummarizing set.  We can't defend against that here
+ *		for lack of info.  Should we change the API to make it safer?
  * ----------------------------------------------------------------
  */
 List *
@@ -273,7 +278,8 @@ ExecInsertIndexTuples(TupleTableSlot *slot,
 					  EState *estate,
 					  bool noDupErr,
 					  bool *specConflict,
-					  List *arbiterIndexes)
+					  List *arbiterIndexes,
+					  bool onlySummarizing)
 {
 	List	   *result = NIL;
 	ResultRelInfo *resultRelInfo;
@@ -324,6 +330,10 @@ ExecInsertIndexTuples(TupleTableSlot *slot,
 		if (!indexInfo->ii_ReadyForInserts)
 			continue;
 
+		/* A HOT update only needs to maintain summarizing indexes */
+		if (onlySummarizing && !indexRelation->rd_amroutine->amsummarizing)
+			continue;
+
 		/* Check for partial index */
 		if (indexInfo->ii_Predicate != NIL)
 		{
@@ -25,8 +25,10 @@
 
 #include "executor/execParallel.h"
 #include "executor/executor.h"
+#include "executor/nodeBitmapHeapscan.h"
 #include "executor/nodeCustom.h"
 #include "executor/nodeForeignscan.h"
+#include "executor/nodeHash.h"
 #include "executor/nodeSeqscan.h"
 #include "executor/tqueue.h"
 #include "nodes/nodeFuncs.h"
@@ -96,6 +98,13 @@ typedef struct ExecParallelInitializeDSMContext
 	int			nnodes;
 } ExecParallelInitializeDSMContext;
 
+/* Context object for ExecParallelInitializeWorker. */
+typedef struct ExecParallelInitializeWorkerContext
+{
+	shm_toc    *toc;
+	dsm_segment *seg;
+} ExecParallelInitializeWorkerContext;
+
 /* Helper functions that run in the parallel leader. */
 static char *ExecSerializePlan(Plan *plan, EState *estate);
 static bool ExecParallelEstimate(PlanState *node,
@@ -205,6 +214,13 @@ ExecParallelEstimate(PlanState *planstate, ExecParallelEstimateContext *e)
 				ExecCustomScanEstimate((CustomScanState *) planstate,
 									   e->pcxt);
 				break;
+			case T_BitmapHeapScanState:
+				ExecBitmapHeapEstimate((BitmapHeapScanState *) planstate,
+									   e->pcxt);
+				break;
+			case T_HashState:
+				ExecHashEstimate((HashState *) planstate, e->pcxt);
+				break;
 			default:
 				break;
 		}
@@ -257,6 +273,13 @@ ExecParallelInitializeDSM(PlanState *planstate,
 				ExecCustomScanInitializeDSM((CustomScanState *) planstate,
 											d->pcxt);
 				break;
+			case T_BitmapHeapScanState:
+				ExecBitmapHeapInitializeDSM((BitmapHeapScanState *) planstate,
+											d->pcxt);
+				break;
+			case T_HashState:
+				ExecHashInitializeDSM((HashState *) planstate, d->pcxt);
+				break;
 			default:
 				break;
 		}
@@ -712,8 +735,11 @@ ExecParallelReportInstrumentation(PlanState *planstate,
  * is allocated and initialized by executor; that is, after ExecutorStart().
  */
 static bool
-ExecParallelInitializeWorker(PlanState *planstate, shm_toc *toc)
+ExecParallelInitializeWorker(PlanState *planstate,
+							 ExecParallelInitializeWorkerContext *w)
 {
+	shm_toc    *toc = w->toc;
+
 	if (planstate == NULL)
 		return false;
 
@@ -733,12 +759,20 @@ ExecParallelInitializeWorker(PlanState *planstate, shm_toc *toc)
 				ExecCustomScanInitializeWorker((CustomScanState *) planstate,
 											   toc);
 				break;
+			case T_BitmapHeapScanState:
+				ExecBitmapHeapInitializeWorker(
+									 (BitmapHeapScanState *) planstate, toc);
+				break;
+			case T_HashState:
+				ExecHashInitializeWorker((HashState *) planstate, toc,
+										 w->seg);
+				break;
 			default:
 				break;
 		}
 	}
 
-	return planstate_tree_walker(planstate, ExecParallelInitializeWorker, toc);
+	return planstate_tree_walker(planstate, ExecParallelInitializeWorker, w);
 }
 
 /*
@@ -767,6 +801,7 @@ ParallelQueryMain(dsm_segment *seg, shm_toc *toc)
 	int			instrument_options = 0;
 	void	   *area_space;
 	dsa_area   *area;
+	ExecParallelInitializeWorkerContext worker_cxt;
 
 	/* Set up DestReceiver, SharedExecutorInstrumentation, and QueryDesc. */
 	receiver = ExecParallelGetReceiver(seg, toc);
@@ -787,7 +822,9 @@ ParallelQueryMain(dsm_segment *seg, shm_toc *toc)
 
 	/* Special executor initialization steps for parallel workers */
 	queryDesc->planstate->state->es_query_dsa = area;
-	ExecParallelInitializeWorker(queryDesc->planstate, toc);
+	worker_cxt.toc = toc;
+	worker_cxt.seg = seg;
+	ExecParallelInitializeWorker(queryDesc->planstate, &worker_cxt);
 
 	/* Run the plan */
 	ExecutorRun(queryDesc, ForwardScanDirection, 0L);
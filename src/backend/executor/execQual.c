@@ -41,6 +41,7 @@
 #include "access/tupconvert.h"
 #include "catalog/objectaccess.h"
 #include "catalog/pg_type.h"
+#include "executor/execExpr.h"
 #include "executor/execdebug.h"
 #include "executor/nodeSubplan.h"
 #include "funcapi.h"
@@ -4273,6 +4274,18 @@ ExecInitExpr(Expr *node, PlanState *parent)
 	/* Guard against stack overflow due to overly complex expressions */
 	check_stack_depth();
 
+	/*
+	 * If the whole subtree consists of node types that execExprInterp.c
+	 * knows how to flatten, evaluate it as a linear step program instead of
+	 * recursing through the state tree built below.
+	 */
+	state = ExecCompileExpr(node);
+	if (state != NULL)
+	{
+		state->expr = node;
+		return state;
+	}
+
 	switch (nodeTag(node))
 	{
 		case T_Var:
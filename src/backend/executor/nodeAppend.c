@@ -36,6 +36,14 @@
  *			  nil	nil		 ...    ...    ...
  *								 subplans
  *
+ *		Subplans that can run asynchronously (currently, foreign scans
+ *		whose FDW supports it) are not processed in turn.  Instead they
+ *		are all started as soon as the Append is first executed, so that
+ *		remote servers can work in parallel, and their tuples are returned
+ *		in whatever order they arrive.  Synchronous subplans are run while
+ *		the asynchronous ones are waiting; when there is nothing else to
+ *		do, we sleep until one of the latter becomes ready.
+ *
  *		Append nodes are currently used for unions, and to support
  *		inheritance queries, where several relations need to be scanned.
  *		For example, in our standard person/student/employee/student-emp
@@ -59,8 +67,15 @@
 
 #include "executor/execdebug.h"
 #include "executor/nodeAppend.h"
+#include "executor/nodeForeignscan.h"
+#include "miscadmin.h"
+#include "optimizer/cost.h"
+#include "pgstat.h"
+#include "storage/latch.h"
 
 static bool exec_append_initialize_next(AppendState *appendstate);
+static TupleTableSlot *exec_append_async(AppendState *node);
+static void exec_append_async_wait(AppendState *node);
 
 
 /* ----------------------------------------------------------------
@@ -169,6 +184,34 @@ ExecInitAppend(Append *node, EState *estate, int eflags)
 		i++;
 	}
 
+	/*
+	 * Decide which subplans to run asynchronously.  We don't do that if we
+	 * might be asked to scan backwards, since tuples are returned in
+	 * arrival order, nor when rechecking a row for EvalPlanQual.
+	 */
+	appendstate->as_asyncplans = (bool *) palloc0(nplans * sizeof(bool));
+	appendstate->as_asyncdone = (bool *) palloc0(nplans * sizeof(bool));
+	appendstate->as_nasyncplans = 0;
+	if (enable_async_append &&
+		!(eflags & EXEC_FLAG_BACKWARD) &&
+		estate->es_epqTuple == NULL)
+	{
+		for (i = 0; i < nplans; i++)
+		{
+			PlanState  *subnode = appendplanstates[i];
+
+			if (IsA(subnode, ForeignScanState) &&
+				ExecForeignScanAsyncCapable((ForeignScanState *) subnode))
+			{
+				((ForeignScanState *) subnode)->async_mode = true;
+				appendstate->as_asyncplans[i] = true;
+				appendstate->as_nasyncplans++;
+			}
+		}
+	}
+	appendstate->as_nasyncremaining = appendstate->as_nasyncplans;
+	appendstate->as_asyncnext = 0;
+
 	/*
 	 * initialize output tuple type
 	 */
@@ -193,6 +236,9 @@ ExecInitAppend(Append *node, EState *estate, int eflags)
 TupleTableSlot *
 ExecAppend(AppendState *node)
 {
+	if (node->as_nasyncplans > 0)
+		return exec_append_async(node);
+
 	for (;;)
 	{
 		PlanState  *subnode;
@@ -234,6 +280,140 @@ ExecAppend(AppendState *node)
 	}
 }
 
+/* ----------------------------------------------------------------
+ *		exec_append_async
+ *
+ *		ExecAppend for an Append with asynchronous subplans.  Only
+ *		forward scans are supported.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+exec_append_async(AppendState *node)
+{
+	for (;;)
+	{
+		TupleTableSlot *result;
+		int			k;
+
+		/*
+		 * Return a tuple from an asynchronous subplan that has one ready,
+		 * preferring the one we returned the last tuple from.  Calling a
+		 * subplan that has not been started yet starts it, so on the first
+		 * pass through here all of them get started.
+		 */
+		for (k = 0; k < node->as_nplans && node->as_nasyncremaining > 0; k++)
+		{
+			int			i = (node->as_asyncnext + k) % node->as_nplans;
+			ForeignScanState *subnode;
+
+			if (!node->as_asyncplans[i] || node->as_asyncdone[i])
+				continue;
+			subnode = (ForeignScanState *) node->appendplans[i];
+			if (subnode->async_waiting)
+				continue;
+
+			result = ExecProcNode((PlanState *) subnode);
+			if (!TupIsNull(result))
+			{
+				node->as_asyncnext = i;
+				return result;
+			}
+
+			/* An empty slot means EOF, unless the subplan is just waiting */
+			if (!subnode->async_waiting)
+			{
+				node->as_asyncdone[i] = true;
+				node->as_nasyncremaining--;
+			}
+		}
+
+		/*
+		 * All the asynchronous subplans are either done or waiting for data,
+		 * so make progress with the synchronous ones meanwhile.
+		 */
+		while (node->as_whichplan < node->as_nplans &&
+			   node->as_asyncplans[node->as_whichplan])
+			node->as_whichplan++;
+
+		if (node->as_whichplan < node->as_nplans)
+		{
+			result = ExecProcNode(node->appendplans[node->as_whichplan]);
+			if (!TupIsNull(result))
+				return result;
+			node->as_whichplan++;
+			continue;
+		}
+
+		/* If everything is done, return the empty slot */
+		if (node->as_nasyncremaining == 0)
+			return ExecClearTuple(node->ps.ps_ResultTupleSlot);
+
+		/* Otherwise, there is nothing to do but wait */
+		exec_append_async_wait(node);
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		exec_append_async_wait
+ *
+ *		Sleep until one of the waiting asynchronous subplans has data,
+ *		and let it process its events.
+ * ----------------------------------------------------------------
+ */
+static void
+exec_append_async_wait(AppendState *node)
+{
+	WaitEventSet *set;
+	WaitEvent  *occurred_events;
+	int			nevents = 1;	/* for our latch */
+	int			noccurred;
+	int			i;
+
+	/*
+	 * A subplan we passed over might have received its data meanwhile, as a
+	 * side effect of running another one that shares its remote connection.
+	 * Don't sleep in that case.
+	 */
+	for (i = 0; i < node->as_nplans; i++)
+	{
+		if (node->as_asyncplans[i] && !node->as_asyncdone[i])
+		{
+			if (!((ForeignScanState *) node->appendplans[i])->async_waiting)
+				return;
+			nevents++;
+		}
+	}
+
+	set = CreateWaitEventSet(CurrentMemoryContext, nevents);
+	AddWaitEventToSet(set, WL_LATCH_SET, PGINVALID_SOCKET, MyLatch, NULL);
+	for (i = 0; i < node->as_nplans; i++)
+	{
+		if (node->as_asyncplans[i] && !node->as_asyncdone[i])
+			ExecAsyncForeignScanConfigureWait((ForeignScanState *) node->appendplans[i],
+											  set);
+	}
+
+	occurred_events = (WaitEvent *) palloc(nevents * sizeof(WaitEvent));
+	noccurred = WaitEventSetWait(set, -1L, occurred_events, nevents,
+								 WAIT_EVENT_APPEND_READY);
+	FreeWaitEventSet(set);
+
+	for (i = 0; i < noccurred; i++)
+	{
+		WaitEvent  *w = &occurred_events[i];
+
+		if (w->events & WL_LATCH_SET)
+		{
+			ResetLatch(MyLatch);
+			CHECK_FOR_INTERRUPTS();
+		}
+		else if (w->events & WL_SOCKET_READABLE)
+			ExecAsyncForeignScanNotify((ForeignScanState *) w->user_data);
+	}
+
+	pfree(occurred_events);
+}
+
 /* ----------------------------------------------------------------
  *		ExecEndAppend
  *
@@ -287,4 +467,9 @@ ExecReScanAppend(AppendState *node)
 	}
 	node->as_whichplan = 0;
 	exec_append_initialize_next(node);
+
+	for (i = 0; i < node->as_nplans; i++)
+		node->as_asyncdone[i] = false;
+	node->as_nasyncremaining = node->as_nasyncplans;
+	node->as_asyncnext = 0;
 }
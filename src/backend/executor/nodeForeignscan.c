@@ -218,6 +218,8 @@ ExecInitForeignScan(ForeignScan *node, EState *estate, int eflags)
 	 */
 	scanstate->fdwroutine = fdwroutine;
 	scanstate->fdw_state = NULL;
+	scanstate->async_mode = false;
+	scanstate->async_waiting = false;
 
 	/* Initialize any outer plan. */
 	if (outerPlan(node))
@@ -353,3 +355,50 @@ ExecForeignScanInitializeWorker(ForeignScanState *node, shm_toc *toc)
 		fdwroutine->InitializeWorkerForeignScan(node, toc, coordinate);
 	}
 }
+
+/* ----------------------------------------------------------------
+ *		ExecForeignScanAsyncCapable
+ *
+ *		Can the scan be run asynchronously under an Append?
+ * ----------------------------------------------------------------
+ */
+bool
+ExecForeignScanAsyncCapable(ForeignScanState *node)
+{
+	FdwRoutine *fdwroutine = node->fdwroutine;
+
+	if (fdwroutine->IsForeignScanAsyncCapable == NULL ||
+		fdwroutine->ForeignAsyncConfigureWait == NULL ||
+		fdwroutine->ForeignAsyncNotify == NULL)
+		return false;
+
+	return fdwroutine->IsForeignScanAsyncCapable(node);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAsyncForeignScanConfigureWait
+ *
+ *		Add the events an asynchronous scan is waiting for to the set
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncForeignScanConfigureWait(ForeignScanState *node, WaitEventSet *set)
+{
+	Assert(node->async_mode && node->async_waiting);
+
+	node->fdwroutine->ForeignAsyncConfigureWait(node, set);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAsyncForeignScanNotify
+ *
+ *		Let an asynchronous scan process an event it was waiting for
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncForeignScanNotify(ForeignScanState *node)
+{
+	Assert(node->async_mode);
+
+	node->fdwroutine->ForeignAsyncNotify(node);
+}
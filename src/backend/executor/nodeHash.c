@@ -17,6 +17,9 @@
  *		MultiExecHash	- generate an in-memory hash table of the relation
  *		ExecInitHash	- initialize node and subnodes
  *		ExecEndHash		- shutdown node and subnodes
+ *		ExecHashEstimate		- estimate DSM space needed for a shared table
+ *		ExecHashInitializeDSM	- initialize DSM for a shared table
+ *		ExecHashInitializeWorker - attach to DSM info in parallel worker
  */
 
 #include "postgres.h"
@@ -32,6 +35,7 @@
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "utils/dynahash.h"
 #include "utils/memutils.h"
 #include "utils/lsyscache.h"
@@ -50,6 +54,25 @@ static void ExecHashRemoveNextSkewBucket(HashJoinTable hashtable);
 
 static void *dense_alloc(HashJoinTable hashtable, Size size);
 
+static void MultiExecPrivateHash(HashState *node);
+static void MultiExecParallelHash(HashState *node);
+static void ExecParallelHashTableInsert(HashJoinTable hashtable,
+							TupleTableSlot *slot,
+							uint32 hashvalue);
+static void *ExecParallelHashTupleAlloc(HashJoinTable hashtable, Size size,
+						   dsa_pointer *shared);
+static void ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable);
+static void ExecParallelHashSaveOverflowTuple(HashJoinTable hashtable,
+								  MinimalTuple tuple, uint32 hashvalue);
+static bool ExecParallelHashReadOverflowTuple(BufFile *file,
+								  TupleTableSlot *slot, uint32 *hashvalue);
+static void ExecParallelHashOverflowFileName(char *name, int fileno);
+static void ExecParallelHashLoadPrivate(HashState *node);
+static inline HashJoinTuple ExecHashFirstTuple(HashJoinTable hashtable,
+				   int bucketno);
+static inline HashJoinTuple ExecHashNextTuple(HashJoinTable hashtable,
+				  HashJoinTuple tuple);
+
 /* ----------------------------------------------------------------
  *		ExecHash
  *
@@ -72,6 +95,38 @@ ExecHash(HashState *node)
  */
 Node *
 MultiExecHash(HashState *node)
+{
+	/* must provide our own instrumentation support */
+	if (node->ps.instrument)
+		InstrStartNode(node->ps.instrument);
+
+	if (node->parallel_state != NULL)
+		MultiExecParallelHash(node);
+	else
+		MultiExecPrivateHash(node);
+
+	/* must provide our own instrumentation support */
+	if (node->ps.instrument)
+		InstrStopNode(node->ps.instrument, node->hashtable->totalTuples);
+
+	/*
+	 * We do not return the hash table directly because it's not a subtype of
+	 * Node, and so would violate the MultiExecProcNode API.  Instead, our
+	 * parent Hashjoin node is expected to know how to fish it out of our node
+	 * state.  Ugly but not really worth cleaning up, since Hashjoin knows
+	 * quite a bit more about Hash besides that.
+	 */
+	return NULL;
+}
+
+/* ----------------------------------------------------------------
+ *		MultiExecPrivateHash
+ *
+ *		build a backend-private hash table
+ * ----------------------------------------------------------------
+ */
+static void
+MultiExecPrivateHash(HashState *node)
 {
 	PlanState  *outerNode;
 	List	   *hashkeys;
@@ -80,10 +135,6 @@ MultiExecHash(HashState *node)
 	ExprContext *econtext;
 	uint32		hashvalue;
 
-	/* must provide our own instrumentation support */
-	if (node->ps.instrument)
-		InstrStartNode(node->ps.instrument);
-
 	/*
 	 * get state info from node
 	 */
@@ -137,19 +188,143 @@ MultiExecHash(HashState *node)
 	hashtable->spaceUsed += hashtable->nbuckets * sizeof(HashJoinTuple);
 	if (hashtable->spaceUsed > hashtable->spacePeak)
 		hashtable->spacePeak = hashtable->spaceUsed;
+}
 
-	/* must provide our own instrumentation support */
-	if (node->ps.instrument)
-		InstrStopNode(node->ps.instrument, hashtable->totalTuples);
+/* ----------------------------------------------------------------
+ *		MultiExecParallelHash
+ *
+ *		build a hash table in shared memory, together with any other
+ *		processes participating in the parallel query
+ *
+ * A process that arrives while the build is still in progress attaches and
+ * inserts whatever tuples its share of the (partial) inner plan produces.
+ * The inner plan divides its tuples among the processes that run it, so
+ * once the last attached participant has finished, every inner tuple is in
+ * the table; that participant then enlarges the bucket array if the
+ * estimate was too low, marks the build done and wakes up everyone else.
+ * A process that arrives after that point just uses the finished table.
+ *
+ * The shared table may not grow beyond work_mem, since unlike a private
+ * table it can't be split into batches.  If the planner underestimated the
+ * inner relation and it doesn't fit, the participants write the tuples that
+ * don't fit to shared overflow files instead; once the build is done, each
+ * of them then builds a private hash table of the whole inner relation from
+ * the shared chunks and the overflow files, which keeps within work_mem by
+ * using multiple batches as usual.  That costs about as much as the
+ * non-shared plan would have, in which each participant hashes the whole
+ * inner relation by itself.
+ * ----------------------------------------------------------------
+ */
+static void
+MultiExecParallelHash(HashState *node)
+{
+	ParallelHashJoinState *pstate = node->parallel_state;
+	HashJoinTable hashtable = node->hashtable;
+	bool		attached = false;
+
+	SpinLockAcquire(&pstate->mutex);
+	if (pstate->build_state == PHJ_BUILD_HASHING)
+	{
+		pstate->nparticipants++;
+		attached = true;
+	}
+	SpinLockRelease(&pstate->mutex);
+
+	if (attached)
+	{
+		PlanState  *outerNode = outerPlanState(node);
+		List	   *hashkeys = node->hashkeys;
+		ExprContext *econtext = node->ps.ps_ExprContext;
+		TupleTableSlot *slot;
+		uint32		hashvalue;
+		bool		last;
+
+		for (;;)
+		{
+			slot = ExecProcNode(outerNode);
+			if (TupIsNull(slot))
+				break;
+			econtext->ecxt_innertuple = slot;
+			if (ExecHashGetHashValue(hashtable, econtext, hashkeys,
+									 false, hashtable->keepNulls,
+									 &hashvalue))
+			{
+				ExecParallelHashTableInsert(hashtable, slot, hashvalue);
+				hashtable->totalTuples += 1;
+			}
+		}
+
+		/* This participant's chunk is complete; forget it. */
+		hashtable->current_chunk = NULL;
+		hashtable->current_chunk_shared = InvalidDsaPointer;
+
+		/* Likewise our overflow file, which others may now read */
+		if (hashtable->overflow_file != NULL)
+		{
+			BufFileClose(hashtable->overflow_file);
+			hashtable->overflow_file = NULL;
+		}
+
+		SpinLockAcquire(&pstate->mutex);
+		pstate->total_tuples += hashtable->totalTuples;
+		last = (--pstate->nparticipants == 0);
+		if (last)
+			pstate->build_state = PHJ_BUILD_GROWING;
+		SpinLockRelease(&pstate->mutex);
+
+		if (last)
+		{
+			/*
+			 * Nobody else can touch the table now, so resize it if needed;
+			 * but not if it overflowed, since it won't be probed then.
+			 */
+			if (!pstate->overflowed)
+				ExecParallelHashIncreaseNumBuckets(hashtable);
+
+			SpinLockAcquire(&pstate->mutex);
+			pstate->build_state = PHJ_BUILD_DONE;
+			SpinLockRelease(&pstate->mutex);
+			ConditionVariableBroadcast(&pstate->build_cv);
+		}
+	}
+
+	/* Wait until the table is complete. */
+	ConditionVariablePrepareToSleep(&pstate->build_cv);
+	for (;;)
+	{
+		bool		done;
+
+		SpinLockAcquire(&pstate->mutex);
+		done = (pstate->build_state == PHJ_BUILD_DONE);
+		SpinLockRelease(&pstate->mutex);
+
+		if (done)
+			break;
+		ConditionVariableSleep(&pstate->build_cv,
+							   WAIT_EVENT_PARALLEL_HASH_BUILD);
+	}
+	ConditionVariableCancelSleep();
+
+	/* If the inner relation didn't fit, build our own table of it instead */
+	if (pstate->overflowed)
+	{
+		ExecParallelHashLoadPrivate(node);
+		return;
+	}
 
 	/*
-	 * We do not return the hash table directly because it's not a subtype of
-	 * Node, and so would violate the MultiExecProcNode API.  Instead, our
-	 * parent Hashjoin node is expected to know how to fish it out of our node
-	 * state.  Ugly but not really worth cleaning up, since Hashjoin knows
-	 * quite a bit more about Hash besides that.
+	 * The shared sizing information can no longer change, so copy it into our
+	 * private control block for use while probing.
 	 */
-	return NULL;
+	hashtable->nbuckets = pstate->nbuckets;
+	hashtable->log2_nbuckets = pstate->log2_nbuckets;
+	hashtable->nbuckets_optimal = pstate->nbuckets;
+	hashtable->log2_nbuckets_optimal = pstate->log2_nbuckets;
+	hashtable->buckets.shared = (dsa_pointer_atomic *)
+		dsa_get_address(hashtable->area, pstate->buckets);
+	hashtable->totalTuples = pstate->total_tuples;
+	hashtable->spaceUsed = pstate->space_used;
+	hashtable->spacePeak = pstate->space_used;
 }
 
 /* ----------------------------------------------------------------
@@ -174,6 +349,7 @@ ExecInitHash(Hash *node, EState *estate, int eflags)
 	hashstate->ps.state = estate;
 	hashstate->hashtable = NULL;
 	hashstate->hashkeys = NIL;	/* will be set by parent HashJoin */
+	hashstate->parallel_state = NULL;	/* set by ExecHashInitializeDSM */
 
 	/*
 	 * Miscellaneous initialization
@@ -243,8 +419,10 @@ ExecEndHash(HashState *node)
  * ----------------------------------------------------------------
  */
 HashJoinTable
-ExecHashTableCreate(Hash *node, List *hashOperators, bool keepNulls)
+ExecHashTableCreate(HashState *state, List *hashOperators, bool keepNulls)
 {
+	Hash	   *node = (Hash *) state->ps.plan;
+	ParallelHashJoinState *pstate = state->parallel_state;
 	HashJoinTable hashtable;
 	Plan	   *outerNode;
 	int			nbuckets;
@@ -259,13 +437,22 @@ ExecHashTableCreate(Hash *node, List *hashOperators, bool keepNulls)
 	/*
 	 * Get information about the size of the relation to be hashed (it's the
 	 * "outer" subtree of this node, but the inner relation of the hashjoin).
-	 * Compute the appropriate size of the hash table.
+	 * Compute the appropriate size of the hash table.  A shared hash table
+	 * was already sized when its bucket array was created, and always has a
+	 * single batch.
 	 */
 	outerNode = outerPlan(node);
 
-	ExecChooseHashTableSize(outerNode->plan_rows, outerNode->plan_width,
-							OidIsValid(node->skewTable),
-							&nbuckets, &nbatch, &num_skew_mcvs);
+	if (pstate != NULL)
+	{
+		nbuckets = pstate->nbuckets;
+		nbatch = 1;
+		num_skew_mcvs = 0;
+	}
+	else
+		ExecChooseHashTableSize(outerNode->plan_rows, outerNode->plan_width,
+								OidIsValid(node->skewTable),
+								&nbuckets, &nbatch, &num_skew_mcvs);
 
 	/* nbuckets must be a power of 2 */
 	log2_nbuckets = my_log2(nbuckets);
@@ -283,7 +470,7 @@ ExecHashTableCreate(Hash *node, List *hashOperators, bool keepNulls)
 	hashtable->nbuckets_optimal = nbuckets;
 	hashtable->log2_nbuckets = log2_nbuckets;
 	hashtable->log2_nbuckets_optimal = log2_nbuckets;
-	hashtable->buckets = NULL;
+	hashtable->buckets.unshared = NULL;
 	hashtable->keepNulls = keepNulls;
 	hashtable->skewEnabled = false;
 	hashtable->skewBucket = NULL;
@@ -306,6 +493,11 @@ ExecHashTableCreate(Hash *node, List *hashOperators, bool keepNulls)
 	hashtable->spaceAllowedSkew =
 		hashtable->spaceAllowed * SKEW_WORK_MEM_PERCENT / 100;
 	hashtable->chunks = NULL;
+	hashtable->area = state->ps.state->es_query_dsa;
+	hashtable->parallel_state = pstate;
+	hashtable->current_chunk = NULL;
+	hashtable->current_chunk_shared = InvalidDsaPointer;
+	hashtable->overflow_file = NULL;
 
 #ifdef HJDEBUG
 	printf("Hashjoin %p: initial nbatch = %d, nbuckets = %d\n",
@@ -370,12 +562,17 @@ ExecHashTableCreate(Hash *node, List *hashOperators, bool keepNulls)
 
 	/*
 	 * Prepare context for the first-scan space allocations; allocate the
-	 * hashbucket array therein, and set each bucket "empty".
+	 * hashbucket array therein, and set each bucket "empty".  A shared
+	 * bucket array already exists in the DSA area.
 	 */
 	MemoryContextSwitchTo(hashtable->batchCxt);
 
-	hashtable->buckets = (HashJoinTuple *)
-		palloc0(nbuckets * sizeof(HashJoinTuple));
+	if (pstate != NULL)
+		hashtable->buckets.shared = (dsa_pointer_atomic *)
+			dsa_get_address(hashtable->area, pstate->buckets);
+	else
+		hashtable->buckets.unshared = (HashJoinTuple *)
+			palloc0(nbuckets * sizeof(HashJoinTuple));
 
 	/*
 	 * Set up for skew optimization, if possible and there's a need for more
@@ -660,7 +857,7 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 		hashtable->nbuckets = hashtable->nbuckets_optimal;
 		hashtable->log2_nbuckets = hashtable->log2_nbuckets_optimal;
 
-		hashtable->buckets = repalloc(hashtable->buckets,
+		hashtable->buckets.unshared = repalloc(hashtable->buckets.unshared,
 								sizeof(HashJoinTuple) * hashtable->nbuckets);
 	}
 
@@ -669,14 +866,15 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	 * buckets now and not have to keep track which tuples in the buckets have
 	 * already been processed. We will free the old chunks as we go.
 	 */
-	memset(hashtable->buckets, 0, sizeof(HashJoinTuple) * hashtable->nbuckets);
+	memset(hashtable->buckets.unshared, 0,
+		   sizeof(HashJoinTuple) * hashtable->nbuckets);
 	oldchunks = hashtable->chunks;
 	hashtable->chunks = NULL;
 
 	/* so, let's scan through the old chunks, and all tuples in each chunk */
 	while (oldchunks != NULL)
 	{
-		HashMemoryChunk nextchunk = oldchunks->next;
+		HashMemoryChunk nextchunk = oldchunks->next.unshared;
 
 		/* position within the buffer (up to oldchunks->used) */
 		size_t		idx = 0;
@@ -703,8 +901,8 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 				memcpy(copyTuple, hashTuple, hashTupleSize);
 
 				/* and add it back to the appropriate bucket */
-				copyTuple->next = hashtable->buckets[bucketno];
-				hashtable->buckets[bucketno] = copyTuple;
+				copyTuple->next.unshared = hashtable->buckets.unshared[bucketno];
+				hashtable->buckets.unshared[bucketno] = copyTuple;
 			}
 			else
 			{
@@ -782,14 +980,15 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 	 * ExecHashIncreaseNumBatches, but without all the copying into new
 	 * chunks)
 	 */
-	hashtable->buckets =
-		(HashJoinTuple *) repalloc(hashtable->buckets,
+	hashtable->buckets.unshared =
+		(HashJoinTuple *) repalloc(hashtable->buckets.unshared,
 								hashtable->nbuckets * sizeof(HashJoinTuple));
 
-	memset(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashJoinTuple));
+	memset(hashtable->buckets.unshared, 0,
+		   hashtable->nbuckets * sizeof(HashJoinTuple));
 
 	/* scan through all tuples in all chunks to rebuild the hash table */
-	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next)
+	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
 	{
 		/* process all tuples stored in this chunk */
 		size_t		idx = 0;
@@ -804,8 +1003,8 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 									  &bucketno, &batchno);
 
 			/* add the tuple to the proper bucket */
-			hashTuple->next = hashtable->buckets[bucketno];
-			hashtable->buckets[bucketno] = hashTuple;
+			hashTuple->next.unshared = hashtable->buckets.unshared[bucketno];
+			hashtable->buckets.unshared[bucketno] = hashTuple;
 
 			/* advance index past the tuple */
 			idx += MAXALIGN(HJTUPLE_OVERHEAD +
@@ -866,8 +1065,8 @@ ExecHashTableInsert(HashJoinTable hashtable,
 		HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(hashTuple));
 
 		/* Push it onto the front of the bucket's list */
-		hashTuple->next = hashtable->buckets[bucketno];
-		hashtable->buckets[bucketno] = hashTuple;
+		hashTuple->next.unshared = hashtable->buckets.unshared[bucketno];
+		hashtable->buckets.unshared[bucketno] = hashTuple;
 
 		/*
 		 * Increase the (optimal) number of buckets if we just exceeded the
@@ -1073,11 +1272,11 @@ ExecScanHashBucket(HashJoinState *hjstate,
 	 * otherwise scan the standard hashtable bucket.
 	 */
 	if (hashTuple != NULL)
-		hashTuple = hashTuple->next;
+		hashTuple = ExecHashNextTuple(hashtable, hashTuple);
 	else if (hjstate->hj_CurSkewBucketNo != INVALID_SKEW_BUCKET_NO)
 		hashTuple = hashtable->skewBucket[hjstate->hj_CurSkewBucketNo]->tuples;
 	else
-		hashTuple = hashtable->buckets[hjstate->hj_CurBucketNo];
+		hashTuple = ExecHashFirstTuple(hashtable, hjstate->hj_CurBucketNo);
 
 	while (hashTuple != NULL)
 	{
@@ -1101,7 +1300,7 @@ ExecScanHashBucket(HashJoinState *hjstate,
 			}
 		}
 
-		hashTuple = hashTuple->next;
+		hashTuple = ExecHashNextTuple(hashtable, hashTuple);
 	}
 
 	/*
@@ -1144,6 +1343,9 @@ ExecScanHashTableForUnmatched(HashJoinState *hjstate, ExprContext *econtext)
 	HashJoinTable hashtable = hjstate->hj_HashTable;
 	HashJoinTuple hashTuple = hjstate->hj_CurTuple;
 
+	/* Parallel hash joins never fill the inner side. */
+	Assert(hashtable->parallel_state == NULL);
+
 	for (;;)
 	{
 		/*
@@ -1152,10 +1354,10 @@ ExecScanHashTableForUnmatched(HashJoinState *hjstate, ExprContext *econtext)
 		 * bucket.
 		 */
 		if (hashTuple != NULL)
-			hashTuple = hashTuple->next;
+			hashTuple = hashTuple->next.unshared;
 		else if (hjstate->hj_CurBucketNo < hashtable->nbuckets)
 		{
-			hashTuple = hashtable->buckets[hjstate->hj_CurBucketNo];
+			hashTuple = hashtable->buckets.unshared[hjstate->hj_CurBucketNo];
 			hjstate->hj_CurBucketNo++;
 		}
 		else if (hjstate->hj_CurSkewBucketNo < hashtable->nSkewBuckets)
@@ -1191,7 +1393,7 @@ ExecScanHashTableForUnmatched(HashJoinState *hjstate, ExprContext *econtext)
 				return true;
 			}
 
-			hashTuple = hashTuple->next;
+			hashTuple = hashTuple->next.unshared;
 		}
 	}
 
@@ -1220,7 +1422,7 @@ ExecHashTableReset(HashJoinTable hashtable)
 	oldcxt = MemoryContextSwitchTo(hashtable->batchCxt);
 
 	/* Reallocate and reinitialize the hash bucket headers. */
-	hashtable->buckets = (HashJoinTuple *)
+	hashtable->buckets.unshared = (HashJoinTuple *)
 		palloc0(nbuckets * sizeof(HashJoinTuple));
 
 	hashtable->spaceUsed = 0;
@@ -1244,7 +1446,8 @@ ExecHashTableResetMatchFlags(HashJoinTable hashtable)
 	/* Reset all flags in the main table ... */
 	for (i = 0; i < hashtable->nbuckets; i++)
 	{
-		for (tuple = hashtable->buckets[i]; tuple != NULL; tuple = tuple->next)
+		for (tuple = hashtable->buckets.unshared[i]; tuple != NULL;
+			 tuple = tuple->next.unshared)
 			HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(tuple));
 	}
 
@@ -1254,7 +1457,8 @@ ExecHashTableResetMatchFlags(HashJoinTable hashtable)
 		int			j = hashtable->skewBucketNums[i];
 		HashSkewBucket *skewBucket = hashtable->skewBucket[j];
 
-		for (tuple = skewBucket->tuples; tuple != NULL; tuple = tuple->next)
+		for (tuple = skewBucket->tuples; tuple != NULL;
+			 tuple = tuple->next.unshared)
 			HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(tuple));
 	}
 }
@@ -1506,7 +1710,7 @@ ExecHashSkewTableInsert(HashJoinTable hashtable,
 	HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(hashTuple));
 
 	/* Push it onto the front of the skew bucket's list */
-	hashTuple->next = hashtable->skewBucket[bucketNumber]->tuples;
+	hashTuple->next.unshared = hashtable->skewBucket[bucketNumber]->tuples;
 	hashtable->skewBucket[bucketNumber]->tuples = hashTuple;
 
 	/* Account for space used, and back off if we've used too much */
@@ -1555,7 +1759,7 @@ ExecHashRemoveNextSkewBucket(HashJoinTable hashtable)
 	hashTuple = bucket->tuples;
 	while (hashTuple != NULL)
 	{
-		HashJoinTuple nextHashTuple = hashTuple->next;
+		HashJoinTuple nextHashTuple = hashTuple->next.unshared;
 		MinimalTuple tuple;
 		Size		tupleSize;
 
@@ -1581,8 +1785,8 @@ ExecHashRemoveNextSkewBucket(HashJoinTable hashtable)
 			memcpy(copyTuple, hashTuple, tupleSize);
 			pfree(hashTuple);
 
-			copyTuple->next = hashtable->buckets[bucketno];
-			hashtable->buckets[bucketno] = copyTuple;
+			copyTuple->next.unshared = hashtable->buckets.unshared[bucketno];
+			hashtable->buckets.unshared[bucketno] = copyTuple;
 
 			/* We have reduced skew space, but overall space doesn't change */
 			hashtable->spaceUsedSkew -= tupleSize;
@@ -1666,12 +1870,12 @@ dense_alloc(HashJoinTable hashtable, Size size)
 		 */
 		if (hashtable->chunks != NULL)
 		{
-			newChunk->next = hashtable->chunks->next;
-			hashtable->chunks->next = newChunk;
+			newChunk->next.unshared = hashtable->chunks->next.unshared;
+			hashtable->chunks->next.unshared = newChunk;
 		}
 		else
 		{
-			newChunk->next = hashtable->chunks;
+			newChunk->next.unshared = hashtable->chunks;
 			hashtable->chunks = newChunk;
 		}
 
@@ -1696,7 +1900,7 @@ dense_alloc(HashJoinTable hashtable, Size size)
 		newChunk->used = size;
 		newChunk->ntuples = 1;
 
-		newChunk->next = hashtable->chunks;
+		newChunk->next.unshared = hashtable->chunks;
 		hashtable->chunks = newChunk;
 
 		return newChunk->data;
@@ -1710,3 +1914,591 @@ dense_alloc(HashJoinTable hashtable, Size size)
 	/* return pointer to the start of the tuple memory */
 	return ptr;
 }
+
+/*
+ * ExecHashFirstTuple
+ *		return the first tuple in a bucket of the main hash table
+ */
+static inline HashJoinTuple
+ExecHashFirstTuple(HashJoinTable hashtable, int bucketno)
+{
+	if (hashtable->parallel_state != NULL)
+	{
+		dsa_pointer p;
+
+		p = dsa_pointer_atomic_read(&hashtable->buckets.shared[bucketno]);
+		return (HashJoinTuple) dsa_get_address(hashtable->area, p);
+	}
+
+	return hashtable->buckets.unshared[bucketno];
+}
+
+/*
+ * ExecHashNextTuple
+ *		return the next tuple in the same bucket of the main hash table
+ */
+static inline HashJoinTuple
+ExecHashNextTuple(HashJoinTable hashtable, HashJoinTuple tuple)
+{
+	if (hashtable->parallel_state != NULL)
+		return (HashJoinTuple) dsa_get_address(hashtable->area,
+											   tuple->next.shared);
+
+	return tuple->next.unshared;
+}
+
+/*
+ * ExecParallelHashTableInsert
+ *		insert a tuple into a shared hash table
+ *
+ * A shared hash table has only one batch, so the tuple goes into memory
+ * unless the table has run out of space, in which case it's written to this
+ * participant's overflow file.  Other participants may be inserting into
+ * the same bucket concurrently, so the bucket's head pointer is swapped
+ * atomically.
+ */
+static void
+ExecParallelHashTableInsert(HashJoinTable hashtable,
+							TupleTableSlot *slot,
+							uint32 hashvalue)
+{
+	MinimalTuple tuple = ExecFetchSlotMinimalTuple(slot);
+	HashJoinTuple hashTuple;
+	dsa_pointer shared;
+	dsa_pointer_atomic *head;
+	int			bucketno;
+	int			batchno;
+
+	ExecHashGetBucketAndBatch(hashtable, hashvalue,
+							  &bucketno, &batchno);
+	Assert(batchno == 0);
+
+	/* Create the HashJoinTuple */
+	hashTuple = (HashJoinTuple)
+		ExecParallelHashTupleAlloc(hashtable, HJTUPLE_OVERHEAD + tuple->t_len,
+								   &shared);
+	if (hashTuple == NULL)
+	{
+		ExecParallelHashSaveOverflowTuple(hashtable, tuple, hashvalue);
+		return;
+	}
+	hashTuple->hashvalue = hashvalue;
+	memcpy(HJTUPLE_MINTUPLE(hashTuple), tuple, tuple->t_len);
+	HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(hashTuple));
+
+	/* Push it onto the front of the bucket's list */
+	head = &hashtable->buckets.shared[bucketno];
+	hashTuple->next.shared = dsa_pointer_atomic_read(head);
+	while (!dsa_pointer_atomic_compare_exchange(head,
+												&hashTuple->next.shared,
+												shared))
+	{
+		/* next.shared has been updated to the current head; retry */
+	}
+}
+
+/*
+ * Allocate 'size' bytes for a tuple in a shared hash table, returning both
+ * its backend-local address and its dsa_pointer (in *shared).
+ *
+ * This works like dense_alloc, except that each participant fills its own
+ * current chunk, and the chunks are linked into the shared list so that the
+ * bucket array can be rebuilt (and the memory freed) later.
+ *
+ * Returns NULL, and marks the table as overflowed, if a new chunk is needed
+ * but would take the table beyond its space allowance.
+ */
+static void *
+ExecParallelHashTupleAlloc(HashJoinTable hashtable, Size size,
+						   dsa_pointer *shared)
+{
+	ParallelHashJoinState *pstate = hashtable->parallel_state;
+	HashMemoryChunk chunk = hashtable->current_chunk;
+	dsa_pointer chunk_shared;
+	Size		chunk_size;
+	char	   *result;
+
+	/* just in case the size is not already aligned properly */
+	size = MAXALIGN(size);
+
+	/* Is there enough space in the current chunk? */
+	if (chunk != NULL && size <= HASH_CHUNK_THRESHOLD &&
+		chunk->maxlen - chunk->used >= size)
+	{
+		*shared = hashtable->current_chunk_shared + HASH_CHUNK_HEADER_SIZE +
+			chunk->used;
+		result = chunk->data + chunk->used;
+		chunk->used += size;
+		chunk->ntuples += 1;
+		return result;
+	}
+
+	/*
+	 * Allocate a new chunk.  As in dense_alloc, a tuple larger than 1/4 of
+	 * the chunk size gets a chunk of its own, and doesn't replace the chunk
+	 * we're currently filling.
+	 */
+	if (size > HASH_CHUNK_THRESHOLD)
+		chunk_size = HASH_CHUNK_HEADER_SIZE + size;
+	else
+		chunk_size = HASH_CHUNK_HEADER_SIZE + HASH_CHUNK_SIZE;
+
+	/* Reserve space for it, if we may */
+	SpinLockAcquire(&pstate->mutex);
+	if (pstate->overflowed ||
+		pstate->space_used + chunk_size > pstate->space_allowed)
+	{
+		pstate->overflowed = true;
+		SpinLockRelease(&pstate->mutex);
+		return NULL;
+	}
+	pstate->space_used += chunk_size;
+	SpinLockRelease(&pstate->mutex);
+
+	chunk_shared = dsa_allocate(hashtable->area, chunk_size);
+	chunk = (HashMemoryChunk) dsa_get_address(hashtable->area, chunk_shared);
+	chunk->maxlen = chunk_size - HASH_CHUNK_HEADER_SIZE;
+	chunk->used = size;
+	chunk->ntuples = 1;
+
+	SpinLockAcquire(&pstate->mutex);
+	chunk->next.shared = pstate->chunks;
+	pstate->chunks = chunk_shared;
+	SpinLockRelease(&pstate->mutex);
+
+	if (size <= HASH_CHUNK_THRESHOLD)
+	{
+		hashtable->current_chunk = chunk;
+		hashtable->current_chunk_shared = chunk_shared;
+	}
+
+	*shared = chunk_shared + HASH_CHUNK_HEADER_SIZE;
+	return chunk->data;
+}
+
+/*
+ * ExecParallelHashIncreaseNumBuckets
+ *		enlarge the bucket array of a shared hash table, if the initial
+ *		estimate turned out to be too low
+ *
+ * This is done by the last participant to finish hashing, while everyone
+ * else waits, so no atomic operations are needed to relink the tuples.  The
+ * larger bucket array must fit in what's left of the space allowance too;
+ * if it doesn't, we make do with fewer buckets than we'd like.
+ */
+static void
+ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable)
+{
+	ParallelHashJoinState *pstate = hashtable->parallel_state;
+	dsa_area   *area = hashtable->area;
+	dsa_pointer new_buckets_shared;
+	dsa_pointer_atomic *new_buckets;
+	dsa_pointer chunk_shared;
+	Size		chunk_space;
+	Size		bucket_space;
+	double		dbuckets;
+	int			nbuckets;
+	int			i;
+
+	Assert(pstate->build_state == PHJ_BUILD_GROWING);
+
+	/* The bucket array may use whatever the chunks left of the allowance */
+	chunk_space = pstate->space_used -
+		pstate->nbuckets * sizeof(dsa_pointer_atomic);
+	if (chunk_space < pstate->space_allowed)
+		bucket_space = pstate->space_allowed - chunk_space;
+	else
+		bucket_space = 0;
+
+	dbuckets = ceil(pstate->total_tuples / NTUP_PER_BUCKET);
+	dbuckets = Min(dbuckets, MaxAllocHugeSize / sizeof(dsa_pointer_atomic));
+	dbuckets = Min(dbuckets, INT_MAX / 2);
+	if (dbuckets <= pstate->nbuckets)
+		return;
+	nbuckets = 1 << my_log2((long) dbuckets);
+	while (nbuckets > pstate->nbuckets &&
+		   nbuckets * sizeof(dsa_pointer_atomic) > bucket_space)
+		nbuckets >>= 1;
+	if (nbuckets <= pstate->nbuckets)
+		return;
+
+#ifdef HJDEBUG
+	printf("Hashjoin %p: increasing shared nbuckets %d => %d\n",
+		   hashtable, pstate->nbuckets, nbuckets);
+#endif
+
+	new_buckets_shared = dsa_allocate_extended(area,
+									  nbuckets * sizeof(dsa_pointer_atomic),
+											   DSA_ALLOC_HUGE);
+	new_buckets = (dsa_pointer_atomic *)
+		dsa_get_address(area, new_buckets_shared);
+	for (i = 0; i < nbuckets; i++)
+		dsa_pointer_atomic_init(&new_buckets[i], InvalidDsaPointer);
+
+	/* scan through all tuples in all chunks to rebuild the hash table */
+	chunk_shared = pstate->chunks;
+	while (DsaPointerIsValid(chunk_shared))
+	{
+		HashMemoryChunk chunk;
+		size_t		idx = 0;
+
+		chunk = (HashMemoryChunk) dsa_get_address(area, chunk_shared);
+		while (idx < chunk->used)
+		{
+			HashJoinTuple hashTuple = (HashJoinTuple) (chunk->data + idx);
+			int			bucketno = hashTuple->hashvalue & (nbuckets - 1);
+
+			hashTuple->next.shared =
+				dsa_pointer_atomic_read(&new_buckets[bucketno]);
+			dsa_pointer_atomic_write(&new_buckets[bucketno],
+									 chunk_shared + HASH_CHUNK_HEADER_SIZE +
+									 idx);
+
+			/* advance index past the tuple */
+			idx += MAXALIGN(HJTUPLE_OVERHEAD +
+							HJTUPLE_MINTUPLE(hashTuple)->t_len);
+		}
+		chunk_shared = chunk->next.shared;
+	}
+
+	dsa_free(area, pstate->buckets);
+	pstate->space_used += (nbuckets - pstate->nbuckets) *
+		sizeof(dsa_pointer_atomic);
+	pstate->buckets = new_buckets_shared;
+	pstate->nbuckets = nbuckets;
+	pstate->log2_nbuckets = my_log2(nbuckets);
+}
+
+/*
+ * ExecParallelHashSaveOverflowTuple
+ *		write a tuple that didn't fit into a shared hash table to this
+ *		participant's overflow file, creating the file if necessary
+ */
+static void
+ExecParallelHashSaveOverflowTuple(HashJoinTable hashtable,
+								  MinimalTuple tuple, uint32 hashvalue)
+{
+	ParallelHashJoinState *pstate = hashtable->parallel_state;
+
+	if (hashtable->overflow_file == NULL)
+	{
+		char		name[MAXPGPATH];
+		int			fileno;
+
+		SpinLockAcquire(&pstate->mutex);
+		fileno = pstate->nfiles++;
+		SpinLockRelease(&pstate->mutex);
+
+		ExecParallelHashOverflowFileName(name, fileno);
+		hashtable->overflow_file = BufFileCreateShared(&pstate->fileset, name);
+	}
+
+	/* Same format as a batch file; see ExecHashJoinSaveTuple */
+	ExecHashJoinSaveTuple(tuple, hashvalue, &hashtable->overflow_file);
+}
+
+/*
+ * ExecParallelHashReadOverflowTuple
+ *		read the next tuple from an overflow file into the given slot.
+ *		Return false if there are no more.
+ */
+static bool
+ExecParallelHashReadOverflowTuple(BufFile *file, TupleTableSlot *slot,
+								  uint32 *hashvalue)
+{
+	uint32		header[2];
+	size_t		nread;
+	MinimalTuple tuple;
+
+	/* See ExecHashJoinGetSavedTuple */
+	nread = BufFileRead(file, (void *) header, sizeof(header));
+	if (nread == 0)				/* end of file */
+		return false;
+	if (nread != sizeof(header))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash-join temporary file: %m")));
+	*hashvalue = header[0];
+	tuple = (MinimalTuple) palloc(header[1]);
+	tuple->t_len = header[1];
+	nread = BufFileRead(file,
+						(void *) ((char *) tuple + sizeof(uint32)),
+						header[1] - sizeof(uint32));
+	if (nread != header[1] - sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash-join temporary file: %m")));
+	ExecStoreMinimalTuple(tuple, slot, true);
+	return true;
+}
+
+/*
+ * Construct the name of a shared hash table's overflow file.
+ */
+static void
+ExecParallelHashOverflowFileName(char *name, int fileno)
+{
+	snprintf(name, MAXPGPATH, "overflow%d", fileno);
+}
+
+/*
+ * ExecParallelHashLoadPrivate
+ *		build a backend-private hash table from the contents of a shared
+ *		hash table that overflowed
+ *
+ * Every inner tuple is either in one of the shared chunks or in one of the
+ * overflow files, and nobody modifies those any more, so we can read them
+ * all.  We turn our hash table, which was set up to refer to the shared
+ * one, into an ordinary private table sized for the number of tuples we now
+ * know about, and insert the tuples with ExecHashTableInsert, which writes
+ * those of later batches to our own batch files.  From here on the join
+ * proceeds as if the planner hadn't chosen a shared hash table.
+ */
+static void
+ExecParallelHashLoadPrivate(HashState *node)
+{
+	ParallelHashJoinState *pstate = node->parallel_state;
+	HashJoinTable hashtable = node->hashtable;
+	dsa_area   *area = hashtable->area;
+	Plan	   *outerNode = outerPlan(node->ps.plan);
+	TupleTableSlot *slot = node->ps.ps_ResultTupleSlot;
+	dsa_pointer chunk_shared;
+	MemoryContext oldcxt;
+	int			nbuckets;
+	int			nbatch;
+	int			num_skew_mcvs;
+	int			log2_nbuckets;
+	uint32		hashvalue;
+	int			i;
+
+	ExecChooseHashTableSize(pstate->total_tuples, outerNode->plan_width,
+							false, &nbuckets, &nbatch, &num_skew_mcvs);
+	log2_nbuckets = my_log2(nbuckets);
+
+#ifdef HJDEBUG
+	printf("Hashjoin %p: shared table overflowed, private nbatch = %d, nbuckets = %d\n",
+		   hashtable, nbatch, nbuckets);
+#endif
+
+	hashtable->parallel_state = NULL;
+	hashtable->nbuckets = nbuckets;
+	hashtable->nbuckets_original = nbuckets;
+	hashtable->nbuckets_optimal = nbuckets;
+	hashtable->log2_nbuckets = log2_nbuckets;
+	hashtable->log2_nbuckets_optimal = log2_nbuckets;
+	hashtable->nbatch = nbatch;
+	hashtable->nbatch_original = nbatch;
+	hashtable->nbatch_outstart = nbatch;
+	hashtable->totalTuples = 0;
+	hashtable->spaceUsed = 0;
+	hashtable->spacePeak = 0;
+
+	/* As in ExecHashTableCreate */
+	oldcxt = MemoryContextSwitchTo(hashtable->hashCxt);
+	if (nbatch > 1)
+	{
+		hashtable->innerBatchFile = (BufFile **)
+			palloc0(nbatch * sizeof(BufFile *));
+		hashtable->outerBatchFile = (BufFile **)
+			palloc0(nbatch * sizeof(BufFile *));
+		PrepareTempTablespaces();
+	}
+	MemoryContextSwitchTo(hashtable->batchCxt);
+	hashtable->buckets.unshared = (HashJoinTuple *)
+		palloc0(nbuckets * sizeof(HashJoinTuple));
+	MemoryContextSwitchTo(oldcxt);
+
+	/*
+	 * Load the tuples that made it into shared memory.  Our Hash node's
+	 * result slot is otherwise unused, and has the right descriptor.
+	 */
+	chunk_shared = pstate->chunks;
+	while (DsaPointerIsValid(chunk_shared))
+	{
+		HashMemoryChunk chunk;
+		size_t		idx = 0;
+
+		chunk = (HashMemoryChunk) dsa_get_address(area, chunk_shared);
+		while (idx < chunk->used)
+		{
+			HashJoinTuple hashTuple = (HashJoinTuple) (chunk->data + idx);
+			MinimalTuple tuple = HJTUPLE_MINTUPLE(hashTuple);
+
+			ExecStoreMinimalTuple(tuple, slot, false);
+			ExecHashTableInsert(hashtable, slot, hashTuple->hashvalue);
+			hashtable->totalTuples += 1;
+
+			/* advance index past the tuple */
+			idx += MAXALIGN(HJTUPLE_OVERHEAD + tuple->t_len);
+		}
+		chunk_shared = chunk->next.shared;
+	}
+
+	/* ... and those that were written to the overflow files */
+	for (i = 0; i < pstate->nfiles; i++)
+	{
+		char		name[MAXPGPATH];
+		BufFile    *file;
+
+		ExecParallelHashOverflowFileName(name, i);
+		file = BufFileOpenShared(&pstate->fileset, name);
+		while (ExecParallelHashReadOverflowTuple(file, slot, &hashvalue))
+		{
+			ExecHashTableInsert(hashtable, slot, hashvalue);
+			hashtable->totalTuples += 1;
+		}
+		BufFileClose(file);
+	}
+	ExecClearTuple(slot);
+
+	/* resize the hash table if needed (NTUP_PER_BUCKET exceeded) */
+	if (hashtable->nbuckets != hashtable->nbuckets_optimal)
+		ExecHashIncreaseNumBuckets(hashtable);
+
+	/* Account for the buckets in spaceUsed (reported in EXPLAIN ANALYZE) */
+	hashtable->spaceUsed += hashtable->nbuckets * sizeof(HashJoinTuple);
+	if (hashtable->spaceUsed > hashtable->spacePeak)
+		hashtable->spacePeak = hashtable->spaceUsed;
+}
+
+/*
+ * ExecHashResetParallelState
+ *		discard the contents of a shared hash table, so that it can be built
+ *		again on rescan
+ *
+ * Must be called by the leader while no workers are running.
+ */
+void
+ExecHashResetParallelState(HashState *node)
+{
+	ParallelHashJoinState *pstate = node->parallel_state;
+	dsa_area   *area = node->ps.state->es_query_dsa;
+	dsa_pointer_atomic *buckets;
+	dsa_pointer chunk_shared;
+	int			i;
+
+	chunk_shared = pstate->chunks;
+	while (DsaPointerIsValid(chunk_shared))
+	{
+		HashMemoryChunk chunk;
+		dsa_pointer next;
+
+		chunk = (HashMemoryChunk) dsa_get_address(area, chunk_shared);
+		next = chunk->next.shared;
+		dsa_free(area, chunk_shared);
+		chunk_shared = next;
+	}
+
+	buckets = (dsa_pointer_atomic *) dsa_get_address(area, pstate->buckets);
+	for (i = 0; i < pstate->nbuckets; i++)
+		dsa_pointer_atomic_write(&buckets[i], InvalidDsaPointer);
+
+	/* Everyone has closed the overflow files by now */
+	for (i = 0; i < pstate->nfiles; i++)
+	{
+		char		name[MAXPGPATH];
+
+		ExecParallelHashOverflowFileName(name, i);
+		BufFileDeleteShared(&pstate->fileset, name);
+	}
+
+	pstate->chunks = InvalidDsaPointer;
+	pstate->build_state = PHJ_BUILD_HASHING;
+	pstate->nparticipants = 0;
+	pstate->total_tuples = 0;
+	pstate->space_used = pstate->nbuckets * sizeof(dsa_pointer_atomic);
+	pstate->overflowed = false;
+	pstate->nfiles = 0;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecHashEstimate
+ *
+ *		estimates the space required for the shared state of a
+ *		parallel-aware hash node
+ * ----------------------------------------------------------------
+ */
+void
+ExecHashEstimate(HashState *node, ParallelContext *pcxt)
+{
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(ParallelHashJoinState));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecHashInitializeDSM
+ *
+ *		Set up the shared state and the empty bucket array of a shared
+ *		hash table.
+ * ----------------------------------------------------------------
+ */
+void
+ExecHashInitializeDSM(HashState *node, ParallelContext *pcxt)
+{
+	Hash	   *plan = (Hash *) node->ps.plan;
+	EState	   *estate = node->ps.state;
+	ParallelHashJoinState *pstate;
+	dsa_pointer_atomic *buckets;
+	int			nbuckets;
+	int			nbatch;
+	int			num_skew_mcvs;
+	int			i;
+
+	/*
+	 * If there is no shared memory area (we failed to create a DSM segment
+	 * and are running with private memory), just build a private hash table
+	 * in the leader; no workers will have been launched either.
+	 */
+	if (estate->es_query_dsa == NULL)
+		return;
+
+	/*
+	 * Size the table for the whole inner relation.  The planner only chose a
+	 * parallel-aware hash if a single batch would do, so we ignore nbatch;
+	 * if the estimate was wrong, the table will overflow work_mem, and
+	 * MultiExecParallelHash deals with that.
+	 */
+	ExecChooseHashTableSize(plan->rows_total, outerPlan(plan)->plan_width,
+							false, &nbuckets, &nbatch, &num_skew_mcvs);
+
+	pstate = shm_toc_allocate(pcxt->toc, sizeof(ParallelHashJoinState));
+	pstate->buckets = dsa_allocate_extended(estate->es_query_dsa,
+									  nbuckets * sizeof(dsa_pointer_atomic),
+											DSA_ALLOC_HUGE);
+	buckets = (dsa_pointer_atomic *)
+		dsa_get_address(estate->es_query_dsa, pstate->buckets);
+	for (i = 0; i < nbuckets; i++)
+		dsa_pointer_atomic_init(&buckets[i], InvalidDsaPointer);
+	pstate->nbuckets = nbuckets;
+	pstate->log2_nbuckets = my_log2(nbuckets);
+	pstate->chunks = InvalidDsaPointer;
+	pstate->build_state = PHJ_BUILD_HASHING;
+	pstate->nparticipants = 0;
+	pstate->total_tuples = 0;
+	pstate->space_used = nbuckets * sizeof(dsa_pointer_atomic);
+	pstate->space_allowed = work_mem * 1024L;
+	pstate->overflowed = false;
+	pstate->nfiles = 0;
+	SpinLockInit(&pstate->mutex);
+	ConditionVariableInit(&pstate->build_cv);
+	SharedFileSetInit(&pstate->fileset, pcxt->seg);
+
+	shm_toc_insert(pcxt->toc, node->ps.plan->plan_node_id, pstate);
+	node->parallel_state = pstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecHashInitializeWorker
+ *
+ *		Copy relevant information from TOC into planstate, and attach
+ *		to the shared file set.
+ * ----------------------------------------------------------------
+ */
+void
+ExecHashInitializeWorker(HashState *node, shm_toc *toc, dsm_segment *seg)
+{
+	Assert(node->ps.state->es_query_dsa != NULL);
+
+	node->parallel_state = shm_toc_lookup(toc, node->ps.plan->plan_node_id);
+	SharedFileSetAttach(&node->parallel_state->fileset, seg);
+}
@@ -148,7 +148,7 @@ ExecHashJoin(HashJoinState *node)
 				/*
 				 * create the hash table
 				 */
-				hashtable = ExecHashTableCreate((Hash *) hashNode->ps.plan,
+				hashtable = ExecHashTableCreate(hashNode,
 												node->hj_HashOperators,
 												HJ_FILL_INNER(node));
 				node->hj_HashTable = hashtable;
@@ -517,13 +517,19 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	lclauses = NIL;
 	rclauses = NIL;
 	hoperators = NIL;
-	foreach(l, hjstate->hashclauses)
+	foreach(l, node->hashclauses)
 	{
-		FuncExprState *fstate = castNode(FuncExprState, lfirst(l));
-		OpExpr	   *hclause = castNode(OpExpr, fstate->xprstate.expr);
+		OpExpr	   *hclause = castNode(OpExpr, lfirst(l));
 
-		lclauses = lappend(lclauses, linitial(fstate->args));
-		rclauses = lappend(rclauses, lsecond(fstate->args));
+		/*
+		 * hjstate->hashclauses may have been flattened by ExecInitExpr, so
+		 * build separate state trees for the arguments from the plan's own
+		 * expressions.
+		 */
+		lclauses = lappend(lclauses, ExecInitExpr(linitial(hclause->args),
+												  (PlanState *) hjstate));
+		rclauses = lappend(rclauses, ExecInitExpr(lsecond(hclause->args),
+												  (PlanState *) hjstate));
 		hoperators = lappend_oid(hoperators, hclause->opno);
 	}
 	hjstate->hj_OuterHashKeys = lclauses;
@@ -888,16 +894,19 @@ ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 void
 ExecReScanHashJoin(HashJoinState *node)
 {
+	HashState  *hashNode = (HashState *) innerPlanState(node);
+
 	/*
 	 * In a multi-batch join, we currently have to do rescans the hard way,
 	 * primarily because batch temp files may have already been released. But
 	 * if it's a single-batch join, and there is no parameter change for the
 	 * inner subnode, then we can just re-use the existing hash table without
-	 * rebuilding it.
+	 * rebuilding it.  (Not so for a shared hash table; see below.)
 	 */
 	if (node->hj_HashTable != NULL)
 	{
 		if (node->hj_HashTable->nbatch == 1 &&
+			hashNode->parallel_state == NULL &&
 			node->js.ps.righttree->chgParam == NULL)
 		{
 			/*
@@ -938,6 +947,24 @@ ExecReScanHashJoin(HashJoinState *node)
 				ExecReScan(node->js.ps.righttree);
 		}
 	}
+	else if (hashNode->parallel_state != NULL &&
+			 node->js.ps.righttree->chgParam == NULL)
+	{
+		/*
+		 * Even if we didn't build our own copy, other participants may have
+		 * consumed the shared inner scan, so it must be rescanned.
+		 */
+		ExecReScan(node->js.ps.righttree);
+	}
+
+	/*
+	 * A shared hash table is always rebuilt from scratch, since its inner
+	 * tuples came from all participants.  The Gather node above us has
+	 * already shut down the workers, so the leader can clear out the shared
+	 * state for the next build.
+	 */
+	if (hashNode->parallel_state != NULL && !IsParallelWorker())
+		ExecHashResetParallelState(hashNode);
 
 	/* Always reset intra-tuple state */
 	node->hj_CurHashValue = 0;
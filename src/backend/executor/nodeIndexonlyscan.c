@@ -546,6 +546,12 @@ ExecInitIndexOnlyScan(IndexOnlyScan *node, EState *estate, int eflags)
 	indexstate->ioss_ScanDesc->xs_want_itup = true;
 	indexstate->ioss_VMBuffer = InvalidBuffer;
 
+	/*
+	 * Prefetch heap pages ahead of the scan, if the index AM can.  Only the
+	 * pages that aren't all-visible will be prefetched.
+	 */
+	index_setprefetch(indexstate->ioss_ScanDesc);
+
 	/*
 	 * If no run-time keys to calculate, go ahead and pass the scankeys to the
 	 * index AM.
@@ -1021,6 +1021,9 @@ ExecInitIndexScan(IndexScan *node, EState *estate, int eflags)
 											   indexstate->iss_NumScanKeys,
 											 indexstate->iss_NumOrderByKeys);
 
+	/* Prefetch heap pages ahead of the scan, if the index AM can */
+	index_setprefetch(indexstate->iss_ScanDesc);
+
 	/*
 	 * If no run-time keys to calculate, go ahead and pass the scankeys to the
 	 * index AM.
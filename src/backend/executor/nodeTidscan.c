@@ -38,11 +38,64 @@
 	 ((Var *) (node))->varattno == SelfItemPointerAttributeNumber && \
 	 ((Var *) (node))->varlevelsup == 0)
 
+static List *TidExprListCreate(TidScanState *tidstate);
 static void TidListCreate(TidScanState *tidstate);
 static int	itemptr_comparator(const void *a, const void *b);
 static TupleTableSlot *TidNext(TidScanState *node);
 
 
+/*
+ * Build the ExprStates needed to compute the TIDs to be visited.
+ *
+ * We only initialize the TID-producing side of each tidqual, since the
+ * quals themselves are never evaluated as a whole.  The result has one
+ * entry per element of the plan's tidquals list (NULL for CurrentOfExpr,
+ * which execCurrentOf evaluates by itself).
+ */
+static List *
+TidExprListCreate(TidScanState *tidstate)
+{
+	TidScan    *node = (TidScan *) tidstate->ss.ps.plan;
+	List	   *result = NIL;
+	ListCell   *l;
+
+	foreach(l, node->tidquals)
+	{
+		Expr	   *expr = (Expr *) lfirst(l);
+		ExprState  *exstate;
+
+		if (is_opclause(expr))
+		{
+			Node	   *arg1;
+			Node	   *arg2;
+
+			arg1 = get_leftop(expr);
+			arg2 = get_rightop(expr);
+			if (IsCTIDVar(arg1))
+				exstate = ExecInitExpr((Expr *) arg2, &tidstate->ss.ps);
+			else if (IsCTIDVar(arg2))
+				exstate = ExecInitExpr((Expr *) arg1, &tidstate->ss.ps);
+			else
+				elog(ERROR, "could not identify CTID variable");
+		}
+		else if (expr && IsA(expr, ScalarArrayOpExpr))
+		{
+			ScalarArrayOpExpr *saex = (ScalarArrayOpExpr *) expr;
+
+			Assert(IsCTIDVar(linitial(saex->args)));
+			exstate = ExecInitExpr(lsecond(saex->args), &tidstate->ss.ps);
+		}
+		else if (expr && IsA(expr, CurrentOfExpr))
+			exstate = NULL;
+		else
+			elog(ERROR, "could not identify CTID expression");
+
+		result = lappend(result, exstate);
+	}
+
+	return result;
+}
+
 /*
  * Compute the list of TIDs to be visited, by evaluating the expressions
  * for them.
@@ -52,6 +105,7 @@ static TupleTableSlot *TidNext(TidScanState *node);
 static void
 TidListCreate(TidScanState *tidstate)
 {
+	List	   *tidquals = ((TidScan *) tidstate->ss.ps.plan)->tidquals;
 	List	   *evalList = tidstate->tss_tidquals;
 	ExprContext *econtext = tidstate->ss.ps.ps_ExprContext;
 	BlockNumber nblocks;
@@ -59,6 +113,7 @@ TidListCreate(TidScanState *tidstate)
 	int			numAllocTids;
 	int			numTids;
 	ListCell   *l;
+	ListCell   *l2;
 
 	/*
 	 * We silently discard any TIDs that are out of range at the time of scan
@@ -79,28 +134,15 @@ TidListCreate(TidScanState *tidstate)
 	numTids = 0;
 	tidstate->tss_isCurrentOf = false;
 
-	foreach(l, evalList)
+	forboth(l, tidquals, l2, evalList)
 	{
-		ExprState  *exstate = (ExprState *) lfirst(l);
-		Expr	   *expr = exstate->expr;
+		Expr	   *expr = (Expr *) lfirst(l);
+		ExprState  *exstate = (ExprState *) lfirst(l2);
 		ItemPointer itemptr;
 		bool		isNull;
 
 		if (is_opclause(expr))
 		{
-			FuncExprState *fexstate = (FuncExprState *) exstate;
-			Node	   *arg1;
-			Node	   *arg2;
-
-			arg1 = get_leftop(expr);
-			arg2 = get_rightop(expr);
-			if (IsCTIDVar(arg1))
-				exstate = (ExprState *) lsecond(fexstate->args);
-			else if (IsCTIDVar(arg2))
-				exstate = (ExprState *) linitial(fexstate->args);
-			else
-				elog(ERROR, "could not identify CTID variable");
-
 			itemptr = (ItemPointer)
 				DatumGetPointer(ExecEvalExprSwitchContext(exstate,
 														  econtext,
@@ -121,7 +163,6 @@ TidListCreate(TidScanState *tidstate)
 		}
 		else if (expr && IsA(expr, ScalarArrayOpExpr))
 		{
-			ScalarArrayOpExprState *saexstate = (ScalarArrayOpExprState *) exstate;
 			Datum		arraydatum;
 			ArrayType  *itemarray;
 			Datum	   *ipdatums;
@@ -129,7 +170,6 @@ TidListCreate(TidScanState *tidstate)
 			int			ndatums;
 			int			i;
 
-			exstate = (ExprState *) lsecond(saexstate->fxprstate.args);
 			arraydatum = ExecEvalExprSwitchContext(exstate,
 												   econtext,
 												   &isNull);
@@ -477,9 +517,7 @@ ExecInitTidScan(TidScan *node, EState *estate, int eflags)
 		ExecInitExpr((Expr *) node->scan.plan.qual,
 					 (PlanState *) tidstate);
 
-	tidstate->tss_tidquals = (List *)
-		ExecInitExpr((Expr *) node->tidquals,
-					 (PlanState *) tidstate);
+	tidstate->tss_tidquals = TidExprListCreate(tidstate);
 
 	/*
 	 * tuple table initialization
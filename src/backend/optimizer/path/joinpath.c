@@ -517,7 +517,7 @@ try_hashjoin_path(PlannerInfo *root,
 	 */
 	initial_cost_hashjoin(root, &workspace, jointype, hashclauses,
 						  outer_path, inner_path,
-						  extra->sjinfo, &extra->semifactors);
+						  extra->sjinfo, &extra->semifactors, false);
 
 	if (add_path_precheck(joinrel,
 						  workspace.startup_cost, workspace.total_cost,
@@ -534,7 +534,8 @@ try_hashjoin_path(PlannerInfo *root,
 									  inner_path,
 									  extra->restrictlist,
 									  required_outer,
-									  hashclauses));
+									  hashclauses,
+									  false));
 	}
 	else
 	{
@@ -547,6 +548,10 @@ try_hashjoin_path(PlannerInfo *root,
  * try_partial_hashjoin_path
  *	  Consider a partial hashjoin join path; if it appears useful, push it into
  *	  the joinrel's partial_pathlist via add_partial_path().
+ *
+ * If parallel_hash is true, inner_path is partial too, and the participants
+ * will build one shared hash table from it rather than each building a
+ * private copy of the whole inner relation.
  */
 static void
 try_partial_hashjoin_path(PlannerInfo *root,
@@ -555,7 +560,8 @@ try_partial_hashjoin_path(PlannerInfo *root,
 						  Path *inner_path,
 						  List *hashclauses,
 						  JoinType jointype,
-						  JoinPathExtraData *extra)
+						  JoinPathExtraData *extra,
+						  bool parallel_hash)
 {
 	JoinCostWorkspace workspace;
 
@@ -580,10 +586,21 @@ try_partial_hashjoin_path(PlannerInfo *root,
 	 */
 	initial_cost_hashjoin(root, &workspace, jointype, hashclauses,
 						  outer_path, inner_path,
-						  extra->sjinfo, &extra->semifactors);
+						  extra->sjinfo, &extra->semifactors,
+						  parallel_hash);
 	if (!add_partial_path_precheck(joinrel, workspace.total_cost, NIL))
 		return;
 
+	/*
+	 * A shared hash table can't be split into batches.  If it turns out not
+	 * to fit in memory at execution time, every participant falls back to
+	 * building a private copy, which is more expensive than the non-shared
+	 * plan; so only consider one if the whole inner relation is expected to
+	 * fit.
+	 */
+	if (parallel_hash && workspace.numbatches > 1)
+		return;
+
 	/* Might be good enough to be worth trying, so let's try it. */
 	add_partial_path(joinrel, (Path *)
 					 create_hashjoin_path(root,
@@ -596,7 +613,8 @@ try_partial_hashjoin_path(PlannerInfo *root,
 										  inner_path,
 										  extra->restrictlist,
 										  NULL,
-										  hashclauses));
+										  hashclauses,
+										  parallel_hash));
 }
 
 /*
@@ -1537,7 +1555,30 @@ hash_inner_and_outer(PlannerInfo *root,
 				try_partial_hashjoin_path(root, joinrel,
 										  cheapest_partial_outer,
 										  cheapest_safe_inner,
-										  hashclauses, jointype, extra);
+										  hashclauses, jointype, extra,
+										  false);
+
+			/*
+			 * If the inner rel also has a partial path, consider having all
+			 * the participants build one shared hash table from it, so that
+			 * each of them reads only its share of the inner relation and
+			 * the table is stored once rather than once per process.  A
+			 * partial inner path can't be unique-ified, though.
+			 */
+			if (enable_parallel_hash &&
+				innerrel->partial_pathlist != NIL &&
+				save_jointype != JOIN_UNIQUE_INNER)
+			{
+				Path	   *cheapest_partial_inner;
+
+				cheapest_partial_inner =
+					(Path *) linitial(innerrel->partial_pathlist);
+				try_partial_hashjoin_path(root, joinrel,
+										  cheapest_partial_outer,
+										  cheapest_partial_inner,
+										  hashclauses, jointype, extra,
+										  true);
+			}
 		}
 	}
 }
@@ -18,10 +18,13 @@
 #include <limits.h>
 #include <math.h>
 
+#include "access/genam.h"
+#include "access/heapam.h"
 #include "access/htup_details.h"
 #include "access/parallel.h"
 #include "access/sysattr.h"
 #include "access/xact.h"
+#include "catalog/catalog.h"
 #include "catalog/pg_constraint_fn.h"
 #include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
@@ -50,6 +53,7 @@
 #include "parser/parsetree.h"
 #include "parser/parse_agg.h"
 #include "rewrite/rewriteManip.h"
+#include "storage/bufmgr.h"
 #include "storage/dsm_impl.h"
 #include "utils/rel.h"
 #include "utils/selfuncs.h"
@@ -3698,8 +3702,7 @@ create_grouping_paths(PlannerInfo *root,
 
 		/*
 		 * Now generate a complete GroupAgg Path atop of the cheapest partial
-		 * path. We need only bother with the cheapest path here, as the
-		 * output of Gather is never sorted.
+		 * path.  We can do this using either Gather or Gather Merge.
 		 */
 		if (grouped_rel->partial_pathlist)
 		{
@@ -3746,6 +3749,63 @@ create_grouping_paths(PlannerInfo *root,
 										   parse->groupClause,
 										   (List *) parse->havingQual,
 										   dNumGroups));
+
+			/*
+			 * The point of using Gather Merge rather than Gather is that it
+			 * can preserve the ordering of the input path, so there's no
+			 * reason to try it unless (1) it's possible to produce more than
+			 * one output row and (2) we want the output path to be ordered.
+			 */
+			if (parse->groupClause != NIL && root->group_pathkeys != NIL)
+			{
+				foreach(lc, grouped_rel->partial_pathlist)
+				{
+					Path	   *subpath = (Path *) lfirst(lc);
+					Path	   *gmpath;
+					double		total_groups;
+
+					/*
+					 * Only consider partial paths that are already properly
+					 * ordered; sorting the cheapest one is handled above.
+					 */
+					if (!pathkeys_contained_in(root->group_pathkeys,
+											   subpath->pathkeys))
+						continue;
+
+					total_groups = subpath->rows * subpath->parallel_workers;
+
+					gmpath = (Path *)
+						create_gather_merge_path(root,
+												 grouped_rel,
+												 subpath,
+												 partial_grouping_target,
+												 root->group_pathkeys,
+												 NULL,
+												 &total_groups);
+
+					if (parse->hasAggs)
+						add_path(grouped_rel, (Path *)
+								 create_agg_path(root,
+												 grouped_rel,
+												 gmpath,
+												 target,
+								 parse->groupClause ? AGG_SORTED : AGG_PLAIN,
+												 AGGSPLIT_FINAL_DESERIAL,
+												 parse->groupClause,
+												 (List *) parse->havingQual,
+												 &agg_final_costs,
+												 dNumGroups));
+					else
+						add_path(grouped_rel, (Path *)
+								 create_group_path(root,
+												   grouped_rel,
+												   gmpath,
+												   target,
+												   parse->groupClause,
+												   (List *) parse->havingQual,
+												   dNumGroups));
+				}
+			}
 		}
 	}
 
@@ -4311,6 +4371,57 @@ create_ordered_paths(PlannerInfo *root,
 		}
 	}
 
+	/*
+	 * generate_gather_paths() will already have generated a simple Gather
+	 * path for the best parallel path, if any, and the loop above will have
+	 * considered sorting it.  Similarly, generate_gather_paths() will also
+	 * have generated order-preserving Gather Merge plans which can be used
+	 * without sorting if they happen to match the sort_pathkeys, and the loop
+	 * above will have handled those as well.  However, there's one more
+	 * possibility: it may make sense to sort the cheapest partial path
+	 * according to the required output order and then use Gather Merge.
+	 */
+	if (ordered_rel->consider_parallel && root->sort_pathkeys != NIL &&
+		input_rel->partial_pathlist != NIL)
+	{
+		Path	   *cheapest_partial_path;
+
+		cheapest_partial_path = linitial(input_rel->partial_pathlist);
+
+		/*
+		 * If cheapest partial path doesn't need a sort, this is redundant
+		 * with what's already been tried.
+		 */
+		if (!pathkeys_contained_in(root->sort_pathkeys,
+								   cheapest_partial_path->pathkeys))
+		{
+			Path	   *path;
+			double		total_groups;
+
+			path = (Path *) create_sort_path(root,
+											 ordered_rel,
+											 cheapest_partial_path,
+											 root->sort_pathkeys,
+											 -1.0);
+
+			total_groups = cheapest_partial_path->rows *
+				cheapest_partial_path->parallel_workers;
+			path = (Path *)
+				create_gather_merge_path(root, ordered_rel,
+										 path,
+										 path->pathtarget,
+										 root->sort_pathkeys, NULL,
+										 &total_groups);
+
+			/* Add projection step if needed */
+			if (path->pathtarget != target)
+				path = apply_projection_to_path(root, ordered_rel,
+												path, target);
+
+			add_path(ordered_rel, path);
+		}
+	}
+
 	/*
 	 * If there is an FDW that's responsible for all baserels of the query,
 	 * let it consider adding ForeignPaths.
@@ -5383,3 +5494,102 @@ plan_cluster_use_sort(Oid tableOid, Oid indexOid)
 
 	return (seqScanAndSortPath.total_cost < indexScanPath->path.total_cost);
 }
+
+/*
+ * plan_create_index_workers
+ *		Use the planner to decide how many parallel worker processes
+ *		CREATE INDEX should request
+ *
+ * tableOid is the table on which the index is to be built, and indexOid the
+ * (already created, and locked) index.  The caller is expected to check that
+ * its access method can build in parallel at all.
+ *
+ * The return value is the number of worker processes to request, not
+ * counting the leader, which always participates too; 0 means the index
+ * must be built serially.
+ */
+int
+plan_create_index_workers(Oid tableOid, Oid indexOid)
+{
+	PlannerGlobal *glob;
+	PlannerInfo *root;
+	Relation	heap;
+	Relation	index;
+	int			parallel_workers;
+
+	/* Return immediately when parallelism is disabled */
+	if (dynamic_shared_memory_type == DSM_IMPL_NONE ||
+		max_parallel_maintenance_workers == 0)
+		return 0;
+
+	/* We can't start workers from inside a parallel operation, either */
+	if (!IsUnderPostmaster || IsInParallelMode())
+		return 0;
+
+	heap = heap_open(tableOid, NoLock);
+	index = index_open(indexOid, NoLock);
+
+	/*
+	 * Workers can't read temporary tables.  Nor can they know about a reindex
+	 * of a system catalog in progress in the leader, so don't try to build
+	 * catalog indexes in parallel.
+	 */
+	if (heap->rd_rel->relpersistence == RELPERSISTENCE_TEMP ||
+		IsSystemRelation(heap))
+	{
+		parallel_workers = 0;
+		goto done;
+	}
+
+	/*
+	 * Workers evaluate the index expressions and predicate, so these must be
+	 * parallel safe.  is_parallel_safe() needs a PlannerInfo to consult, but
+	 * only for the global state it has gathered; give it an empty one.
+	 */
+	glob = makeNode(PlannerGlobal);
+	glob->maxParallelHazard = PROPARALLEL_UNSAFE;
+	root = makeNode(PlannerInfo);
+	root->glob = glob;
+
+	if (!is_parallel_safe(root, (Node *) RelationGetIndexExpressions(index)) ||
+		!is_parallel_safe(root, (Node *) RelationGetIndexPredicate(index)))
+	{
+		parallel_workers = 0;
+		goto done;
+	}
+
+	/*
+	 * If the user has set the parallel_workers reloption on the table, use
+	 * that; otherwise select a number of workers based on the size of the
+	 * table, in the same way as for a parallel sequential scan.
+	 */
+	parallel_workers = RelationGetParallelWorkers(heap, -1);
+	if (parallel_workers == -1)
+	{
+		BlockNumber heap_blocks = RelationGetNumberOfBlocks(heap);
+		int			parallel_threshold;
+
+		parallel_workers = 0;
+		parallel_threshold = Max(min_parallel_relation_size, 1);
+		if (heap_blocks >= (BlockNumber) parallel_threshold)
+		{
+			parallel_workers = 1;
+			while (heap_blocks >= (BlockNumber) (parallel_threshold * 3))
+			{
+				parallel_workers++;
+				parallel_threshold *= 3;
+				if (parallel_threshold > INT_MAX / 3)
+					break;		/* avoid overflow */
+			}
+		}
+	}
+
+	/* In no case use more than max_parallel_maintenance_workers workers */
+	parallel_workers = Min(parallel_workers, max_parallel_maintenance_workers);
+
+done:
+	index_close(index, NoLock);
+	heap_close(heap, NoLock);
+
+	return parallel_workers;
+}
@@ -186,6 +186,8 @@ static void SplitColQualList(List *qualList,
 static void processCASbits(int cas_bits, int location, const char *constrType,
 			   bool *deferrable, bool *initdeferred, bool *not_valid,
 			   bool *no_inherit, core_yyscan_t yyscanner);
+static int processVacuumOptions(List *options, int *nworkers,
+			   core_yyscan_t yyscanner);
 static Node *makeRecursiveViewSelect(char *relname, List *aliases, Node *query);
 
 %}
@@ -303,7 +305,8 @@ static Node *makeRecursiveViewSelect(char *relname, List *aliases, Node *query);
 				create_extension_opt_item alter_extension_opt_item
 
 %type <ival>	opt_lock lock_type cast_context
-%type <ival>	vacuum_option_list vacuum_option_elem
+%type <list>	vacuum_option_list
+%type <defelt>	vacuum_option_elem
 %type <boolean>	opt_or_replace
 				opt_grant_grant_option opt_grant_admin_option
 				opt_nowait opt_if_exists opt_with_data
@@ -10028,7 +10031,8 @@ VacuumStmt: VACUUM opt_full opt_freeze opt_verbose
 			| VACUUM '(' vacuum_option_list ')'
 				{
 					VacuumStmt *n = makeNode(VacuumStmt);
-					n->options = VACOPT_VACUUM | $3;
+					n->options = VACOPT_VACUUM |
+						processVacuumOptions($3, &n->nworkers, yyscanner);
 					n->relation = NULL;
 					n->va_cols = NIL;
 					$$ = (Node *) n;
@@ -10036,7 +10040,8 @@ VacuumStmt: VACUUM opt_full opt_freeze opt_verbose
 			| VACUUM '(' vacuum_option_list ')' qualified_name opt_name_list
 				{
 					VacuumStmt *n = makeNode(VacuumStmt);
-					n->options = VACOPT_VACUUM | $3;
+					n->options = VACOPT_VACUUM |
+						processVacuumOptions($3, &n->nworkers, yyscanner);
 					n->relation = $5;
 					n->va_cols = $6;
 					if (n->va_cols != NIL)	/* implies analyze */
@@ -10046,25 +10051,20 @@ VacuumStmt: VACUUM opt_full opt_freeze opt_verbose
 		;
 
 vacuum_option_list:
-			vacuum_option_elem								{ $$ = $1; }
-			| vacuum_option_list ',' vacuum_option_elem		{ $$ = $1 | $3; }
+			vacuum_option_elem								{ $$ = list_make1($1); }
+			| vacuum_option_list ',' vacuum_option_elem		{ $$ = lappend($1, $3); }
 		;
 
 vacuum_option_elem:
-			analyze_keyword		{ $$ = VACOPT_ANALYZE; }
-			| VERBOSE			{ $$ = VACOPT_VERBOSE; }
-			| FREEZE			{ $$ = VACOPT_FREEZE; }
-			| FULL				{ $$ = VACOPT_FULL; }
-			| IDENT
+			analyze_keyword		{ $$ = makeDefElem("analyze", NULL, @1); }
+			| VERBOSE			{ $$ = makeDefElem("verbose", NULL, @1); }
+			| FREEZE			{ $$ = makeDefElem("freeze", NULL, @1); }
+			| FULL				{ $$ = makeDefElem("full", NULL, @1); }
+			| PARALLEL Iconst
 				{
-					if (strcmp($1, "disable_page_skipping") == 0)
-						$$ = VACOPT_DISABLE_PAGE_SKIPPING;
-					else
-						ereport(ERROR,
-								(errcode(ERRCODE_SYNTAX_ERROR),
-							 errmsg("unrecognized VACUUM option \"%s\"", $1),
-									 parser_errposition(@1)));
+					$$ = makeDefElem("parallel", (Node *) makeInteger($2), @1);
 				}
+			| IDENT				{ $$ = makeDefElem($1, NULL, @1); }
 		;
 
 AnalyzeStmt:
@@ -15522,6 +15522,45 @@ processCASbits(int cas_bits, int location, const char *constrType,
 	}
 }
 
+/*
+ * Convert the options of a parenthesized VACUUM option list into VacuumOption
+ * flags.  The number of parallel workers requested, if any, is returned in
+ * *nworkers.
+ */
+static int
+processVacuumOptions(List *options, int *nworkers, core_yyscan_t yyscanner)
+{
+	int			result = 0;
+	ListCell   *lc;
+
+	*nworkers = 0;
+
+	foreach(lc, options)
+	{
+		DefElem    *opt = (DefElem *) lfirst(lc);
+
+		if (strcmp(opt->defname, "analyze") == 0)
+			result |= VACOPT_ANALYZE;
+		else if (strcmp(opt->defname, "verbose") == 0)
+			result |= VACOPT_VERBOSE;
+		else if (strcmp(opt->defname, "freeze") == 0)
+			result |= VACOPT_FREEZE;
+		else if (strcmp(opt->defname, "full") == 0)
+			result |= VACOPT_FULL;
+		else if (strcmp(opt->defname, "disable_page_skipping") == 0)
+			result |= VACOPT_DISABLE_PAGE_SKIPPING;
+		else if (strcmp(opt->defname, "parallel") == 0)
+			*nworkers = intVal(opt->arg);
+		else
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("unrecognized VACUUM option \"%s\"", opt->defname),
+					 parser_errposition(opt->location)));
+	}
+
+	return result;
+}
+
 /*----------
  * Recursive view transformation
  *
@@ -0,0 +1,186 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_numa.c
+ *	  Basic NUMA (non-uniform memory access) support.
+ *
+ * On Linux, we talk to the kernel's memory policy interface directly
+ * rather than depending on libnuma, since we need only a handful of calls.
+ * Elsewhere, the machine is treated as having a single node.
+ *
+ * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/port/pg_numa.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+#include "port/pg_numa.h"
+
+#if defined(__linux__) && defined(SYS_mbind) && \
+	defined(SYS_get_mempolicy) && defined(SYS_getcpu)
+#define USE_LINUX_NUMA
+#endif
+
+#ifdef USE_LINUX_NUMA
+
+#define NODEMASK_WORDS	(PG_NUMA_MAX_NODES / (8 * sizeof(unsigned long)))
+#define NODEMASK_BITS(mask, node) \
+	((mask)[(node) / (8 * sizeof(unsigned long))])
+#define NODEMASK_BIT(node) \
+	(1UL << ((node) % (8 * sizeof(unsigned long))))
+
+/*
+ * Fetch the set of nodes this process may allocate memory on.
+ */
+static bool
+get_allowed_nodes(unsigned long *mask)
+{
+	int			mode;
+
+	memset(mask, 0, NODEMASK_WORDS * sizeof(unsigned long));
+
+	/* The kernel wants the mask size in bits, plus one */
+	return syscall(SYS_get_mempolicy, &mode, mask,
+				   (unsigned long) PG_NUMA_MAX_NODES + 1,
+				   NULL, MPOL_F_MEMS_ALLOWED) == 0;
+}
+
+/*
+ * Shrink [ptr, ptr + size) to the whole pages it contains, since the
+ * kernel applies memory policies to whole pages only.  Returns false if no
+ * whole page is left.
+ */
+static bool
+align_range(void **ptr, Size *size, Size pagesize)
+{
+	uintptr_t	start = (uintptr_t) *ptr;
+	uintptr_t	end = start + *size;
+
+	start = TYPEALIGN(pagesize, start);
+	end = TYPEALIGN_DOWN(pagesize, end);
+	if (end <= start)
+		return false;
+
+	*ptr = (void *) start;
+	*size = end - start;
+	return true;
+}
+
+static int
+set_policy(void *ptr, Size size, Size pagesize, int mode,
+		   unsigned long *mask)
+{
+	if (!align_range(&ptr, &size, pagesize))
+		return 0;
+
+	/* Move pages that were touched already, too */
+	return (int) syscall(SYS_mbind, ptr, (unsigned long) size, mode, mask,
+						 (unsigned long) PG_NUMA_MAX_NODES + 1,
+						 MPOL_MF_MOVE);
+}
+
+#endif   /* USE_LINUX_NUMA */
+
+/*
+ * pg_numa_get_nodes
+ *		Store the IDs of the NUMA nodes we may allocate memory on into
+ *		nodes[], and return their number.
+ *
+ * Returns 0 if NUMA is not supported or the nodes can't be determined.
+ */
+int
+pg_numa_get_nodes(int *nodes, int maxnodes)
+{
+#ifdef USE_LINUX_NUMA
+	unsigned long mask[NODEMASK_WORDS];
+	int			nnodes = 0;
+	int			node;
+
+	if (!get_allowed_nodes(mask))
+		return 0;
+
+	for (node = 0; node < PG_NUMA_MAX_NODES && nnodes < maxnodes; node++)
+	{
+		if (NODEMASK_BITS(mask, node) & NODEMASK_BIT(node))
+			nodes[nnodes++] = node;
+	}
+	return nnodes;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * pg_numa_current_node
+ *		Return the NUMA node of the CPU we're running on, or -1 if unknown.
+ *
+ * Note that unless the process is bound to particular CPUs, the scheduler
+ * may move it to another node at any time.
+ */
+int
+pg_numa_current_node(void)
+{
+#ifdef USE_LINUX_NUMA
+	unsigned int cpu;
+	unsigned int node;
+
+	if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+		return (int) node;
+#endif
+	return -1;
+}
+
+/*
+ * pg_numa_interleave
+ *		Spread the pages of a memory range round-robin over all nodes.
+ *
+ * pagesize is the size of the pages backing the range; only whole pages
+ * within the range are affected.  Returns 0 on success, or -1 with errno
+ * set.
+ */
+int
+pg_numa_interleave(void *ptr, Size size, Size pagesize)
+{
+#ifdef USE_LINUX_NUMA
+	unsigned long mask[NODEMASK_WORDS];
+
+	if (!get_allowed_nodes(mask))
+		return -1;
+	return set_policy(ptr, size, pagesize, MPOL_INTERLEAVE, mask);
+#else
+	return 0;
+#endif
+}
+
+/*
+ * pg_numa_bind
+ *		Place the pages of a memory range on the given node.
+ *
+ * This is a preference, not a hard binding: if the node runs out of memory,
+ * the kernel will fall back to other nodes rather than fail.  Otherwise
+ * like pg_numa_interleave.
+ */
+int
+pg_numa_bind(void *ptr, Size size, Size pagesize, int node)
+{
+#ifdef USE_LINUX_NUMA
+	unsigned long mask[NODEMASK_WORDS];
+
+	Assert(node >= 0 && node < PG_NUMA_MAX_NODES);
+
+	memset(mask, 0, sizeof(mask));
+	NODEMASK_BITS(mask, node) |= NODEMASK_BIT(node);
+	return set_policy(ptr, size, pagesize, MPOL_PREFERRED, mask);
+#else
+	return 0;
+#endif
+}
@@ -73,6 +73,7 @@ typedef int IpcMemoryId;		/* shared memory ID returned by shmget(2) */
 
 unsigned long UsedShmemSegID = 0;
 void	   *UsedShmemSegAddr = NULL;
+Size		UsedShmemPageSize = 0;
 
 #ifdef USE_ANONYMOUS_SHMEM
 static Size AnonymousShmemSize;
@@ -461,6 +462,8 @@ CreateAnonymousSegment(Size *size)
 		if (huge_pages == HUGE_PAGES_TRY && ptr == MAP_FAILED)
 			elog(DEBUG1, "mmap(%zu) with MAP_HUGETLB failed, huge pages disabled: %m",
 				 allocsize);
+		if (ptr != MAP_FAILED)
+			UsedShmemPageSize = hugepagesize;
 	}
 #endif
 
@@ -554,6 +557,9 @@ PGSharedMemoryCreate(Size size, bool makePrivate, int port,
 	/* Room for a header? */
 	Assert(size > MAXALIGN(sizeof(PGShmemHeader)));
 
+	/* Assume regular pages, unless CreateAnonymousSegment gets huge ones */
+	UsedShmemPageSize = sysconf(_SC_PAGESIZE);
+
 #ifdef USE_ANONYMOUS_SHMEM
 	AnonymousShmem = CreateAnonymousSegment(&size);
 	AnonymousShmemSize = size;
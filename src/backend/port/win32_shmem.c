@@ -19,6 +19,7 @@
 
 HANDLE		UsedShmemSegID = INVALID_HANDLE_VALUE;
 void	   *UsedShmemSegAddr = NULL;
+Size		UsedShmemPageSize = 0;
 static Size UsedShmemSegSize = 0;
 
 static void pgwin32_SharedMemoryDelete(int status, Datum shmId);
@@ -136,6 +137,13 @@ PGSharedMemoryCreate(Size size, bool makePrivate, int port,
 	/* Room for a header? */
 	Assert(size > MAXALIGN(sizeof(PGShmemHeader)));
 
+	{
+		SYSTEM_INFO sysinfo;
+
+		GetSystemInfo(&sysinfo);
+		UsedShmemPageSize = sysinfo.dwPageSize;
+	}
+
 	szShareMem = GetSharedMemName();
 
 	UsedShmemSegAddr = NULL;
@@ -145,6 +145,7 @@ static CheckpointerShmemStruct *CheckpointerShmem;
 int			CheckPointTimeout = 300;
 int			CheckPointWarning = 30;
 double		CheckPointCompletionTarget = 0.5;
+double		CheckPointSyncFraction = 0.2;
 
 /*
  * Flags set by interrupt handlers for later service in the main loop.
@@ -159,6 +160,7 @@ static volatile sig_atomic_t shutdown_requested = false;
 static bool ckpt_active = false;
 
 /* these values are valid when ckpt_active is true: */
+static int	ckpt_active_flags;
 static pg_time_t ckpt_start_time;
 static XLogRecPtr ckpt_start_recptr;
 static double ckpt_cached_elapsed;
@@ -169,6 +171,7 @@ static pg_time_t last_xlog_switch_time;
 /* Prototypes for private functions */
 
 static void CheckArchiveTimeout(void);
+static void CheckpointNap(void);
 static bool IsCheckpointOnSchedule(double progress);
 static bool ImmediateCheckpointRequested(void);
 static bool CompactCheckpointerRequestQueue(void);
@@ -473,6 +476,7 @@ CheckpointerMain(void)
 			 * checkpoint.
 			 */
 			ckpt_active = true;
+			ckpt_active_flags = flags;
 			if (do_restartpoint)
 				ckpt_start_recptr = GetXLogReplayRecPtr(NULL);
 			else
@@ -671,7 +675,9 @@ ImmediateCheckpointRequested(void)
  * examined is CHECKPOINT_IMMEDIATE, which disables delays between writes.
  *
  * 'progress' is an estimate of how much of the work has been done, as a
- * fraction between 0.0 meaning none, and 1.0 meaning all done.
+ * fraction between 0.0 meaning none, and 1.0 meaning all done.  The writes
+ * are scheduled to take up all of the checkpoint but the last
+ * checkpoint_sync_fraction, which is left for CheckpointSyncDelay.
  */
 void
 CheckpointWriteDelay(int flags, double progress)
@@ -689,33 +695,10 @@ CheckpointWriteDelay(int flags, double progress)
 	if (!(flags & CHECKPOINT_IMMEDIATE) &&
 		!shutdown_requested &&
 		!ImmediateCheckpointRequested() &&
-		IsCheckpointOnSchedule(progress))
+		IsCheckpointOnSchedule(progress * (1.0 - CheckPointSyncFraction)))
 	{
-		if (got_SIGHUP)
-		{
-			got_SIGHUP = false;
-			ProcessConfigFile(PGC_SIGHUP);
-			/* update shmem copies of config variables */
-			UpdateSharedMemoryConfig();
-		}
-
-		AbsorbFsyncRequests();
+		CheckpointNap();
 		absorb_counter = WRITES_PER_ABSORB;
-
-		CheckArchiveTimeout();
-
-		/*
-		 * Report interim activity statistics to the stats collector.
-		 */
-		pgstat_send_bgwriter();
-
-		/*
-		 * This sleep used to be connected to bgwriter_delay, typically 200ms.
-		 * That resulted in more frequent wakeups if not much work to do.
-		 * Checkpointer and bgwriter are no longer related so take the Big
-		 * Sleep.
-		 */
-		pg_usleep(100000L);
 	}
 	else if (--absorb_counter <= 0)
 	{
@@ -729,6 +712,65 @@ CheckpointWriteDelay(int flags, double progress)
 	}
 }
 
+/*
+ * CheckpointSyncDelay -- control rate of fsyncs at the end of a checkpoint
+ *
+ * This function is called by mdsync() after each file segment it fsyncs,
+ * with 'progress' the fraction of them done so far.  The fsyncs get the last
+ * checkpoint_sync_fraction of the checkpoint's schedule, and we wait here as
+ * long as we're ahead of it.  Issuing the fsyncs back to back, as soon as
+ * the writes are done, would force out all the data the kernel hasn't yet
+ * written back at once, stalling other I/O for the duration.
+ */
+void
+CheckpointSyncDelay(double progress)
+{
+	/* Do nothing if checkpoint is being executed by non-checkpointer process */
+	if (!AmCheckpointerProcess() || !ckpt_active)
+		return;
+
+	progress = (1.0 - CheckPointSyncFraction) +
+		progress * CheckPointSyncFraction;
+
+	while (!(ckpt_active_flags & CHECKPOINT_IMMEDIATE) &&
+		   !shutdown_requested &&
+		   !ImmediateCheckpointRequested() &&
+		   IsCheckpointOnSchedule(progress))
+		CheckpointNap();
+}
+
+/*
+ * CheckpointNap -- perform the usual duties and sleep a while, between the
+ *		writes or fsyncs of a checkpoint that is ahead of schedule
+ */
+static void
+CheckpointNap(void)
+{
+	if (got_SIGHUP)
+	{
+		got_SIGHUP = false;
+		ProcessConfigFile(PGC_SIGHUP);
+		/* update shmem copies of config variables */
+		UpdateSharedMemoryConfig();
+	}
+
+	AbsorbFsyncRequests();
+
+	CheckArchiveTimeout();
+
+	/*
+	 * Report interim activity statistics to the stats collector.
+	 */
+	pgstat_send_bgwriter();
+
+	/*
+	 * This sleep used to be connected to bgwriter_delay, typically 200ms.
+	 * That resulted in more frequent wakeups if not much work to do.
+	 * Checkpointer and bgwriter are no longer related so take the Big Sleep.
+	 */
+	pg_usleep(100000L);
+}
+
 /*
  * IsCheckpointOnSchedule -- are we on schedule to finish this checkpoint
  *		 (or restartpoint) in time?
@@ -3368,6 +3368,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 
 	switch (w)
 	{
+		case WAIT_EVENT_APPEND_READY:
+			event_name = "AppendReady";
+			break;
 		case WAIT_EVENT_BGWORKER_SHUTDOWN:
 			event_name = "BgWorkerShutdown";
 			break;
@@ -3392,6 +3395,12 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_PARALLEL_FINISH:
 			event_name = "ParallelFinish";
 			break;
+		case WAIT_EVENT_PARALLEL_BITMAP_SCAN:
+			event_name = "ParallelBitmapScan";
+			break;
+		case WAIT_EVENT_PARALLEL_HASH_BUILD:
+			event_name = "ParallelHashBuild";
+			break;
 		case WAIT_EVENT_SAFE_SNAPSHOT:
 			event_name = "SafeSnapshot";
 			break;
@@ -3687,6 +3696,30 @@ pgstat_send_bgwriter(void)
 	MemSet(&BgWriterStats, 0, sizeof(BgWriterStats));
 }
 
+/* ----------
+ * pgstat_count_checkpoint_sync() -
+ *
+ *	Record the duration of a checkpoint fsync, in microseconds.  Sent to
+ *	the collector by the next pgstat_send_bgwriter().
+ * ----------
+ */
+void
+pgstat_count_checkpoint_sync(uint64 elapsed_us)
+{
+	int			bucket = 0;
+	uint64		v = elapsed_us;
+
+	while (v >= 2 && bucket < PGSTAT_SYNC_HIST_BUCKETS - 1)
+	{
+		v >>= 1;
+		bucket++;
+	}
+
+	BgWriterStats.m_checkpoint_sync_hist[bucket]++;
+	if (elapsed_us > BgWriterStats.m_checkpoint_sync_max)
+		BgWriterStats.m_checkpoint_sync_max = elapsed_us;
+}
+
 
 /* ----------
  * PgstatCollectorMain() -
@@ -4088,6 +4121,7 @@ pgstat_get_tab_entry(PgStat_StatDBEntry *dbentry, Oid tableoid, bool create)
 		result->n_live_tuples = 0;
 		result->n_dead_tuples = 0;
 		result->changes_since_analyze = 0;
+		result->inserts_since_vacuum = 0;
 		result->blocks_fetched = 0;
 		result->blocks_hit = 0;
 		result->vacuum_timestamp = 0;
@@ -5197,6 +5231,7 @@ pgstat_recv_tabstat(PgStat_MsgTabstat *msg, int len)
 			tabentry->n_live_tuples = tabmsg->t_counts.t_delta_live_tuples;
 			tabentry->n_dead_tuples = tabmsg->t_counts.t_delta_dead_tuples;
 			tabentry->changes_since_analyze = tabmsg->t_counts.t_changed_tuples;
+			tabentry->inserts_since_vacuum = tabmsg->t_counts.t_tuples_inserted;
 			tabentry->blocks_fetched = tabmsg->t_counts.t_blocks_fetched;
 			tabentry->blocks_hit = tabmsg->t_counts.t_blocks_hit;
 
@@ -5226,10 +5261,12 @@ pgstat_recv_tabstat(PgStat_MsgTabstat *msg, int len)
 			{
 				tabentry->n_live_tuples = 0;
 				tabentry->n_dead_tuples = 0;
+				tabentry->inserts_since_vacuum = 0;
 			}
 			tabentry->n_live_tuples += tabmsg->t_counts.t_delta_live_tuples;
 			tabentry->n_dead_tuples += tabmsg->t_counts.t_delta_dead_tuples;
 			tabentry->changes_since_analyze += tabmsg->t_counts.t_changed_tuples;
+			tabentry->inserts_since_vacuum += tabmsg->t_counts.t_tuples_inserted;
 			tabentry->blocks_fetched += tabmsg->t_counts.t_blocks_fetched;
 			tabentry->blocks_hit += tabmsg->t_counts.t_blocks_hit;
 		}
@@ -5464,6 +5501,12 @@ pgstat_recv_vacuum(PgStat_MsgVacuum *msg, int len)
 	tabentry->n_live_tuples = msg->m_live_tuples;
 	tabentry->n_dead_tuples = msg->m_dead_tuples;
 
+	/*
+	 * Like changes_since_analyze for ANALYZE, this forgets any insertions
+	 * committed while the VACUUM was in progress.
+	 */
+	tabentry->inserts_since_vacuum = 0;
+
 	if (msg->m_autovacuum)
 	{
 		tabentry->autovac_vacuum_timestamp = msg->m_vacuumtime;
@@ -5555,6 +5598,8 @@ pgstat_recv_archiver(PgStat_MsgArchiver *msg, int len)
 static void
 pgstat_recv_bgwriter(PgStat_MsgBgWriter *msg, int len)
 {
+	int			i;
+
 	globalStats.timed_checkpoints += msg->m_timed_checkpoints;
 	globalStats.requested_checkpoints += msg->m_requested_checkpoints;
 	globalStats.checkpoint_write_time += msg->m_checkpoint_write_time;
@@ -5565,6 +5610,10 @@ pgstat_recv_bgwriter(PgStat_MsgBgWriter *msg, int len)
 	globalStats.buf_written_backend += msg->m_buf_written_backend;
 	globalStats.buf_fsync_backend += msg->m_buf_fsync_backend;
 	globalStats.buf_alloc += msg->m_buf_alloc;
+	for (i = 0; i < PGSTAT_SYNC_HIST_BUCKETS; i++)
+		globalStats.checkpoint_sync_hist[i] += msg->m_checkpoint_sync_hist[i];
+	if (msg->m_checkpoint_sync_max > globalStats.checkpoint_sync_max)
+		globalStats.checkpoint_sync_max = msg->m_checkpoint_sync_max;
 }
 
 /* ----------
@@ -3,11 +3,29 @@
  * buf_table.c
  *	  routines for mapping BufferTags to buffer indexes.
  *
- * Note: the routines in this file do no locking of their own.  The caller
- * must hold a suitable lock on the appropriate BufMappingLock, as specified
- * in the comments.  We can't do the locking inside these functions because
- * in most cases the caller needs to adjust the buffer header contents
- * before the lock is released (see notes in README).
+ * The mapping is kept in a fixed-size open-addressing hash table in shared
+ * memory, rather than in a dynahash table.  Each bucket occupies a single
+ * cache line and holds a few (tag, buffer ID) entries together with a
+ * version counter that works as a sequence lock: writers make the counter
+ * odd while they modify the bucket, and readers retry if they see the
+ * counter odd or changed across their read.  Lookups therefore take no lock
+ * at all, and write no shared memory.
+ *
+ * A tag is stored in its "home" bucket (chosen by its hash code) if there is
+ * room there, else in the first following bucket with a free slot.  Each
+ * bucket counts the entries that had to pass over it on their way to a later
+ * bucket; a lookup that doesn't find its tag in a bucket whose count is zero
+ * can stop there.  Entries never move once inserted, so a concurrent lookup
+ * can never miss an entry that is present for the whole duration of the
+ * lookup.
+ *
+ * Note: the insert and delete routines only lock the individual buckets they
+ * modify.  The caller must hold exclusive lock on the appropriate
+ * BufMappingLock, which serializes all changes for a given tag and allows the
+ * caller to adjust the buffer header contents before the lock is released
+ * (see notes in README).  A lookup needs no lock, but since the mapping can
+ * change as soon as it returns, a caller that doesn't hold the
+ * BufMappingLock must pin the buffer and then recheck its tag.
  *
  *
  * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
@@ -21,20 +39,58 @@
  */
 #include "postgres.h"
 
+#include "access/hash.h"
+#include "port/atomics.h"
 #include "storage/bufmgr.h"
 #include "storage/buf_internals.h"
+#include "storage/s_lock.h"
+#include "storage/shmem.h"
+
 
+/* number of entries that fit in one cache-line-sized bucket */
+#define BUFTABLE_BUCKET_SLOTS	2
 
 /* entry for buffer lookup hashtable */
 typedef struct
 {
 	BufferTag	key;			/* Tag of a disk page */
-	int			id;				/* Associated buffer ID */
+	int			id;				/* Associated buffer ID, or -1 if unused */
 } BufferLookupEnt;
 
-static HTAB *SharedBufHash;
+typedef struct
+{
+	pg_atomic_uint32 version;	/* odd while a writer is modifying bucket */
+	uint32		noverflow;		/* # of entries stored beyond this bucket
+								 * that probed past it */
+	BufferLookupEnt slots[BUFTABLE_BUCKET_SLOTS];
+} BufTableBucket;
+
+/* pad buckets to a cache line, so that each can be read with one miss */
+typedef union BufTableBucketPadded
+{
+	BufTableBucket bucket;
+	char		pad[PG_CACHE_LINE_SIZE];
+} BufTableBucketPadded;
+
+static BufTableBucketPadded *SharedBufTable;
+static uint32 SharedBufTableMask;	/* number of buckets - 1 */
 
 
+/*
+ * Compute the number of buckets for a table of the given size.  We provide
+ * at least twice as many slots as entries, which keeps probe sequences short.
+ */
+static uint32
+BufTableNumBuckets(int size)
+{
+	uint32		nbuckets = 1;
+
+	while (nbuckets * BUFTABLE_BUCKET_SLOTS < (uint32) size * 2)
+		nbuckets <<= 1;
+
+	return nbuckets;
+}
+
 /*
  * Estimate space needed for mapping hashtable
  *		size is the desired hash table size (possibly more than NBuffers)
@@ -42,7 +98,7 @@ static HTAB *SharedBufHash;
 Size
 BufTableShmemSize(int size)
 {
-	return hash_estimate_size(size, sizeof(BufferLookupEnt));
+	return mul_size(BufTableNumBuckets(size), sizeof(BufTableBucketPadded));
 }
 
 /*
@@ -52,19 +108,67 @@ BufTableShmemSize(int size)
 void
 InitBufTable(int size)
 {
-	HASHCTL		info;
+	uint32		nbuckets = BufTableNumBuckets(size);
+	bool		found;
+	uint32		i;
+
+	StaticAssertStmt(sizeof(BufTableBucket) <= PG_CACHE_LINE_SIZE,
+					 "buffer mapping bucket does not fit in a cache line");
 
 	/* assume no locking is needed yet */
 
-	/* BufferTag maps to Buffer */
-	info.keysize = sizeof(BufferTag);
-	info.entrysize = sizeof(BufferLookupEnt);
-	info.num_partitions = NUM_BUFFER_PARTITIONS;
+	SharedBufTable = (BufTableBucketPadded *)
+		ShmemInitStruct("Shared Buffer Lookup Table",
+						mul_size(nbuckets, sizeof(BufTableBucketPadded)),
+						&found);
+	SharedBufTableMask = nbuckets - 1;
+
+	if (!found)
+	{
+		for (i = 0; i < nbuckets; i++)
+		{
+			BufTableBucket *bucket = &SharedBufTable[i].bucket;
+			int			j;
+
+			pg_atomic_init_u32(&bucket->version, 0);
+			bucket->noverflow = 0;
+			for (j = 0; j < BUFTABLE_BUCKET_SLOTS; j++)
+				bucket->slots[j].id = -1;
+		}
+	}
+}
+
+/*
+ * Lock a bucket for modification, by making its version counter odd.
+ */
+static void
+BufTableLockBucket(BufTableBucket *bucket)
+{
+	SpinDelayStatus delayStatus;
+	uint32		version;
+
+	init_local_spin_delay(&delayStatus);
+
+	for (;;)
+	{
+		version = pg_atomic_read_u32(&bucket->version);
+		if ((version & 1) == 0 &&
+			pg_atomic_compare_exchange_u32(&bucket->version, &version,
+										   version + 1))
+			break;
+		perform_spin_delay(&delayStatus);
+	}
+	finish_spin_delay(&delayStatus);
+}
 
-	SharedBufHash = ShmemInitHash("Shared Buffer Lookup Table",
-								  size, size,
-								  &info,
-								  HASH_ELEM | HASH_BLOBS | HASH_PARTITION);
+/*
+ * Release a bucket locked by BufTableLockBucket.  The atomic increment acts
+ * as a full barrier, so readers that see the new version see our changes.
+ */
+static inline void
+BufTableUnlockBucket(BufTableBucket *bucket)
+{
+	pg_atomic_fetch_add_u32(&bucket->version, 1);
 }
 
 /*
@@ -79,31 +183,70 @@ InitBufTable(int size)
 uint32
 BufTableHashCode(BufferTag *tagPtr)
 {
-	return get_hash_value(SharedBufHash, (void *) tagPtr);
+	return DatumGetUInt32(hash_any((unsigned char *) tagPtr,
+								   sizeof(BufferTag)));
 }
 
 /*
  * BufTableLookup
  *		Lookup the given BufferTag; return buffer ID, or -1 if not found
  *
- * Caller must hold at least share lock on BufMappingLock for tag's partition
+ * No lock is required.  If the caller doesn't hold the BufMappingLock for
+ * the tag's partition, the result may be out of date by the time it is
+ * returned; see the notes at the top of this file.
  */
 int
 BufTableLookup(BufferTag *tagPtr, uint32 hashcode)
 {
-	BufferLookupEnt *result;
+	uint32		bucketno = hashcode & SharedBufTableMask;
+	uint32		nprobed;
+
+	for (nprobed = 0; nprobed <= SharedBufTableMask; nprobed++)
+	{
+		BufTableBucket *bucket = &SharedBufTable[bucketno].bucket;
+		uint32		version;
+		uint32		noverflow;
+		int			result;
+		int			j;
+
+		for (;;)
+		{
+			version = pg_atomic_read_u32(&bucket->version);
+			if (version & 1)
+			{
+				/* a writer is busy with this bucket; it won't be for long */
+				pg_spin_delay();
+				continue;
+			}
+			pg_read_barrier();
+
+			result = -1;
+			for (j = 0; j < BUFTABLE_BUCKET_SLOTS; j++)
+			{
+				BufferLookupEnt *ent = &bucket->slots[j];
+
+				if (ent->id >= 0 && BUFFERTAGS_EQUAL(ent->key, *tagPtr))
+				{
+					result = ent->id;
+					break;
+				}
+			}
+			noverflow = bucket->noverflow;
+
+			pg_read_barrier();
+			if (pg_atomic_read_u32(&bucket->version) == version)
+				break;
+		}
 
-	result = (BufferLookupEnt *)
-		hash_search_with_hash_value(SharedBufHash,
-									(void *) tagPtr,
-									hashcode,
-									HASH_FIND,
-									NULL);
+		if (result >= 0)
+			return result;
+		if (noverflow == 0)
+			break;
 
-	if (!result)
-		return -1;
+		bucketno = (bucketno + 1) & SharedBufTableMask;
+	}
 
-	return result->id;
+	return -1;
 }
 
 /*
@@ -119,25 +262,50 @@ BufTableLookup(BufferTag *tagPtr, uint32 hashcode)
 int
 BufTableInsert(BufferTag *tagPtr, uint32 hashcode, int buf_id)
 {
-	BufferLookupEnt *result;
-	bool		found;
+	uint32		bucketno = hashcode & SharedBufTableMask;
+	uint32		nprobed;
+	int			result;
 
 	Assert(buf_id >= 0);		/* -1 is reserved for not-in-table */
 	Assert(tagPtr->blockNum != P_NEW);	/* invalid tag */
 
-	result = (BufferLookupEnt *)
-		hash_search_with_hash_value(SharedBufHash,
-									(void *) tagPtr,
-									hashcode,
-									HASH_ENTER,
-									&found);
+	/* nobody else can insert this tag concurrently, so just look it up */
+	result = BufTableLookup(tagPtr, hashcode);
+	if (result >= 0)
+		return result;
 
-	if (found)					/* found something already in the table */
-		return result->id;
+	for (nprobed = 0; nprobed <= SharedBufTableMask; nprobed++)
+	{
+		BufTableBucket *bucket = &SharedBufTable[bucketno].bucket;
+		int			j;
 
-	result->id = buf_id;
+		BufTableLockBucket(bucket);
+		for (j = 0; j < BUFTABLE_BUCKET_SLOTS; j++)
+		{
+			BufferLookupEnt *ent = &bucket->slots[j];
 
-	return -1;
+			if (ent->id < 0)
+			{
+				ent->key = *tagPtr;
+				ent->id = buf_id;
+				BufTableUnlockBucket(bucket);
+				return -1;
+			}
+		}
+
+		/*
+		 * Bucket is full, so the entry will live beyond it.  Count that
+		 * before moving on, so that lookups never stop short of the entry.
+		 */
+		bucket->noverflow++;
+		BufTableUnlockBucket(bucket);
+
+		bucketno = (bucketno + 1) & SharedBufTableMask;
+	}
+
+	/* shouldn't happen, since the table is sized for all possible entries */
+	elog(ERROR, "shared buffer hash table is full");
+	return -1;					/* keep compiler quiet */
 }
 
 /*
@@ -149,15 +317,52 @@ BufTableInsert(BufferTag *tagPtr, uint32 hashcode, int buf_id)
 void
 BufTableDelete(BufferTag *tagPtr, uint32 hashcode)
 {
-	BufferLookupEnt *result;
+	uint32		home = hashcode & SharedBufTableMask;
+	uint32		bucketno = home;
+	uint32		nprobed;
+
+	for (nprobed = 0; nprobed <= SharedBufTableMask; nprobed++)
+	{
+		BufTableBucket *bucket = &SharedBufTable[bucketno].bucket;
+		bool		overflowed;
+		int			j;
+
+		BufTableLockBucket(bucket);
+		for (j = 0; j < BUFTABLE_BUCKET_SLOTS; j++)
+		{
+			BufferLookupEnt *ent = &bucket->slots[j];
+
+			if (ent->id >= 0 && BUFFERTAGS_EQUAL(ent->key, *tagPtr))
+			{
+				ent->id = -1;
+				BufTableUnlockBucket(bucket);
+
+				/*
+				 * Now uncount the entry in the buckets it passed over.  Until
+				 * we're done they overstate their counts, which only makes
+				 * lookups probe a little further than they need to.
+				 */
+				for (bucketno = home; nprobed > 0; nprobed--)
+				{
+					bucket = &SharedBufTable[bucketno].bucket;
+					BufTableLockBucket(bucket);
+					Assert(bucket->noverflow > 0);
+					bucket->noverflow--;
+					BufTableUnlockBucket(bucket);
+					bucketno = (bucketno + 1) & SharedBufTableMask;
+				}
+				return;
+			}
+		}
+		overflowed = (bucket->noverflow > 0);
+		BufTableUnlockBucket(bucket);
+
+		if (!overflowed)
+			break;
 
-	result = (BufferLookupEnt *)
-		hash_search_with_hash_value(SharedBufHash,
-									(void *) tagPtr,
-									hashcode,
-									HASH_REMOVE,
-									NULL);
+		bucketno = (bucketno + 1) & SharedBufTableMask;
+	}
 
-	if (!result)				/* shouldn't happen */
-		elog(ERROR, "shared buffer hash table corrupted");
+	/* shouldn't happen */
+	elog(ERROR, "shared buffer hash table corrupted");
 }
@@ -48,6 +48,7 @@
 #include "storage/proc.h"
 #include "storage/smgr.h"
 #include "storage/standby.h"
+#include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/resowner_private.h"
 #include "utils/timestamp.h"
@@ -119,6 +120,9 @@ int			checkpoint_flush_after = 0;
 int			bgwriter_flush_after = 0;
 int			backend_flush_after = 0;
 
+/* largest run of consecutive blocks to read or write with one request */
+int			io_combine_limit = 16;
+
 /*
  * How many buffers PrefetchBuffer callers should try to stay ahead of their
  * ReadBuffer calls by.  This is maintained by the assign hook for
@@ -128,10 +132,20 @@ int			backend_flush_after = 0;
  */
 int			target_prefetch_pages = 0;
 
-/* local state for StartBufferIO and related functions */
-static BufferDesc *InProgressBuf = NULL;
+/*
+ * local state for StartBufferIO and related functions
+ *
+ * A backend normally has I/O in progress on at most one buffer at a time,
+ * but combined reads and writes (see io_combine_limit) have several.  They
+ * are all in the same direction.
+ */
+static BufferDesc *InProgressBufs[MAX_IO_COMBINE_LIMIT];
+static int	NumInProgressBufs = 0;
 static bool IsForInput;
 
+/* private copies of pages being checksummed for a combined write */
+static char *SyncRunPageCopies = NULL;
+
 /* local state for LockBufferForCleanup */
 static BufferDesc *PinCountWaitBuf = NULL;
 
@@ -437,9 +451,14 @@ static void PinBuffer_Locked(BufferDesc *buf);
 static void UnpinBuffer(BufferDesc *buf, bool fixOwner);
 static void BufferSync(int flags);
 static uint32 WaitBufHdrUnlocked(BufferDesc *buf);
+struct BgBufferSyncState;
+static bool BgBufferSyncPartition(struct BgBufferSyncState *st, int partition,
+					  WritebackContext *wb_context);
 static int	SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *flush_context);
+static int SyncBufferRun(CkptSortItem *items, int nitems,
+			  WritebackContext *wb_context, int *nwritten);
 static void WaitIO(BufferDesc *buf);
-static bool StartBufferIO(BufferDesc *buf, bool forInput);
+static bool StartBufferIO(BufferDesc *buf, bool forInput, bool nowait);
 static void TerminateBufferIO(BufferDesc *buf, bool clear_dirty,
 				  uint32 set_flag_bits);
 static void shared_buffer_write_error_callback(void *arg);
@@ -449,7 +468,12 @@ static BufferDesc *BufferAlloc(SMgrRelation smgr,
 			ForkNumber forkNum,
 			BlockNumber blockNum,
 			BufferAccessStrategy strategy,
-			bool *foundPtr);
+			bool *foundPtr, bool nowait);
+static int ReadAheadBuffers(SMgrRelation smgr, char relpersistence,
+				 ForkNumber forkNum, BlockNumber blockNum,
+				 BufferAccessStrategy strategy, BufferDesc **bufs);
+static void CompleteReadAhead(BlockNumber blockNum, BufferDesc **bufs,
+				  int nbufs);
 static void FlushBuffer(BufferDesc *buf, SMgrRelation reln);
 static void AtProcExit_Buffers(int code, Datum arg);
 static void CheckForBufferLeaks(void);
@@ -548,40 +572,64 @@ PrefetchBuffer(Relation reln, ForkNumber forkNum, BlockNumber blockNum)
 	}
 	else
 	{
-		BufferTag	newTag;		/* identity of requested block */
-		uint32		newHash;	/* hash value for newTag */
-		LWLock	   *newPartitionLock;	/* buffer partition lock for it */
-		int			buf_id;
-
-		/* create a tag so we can lookup the buffer */
-		INIT_BUFFERTAG(newTag, reln->rd_smgr->smgr_rnode.node,
-					   forkNum, blockNum);
-
-		/* determine its hash code and partition lock ID */
-		newHash = BufTableHashCode(&newTag);
-		newPartitionLock = BufMappingPartitionLock(newHash);
-
-		/* see if the block is in the buffer pool already */
-		LWLockAcquire(newPartitionLock, LW_SHARED);
-		buf_id = BufTableLookup(&newTag, newHash);
-		LWLockRelease(newPartitionLock);
+		/* pass it to the shared buffer version */
+		(void) PrefetchSharedBuffer(reln->rd_smgr, forkNum, blockNum);
+	}
+#endif   /* USE_PREFETCH */
+}
 
-		/* If not in buffers, initiate prefetch */
-		if (buf_id < 0)
-			smgrprefetch(reln->rd_smgr, forkNum, blockNum);
+/*
+ * PrefetchSharedBuffer -- initiate asynchronous read of a block of a
+ *		relation that uses shared buffers
+ *
+ * This is the guts of PrefetchBuffer, usable without a relcache entry, as
+ * during recovery.  Returns true if the block was found in shared buffers
+ * already, in which case no prefetch is issued.
+ */
+bool
+PrefetchSharedBuffer(SMgrRelation smgr_reln, ForkNumber forkNum,
+					 BlockNumber blockNum)
+{
+#ifdef USE_PREFETCH
+	BufferTag	newTag;			/* identity of requested block */
+	uint32		newHash;		/* hash value for newTag */
+	int			buf_id;
 
-		/*
-		 * If the block *is* in buffers, we do nothing.  This is not really
-		 * ideal: the block might be just about to be evicted, which would be
-		 * stupid since we know we are going to need it soon.  But the only
-		 * easy answer is to bump the usage_count, which does not seem like a
-		 * great solution: when the caller does ultimately touch the block,
-		 * usage_count would get bumped again, resulting in too much
-		 * favoritism for blocks that are involved in a prefetch sequence. A
-		 * real fix would involve some additional per-buffer state, and it's
-		 * not clear that there's enough of a problem to justify that.
-		 */
+	Assert(BlockNumberIsValid(blockNum));
+
+	/* create a tag so we can lookup the buffer */
+	INIT_BUFFERTAG(newTag, smgr_reln->smgr_rnode.node, forkNum, blockNum);
+
+	/* determine its hash code */
+	newHash = BufTableHashCode(&newTag);
+
+	/*
+	 * See if the block is in the buffer pool already.  No lock is needed,
+	 * since a stale answer only costs us a useless or missed prefetch.
+	 */
+	buf_id = BufTableLookup(&newTag, newHash);
+
+	/* If not in buffers, initiate prefetch */
+	if (buf_id < 0)
+	{
+		smgrprefetch(smgr_reln, forkNum, blockNum);
+		return false;
 	}
+
+	/*
+	 * If the block *is* in buffers, we do nothing.  This is not really
+	 * ideal: the block might be just about to be evicted, which would be
+	 * stupid since we know we are going to need it soon.  But the only easy
+	 * answer is to bump the usage_count, which does not seem like a great
+	 * solution: when the caller does ultimately touch the block, usage_count
+	 * would get bumped again, resulting in too much favoritism for blocks
+	 * that are involved in a prefetch sequence. A real fix would involve some
+	 * additional per-buffer state, and it's not clear that there's enough of
+	 * a problem to justify that.
+	 */
+	return true;
+#else
+	return false;
 #endif   /* USE_PREFETCH */
 }
 
@@ -743,7 +791,7 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 		 * not currently in memory.
 		 */
 		bufHdr = BufferAlloc(smgr, relpersistence, forkNum, blockNum,
-							 strategy, &found);
+							 strategy, &found, false);
 		if (found)
 			pgBufferUsage.shared_blks_hit++;
 		else
@@ -837,7 +885,7 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 				Assert(buf_state & BM_VALID);
 				buf_state &= ~BM_VALID;
 				UnlockBufHdr(bufHdr, buf_state);
-			} while (!StartBufferIO(bufHdr, true));
+			} while (!StartBufferIO(bufHdr, true, false));
 		}
 	}
 
@@ -883,11 +931,32 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 		{
 			instr_time	io_start,
 						io_time;
+			BufferDesc *rabufs[MAX_IO_COMBINE_LIMIT];
+			int			nra = 0;
+
+			/*
+			 * If the caller is scanning the relation sequentially, read the
+			 * following blocks in the same request.
+			 */
+			if (!isLocalBuf && mode == RBM_NORMAL && strategy != NULL)
+				nra = ReadAheadBuffers(smgr, relpersistence, forkNum, blockNum,
+									   strategy, rabufs);
 
 			if (track_io_timing)
 				INSTR_TIME_SET_CURRENT(io_start);
 
-			smgrread(smgr, forkNum, blockNum, (char *) bufBlock);
+			if (nra == 0)
+				smgrread(smgr, forkNum, blockNum, (char *) bufBlock);
+			else
+			{
+				char	   *blocks[MAX_IO_COMBINE_LIMIT];
+				int			i;
+
+				blocks[0] = (char *) bufBlock;
+				for (i = 0; i < nra; i++)
+					blocks[i + 1] = (char *) BufHdrGetBlock(rabufs[i]);
+				smgrreadv(smgr, forkNum, blockNum, blocks, nra + 1);
+			}
 
 			if (track_io_timing)
 			{
@@ -916,6 +985,9 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 									blockNum,
 									relpath(smgr->smgr_rnode, forkNum))));
 			}
+
+			if (nra > 0)
+				CompleteReadAhead(blockNum, rabufs, nra);
 		}
 	}
 
@@ -964,6 +1036,76 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	return BufferDescriptorGetBuffer(bufHdr);
 }
 
+/*
+ * ReadAheadBuffers -- subroutine for ReadBuffer_common
+ *
+ * Set up buffers for the blocks following blockNum, as many as the strategy
+ * and io_combine_limit allow, stopping at the end of the relation and at the
+ * first block that is in the buffer pool already or can't be set up without
+ * waiting.  The buffers are returned in bufs[], pinned and with I/O in
+ * progress, for the caller to read together with blockNum and then pass to
+ * CompleteReadAhead.  Returns the number of buffers set up.
+ */
+static int
+ReadAheadBuffers(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
+				 BlockNumber blockNum, BufferAccessStrategy strategy,
+				 BufferDesc **bufs)
+{
+	int			maxblocks;
+	BlockNumber nblocks;
+	int			n = 0;
+
+	maxblocks = Min(io_combine_limit, StrategyMaxReadBlocks(strategy));
+	if (maxblocks <= 1)
+		return 0;
+
+	nblocks = smgrnblocks(smgr, forkNum);
+
+	while (n + 1 < maxblocks && blockNum + n + 1 < nblocks)
+	{
+		BufferDesc *buf;
+		bool		found;
+
+		ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+
+		buf = BufferAlloc(smgr, relpersistence, forkNum, blockNum + n + 1,
+						  strategy, &found, true);
+		if (buf == NULL)
+			break;
+		Assert(!found);
+
+		bufs[n++] = buf;
+		pgBufferUsage.shared_blks_read++;
+	}
+
+	return n;
+}
+
+/*
+ * CompleteReadAhead -- finish the buffers set up by ReadAheadBuffers
+ *
+ * Their blocks, following blockNum, have been read in.  Nobody has asked for
+ * these pages yet, so if one fails verification we just leave it invalid;
+ * whoever reads it for real will retry the read and report the problem.
+ */
+static void
+CompleteReadAhead(BlockNumber blockNum, BufferDesc **bufs, int nbufs)
+{
+	int			i;
+
+	for (i = 0; i < nbufs; i++)
+	{
+		BufferDesc *buf = bufs[i];
+
+		if (PageIsVerified((Page) BufHdrGetBlock(buf), blockNum + i + 1))
+			TerminateBufferIO(buf, false, BM_VALID);
+		else
+			TerminateBufferIO(buf, false, 0);
+
+		UnpinBuffer(buf, true);
+	}
+}
+
 /*
  * BufferAlloc -- subroutine for ReadBuffer.  Handles lookup of a shared
  *		buffer.  If no buffer exists already, selects a replacement
@@ -981,13 +1123,19 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
  * *foundPtr is actually redundant with the buffer's BM_VALID flag, but
  * we keep it for simplicity in ReadBuffer.
  *
+ * If nowait is TRUE, we are setting up a buffer to be read ahead, and must
+ * not wait for anything (see StartBufferIO).  Return NULL instead if the
+ * page is in the buffer pool already, if the chosen victim would have to be
+ * written out first, or if someone else gets to the page before we do.
+ * Otherwise the result is as for a page that was not found.
+ *
  * No locks are held either at entry or exit.
  */
 static BufferDesc *
 BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 			BlockNumber blockNum,
 			BufferAccessStrategy strategy,
-			bool *foundPtr)
+			bool *foundPtr, bool nowait)
 {
 	BufferTag	newTag;			/* identity of requested block */
 	uint32		newHash;		/* hash value for newTag */
@@ -1008,23 +1156,51 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	newHash = BufTableHashCode(&newTag);
 	newPartitionLock = BufMappingPartitionLock(newHash);
 
-	/* see if the block is in the buffer pool already */
-	LWLockAcquire(newPartitionLock, LW_SHARED);
+	/*
+	 * See if the block is in the buffer pool already.  The lookup itself
+	 * takes no lock, so the buffer we find may be reassigned to another page
+	 * before we manage to pin it.  Once we hold a pin that can't happen any
+	 * more, so we recheck the buffer's tag after pinning.  If we lost the
+	 * race, look again while holding the mapping lock, which gives a stable
+	 * answer.  A failed lookup needs no recheck: if someone else is loading
+	 * the page concurrently, BufTableInsert will notice below.
+	 */
 	buf_id = BufTableLookup(&newTag, newHash);
+	if (buf_id >= 0 && nowait)
+		return NULL;
 	if (buf_id >= 0)
 	{
-		/*
-		 * Found it.  Now, pin the buffer so no one can steal it from the
-		 * buffer pool, and check to see if the correct data has been loaded
-		 * into the buffer.
-		 */
 		buf = GetBufferDescriptor(buf_id);
 
 		valid = PinBuffer(buf, strategy);
 
-		/* Can release the mapping lock as soon as we've pinned it */
-		LWLockRelease(newPartitionLock);
+		buf_state = LockBufHdr(buf);
+		if (!(buf_state & BM_TAG_VALID) || !BUFFERTAGS_EQUAL(buf->tag, newTag))
+			buf_id = -1;
+		UnlockBufHdr(buf, buf_state);
+
+		if (buf_id < 0)
+		{
+			UnpinBuffer(buf, true);
+
+			LWLockAcquire(newPartitionLock, LW_SHARED);
+			buf_id = BufTableLookup(&newTag, newHash);
+			if (buf_id >= 0)
+			{
+				buf = GetBufferDescriptor(buf_id);
+				valid = PinBuffer(buf, strategy);
+			}
+			LWLockRelease(newPartitionLock);
+		}
+	}
 
+	if (buf_id >= 0)
+	{
+		/*
+		 * Found it, and it's pinned so no one can steal it from the buffer
+		 * pool.  Check to see if the correct data has been loaded into the
+		 * buffer.
+		 */
 		*foundPtr = TRUE;
 
 		if (!valid)
@@ -1036,7 +1212,7 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 			 * own read attempt if the page is still not BM_VALID.
 			 * StartBufferIO does it all.
 			 */
-			if (StartBufferIO(buf, true))
+			if (StartBufferIO(buf, true, false))
 			{
 				/*
 				 * If we get here, previous attempts to read the buffer must
@@ -1051,9 +1227,8 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 
 	/*
 	 * Didn't find it in the buffer pool.  We'll have to initialize a new
-	 * buffer.  Remember to unlock the mapping lock while doing the work.
+	 * buffer.
 	 */
-	LWLockRelease(newPartitionLock);
 
 	/* Loop here in case we have to try another victim buffer */
 	for (;;)
@@ -1087,6 +1262,12 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 		 */
 		if (oldFlags & BM_DIRTY)
 		{
+			if (nowait)
+			{
+				UnpinBuffer(buf, true);
+				return NULL;
+			}
+
 			/*
 			 * We need a share-lock on the buffer contents to write it out
 			 * (else we might write invalid data, eg because someone else is
@@ -1228,6 +1409,12 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 				oldPartitionLock != newPartitionLock)
 				LWLockRelease(oldPartitionLock);
 
+			if (nowait)
+			{
+				LWLockRelease(newPartitionLock);
+				return NULL;
+			}
+
 			/* remaining code should match code at top of routine */
 
 			buf = GetBufferDescriptor(buf_id);
@@ -1248,7 +1435,7 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 				 * then set up our own read attempt if the page is still not
 				 * BM_VALID.  StartBufferIO does it all.
 				 */
-				if (StartBufferIO(buf, true))
+				if (StartBufferIO(buf, true, false))
 				{
 					/*
 					 * If we get here, previous attempts to read the buffer
@@ -1313,13 +1500,21 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 
 	LWLockRelease(newPartitionLock);
 
+	/* Let the replacement policy know what happened */
+	StrategyBufferRenamed(buf, oldPartitionLock != NULL, oldHash, newHash);
+
 	/*
 	 * Buffer contents are currently invalid.  Try to get the io_in_progress
 	 * lock.  If StartBufferIO returns false, then someone else managed to
 	 * read it before we did, so there's nothing left for BufferAlloc() to do.
 	 */
-	if (StartBufferIO(buf, true))
+	if (StartBufferIO(buf, true, nowait))
 		*foundPtr = FALSE;
+	else if (nowait)
+	{
+		UnpinBuffer(buf, true);
+		return NULL;
+	}
 	else
 		*foundPtr = TRUE;
 
@@ -1942,14 +2137,13 @@ BufferSync(int flags)
 		BufferDesc *bufHdr = NULL;
 		CkptTsStatus *ts_stat = (CkptTsStatus *)
 		DatumGetPointer(binaryheap_first(ts_heap));
+		int			nitems = 1;
 
 		buf_id = CkptBufferIds[ts_stat->index].buf_id;
 		Assert(buf_id != -1);
 
 		bufHdr = GetBufferDescriptor(buf_id);
 
-		num_processed++;
-
 		/*
 		 * We don't need to acquire the lock here, because we're only looking
 		 * at a single bit. It's possible that someone else writes the buffer
@@ -1964,21 +2158,42 @@ BufferSync(int flags)
 		 */
 		if (pg_atomic_read_u32(&bufHdr->state) & BM_CHECKPOINT_NEEDED)
 		{
-			if (SyncOneBuffer(buf_id, false, &wb_context) & BUF_WRITTEN)
-			{
-				TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(buf_id);
-				BgWriterStats.m_buf_written_checkpoints++;
-				num_written++;
-			}
+			CkptSortItem *items = &CkptBufferIds[ts_stat->index];
+			int			maxitems;
+			int			nwritten = 0;
+
+			/*
+			 * If the next entries are for the following blocks of the same
+			 * relation fork, try to write them all with one request.
+			 */
+			maxitems = Min(io_combine_limit,
+						   ts_stat->num_to_scan - ts_stat->num_scanned);
+			while (nitems < maxitems &&
+				   items[nitems].relNode == items[0].relNode &&
+				   items[nitems].forkNum == items[0].forkNum &&
+				   items[nitems].blockNum == items[0].blockNum + nitems)
+				nitems++;
+
+			if (nitems > 1)
+				nitems = SyncBufferRun(items, nitems, &wb_context, &nwritten);
+			else if (SyncOneBuffer(buf_id, false, &wb_context) & BUF_WRITTEN)
+				nwritten = 1;
+
+			for (i = 0; i < nwritten; i++)
+				TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(items[i].buf_id);
+			BgWriterStats.m_buf_written_checkpoints += nwritten;
+			num_written += nwritten;
 		}
 
+		num_processed += nitems;
+
 		/*
 		 * Measure progress independent of actually having to flush the buffer
 		 * - otherwise writing become unbalanced.
 		 */
-		ts_stat->progress += ts_stat->progress_slice;
-		ts_stat->num_scanned++;
-		ts_stat->index++;
+		ts_stat->progress += ts_stat->progress_slice * nitems;
+		ts_stat->num_scanned += nitems;
+		ts_stat->index += nitems;
 
 		/* Have all the buffers from the tablespace been processed? */
 		if (ts_stat->num_scanned == ts_stat->num_to_scan)
@@ -2013,193 +2228,120 @@ BufferSync(int flags)
 	TRACE_POSTGRESQL_BUFFER_SYNC_DONE(NBuffers, num_written, num_to_scan);
 }
 
+/*
+ * State kept by BgBufferSync between calls, for each partition of the buffer
+ * pool (see freelist.c).
+ */
+typedef struct BgBufferSyncState
+{
+	/* Moving average of the allocation rate */
+	float		smoothed_alloc;
+} BgBufferSyncState;
+
 /*
  * BgBufferSync -- Write out some dirty buffers in the pool.
  *
  * This is called periodically by the background writer process.
  *
  * Returns true if it's appropriate for the bgwriter process to go into
- * low-power hibernation mode.  (This happens if the strategy clock sweep
- * has been "lapped" and no buffer allocations have occurred recently,
- * or if the bgwriter has been effectively disabled by setting
- * bgwriter_lru_maxpages to 0.)
+ * low-power hibernation mode.  (This happens if the clean buffer lists are
+ * stocked and no buffer allocations have occurred recently, or if the
+ * bgwriter has been effectively disabled by setting bgwriter_lru_maxpages
+ * to 0.)
+ *
+ * Each partition of the buffer pool has its own clock sweep and clean
+ * buffer list, so we look after each of them separately.
  */
 bool
 BgBufferSync(WritebackContext *wb_context)
 {
-	/* info obtained from freelist.c */
-	int			strategy_buf_id;
-	uint32		strategy_passes;
-	uint32		recent_alloc;
+	static BgBufferSyncState *states = NULL;
+	int			nparts = StrategyNumPartitions();
+	bool		hibernate = true;
+	int			i;
 
-	/*
-	 * Information saved between calls so we can determine the strategy
-	 * point's advance rate and avoid scanning already-cleaned buffers.
-	 */
-	static bool saved_info_valid = false;
-	static int	prev_strategy_buf_id;
-	static uint32 prev_strategy_passes;
-	static int	next_to_clean;
-	static uint32 next_passes;
+	if (states == NULL)
+		states = (BgBufferSyncState *)
+			MemoryContextAllocZero(TopMemoryContext,
+								   nparts * sizeof(BgBufferSyncState));
+
+	for (i = 0; i < nparts; i++)
+	{
+		if (!BgBufferSyncPartition(&states[i], i, wb_context))
+			hibernate = false;
+	}
 
-	/* Moving averages of allocation rate and clean-buffer density */
-	static float smoothed_alloc = 0;
-	static float smoothed_density = 10.0;
+	return hibernate;
+}
+
+/*
+ * BgBufferSyncPartition -- BgBufferSync's work for one partition
+ *
+ * We keep the partition's clean list stocked with enough buffers to satisfy
+ * the allocations we expect before our next call, so that backends rarely
+ * have to run the clock sweep or write out a dirty victim themselves.  To
+ * refill the list, we run the clock sweep ourselves: each buffer the hand
+ * passes that would be a victim is written out if dirty, and then added to
+ * the list.
+ */
+static bool
+BgBufferSyncPartition(BgBufferSyncState *st, int partition,
+					  WritebackContext *wb_context)
+{
+	/* info obtained from freelist.c */
+	int			first_buffer;
+	int			num_buffers;
+	uint32		recent_alloc;
+	int			lru_maxpages;
 
 	/* Potentially these could be tunables, but for now, not */
 	float		smoothing_samples = 16;
 	float		scan_whole_pool_milliseconds = 120000.0;
 
-	/* Used to compute how far we scan ahead */
-	long		strategy_delta;
-	int			bufs_to_lap;
-	int			bufs_ahead;
-	float		scans_per_alloc;
-	int			reusable_buffers_est;
+	/* Used to compute how many clean buffers we want */
 	int			upcoming_alloc_est;
-	int			min_scan_buffers;
+	int			min_clean_buffers;
 
 	/* Variables for the scanning loop proper */
 	int			num_to_scan;
 	int			num_written;
-	int			reusable_buffers;
-
-	/* Variables for final smoothed_density update */
-	long		new_strategy_delta;
-	uint32		new_recent_alloc;
+	int			clean_buffers;
 
 	/*
-	 * Find out where the freelist clock sweep currently is, and how many
-	 * buffer allocations have happened since our last call.
+	 * Find out how many buffer allocations have happened since our last
+	 * call.
 	 */
-	strategy_buf_id = StrategySyncStart(&strategy_passes, &recent_alloc);
+	StrategyPartitionBuffers(partition, &first_buffer, &num_buffers);
+	(void) StrategySyncStart(partition, NULL, &recent_alloc);
 
 	/* Report buffer alloc counts to pgstat */
 	BgWriterStats.m_buf_alloc += recent_alloc;
 
 	/*
 	 * If we're not running the LRU scan, just stop after doing the stats
-	 * stuff.  We mark the saved state invalid so that we can recover sanely
-	 * if LRU scan is turned back on later.
+	 * stuff.  Backends then find their victims with the clock sweep, once
+	 * the buffers we left on the clean list are gone.
 	 */
 	if (bgwriter_lru_maxpages <= 0)
-	{
-		saved_info_valid = false;
 		return true;
-	}
-
-	/*
-	 * Compute strategy_delta = how many buffers have been scanned by the
-	 * clock sweep since last time.  If first time through, assume none. Then
-	 * see if we are still ahead of the clock sweep, and if so, how many
-	 * buffers we could scan before we'd catch up with it and "lap" it. Note:
-	 * weird-looking coding of xxx_passes comparisons are to avoid bogus
-	 * behavior when the passes counts wrap around.
-	 */
-	if (saved_info_valid)
-	{
-		int32		passes_delta = strategy_passes - prev_strategy_passes;
 
-		strategy_delta = strategy_buf_id - prev_strategy_buf_id;
-		strategy_delta += (long) passes_delta *NBuffers;
-
-		Assert(strategy_delta >= 0);
-
-		if ((int32) (next_passes - strategy_passes) > 0)
-		{
-			/* we're one pass ahead of the strategy point */
-			bufs_to_lap = strategy_buf_id - next_to_clean;
-#ifdef BGW_DEBUG
-			elog(DEBUG2, "bgwriter ahead: bgw %u-%u strategy %u-%u delta=%ld lap=%d",
-				 next_passes, next_to_clean,
-				 strategy_passes, strategy_buf_id,
-				 strategy_delta, bufs_to_lap);
-#endif
-		}
-		else if (next_passes == strategy_passes &&
-				 next_to_clean >= strategy_buf_id)
-		{
-			/* on same pass, but ahead or at least not behind */
-			bufs_to_lap = NBuffers - (next_to_clean - strategy_buf_id);
-#ifdef BGW_DEBUG
-			elog(DEBUG2, "bgwriter ahead: bgw %u-%u strategy %u-%u delta=%ld lap=%d",
-				 next_passes, next_to_clean,
-				 strategy_passes, strategy_buf_id,
-				 strategy_delta, bufs_to_lap);
-#endif
-		}
-		else
-		{
-			/*
-			 * We're behind, so skip forward to the strategy point and start
-			 * cleaning from there.
-			 */
-#ifdef BGW_DEBUG
-			elog(DEBUG2, "bgwriter behind: bgw %u-%u strategy %u-%u delta=%ld",
-				 next_passes, next_to_clean,
-				 strategy_passes, strategy_buf_id,
-				 strategy_delta);
-#endif
-			next_to_clean = strategy_buf_id;
-			next_passes = strategy_passes;
-			bufs_to_lap = NBuffers;
-		}
-	}
-	else
-	{
-		/*
-		 * Initializing at startup or after LRU scanning had been off. Always
-		 * start at the strategy point.
-		 */
-#ifdef BGW_DEBUG
-		elog(DEBUG2, "bgwriter initializing: strategy %u-%u",
-			 strategy_passes, strategy_buf_id);
-#endif
-		strategy_delta = 0;
-		next_to_clean = strategy_buf_id;
-		next_passes = strategy_passes;
-		bufs_to_lap = NBuffers;
-	}
-
-	/* Update saved info for next time */
-	prev_strategy_buf_id = strategy_buf_id;
-	prev_strategy_passes = strategy_passes;
-	saved_info_valid = true;
-
-	/*
-	 * Compute how many buffers had to be scanned for each new allocation, ie,
-	 * 1/density of reusable buffers, and track a moving average of that.
-	 *
-	 * If the strategy point didn't move, we don't update the density estimate
-	 */
-	if (strategy_delta > 0 && recent_alloc > 0)
-	{
-		scans_per_alloc = (float) strategy_delta / (float) recent_alloc;
-		smoothed_density += (scans_per_alloc - smoothed_density) /
-			smoothing_samples;
-	}
-
-	/*
-	 * Estimate how many reusable buffers there are between the current
-	 * strategy point and where we've scanned ahead to, based on the smoothed
-	 * density estimate.
-	 */
-	bufs_ahead = NBuffers - bufs_to_lap;
-	reusable_buffers_est = (float) bufs_ahead / smoothed_density;
+	/* Each partition gets its share of the write limit */
+	lru_maxpages = Max((int) ((double) bgwriter_lru_maxpages *
+							  num_buffers / NBuffers), 1);
 
 	/*
 	 * Track a moving average of recent buffer allocations.  Here, rather than
 	 * a true average we want a fast-attack, slow-decline behavior: we
 	 * immediately follow any increase.
 	 */
-	if (smoothed_alloc <= (float) recent_alloc)
-		smoothed_alloc = recent_alloc;
+	if (st->smoothed_alloc <= (float) recent_alloc)
+		st->smoothed_alloc = recent_alloc;
 	else
-		smoothed_alloc += ((float) recent_alloc - smoothed_alloc) /
+		st->smoothed_alloc += ((float) recent_alloc - st->smoothed_alloc) /
 			smoothing_samples;
 
 	/* Scale the estimate by a GUC to allow more aggressive tuning. */
-	upcoming_alloc_est = (int) (smoothed_alloc * bgwriter_lru_multiplier);
+	upcoming_alloc_est = (int) (st->smoothed_alloc * bgwriter_lru_multiplier);
 
 	/*
 	 * If recent_alloc remains at zero for many cycles, smoothed_alloc will
@@ -2210,105 +2352,77 @@ BgBufferSync(WritebackContext *wb_context)
 	 * syndrome.  It will pop back up as soon as recent_alloc increases.
 	 */
 	if (upcoming_alloc_est == 0)
-		smoothed_alloc = 0;
+		st->smoothed_alloc = 0;
 
 	/*
 	 * Even in cases where there's been little or no buffer allocation
-	 * activity, we want to make a small amount of progress through the buffer
-	 * cache so that as many reusable buffers as possible are clean after an
-	 * idle period.
+	 * activity, we want to keep a few clean buffers in stock, so that a
+	 * burst of allocations after an idle period doesn't find the list empty.
 	 *
 	 * (scan_whole_pool_milliseconds / BgWriterDelay) computes how many times
 	 * the BGW will be called during the scan_whole_pool time; slice the
 	 * buffer pool into that many sections.
 	 */
-	min_scan_buffers = (int) (NBuffers / (scan_whole_pool_milliseconds / BgWriterDelay));
+	min_clean_buffers = (int) (num_buffers / (scan_whole_pool_milliseconds / BgWriterDelay));
 
-	if (upcoming_alloc_est < (min_scan_buffers + reusable_buffers_est))
-	{
-#ifdef BGW_DEBUG
-		elog(DEBUG2, "bgwriter: alloc_est=%d too small, using min=%d + reusable_est=%d",
-			 upcoming_alloc_est, min_scan_buffers, reusable_buffers_est);
-#endif
-		upcoming_alloc_est = min_scan_buffers + reusable_buffers_est;
-	}
+	if (upcoming_alloc_est < min_clean_buffers)
+		upcoming_alloc_est = min_clean_buffers;
+	if (upcoming_alloc_est > num_buffers)
+		upcoming_alloc_est = num_buffers;
 
 	/*
-	 * Now write out dirty reusable buffers, working forward from the
-	 * next_to_clean point, until we have lapped the strategy scan, or cleaned
-	 * enough buffers to match our estimate of the next cycle's allocation
-	 * requirements, or hit the bgwriter_lru_maxpages limit.
+	 * Now advance the clock sweep, writing out dirty victims and putting them
+	 * on the clean list, until the list holds our estimate of the next
+	 * cycle's allocation requirements, or we have gone once around the
+	 * partition, or hit the bgwriter_lru_maxpages limit.
 	 */
 
 	/* Make sure we can handle the pin inside SyncOneBuffer */
 	ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
 
-	num_to_scan = bufs_to_lap;
+	num_to_scan = num_buffers;
 	num_written = 0;
-	reusable_buffers = reusable_buffers_est;
+	clean_buffers = StrategyCleanBufferCount(partition);
 
-	/* Execute the LRU scan */
-	while (num_to_scan > 0 && reusable_buffers < upcoming_alloc_est)
+	while (num_to_scan > 0 && clean_buffers < upcoming_alloc_est)
 	{
-		int			sync_state = SyncOneBuffer(next_to_clean, true,
-											   wb_context);
+		int			buf_id = StrategyCleanSweep(partition);
+		int			sync_state;
 
-		if (++next_to_clean >= NBuffers)
-		{
-			next_to_clean = 0;
-			next_passes++;
-		}
 		num_to_scan--;
+		if (buf_id < 0)
+			continue;
+
+		sync_state = SyncOneBuffer(buf_id, true, wb_context);
+
+		if ((sync_state & BUF_REUSABLE) &&
+			StrategyPushCleanBuffer(partition, buf_id))
+			clean_buffers++;
 
 		if (sync_state & BUF_WRITTEN)
 		{
-			reusable_buffers++;
-			if (++num_written >= bgwriter_lru_maxpages)
+			if (++num_written >= lru_maxpages)
 			{
 				BgWriterStats.m_maxwritten_clean++;
 				break;
 			}
 		}
-		else if (sync_state & BUF_REUSABLE)
-			reusable_buffers++;
 	}
 
 	BgWriterStats.m_buf_written_clean += num_written;
 
 #ifdef BGW_DEBUG
-	elog(DEBUG1, "bgwriter: recent_alloc=%u smoothed=%.2f delta=%ld ahead=%d density=%.2f reusable_est=%d upcoming_est=%d scanned=%d wrote=%d reusable=%d",
-		 recent_alloc, smoothed_alloc, strategy_delta, bufs_ahead,
-		 smoothed_density, reusable_buffers_est, upcoming_alloc_est,
-		 bufs_to_lap - num_to_scan,
-		 num_written,
-		 reusable_buffers - reusable_buffers_est);
+	elog(DEBUG1, "bgwriter: partition %d recent_alloc=%u smoothed=%.2f upcoming_est=%d scanned=%d wrote=%d clean=%d",
+		 partition, recent_alloc, st->smoothed_alloc, upcoming_alloc_est,
+		 num_buffers - num_to_scan, num_written, clean_buffers);
 #endif
 
 	/*
-	 * Consider the above scan as being like a new allocation scan.
-	 * Characterize its density and update the smoothed one based on it. This
-	 * effectively halves the moving average period in cases where both the
-	 * strategy and the background writer are doing some useful scanning,
-	 * which is helpful because a long memory isn't as desirable on the
-	 * density estimates.
+	 * Return true if OK to hibernate: nobody has allocated anything, and the
+	 * list is stocked or we've been all the way round without stocking it.
 	 */
-	new_strategy_delta = bufs_to_lap - num_to_scan;
-	new_recent_alloc = reusable_buffers - reusable_buffers_est;
-	if (new_strategy_delta > 0 && new_recent_alloc > 0)
-	{
-		scans_per_alloc = (float) new_strategy_delta / (float) new_recent_alloc;
-		smoothed_density += (scans_per_alloc - smoothed_density) /
-			smoothing_samples;
-
-#ifdef BGW_DEBUG
-		elog(DEBUG2, "bgwriter: cleaner density alloc=%u scan=%ld density=%.2f new smoothed=%.2f",
-			 new_recent_alloc, new_strategy_delta,
-			 scans_per_alloc, smoothed_density);
-#endif
-	}
-
-	/* Return true if OK to hibernate */
-	return (bufs_to_lap == 0 && recent_alloc == 0);
+	return (recent_alloc == 0 &&
+			(clean_buffers >= upcoming_alloc_est || num_to_scan == 0));
 }
 
 /*
@@ -2387,6 +2501,186 @@ SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *wb_context)
 	return result | BUF_WRITTEN;
 }
 
+/*
+ * SyncBufferRun -- write out a run of buffers for BufferSync
+ *
+ * items[] are the CkptBufferIds entries for nitems consecutive blocks of one
+ * relation fork, as far as the sort key can tell (it doesn't include the
+ * database).  The first buffer is written just as SyncOneBuffer would.  Each
+ * following buffer is added to the same write request as long as it still
+ * holds the expected block, still needs to be written for the checkpoint,
+ * and can be locked without waiting, since by then we have I/O in progress.
+ *
+ * Returns the number of items dealt with, at least one.  *nwritten is set
+ * to the number of buffers written, which is either that or zero.
+ *
+ * Note: caller must have done ResourceOwnerEnlargeBuffers.
+ */
+static int
+SyncBufferRun(CkptSortItem *items, int nitems, WritebackContext *wb_context,
+			  int *nwritten)
+{
+	BufferDesc *bufs[MAX_IO_COMBINE_LIMIT];
+	char	   *blocks[MAX_IO_COMBINE_LIMIT];
+	BufferDesc *bufHdr;
+	BufferTag	tag;
+	SMgrRelation reln;
+	XLogRecPtr	maxlsn = InvalidXLogRecPtr;
+	ErrorContextCallback errcallback;
+	instr_time	io_start,
+				io_time;
+	uint32		buf_state;
+	int			n;
+	int			i;
+
+	Assert(nitems > 1 && nitems <= MAX_IO_COMBINE_LIMIT);
+	*nwritten = 0;
+
+	bufHdr = GetBufferDescriptor(items[0].buf_id);
+
+	ReservePrivateRefCountEntry();
+
+	buf_state = LockBufHdr(bufHdr);
+	if (!(buf_state & BM_VALID) || !(buf_state & BM_DIRTY))
+	{
+		/* It's clean, so nothing to do */
+		UnlockBufHdr(bufHdr, buf_state);
+		return 1;
+	}
+	PinBuffer_Locked(bufHdr);
+	LWLockAcquire(BufferDescriptorGetContentLock(bufHdr), LW_SHARED);
+
+	if (!StartBufferIO(bufHdr, false, false))
+	{
+		/* someone else flushed it before we could */
+		LWLockRelease(BufferDescriptorGetContentLock(bufHdr));
+		UnpinBuffer(bufHdr, true);
+		return 1;
+	}
+	bufs[0] = bufHdr;
+
+	/* Buffer is pinned, so we can read tag without spinlock */
+	tag = bufHdr->tag;
+
+	for (n = 1; n < nitems; n++)
+	{
+		bufHdr = GetBufferDescriptor(items[n].buf_id);
+		tag.blockNum++;
+
+		ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+		ReservePrivateRefCountEntry();
+
+		buf_state = LockBufHdr(bufHdr);
+		if (!(buf_state & BM_CHECKPOINT_NEEDED) ||
+			!(buf_state & BM_VALID) || !(buf_state & BM_DIRTY) ||
+			!BUFFERTAGS_EQUAL(bufHdr->tag, tag))
+		{
+			UnlockBufHdr(bufHdr, buf_state);
+			break;
+		}
+		PinBuffer_Locked(bufHdr);
+
+		if (!LWLockConditionalAcquire(BufferDescriptorGetContentLock(bufHdr),
+									  LW_SHARED))
+		{
+			UnpinBuffer(bufHdr, true);
+			break;
+		}
+		if (!StartBufferIO(bufHdr, false, true))
+		{
+			LWLockRelease(BufferDescriptorGetContentLock(bufHdr));
+			UnpinBuffer(bufHdr, true);
+			break;
+		}
+		bufs[n] = bufHdr;
+	}
+
+	/* Setup error traceback support for ereport() */
+	errcallback.callback = shared_buffer_write_error_callback;
+	errcallback.arg = (void *) bufs[0];
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	reln = smgropen(bufs[0]->tag.rnode, InvalidBackendId);
+
+	/*
+	 * Collect the LSNs and clear BM_JUST_DIRTIED, as FlushBuffer does, and
+	 * flush WAL once for the whole run.
+	 */
+	for (i = 0; i < n; i++)
+	{
+		XLogRecPtr	recptr;
+
+		buf_state = LockBufHdr(bufs[i]);
+		recptr = BufferGetLSN(bufs[i]);
+		buf_state &= ~BM_JUST_DIRTIED;
+		UnlockBufHdr(bufs[i], buf_state);
+
+		if ((buf_state & BM_PERMANENT) && recptr > maxlsn)
+			maxlsn = recptr;
+	}
+	if (maxlsn != InvalidXLogRecPtr)
+		XLogFlush(maxlsn);
+
+	/*
+	 * PageSetChecksumCopy has room for only one page, so make our own copies
+	 * if we need to checksum.
+	 */
+	if (DataChecksumsEnabled() && SyncRunPageCopies == NULL)
+	{
+		char	   *p;
+
+		p = MemoryContextAlloc(TopMemoryContext,
+							   MAX_IO_COMBINE_LIMIT * BLCKSZ + PG_IO_ALIGN_SIZE);
+		SyncRunPageCopies = (char *) TYPEALIGN(PG_IO_ALIGN_SIZE, p);
+	}
+	for (i = 0; i < n; i++)
+	{
+		blocks[i] = (char *) BufHdrGetBlock(bufs[i]);
+		if (DataChecksumsEnabled())
+		{
+			char	   *copy = SyncRunPageCopies + i * BLCKSZ;
+
+			memcpy(copy, blocks[i], BLCKSZ);
+			PageSetChecksumInplace((Page) copy, bufs[i]->tag.blockNum);
+			blocks[i] = copy;
+		}
+	}
+
+	if (track_io_timing)
+		INSTR_TIME_SET_CURRENT(io_start);
+
+	smgrwritev(reln, bufs[0]->tag.forkNum, bufs[0]->tag.blockNum, blocks, n,
+			   false);
+
+	if (track_io_timing)
+	{
+		INSTR_TIME_SET_CURRENT(io_time);
+		INSTR_TIME_SUBTRACT(io_time, io_start);
+		pgstat_count_buffer_write_time(INSTR_TIME_GET_MICROSEC(io_time));
+		INSTR_TIME_ADD(pgBufferUsage.blk_write_time, io_time);
+	}
+
+	pgBufferUsage.shared_blks_written += n;
+
+	for (i = 0; i < n; i++)
+	{
+		TerminateBufferIO(bufs[i], true, 0);
+		LWLockRelease(BufferDescriptorGetContentLock(bufs[i]));
+
+		tag = bufs[i]->tag;
+		UnpinBuffer(bufs[i], true);
+
+		ScheduleBufferTagForWriteback(wb_context, &tag);
+	}
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
+
+	*nwritten = n;
+	return n;
+}
+
 /*
  *		AtEOXact_Buffers - clean up at end of transaction.
  *
@@ -2660,7 +2954,7 @@ FlushBuffer(BufferDesc *buf, SMgrRelation reln)
 	 * false, then someone else flushed the buffer before we could, so we need
 	 * not do anything.
 	 */
-	if (!StartBufferIO(buf, false))
+	if (!StartBufferIO(buf, false, false))
 		return;
 
 	/* Setup error traceback support for ereport() */
@@ -3853,13 +4147,19 @@ WaitIO(BufferDesc *buf)
  *
  * Returns TRUE if we successfully marked the buffer as I/O busy,
  * FALSE if someone else already did the work.
+ *
+ * If nowait is TRUE, return FALSE rather than wait for someone else's I/O.
+ * That is required when adding a buffer to a combined read or write, while
+ * we already have I/O in progress on other buffers: waiting for another
+ * backend that might be waiting for one of those would deadlock.
  */
 static bool
-StartBufferIO(BufferDesc *buf, bool forInput)
+StartBufferIO(BufferDesc *buf, bool forInput, bool nowait)
 {
 	uint32		buf_state;
 
-	Assert(!InProgressBuf);
+	Assert(NumInProgressBufs == 0 || (nowait && IsForInput == forInput));
+	Assert(NumInProgressBufs < MAX_IO_COMBINE_LIMIT);
 
 	for (;;)
 	{
@@ -3867,7 +4167,11 @@ StartBufferIO(BufferDesc *buf, bool forInput)
 		 * Grab the io_in_progress lock so that other processes can wait for
 		 * me to finish the I/O.
 		 */
-		LWLockAcquire(BufferDescriptorGetIOLock(buf), LW_EXCLUSIVE);
+		if (!nowait)
+			LWLockAcquire(BufferDescriptorGetIOLock(buf), LW_EXCLUSIVE);
+		else if (!LWLockConditionalAcquire(BufferDescriptorGetIOLock(buf),
+										   LW_EXCLUSIVE))
+			return false;
 
 		buf_state = LockBufHdr(buf);
 
@@ -3882,6 +4186,8 @@ StartBufferIO(BufferDesc *buf, bool forInput)
 		 */
 		UnlockBufHdr(buf, buf_state);
 		LWLockRelease(BufferDescriptorGetIOLock(buf));
+		if (nowait)
+			return false;
 		WaitIO(buf);
 	}
 
@@ -3898,7 +4204,7 @@ StartBufferIO(BufferDesc *buf, bool forInput)
 	buf_state |= BM_IO_IN_PROGRESS;
 	UnlockBufHdr(buf, buf_state);
 
-	InProgressBuf = buf;
+	InProgressBufs[NumInProgressBufs++] = buf;
 	IsForInput = forInput;
 
 	return true;
@@ -3925,8 +4231,14 @@ static void
 TerminateBufferIO(BufferDesc *buf, bool clear_dirty, uint32 set_flag_bits)
 {
 	uint32		buf_state;
+	int			i;
 
-	Assert(buf == InProgressBuf);
+	for (i = NumInProgressBufs - 1; i >= 0; i--)
+	{
+		if (InProgressBufs[i] == buf)
+			break;
+	}
+	Assert(i >= 0);
 
 	buf_state = LockBufHdr(buf);
 
@@ -3939,7 +4251,7 @@ TerminateBufferIO(BufferDesc *buf, bool clear_dirty, uint32 set_flag_bits)
 	buf_state |= set_flag_bits;
 	UnlockBufHdr(buf, buf_state);
 
-	InProgressBuf = NULL;
+	InProgressBufs[i] = InProgressBufs[--NumInProgressBufs];
 
 	LWLockRelease(BufferDescriptorGetIOLock(buf));
 }
@@ -3951,15 +4263,15 @@ TerminateBufferIO(BufferDesc *buf, bool clear_dirty, uint32 set_flag_bits)
  *	but we haven't yet released buffer pins, so the buffer is still pinned.
  *
  *	If I/O was in progress, we always set BM_IO_ERROR, even though it's
- *	possible the error condition wasn't related to the I/O.
+ *	possible the error condition wasn't related to the I/O.  For a combined
+ *	read or write, that applies to all of its buffers.
  */
 void
 AbortBufferIO(void)
 {
-	BufferDesc *buf = InProgressBuf;
-
-	if (buf)
+	while (NumInProgressBufs > 0)
 	{
+		BufferDesc *buf = InProgressBufs[NumInProgressBufs - 1];
 		uint32		buf_state;
 
 		/*
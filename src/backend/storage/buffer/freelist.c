@@ -15,26 +15,62 @@
  */
 #include "postgres.h"
 
+#include "access/htup_details.h"
+#include "funcapi.h"
+#include "miscadmin.h"
 #include "port/atomics.h"
+#include "port/pg_numa.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
+#include "storage/pg_shmem.h"
 #include "storage/proc.h"
+#include "utils/builtins.h"
+#include "utils/tuplestore.h"
 
 #define INT_ACCESS_ONCE(var)	((int)(*((volatile int *)&(var))))
 
+/*
+ * How many buffer allocations a backend makes before checking again which
+ * NUMA node it is running on.
+ */
+#define STRATEGY_NODE_RECHECK_INTERVAL	256
 
 /*
- * The shared freelist control information.
+ * With buffer_replacement_policy = 2q, the share of each partition that the
+ * probationary queue may fill before we start recycling its buffers, and
+ * the number of evicted probationary pages remembered, as a fraction of
+ * shared_buffers.  These are the values suggested in the 2Q paper.
+ */
+#define STRATEGY_PROBATION_FRACTION		0.25
+#define STRATEGY_GHOST_FRACTION			0.5
+
+/* Values of StrategyBufferQueueState[] */
+#define BUF_QUEUE_MAIN			0	/* not on the probationary queue */
+#define BUF_QUEUE_PROBATION		1	/* on the probationary queue */
+#define BUF_QUEUE_EVICTED		2	/* just recycled from the queue */
+
+/* GUC variable */
+int			buffer_replacement_policy = BUFFER_REPLACEMENT_CLOCK;
+
+
+/*
+ * The buffer pool is divided into one or more partitions, each consisting
+ * of a contiguous range of buffers with its own freelist and clock sweep.
+ * Normally there is just a single partition.  With shared_memory_numa set
+ * to "local", there is one partition per NUMA node, whose buffers are placed
+ * in that node's memory, and backends prefer to take victim buffers from
+ * the partition of the node they are running on.
  */
 typedef struct
 {
-	/* Spinlock: protects the values below */
-	slock_t		buffer_strategy_lock;
+	/* Spinlock: protects the freelist and completePasses */
+	slock_t		partition_lock;
 
 	/*
-	 * Clock sweep hand: index of next buffer to consider grabbing. Note that
-	 * this isn't a concrete buffer - we only ever increase the value. So, to
-	 * get an actual buffer, it needs to be used modulo NBuffers.
+	 * Clock sweep hand: index of next buffer to consider grabbing, counted
+	 * from firstBuffer. Note that this isn't a concrete buffer - we only ever
+	 * increase the value. So, to get an actual buffer, it needs to be used
+	 * modulo numBuffers.
 	 */
 	pg_atomic_uint32 nextVictimBuffer;
 
@@ -53,15 +89,101 @@ typedef struct
 	uint32		completePasses; /* Complete cycles of the clock sweep */
 	pg_atomic_uint32 numBufferAllocs;	/* Buffers allocated since last reset */
 
+	/*
+	 * Probationary queue, used only by the 2q policy: a FIFO of buffers
+	 * holding pages that haven't proven themselves yet, kept in this
+	 * partition's slice of StrategyProbationQueue.  Both counters only ever
+	 * increase; the queue holds tail - head entries, and entry i is at
+	 * position i % numBuffers.  Protected by partition_lock.
+	 */
+	uint32		probationHead;
+	uint32		probationTail;
+
+	/*
+	 * List of clean buffers that the background writer found ready for
+	 * replacement ahead of the clock hand, kept in this partition's slice of
+	 * StrategyCleanList like the probationary queue.  The bgwriter is the
+	 * only one adding entries, at the tail; backends take them off the head.
+	 * No lock is needed for that: see StrategyPushCleanBuffer and
+	 * GetBufferFromCleanList.
+	 */
+	pg_atomic_uint32 cleanHead;
+	pg_atomic_uint32 cleanTail;
+
+	/* Cumulative statistics, for pg_shmem_numa */
+	pg_atomic_uint64 totalAllocs;	/* Buffers allocated from this partition */
+	pg_atomic_uint64 remoteAllocs;	/* ... for backends on another node */
+
+	/* Cumulative statistics, for pg_stat_buffer_replacement */
+	pg_atomic_uint64 evictions; /* Buffers recycled by the policy */
+	pg_atomic_uint64 probationEvictions;	/* ... from the probationary queue */
+	pg_atomic_uint64 promotions;	/* Pages loaded straight into the main
+									 * part, because they were re-referenced
+									 * soon after leaving the queue */
+	pg_atomic_uint64 cleanEvictions;	/* Buffers taken from the clean list */
+
+	/* These don't change after initialization */
+	int			firstBuffer;	/* First buffer in the partition */
+	int			numBuffers;		/* Number of buffers in the partition */
+	int			numaNode;		/* Node its memory is on, or -1 */
+} BufferStrategyPartition;
+
+/* keep each partition on its own cache line(s) */
+typedef union BufferStrategyPartitionPadded
+{
+	BufferStrategyPartition part;
+	char		pad[PG_CACHE_LINE_SIZE];
+} BufferStrategyPartitionPadded;
+
+/*
+ * The shared freelist control information.
+ */
+typedef struct
+{
+	/* Spinlock: protects bgwprocno */
+	slock_t		buffer_strategy_lock;
+
 	/*
 	 * Bgworker process to be notified upon activity or -1 if none. See
 	 * StrategyNotifyBgWriter.
 	 */
 	int			bgwprocno;
+
+	/*
+	 * Number of partitions, and the number of buffers in each; the last
+	 * partition also gets the remainder.  These don't change after
+	 * initialization.
+	 */
+	int			numPartitions;
+	int			partitionSize;
+
+	/* Number of entries in StrategyGhostTable, minus one (2q only) */
+	uint32		ghostMask;
 } BufferStrategyControl;
 
 /* Pointers to shared state */
 static BufferStrategyControl *StrategyControl = NULL;
+static BufferStrategyPartitionPadded *StrategyPartitions = NULL;
+
+/*
+ * Shared state of the 2q policy.  StrategyProbationQueue holds the entries
+ * of the partitions' probationary queues, and StrategyBufferQueueState tells
+ * for each buffer whether it is on one.  StrategyGhostTable remembers the
+ * hash codes of pages recently evicted from the queues, so that we can
+ * notice when they come back.  It is direct-mapped, so a page can be
+ * forgotten early when another page's hash code lands on the same entry;
+ * that only costs the page another trip through the queue.
+ */
+static int *StrategyProbationQueue = NULL;
+static uint8 *StrategyBufferQueueState = NULL;
+static uint32 *StrategyGhostTable = NULL;
+
+/* Entries of the partitions' clean buffer lists, see above */
+static int *StrategyCleanList = NULL;
+
+/* Partition this backend currently prefers, see StrategyLocalPartition */
+static int	MyStrategyPartition = 0;
+static int	StrategyNodeRecheckCountdown = 0;
 
 /*
  * Private (non-shared) state for managing a ring of shared buffers to re-use.
@@ -98,19 +220,29 @@ typedef struct BufferAccessStrategyData
 
 
 /* Prototypes for internal functions */
+static BufferDesc *GetBufferFromPartition(BufferStrategyPartition *part,
+					   BufferAccessStrategy strategy,
+					   uint32 *buf_state);
+static BufferDesc *GetBufferFromCleanList(BufferStrategyPartition *part,
+					   BufferAccessStrategy strategy,
+					   uint32 *buf_state);
 static BufferDesc *GetBufferFromRing(BufferAccessStrategy strategy,
 				  uint32 *buf_state);
 static void AddBufferToRing(BufferAccessStrategy strategy,
 				BufferDesc *buf);
+static BufferDesc *GetBufferFromProbation(BufferStrategyPartition *part,
+					   BufferAccessStrategy strategy,
+					   uint32 *buf_state);
+static void ProbationEnqueue(BufferStrategyPartition *part, int buf_id);
 
 /*
  * ClockSweepTick - Helper routine for StrategyGetBuffer()
  *
- * Move the clock hand one buffer ahead of its current position and return the
- * id of the buffer now under the hand.
+ * Move the partition's clock hand one buffer ahead of its current position
+ * and return the id of the buffer now under the hand.
  */
 static inline uint32
-ClockSweepTick(void)
+ClockSweepTick(BufferStrategyPartition *part)
 {
 	uint32		victim;
 
@@ -120,14 +252,14 @@ ClockSweepTick(void)
 	 * apparent order.
 	 */
 	victim =
-		pg_atomic_fetch_add_u32(&StrategyControl->nextVictimBuffer, 1);
+		pg_atomic_fetch_add_u32(&part->nextVictimBuffer, 1);
 
-	if (victim >= NBuffers)
+	if (victim >= part->numBuffers)
 	{
 		uint32		originalVictim = victim;
 
 		/* always wrap what we look up in BufferDescriptors */
-		victim = victim % NBuffers;
+		victim = victim % part->numBuffers;
 
 		/*
 		 * If we're the one that just caused a wraparound, force
@@ -153,19 +285,63 @@ ClockSweepTick(void)
 				 * could lead to an overflow of nextVictimBuffers, but that's
 				 * highly unlikely and wouldn't be particularly harmful.
 				 */
-				SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+				SpinLockAcquire(&part->partition_lock);
 
-				wrapped = expected % NBuffers;
+				wrapped = expected % part->numBuffers;
 
-				success = pg_atomic_compare_exchange_u32(&StrategyControl->nextVictimBuffer,
+				success = pg_atomic_compare_exchange_u32(&part->nextVictimBuffer,
 														 &expected, wrapped);
 				if (success)
-					StrategyControl->completePasses++;
-				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+					part->completePasses++;
+				SpinLockRelease(&part->partition_lock);
+			}
+		}
+	}
+	return part->firstBuffer + victim;
+}
+
+/*
+ * StrategyLocalPartition - which partition should this backend use first?
+ *
+ * That's the partition of the NUMA node we're running on.  Since the
+ * scheduler may move us to another node, we look again every so often.  If
+ * we can't tell, or the node has no partition, spread backends over all
+ * partitions.
+ */
+static int
+StrategyLocalPartition(void)
+{
+	int			nparts = StrategyControl->numPartitions;
+
+	if (nparts > 1 && --StrategyNodeRecheckCountdown <= 0)
+	{
+		int			node = pg_numa_current_node();
+		int			i;
+
+		MyStrategyPartition = MyProcPid % nparts;
+		for (i = 0; i < nparts; i++)
+		{
+			if (node >= 0 && StrategyPartitions[i].part.numaNode == node)
+			{
+				MyStrategyPartition = i;
+				break;
 			}
 		}
+		StrategyNodeRecheckCountdown = STRATEGY_NODE_RECHECK_INTERVAL;
 	}
-	return victim;
+
+	return MyStrategyPartition;
+}
+
+/*
+ * StrategyPartitionOf - which partition does the given buffer belong to?
+ */
+static inline BufferStrategyPartition *
+StrategyPartitionOf(int buf_id)
+{
+	int			p = buf_id / StrategyControl->partitionSize;
+
+	return &StrategyPartitions[Min(p, StrategyControl->numPartitions - 1)].part;
 }
 
 /*
@@ -185,8 +361,8 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 {
 	BufferDesc *buf;
 	int			bgwprocno;
-	int			trycounter;
-	uint32		local_buf_state;	/* to avoid repeated (de-)referencing */
+	int			local;
+	int			i;
 
 	/*
 	 * If given a strategy object, see whether it can select a buffer. We
@@ -226,11 +402,55 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 	}
 
 	/*
-	 * We count buffer allocation requests so that the bgwriter can estimate
-	 * the rate of buffer consumption.  Note that buffers recycled by a
-	 * strategy object are intentionally not counted here.
+	 * Look in our own partition first.  Only if all of its buffers are
+	 * pinned do we resort to the other partitions.
 	 */
-	pg_atomic_fetch_add_u32(&StrategyControl->numBufferAllocs, 1);
+	local = StrategyLocalPartition();
+	for (i = 0; i < StrategyControl->numPartitions; i++)
+	{
+		int			p = (local + i) % StrategyControl->numPartitions;
+		BufferStrategyPartition *part = &StrategyPartitions[p].part;
+
+		buf = GetBufferFromPartition(part, strategy, buf_state);
+		if (buf != NULL)
+		{
+			/*
+			 * We count buffer allocation requests so that the bgwriter can
+			 * estimate the rate of buffer consumption.  Note that buffers
+			 * recycled by a strategy object are intentionally not counted
+			 * here.
+			 */
+			pg_atomic_fetch_add_u32(&part->numBufferAllocs, 1);
+			pg_atomic_fetch_add_u64(&part->totalAllocs, 1);
+			if (p != local)
+				pg_atomic_fetch_add_u64(&part->remoteAllocs, 1);
+			return buf;
+		}
+	}
+
+	/*
+	 * We've scanned all the buffers without making any state changes, so all
+	 * the buffers are pinned (or were when we looked at them).  We could hope
+	 * that someone will free one eventually, but it's probably better to fail
+	 * than to risk getting stuck in an infinite loop.
+	 */
+	elog(ERROR, "no unpinned buffers available");
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * GetBufferFromPartition -- subroutine for StrategyGetBuffer()
+ *
+ * Returns a buffer from the partition with its header spinlock held, or NULL
+ * if all of the partition's buffers are pinned.
+ */
+static BufferDesc *
+GetBufferFromPartition(BufferStrategyPartition *part,
+					   BufferAccessStrategy strategy, uint32 *buf_state)
+{
+	BufferDesc *buf;
+	int			trycounter;
+	uint32		local_buf_state;	/* to avoid repeated (de-)referencing */
 
 	/*
 	 * First check, without acquiring the lock, whether there's buffers in the
@@ -245,34 +465,34 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 	 * repeat if not.
 	 *
 	 * Note that the freeNext fields are considered to be protected by the
-	 * buffer_strategy_lock not the individual buffer spinlocks, so it's OK to
+	 * partition_lock not the individual buffer spinlocks, so it's OK to
 	 * manipulate them without holding the spinlock.
 	 */
-	if (StrategyControl->firstFreeBuffer >= 0)
+	if (part->firstFreeBuffer >= 0)
 	{
 		while (true)
 		{
 			/* Acquire the spinlock to remove element from the freelist */
-			SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+			SpinLockAcquire(&part->partition_lock);
 
-			if (StrategyControl->firstFreeBuffer < 0)
+			if (part->firstFreeBuffer < 0)
 			{
-				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+				SpinLockRelease(&part->partition_lock);
 				break;
 			}
 
-			buf = GetBufferDescriptor(StrategyControl->firstFreeBuffer);
+			buf = GetBufferDescriptor(part->firstFreeBuffer);
 			Assert(buf->freeNext != FREENEXT_NOT_IN_LIST);
 
 			/* Unconditionally remove buffer from freelist */
-			StrategyControl->firstFreeBuffer = buf->freeNext;
+			part->firstFreeBuffer = buf->freeNext;
 			buf->freeNext = FREENEXT_NOT_IN_LIST;
 
 			/*
 			 * Release the lock so someone else can access the freelist while
 			 * we check out this buffer.
 			 */
-			SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+			SpinLockRelease(&part->partition_lock);
 
 			/*
 			 * If the buffer is pinned or has a nonzero usage_count, we cannot
@@ -295,11 +515,44 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 		}
 	}
 
-	/* Nothing on the freelist, so run the "clock sweep" algorithm */
-	trycounter = NBuffers;
+	/*
+	 * With the 2q policy, recycle the oldest probationary buffer if the
+	 * queue has grown beyond its share of the partition.
+	 */
+	if (buffer_replacement_policy == BUFFER_REPLACEMENT_2Q &&
+		part->probationTail - part->probationHead >
+		part->numBuffers * STRATEGY_PROBATION_FRACTION)
+	{
+		buf = GetBufferFromProbation(part, strategy, buf_state);
+		if (buf != NULL)
+			return buf;
+	}
+
+	/*
+	 * Normally the background writer has already run the clock sweep for
+	 * us, and left the buffers it found on the clean list.
+	 */
+	buf = GetBufferFromCleanList(part, strategy, buf_state);
+	if (buf != NULL)
+		return buf;
+
+	/* Nothing on the freelists, so run the "clock sweep" algorithm */
+	trycounter = part->numBuffers;
 	for (;;)
 	{
-		buf = GetBufferDescriptor(ClockSweepTick());
+		buf = GetBufferDescriptor(ClockSweepTick(part));
+
+		/*
+		 * Buffers on the probationary queue are not the clock's business;
+		 * they get recycled in queue order, above.
+		 */
+		if (StrategyBufferQueueState != NULL &&
+			StrategyBufferQueueState[buf->buf_id] == BUF_QUEUE_PROBATION)
+		{
+			if (--trycounter == 0)
+				break;
+			continue;
+		}
 
 		/*
 		 * If the buffer is pinned or has a nonzero usage_count, we cannot use
@@ -313,31 +566,231 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 			{
 				local_buf_state -= BUF_USAGECOUNT_ONE;
 
-				trycounter = NBuffers;
+				trycounter = part->numBuffers;
 			}
 			else
 			{
 				/* Found a usable buffer */
 				if (strategy != NULL)
 					AddBufferToRing(strategy, buf);
+				pg_atomic_fetch_add_u64(&part->evictions, 1);
 				*buf_state = local_buf_state;
 				return buf;
 			}
 		}
 		else if (--trycounter == 0)
 		{
-			/*
-			 * We've scanned all the buffers without making any state changes,
-			 * so all the buffers are pinned (or were when we looked at them).
-			 * We could hope that someone will free one eventually, but it's
-			 * probably better to fail than to risk getting stuck in an
-			 * infinite loop.
-			 */
 			UnlockBufHdr(buf, local_buf_state);
-			elog(ERROR, "no unpinned buffers available");
+			break;
 		}
 		UnlockBufHdr(buf, local_buf_state);
 	}
+
+	/*
+	 * Everything outside the probationary queue is pinned.  The queue is
+	 * our last hope, however short it is.
+	 */
+	if (buffer_replacement_policy == BUFFER_REPLACEMENT_2Q)
+		return GetBufferFromProbation(part, strategy, buf_state);
+
+	/* We've scanned the whole partition and everything is pinned */
+	return NULL;
+}
+
+/*
+ * GetBufferFromCleanList -- subroutine for GetBufferFromPartition()
+ *
+ * Take buffers off the head of the partition's clean list until we find one
+ * that is still fit for replacement, and return it with its header spinlock
+ * held.  Returns NULL if the list runs out.
+ *
+ * A buffer may have been pinned or used again since the background writer
+ * put it on the list, or even recycled by the clock sweep; such entries are
+ * just dropped.  One that has been dirtied again is still a good victim, it
+ * merely costs our caller a write.
+ */
+static BufferDesc *
+GetBufferFromCleanList(BufferStrategyPartition *part,
+					   BufferAccessStrategy strategy, uint32 *buf_state)
+{
+	int		   *list = StrategyCleanList + part->firstBuffer;
+	uint32		local_buf_state;
+
+	for (;;)
+	{
+		BufferDesc *buf;
+		uint32		head;
+		int			buf_id;
+
+		head = pg_atomic_read_u32(&part->cleanHead);
+		if (head == pg_atomic_read_u32(&part->cleanTail))
+			return NULL;
+
+		/*
+		 * Read the entry before claiming it.  The bgwriter won't reuse its
+		 * slot until the head has moved past it, and then our compare and
+		 * exchange fails, so whatever we read is good if that succeeds.
+		 */
+		pg_read_barrier();
+		buf_id = list[head % part->numBuffers];
+		if (!pg_atomic_compare_exchange_u32(&part->cleanHead, &head, head + 1))
+			continue;
+
+		if (StrategyBufferQueueState != NULL &&
+			StrategyBufferQueueState[buf_id] == BUF_QUEUE_PROBATION)
+			continue;
+
+		buf = GetBufferDescriptor(buf_id);
+		local_buf_state = LockBufHdr(buf);
+		if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0
+			&& BUF_STATE_GET_USAGECOUNT(local_buf_state) == 0)
+		{
+			if (strategy != NULL)
+				AddBufferToRing(strategy, buf);
+			pg_atomic_fetch_add_u64(&part->evictions, 1);
+			pg_atomic_fetch_add_u64(&part->cleanEvictions, 1);
+			*buf_state = local_buf_state;
+			return buf;
+		}
+		UnlockBufHdr(buf, local_buf_state);
+	}
+}
+
+/*
+ * GetBufferFromProbation -- subroutine for GetBufferFromPartition()
+ *
+ * Take buffers off the head of the partition's probationary queue until we
+ * find one that isn't pinned, and return it with its header spinlock held.
+ * Pinned buffers go back to the tail of the queue.  Returns NULL if every
+ * buffer on the queue is pinned, or the queue is empty.
+ *
+ * Unlike the clock sweep, we don't care about usage_count here: the point of
+ * the queue is that a page must be referenced again after it has left the
+ * queue to earn a place in the rest of the buffer pool.  Repeated references
+ * while on the queue are typically just the same query coming back to the
+ * same page, and don't prove anything.
+ */
+static BufferDesc *
+GetBufferFromProbation(BufferStrategyPartition *part,
+					   BufferAccessStrategy strategy, uint32 *buf_state)
+{
+	int		   *queue = StrategyProbationQueue + part->firstBuffer;
+	uint32		trycounter;
+	uint32		local_buf_state;
+
+	SpinLockAcquire(&part->partition_lock);
+	trycounter = part->probationTail - part->probationHead;
+	SpinLockRelease(&part->partition_lock);
+
+	while (trycounter-- > 0)
+	{
+		BufferDesc *buf;
+		int			buf_id;
+
+		SpinLockAcquire(&part->partition_lock);
+		if (part->probationHead == part->probationTail)
+		{
+			SpinLockRelease(&part->partition_lock);
+			break;
+		}
+		buf_id = queue[part->probationHead % part->numBuffers];
+		part->probationHead++;
+		StrategyBufferQueueState[buf_id] = BUF_QUEUE_EVICTED;
+		SpinLockRelease(&part->partition_lock);
+
+		buf = GetBufferDescriptor(buf_id);
+		local_buf_state = LockBufHdr(buf);
+		if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0)
+		{
+			if (strategy != NULL)
+				AddBufferToRing(strategy, buf);
+			pg_atomic_fetch_add_u64(&part->evictions, 1);
+			pg_atomic_fetch_add_u64(&part->probationEvictions, 1);
+			*buf_state = local_buf_state;
+			return buf;
+		}
+		UnlockBufHdr(buf, local_buf_state);
+
+		/* in use, so give it another turn */
+		ProbationEnqueue(part, buf_id);
+	}
+
+	return NULL;
+}
+
+/*
+ * ProbationEnqueue -- put a buffer at the tail of its probationary queue
+ */
+static void
+ProbationEnqueue(BufferStrategyPartition *part, int buf_id)
+{
+	int		   *queue = StrategyProbationQueue + part->firstBuffer;
+
+	SpinLockAcquire(&part->partition_lock);
+
+	/*
+	 * A buffer can be on the queue only once, so the queue can never hold
+	 * more than numBuffers entries.  Buffers that get a new page while
+	 * already on the queue (for example, because a BufferAccessStrategy
+	 * ring recycled them) keep their place.
+	 */
+	if (StrategyBufferQueueState[buf_id] != BUF_QUEUE_PROBATION)
+	{
+		Assert(part->probationTail - part->probationHead < part->numBuffers);
+		queue[part->probationTail % part->numBuffers] = buf_id;
+		part->probationTail++;
+		StrategyBufferQueueState[buf_id] = BUF_QUEUE_PROBATION;
+	}
+
+	SpinLockRelease(&part->partition_lock);
+}
+
+/*
+ * StrategyBufferRenamed -- tell the replacement policy about a new page
+ *
+ * Called by BufferAlloc() after it has given a buffer a new tag, while
+ * still holding a pin on it.  If a valid page was evicted from the buffer,
+ * evicted is true and oldHash is its hash code.  newHash is the hash code
+ * of the new page.
+ *
+ * With the 2q policy, pages start out on the probationary queue, unless
+ * they were evicted from it recently; in that case they have been
+ * referenced again after leaving it, and go straight into the main part
+ * of the pool.
+ */
+void
+StrategyBufferRenamed(BufferDesc *buf, bool evicted, uint32 oldHash,
+					  uint32 newHash)
+{
+	BufferStrategyPartition *part;
+	uint32	   *ghost;
+	bool		from_probation;
+
+	if (buffer_replacement_policy != BUFFER_REPLACEMENT_2Q)
+		return;
+
+	part = StrategyPartitionOf(buf->buf_id);
+
+	SpinLockAcquire(&part->partition_lock);
+	from_probation =
+		(StrategyBufferQueueState[buf->buf_id] == BUF_QUEUE_EVICTED);
+	if (from_probation)
+		StrategyBufferQueueState[buf->buf_id] = BUF_QUEUE_MAIN;
+	SpinLockRelease(&part->partition_lock);
+
+	/* If the old page was just recycled off the queue, remember it */
+	if (from_probation && evicted)
+		StrategyGhostTable[oldHash & StrategyControl->ghostMask] = oldHash;
+
+	ghost = &StrategyGhostTable[newHash & StrategyControl->ghostMask];
+	if (*ghost == newHash)
+	{
+		/* seen recently, so promote it */
+		*ghost = 0;
+		pg_atomic_fetch_add_u64(&part->promotions, 1);
+	}
+	else
+		ProbationEnqueue(part, buf->buf_id);
 }
 
 /*
@@ -346,7 +799,9 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 void
 StrategyFreeBuffer(BufferDesc *buf)
 {
-	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+	BufferStrategyPartition *part = StrategyPartitionOf(buf->buf_id);
+
+	SpinLockAcquire(&part->partition_lock);
 
 	/*
 	 * It is possible that we are told to put something in the freelist that
@@ -354,20 +809,42 @@ StrategyFreeBuffer(BufferDesc *buf)
 	 */
 	if (buf->freeNext == FREENEXT_NOT_IN_LIST)
 	{
-		buf->freeNext = StrategyControl->firstFreeBuffer;
+		buf->freeNext = part->firstFreeBuffer;
 		if (buf->freeNext < 0)
-			StrategyControl->lastFreeBuffer = buf->buf_id;
-		StrategyControl->firstFreeBuffer = buf->buf_id;
+			part->lastFreeBuffer = buf->buf_id;
+		part->firstFreeBuffer = buf->buf_id;
 	}
 
-	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+	SpinLockRelease(&part->partition_lock);
+}
+
+/*
+ * StrategyNumPartitions -- number of partitions of the buffer pool
+ */
+int
+StrategyNumPartitions(void)
+{
+	return StrategyControl->numPartitions;
+}
+
+/*
+ * StrategyPartitionBuffers -- range of buffers making up a partition
+ */
+void
+StrategyPartitionBuffers(int partition, int *first_buffer, int *num_buffers)
+{
+	BufferStrategyPartition *part = &StrategyPartitions[partition].part;
+
+	*first_buffer = part->firstBuffer;
+	*num_buffers = part->numBuffers;
 }
 
 /*
  * StrategySyncStart -- tell BufferSync where to start syncing
  *
- * The result is the buffer index of the best buffer to sync first.
- * BufferSync() will proceed circularly around the buffer array from there.
+ * The result is the buffer index of the best buffer to sync first in the
+ * given partition.  BufferSync() will proceed circularly around the
+ * partition from there.
  *
  * In addition, we return the completed-pass count (which is effectively
  * the higher-order bits of nextVictimBuffer) and the count of recent buffer
@@ -375,34 +852,111 @@ StrategyFreeBuffer(BufferDesc *buf)
  * being read.
  */
 int
-StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc)
+StrategySyncStart(int partition, uint32 *complete_passes,
+				  uint32 *num_buf_alloc)
 {
+	BufferStrategyPartition *part = &StrategyPartitions[partition].part;
 	uint32		nextVictimBuffer;
 	int			result;
 
-	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
-	nextVictimBuffer = pg_atomic_read_u32(&StrategyControl->nextVictimBuffer);
-	result = nextVictimBuffer % NBuffers;
+	SpinLockAcquire(&part->partition_lock);
+	nextVictimBuffer = pg_atomic_read_u32(&part->nextVictimBuffer);
+	result = part->firstBuffer + nextVictimBuffer % part->numBuffers;
 
 	if (complete_passes)
 	{
-		*complete_passes = StrategyControl->completePasses;
+		*complete_passes = part->completePasses;
 
 		/*
 		 * Additionally add the number of wraparounds that happened before
 		 * completePasses could be incremented. C.f. ClockSweepTick().
 		 */
-		*complete_passes += nextVictimBuffer / NBuffers;
+		*complete_passes += nextVictimBuffer / part->numBuffers;
 	}
 
 	if (num_buf_alloc)
 	{
-		*num_buf_alloc = pg_atomic_exchange_u32(&StrategyControl->numBufferAllocs, 0);
+		*num_buf_alloc = pg_atomic_exchange_u32(&part->numBufferAllocs, 0);
 	}
-	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+	SpinLockRelease(&part->partition_lock);
 	return result;
 }
 
+/*
+ * StrategyCleanSweep -- advance the clock sweep for the background writer
+ *
+ * Move the partition's clock hand one buffer on, just as StrategyGetBuffer
+ * would, and return the id of the buffer passed if it is a candidate for
+ * replacement: not pinned, with a zero usage_count, and not on the
+ * probationary queue.  Otherwise returns -1, after decrementing the
+ * buffer's usage_count if it isn't pinned.
+ *
+ * This lets the background writer run the sweep ahead of the backends, so
+ * that it can clean the buffers it finds and put them on the clean list.
+ */
+int
+StrategyCleanSweep(int partition)
+{
+	BufferStrategyPartition *part = &StrategyPartitions[partition].part;
+	BufferDesc *buf;
+	uint32		buf_state;
+	int			result = -1;
+
+	buf = GetBufferDescriptor(ClockSweepTick(part));
+
+	if (StrategyBufferQueueState != NULL &&
+		StrategyBufferQueueState[buf->buf_id] == BUF_QUEUE_PROBATION)
+		return -1;
+
+	buf_state = LockBufHdr(buf);
+	if (BUF_STATE_GET_REFCOUNT(buf_state) == 0)
+	{
+		if (BUF_STATE_GET_USAGECOUNT(buf_state) != 0)
+			buf_state -= BUF_USAGECOUNT_ONE;
+		else
+			result = buf->buf_id;
+	}
+	UnlockBufHdr(buf, buf_state);
+
+	return result;
+}
+
+/*
+ * StrategyCleanBufferCount -- number of entries on a partition's clean list
+ */
+int
+StrategyCleanBufferCount(int partition)
+{
+	BufferStrategyPartition *part = &StrategyPartitions[partition].part;
+
+	return (int) (pg_atomic_read_u32(&part->cleanTail) -
+				  pg_atomic_read_u32(&part->cleanHead));
+}
+
+/*
+ * StrategyPushCleanBuffer -- add a buffer to the tail of its clean list
+ *
+ * Returns false if the list is full.  Only the background writer may call
+ * this; with a single producer, the tail needs no interlocking.
+ */
+bool
+StrategyPushCleanBuffer(int partition, int buf_id)
+{
+	BufferStrategyPartition *part = &StrategyPartitions[partition].part;
+	int		   *list = StrategyCleanList + part->firstBuffer;
+	uint32		tail = pg_atomic_read_u32(&part->cleanTail);
+
+	if (tail - pg_atomic_read_u32(&part->cleanHead) >= part->numBuffers)
+		return false;
+
+	/* make the entry visible before the new tail that covers it */
+	list[tail % part->numBuffers] = buf_id;
+	pg_write_barrier();
+	pg_atomic_write_u32(&part->cleanTail, tail + 1);
+
+	return true;
+}
+
 /*
  * StrategyNotifyBgWriter -- set or clear allocation notification latch
  *
@@ -425,6 +979,106 @@ StrategyNotifyBgWriter(int bgwprocno)
 }
 
 
+/*
+ * StrategyGetPartitionNodes
+ *
+ * Decide how to partition the buffer pool.  Returns the number of
+ * partitions, and sets nodes[i] to the NUMA node for partition i, or -1.
+ * nodes[] must have room for PG_NUMA_MAX_NODES entries.
+ */
+static int
+StrategyGetPartitionNodes(int *nodes)
+{
+	int			nnodes = 0;
+
+	if (shared_memory_numa == SHMEM_NUMA_LOCAL)
+		nnodes = pg_numa_get_nodes(nodes, Min(NBuffers, PG_NUMA_MAX_NODES));
+
+	if (nnodes == 0)
+	{
+		nodes[0] = -1;
+		nnodes = 1;
+	}
+
+	return nnodes;
+}
+
+/*
+ * Compute the range of buffers making up partition part of nparts.
+ */
+static void
+StrategyComputeBounds(int nparts, int part, int *first, int *count)
+{
+	int			size = NBuffers / nparts;
+
+	*first = part * size;
+	*count = (part == nparts - 1) ? NBuffers - *first : size;
+}
+
+/*
+ * StrategyPlaceBuffers
+ *
+ * With shared_memory_numa = local, move the memory of each partition's
+ * buffers, buffer descriptors and I/O locks to the partition's NUMA node.
+ * This is done before the descriptors are initialized, so that no pages
+ * need to be migrated.  Failure is not fatal, since it affects only
+ * performance.
+ *
+ * Only called by postmaster and only during initialization.
+ */
+void
+StrategyPlaceBuffers(void)
+{
+	int			nodes[PG_NUMA_MAX_NODES];
+	int			nparts;
+	int			i;
+
+	if (shared_memory_numa != SHMEM_NUMA_LOCAL)
+		return;
+
+	nparts = StrategyGetPartitionNodes(nodes);
+	for (i = 0; i < nparts; i++)
+	{
+		int			first;
+		int			count;
+
+		if (nodes[i] < 0)
+			continue;
+
+		StrategyComputeBounds(nparts, i, &first, &count);
+
+		if (pg_numa_bind(BufferBlocks + (Size) first * BLCKSZ,
+						 (Size) count * BLCKSZ,
+						 UsedShmemPageSize, nodes[i]) != 0 ||
+			pg_numa_bind(GetBufferDescriptor(first),
+						 (Size) count * sizeof(BufferDescPadded),
+						 UsedShmemPageSize, nodes[i]) != 0 ||
+			pg_numa_bind(&BufferIOLWLockArray[first],
+						 (Size) count * sizeof(LWLockMinimallyPadded),
+						 UsedShmemPageSize, nodes[i]) != 0)
+		{
+			ereport(LOG,
+					(errmsg("could not place shared buffers on NUMA node %d: %m",
+							nodes[i])));
+			break;
+		}
+	}
+}
+
+/*
+ * Number of entries in the 2q policy's ghost table.
+ */
+static uint32
+StrategyGhostTableSize(void)
+{
+	uint32		size = 1;
+
+	while (size < NBuffers * STRATEGY_GHOST_FRACTION)
+		size <<= 1;
+
+	return size;
+}
+
 /*
  * StrategyShmemSize
  *
@@ -436,6 +1090,7 @@ StrategyNotifyBgWriter(int bgwprocno)
 Size
 StrategyShmemSize(void)
 {
+	int			nodes[PG_NUMA_MAX_NODES];
 	Size		size = 0;
 
 	/* size of lookup hash table ... see comment in StrategyInitialize */
@@ -444,6 +1099,22 @@ StrategyShmemSize(void)
 	/* size of the shared replacement strategy control block */
 	size = add_size(size, MAXALIGN(sizeof(BufferStrategyControl)));
 
+	/* size of the partitions */
+	size = add_size(size, mul_size(StrategyGetPartitionNodes(nodes),
+								   sizeof(BufferStrategyPartitionPadded)));
+
+	/* size of the clean buffer lists */
+	size = add_size(size, mul_size(NBuffers, sizeof(int)));
+
+	/* size of the 2q policy's queues and ghost table */
+	if (buffer_replacement_policy == BUFFER_REPLACEMENT_2Q)
+	{
+		size = add_size(size, mul_size(NBuffers, sizeof(int)));
+		size = add_size(size, mul_size(NBuffers, sizeof(uint8)));
+		size = add_size(size, mul_size(StrategyGhostTableSize(),
+									   sizeof(uint32)));
+	}
+
 	return size;
 }
 
@@ -457,7 +1128,10 @@ StrategyShmemSize(void)
 void
 StrategyInitialize(bool init)
 {
+	int			nodes[PG_NUMA_MAX_NODES];
 	bool		found;
+	int			nparts;
+	int			i;
 
 	/*
 	 * Initialize the shared buffer lookup hashtable.
@@ -488,25 +1162,211 @@ StrategyInitialize(bool init)
 
 		SpinLockInit(&StrategyControl->buffer_strategy_lock);
 
-		/*
-		 * Grab the whole linked list of free buffers for our strategy. We
-		 * assume it was previously set up by InitBufferPool().
-		 */
-		StrategyControl->firstFreeBuffer = 0;
-		StrategyControl->lastFreeBuffer = NBuffers - 1;
-
-		/* Initialize the clock sweep pointer */
-		pg_atomic_init_u32(&StrategyControl->nextVictimBuffer, 0);
-
-		/* Clear statistics */
-		StrategyControl->completePasses = 0;
-		pg_atomic_init_u32(&StrategyControl->numBufferAllocs, 0);
-
 		/* No pending notification */
 		StrategyControl->bgwprocno = -1;
+
+		nparts = StrategyGetPartitionNodes(nodes);
+		StrategyControl->numPartitions = nparts;
+		StrategyControl->partitionSize = NBuffers / nparts;
+
+		StrategyControl->ghostMask = StrategyGhostTableSize() - 1;
 	}
 	else
 		Assert(!init);
+
+	if (buffer_replacement_policy == BUFFER_REPLACEMENT_2Q)
+	{
+		uint32		nghosts = StrategyControl->ghostMask + 1;
+
+		StrategyProbationQueue = (int *)
+			ShmemInitStruct("Buffer Strategy Probationary Queue",
+							NBuffers * sizeof(int), &found);
+		StrategyBufferQueueState = (uint8 *)
+			ShmemInitStruct("Buffer Strategy Queue State",
+							NBuffers * sizeof(uint8), &found);
+		if (!found)
+			memset(StrategyBufferQueueState, BUF_QUEUE_MAIN,
+				   NBuffers * sizeof(uint8));
+		StrategyGhostTable = (uint32 *)
+			ShmemInitStruct("Buffer Strategy Ghost Table",
+							nghosts * sizeof(uint32), &found);
+		if (!found)
+			memset(StrategyGhostTable, 0, nghosts * sizeof(uint32));
+	}
+
+	StrategyCleanList = (int *)
+		ShmemInitStruct("Buffer Strategy Clean List",
+						NBuffers * sizeof(int), &found);
+
+	nparts = StrategyControl->numPartitions;
+	StrategyPartitions = (BufferStrategyPartitionPadded *)
+		ShmemInitStruct("Buffer Strategy Partitions",
+						nparts * sizeof(BufferStrategyPartitionPadded),
+						&found);
+
+	if (!found)
+	{
+		Assert(init);
+
+		/* Same answer as above, since we're still in the same process */
+		nparts = StrategyGetPartitionNodes(nodes);
+		Assert(nparts == StrategyControl->numPartitions);
+
+		for (i = 0; i < nparts; i++)
+		{
+			BufferStrategyPartition *part = &StrategyPartitions[i].part;
+			int			first;
+			int			count;
+
+			StrategyComputeBounds(nparts, i, &first, &count);
+
+			SpinLockInit(&part->partition_lock);
+			part->firstBuffer = first;
+			part->numBuffers = count;
+			part->numaNode = nodes[i];
+
+			/*
+			 * Grab this partition's part of the linked list of free buffers.
+			 * We assume it was previously set up by InitBufferPool(), as a
+			 * single list, so cut it at the end of the partition.
+			 */
+			part->firstFreeBuffer = first;
+			part->lastFreeBuffer = first + count - 1;
+			GetBufferDescriptor(first + count - 1)->freeNext =
+				FREENEXT_END_OF_LIST;
+
+			/* Initialize the clock sweep pointer */
+			pg_atomic_init_u32(&part->nextVictimBuffer, 0);
+
+			/* The probationary queue starts out empty */
+			part->probationHead = 0;
+			part->probationTail = 0;
+
+			/* And so does the clean list */
+			pg_atomic_init_u32(&part->cleanHead, 0);
+			pg_atomic_init_u32(&part->cleanTail, 0);
+
+			/* Clear statistics */
+			part->completePasses = 0;
+			pg_atomic_init_u32(&part->numBufferAllocs, 0);
+			pg_atomic_init_u64(&part->totalAllocs, 0);
+			pg_atomic_init_u64(&part->remoteAllocs, 0);
+			pg_atomic_init_u64(&part->evictions, 0);
+			pg_atomic_init_u64(&part->probationEvictions, 0);
+			pg_atomic_init_u64(&part->promotions, 0);
+			pg_atomic_init_u64(&part->cleanEvictions, 0);
+		}
+	}
+}
+
+/*
+ * pg_get_shmem_numa -- report on the buffer pool partitions
+ *
+ * This is the function underlying the pg_shmem_numa view.
+ */
+Datum
+pg_get_shmem_numa(PG_FUNCTION_ARGS)
+{
+#define PG_GET_SHMEM_NUMA_COLS	4
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	int			i;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	for (i = 0; i < StrategyControl->numPartitions; i++)
+	{
+		BufferStrategyPartition *part = &StrategyPartitions[i].part;
+		Datum		values[PG_GET_SHMEM_NUMA_COLS];
+		bool		nulls[PG_GET_SHMEM_NUMA_COLS];
+
+		memset(nulls, 0, sizeof(nulls));
+
+		if (part->numaNode >= 0)
+			values[0] = Int32GetDatum(part->numaNode);
+		else
+			nulls[0] = true;
+		values[1] = Int32GetDatum(part->numBuffers);
+		values[2] = Int64GetDatum((int64) pg_atomic_read_u64(&part->totalAllocs));
+		values[3] = Int64GetDatum((int64) pg_atomic_read_u64(&part->remoteAllocs));
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_stat_get_buffer_replacement -- report on the work of the replacement
+ *		policy
+ *
+ * This is the function underlying the pg_stat_buffer_replacement view.  The
+ * counts are summed over all partitions, and cover the time since server
+ * start.
+ */
+Datum
+pg_stat_get_buffer_replacement(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_BUFFER_REPLACEMENT_COLS	4
+	TupleDesc	tupdesc;
+	Datum		values[PG_STAT_GET_BUFFER_REPLACEMENT_COLS];
+	bool		nulls[PG_STAT_GET_BUFFER_REPLACEMENT_COLS];
+	uint64		evictions = 0;
+	uint64		probation_evictions = 0;
+	uint64		promotions = 0;
+	uint64		clean_evictions = 0;
+	int			i;
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	for (i = 0; i < StrategyControl->numPartitions; i++)
+	{
+		BufferStrategyPartition *part = &StrategyPartitions[i].part;
+
+		evictions += pg_atomic_read_u64(&part->evictions);
+		probation_evictions += pg_atomic_read_u64(&part->probationEvictions);
+		promotions += pg_atomic_read_u64(&part->promotions);
+		clean_evictions += pg_atomic_read_u64(&part->cleanEvictions);
+	}
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum((int64) evictions);
+	values[1] = Int64GetDatum((int64) probation_evictions);
+	values[2] = Int64GetDatum((int64) promotions);
+	values[3] = Int64GetDatum((int64) clean_evictions);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
 }
 
 
@@ -654,6 +1514,23 @@ AddBufferToRing(BufferAccessStrategy strategy, BufferDesc *buf)
 	strategy->buffers[strategy->current] = BufferDescriptorGetBuffer(buf);
 }
 
+/*
+ * StrategyMaxReadBlocks -- how many consecutive blocks may be read at once
+ *
+ * The buffer manager reads the blocks following a requested one in the same
+ * I/O request only for sequential scans, which we recognize by the bulk-read
+ * strategy.  The blocks read ahead occupy ring members until the scan gets
+ * to them, so don't take more than half the ring.
+ */
+int
+StrategyMaxReadBlocks(BufferAccessStrategy strategy)
+{
+	if (strategy == NULL || strategy->btype != BAS_BULKREAD)
+		return 1;
+
+	return Max(strategy->ring_size / 2, 1);
+}
+
 /*
  * StrategyRejectBuffer -- consider rejecting a dirty buffer
  *
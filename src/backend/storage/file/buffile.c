@@ -31,15 +31,25 @@
  * BufFile also supports temporary files that exceed the OS file size limit
  * (by opening multiple fd.c temporary files).  This is an essential feature
  * for sorts and hashjoins on large amounts of data.
+ *
+ * BufFile supports temporary files that can be shared with other backends,
+ * as infrastructure for parallel execution.  Such files need to be created
+ * as a member of a SharedFileSet that all participants are attached to.
+ * A shared BufFile is made of segment files named after the BufFile, so
+ * that other backends can find and open them, and it is not deleted when
+ * it is closed; the SharedFileSet deletes it when the last participant
+ * detaches.
  *-------------------------------------------------------------------------
  */
 
 #include "postgres.h"
 
 #include "executor/instrument.h"
+#include "miscadmin.h"
 #include "storage/fd.h"
 #include "storage/buffile.h"
 #include "storage/buf_internals.h"
+#include "storage/sharedfileset.h"
 #include "utils/resowner.h"
 
 /*
@@ -71,6 +81,13 @@ struct BufFile
 	bool		isInterXact;	/* keep open over transactions? */
 	bool		dirty;			/* does buffer need to be written? */
 
+	/*
+	 * For a shared BufFile, the SharedFileSet it belongs to and the name from
+	 * which the names of its segment files are derived; else NULL.
+	 */
+	SharedFileSet *fileset;
+	const char *name;
+
 	/*
 	 * resowner is the ResourceOwner to use for underlying temp files.  (We
 	 * don't need to remember the memory context we're using explicitly,
@@ -91,6 +108,8 @@ struct BufFile
 
 static BufFile *makeBufFile(File firstfile);
 static void extendBufFile(BufFile *file);
+static void SharedSegmentName(char *name, const char *buffile_name, int segment);
+static File MakeNewSharedSegment(BufFile *file, int segment);
 static void BufFileLoadBuffer(BufFile *file);
 static void BufFileDumpBuffer(BufFile *file);
 static int	BufFileFlush(BufFile *file);
@@ -113,6 +132,8 @@ makeBufFile(File firstfile)
 	file->isTemp = false;
 	file->isInterXact = false;
 	file->dirty = false;
+	file->fileset = NULL;
+	file->name = NULL;
 	file->resowner = CurrentResourceOwner;
 	file->curFile = 0;
 	file->curOffset = 0L;
@@ -136,7 +157,10 @@ extendBufFile(BufFile *file)
 	CurrentResourceOwner = file->resowner;
 
 	Assert(file->isTemp);
-	pfile = OpenTemporaryFile(file->isInterXact);
+	if (file->fileset == NULL)
+		pfile = OpenTemporaryFile(file->isInterXact);
+	else
+		pfile = MakeNewSharedSegment(file, file->numFiles);
 	Assert(pfile >= 0);
 
 	CurrentResourceOwner = oldowner;
@@ -178,6 +202,280 @@ BufFileCreateTemp(bool interXact)
 	return file;
 }
 
+/*
+ * Build the name for a given segment of a given BufFile.
+ */
+static void
+SharedSegmentName(char *name, const char *buffile_name, int segment)
+{
+	snprintf(name, MAXPGPATH, "%s.%d", buffile_name, segment);
+}
+
+/*
+ * Create a new segment file backing a shared BufFile.
+ */
+static File
+MakeNewSharedSegment(BufFile *file, int segment)
+{
+	char		name[MAXPGPATH];
+	File		pfile;
+
+	/*
+	 * It is possible that there are files left over from before a crash
+	 * restart with the same name.  In order for BufFileOpenShared() not to
+	 * get confused about how many segments there are, we'll unlink the next
+	 * segment number if it already exists.
+	 */
+	SharedSegmentName(name, file->name, segment + 1);
+	SharedFileSetDelete(file->fileset, name, true);
+
+	/* Create the new segment. */
+	SharedSegmentName(name, file->name, segment);
+	pfile = SharedFileSetCreate(file->fileset, name);
+
+	/* SharedFileSetCreate would've errored out */
+	Assert(pfile > 0);
+
+	return pfile;
+}
+
+/*
+ * Create a BufFile that can be discovered and opened by other backends that
+ * are attached to the same SharedFileSet, using the same name.
+ *
+ * The naming scheme for shared BufFiles is left up to the calling code.  The
+ * name will appear as part of one or more filenames on disk, and might
+ * provide clues to administrators about which subsystem is generating
+ * temporary file data.  Since each SharedFileSet object is backed by one or
+ * more uniquely named temporary directories, names don't conflict with
+ * unrelated SharedFileSet objects.
+ */
+BufFile *
+BufFileCreateShared(SharedFileSet *fileset, const char *name)
+{
+	BufFile    *file;
+
+	file = (BufFile *) palloc(sizeof(BufFile));
+	file->fileset = fileset;
+	file->name = pstrdup(name);
+	file->numFiles = 1;
+	file->files = (File *) palloc(sizeof(File));
+	file->files[0] = MakeNewSharedSegment(file, 0);
+	file->offsets = (off_t *) palloc(sizeof(off_t));
+	file->offsets[0] = 0L;
+	file->isTemp = true;
+	file->isInterXact = false;
+	file->dirty = false;
+	file->resowner = CurrentResourceOwner;
+	file->curFile = 0;
+	file->curOffset = 0L;
+	file->pos = 0;
+	file->nbytes = 0;
+
+	return file;
+}
+
+/*
+ * Open a shared BufFile, created by BufFileCreateShared in the same or
+ * another backend.  The backend that created it must have finished writing
+ * it and called BufFileExportShared.
+ */
+BufFile *
+BufFileOpenShared(SharedFileSet *fileset, const char *name)
+{
+	BufFile    *file;
+	char		segment_name[MAXPGPATH];
+	Size		capacity = 16;
+	File	   *files;
+	int			nfiles = 0;
+
+	files = palloc(sizeof(File) * capacity);
+
+	/*
+	 * We don't know how many segments there are, so we'll probe the
+	 * filesystem to find out.
+	 */
+	for (;;)
+	{
+		/* See if we need to expand our file segment array. */
+		if (nfiles + 1 > capacity)
+		{
+			capacity *= 2;
+			files = repalloc(files, sizeof(File) * capacity);
+		}
+		/* Try to load a segment. */
+		SharedSegmentName(segment_name, name, nfiles);
+		files[nfiles] = SharedFileSetOpen(fileset, segment_name);
+		if (files[nfiles] <= 0)
+			break;
+		++nfiles;
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	/*
+	 * If we didn't find any files at all, then no BufFile exists with this
+	 * name.
+	 */
+	if (nfiles == 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open BufFile \"%s\"", name)));
+
+	file = makeBufFile(files[0]);
+	pfree(file->files);
+	pfree(file->offsets);
+	file->numFiles = nfiles;
+	file->files = files;
+	file->offsets = (off_t *) palloc0(sizeof(off_t) * nfiles);
+	file->isTemp = true;
+	file->fileset = fileset;
+	file->name = pstrdup(name);
+
+	return file;
+}
+
+/*
+ * Delete a BufFile that was created by BufFileCreateShared in the given
+ * SharedFileSet using the given name.
+ *
+ * It is not necessary to delete files explicitly with this function.  It is
+ * provided only as a way to delete files proactively, rather than waiting
+ * for the SharedFileSet to be cleaned up.
+ *
+ * Only one backend should attempt to delete a given name, and should know
+ * that it exists and has been exported or closed.
+ */
+void
+BufFileDeleteShared(SharedFileSet *fileset, const char *name)
+{
+	char		segment_name[MAXPGPATH];
+	int			segment = 0;
+	bool		found = false;
+
+	/*
+	 * We don't know how many segments the file has.  We'll keep deleting
+	 * until we run out.  If we don't manage to find even an initial segment,
+	 * raise an error.
+	 */
+	for (;;)
+	{
+		SharedSegmentName(segment_name, name, segment);
+		if (!SharedFileSetDelete(fileset, segment_name, true))
+			break;
+		found = true;
+		++segment;
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	if (!found)
+		elog(ERROR, "could not delete unknown shared BufFile \"%s\"", name);
+}
+
+/*
+ * Finish writing a shared BufFile, so that other backends can open it.
+ * The file stays open in this backend, and may still be read through it.
+ */
+void
+BufFileExportShared(BufFile *file)
+{
+	/* Must be a file belonging to a SharedFileSet. */
+	Assert(file->fileset != NULL);
+
+	if (BufFileFlush(file) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write shared BufFile \"%s\": %m",
+						file->name)));
+}
+
+/*
+ * Append the contents of the source file to the end of the target file,
+ * and free the source BufFile.
+ *
+ * Note that operation subsumes ownership of underlying resources from
+ * "source".  Caller should never call BufFileClose against source having
+ * called here first.  Resource owners for source and target must match,
+ * too.
+ *
+ * The source is placed at the start of a new segment of the target, so
+ * there may be a gap between the old end of the target and its start; this
+ * is a "hole" that callers must never read or write.  Returns the block
+ * number within the target at which the source's contents begin, so that
+ * callers can translate block numbers of the source into the target.
+ */
+long
+BufFileAppend(BufFile *target, BufFile *source)
+{
+	long		startBlock = target->numFiles * BUFFILE_SEG_SIZE;
+	int			newNumFiles = target->numFiles + source->numFiles;
+	int			i;
+
+	Assert(target->isTemp && source->isTemp);
+	Assert(source->fileset != NULL);
+	Assert(!source->dirty);
+
+	if (target->resowner != source->resowner)
+		elog(ERROR, "could not append BufFile with non-matching resource owner");
+
+	/* Flush the target, since its current position will become invalid */
+	if (BufFileFlush(target) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write temporary file: %m")));
+
+	target->files = (File *)
+		repalloc(target->files, sizeof(File) * newNumFiles);
+	target->offsets = (off_t *)
+		repalloc(target->offsets, sizeof(off_t) * newNumFiles);
+	for (i = target->numFiles; i < newNumFiles; i++)
+	{
+		target->files[i] = source->files[i - target->numFiles];
+		target->offsets[i] = source->offsets[i - target->numFiles];
+	}
+	target->numFiles = newNumFiles;
+
+	/* Leave the target positioned at its (unchanged) start */
+	target->curFile = 0;
+	target->curOffset = 0L;
+	target->pos = 0;
+	target->nbytes = 0;
+
+	pfree(source->files);
+	pfree(source->offsets);
+	pfree((char *) source->name);
+	pfree(source);
+
+	return startBlock;
+}
+
+/*
+ * Return the size of a BufFile, in BLCKSZ blocks.  Any fractional final
+ * block is counted as a whole one.
+ */
+long
+BufFileNumBlocks(BufFile *file)
+{
+	off_t		lastsize;
+
+	if (BufFileFlush(file) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write temporary file: %m")));
+
+	lastsize = FileSeek(file->files[file->numFiles - 1], 0L, SEEK_END);
+	if (lastsize < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not determine size of temporary file \"%s\": %m",
+						FilePathName(file->files[file->numFiles - 1]))));
+	file->offsets[file->numFiles - 1] = lastsize;
+
+	return (long) (file->numFiles - 1) * BUFFILE_SEG_SIZE +
+		(long) ((lastsize + BLCKSZ - 1) / BLCKSZ);
+}
+
 #ifdef NOT_USED
 /*
  * Create a BufFile and attach it to an already-opened virtual File.
@@ -205,12 +503,17 @@ BufFileClose(BufFile *file)
 
 	/* flush any unwritten data */
 	BufFileFlush(file);
-	/* close the underlying file(s) (with delete if it's a temp file) */
+	/*
+	 * close the underlying file(s) (with delete if it's a temp file, but not
+	 * if it's shared)
+	 */
 	for (i = 0; i < file->numFiles; i++)
 		FileClose(file->files[i]);
 	/* release the buffer space */
 	pfree(file->files);
 	pfree(file->offsets);
+	if (file->name)
+		pfree((char *) file->name);
 	pfree(file);
 }
 
@@ -77,6 +77,7 @@
 #include "catalog/catalog.h"
 #include "catalog/pg_tablespace.h"
 #include "pgstat.h"
+#include "port/pg_iovec.h"
 #include "portability/mem.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
@@ -125,6 +126,23 @@
  */
 int			max_files_per_process = 1000;
 
+/*
+ * Which files to open with O_DIRECT, as a combination of the DIRECT_IO_*
+ * flags.  Not honored by fd.c itself; md.c and xlog.c add PG_O_DIRECT to
+ * their open flags and take care of buffer alignment.
+ */
+int			direct_io = 0;
+
+const struct config_enum_entry direct_io_options[] = {
+	{"off", 0, false},
+#if PG_O_DIRECT != 0
+	{"data", DIRECT_IO_DATA, false},
+	{"wal", DIRECT_IO_WAL, false},
+	{"all", DIRECT_IO_DATA | DIRECT_IO_WAL, false},
+#endif
+	{NULL, 0, false}
+};
+
 /*
  * Maximum number of file descriptors to open for either VFD entries or
  * AllocateFile/AllocateDir/OpenTransientFile operations.  This is initialized
@@ -165,6 +183,7 @@ int			max_safe_fds = 32;	/* default if not changed */
 /* these are the assigned bits in fdstate below: */
 #define FD_TEMPORARY		(1 << 0)	/* T = delete when closed */
 #define FD_XACT_TEMPORARY	(1 << 1)	/* T = delete at eoXact */
+#define FD_TEMP_FILE_LIMIT	(1 << 2)	/* T = counts toward temp_file_limit */
 
 typedef struct vfd
 {
@@ -175,7 +194,8 @@ typedef struct vfd
 	File		lruMoreRecently;	/* doubly linked recency-of-use list */
 	File		lruLessRecently;
 	off_t		seekPos;		/* current logical file position */
-	off_t		fileSize;		/* current size of file (0 if not temporary) */
+	off_t		fileSize;		/* current size of file (0 if not counted
+								 * toward temp_file_limit) */
 	char	   *fileName;		/* name of file, or NULL for unused VFD */
 	/* NB: fileName is malloc'd, and must be free'd when closing the VFD */
 	int			fileFlags;		/* open(2) flags for (re)opening the file */
@@ -252,6 +272,15 @@ static int	numTempTableSpaces = -1;
 static int	nextTempTableSpace = 0;
 
 
+#ifndef WIN32
+#define pg_readv(fd, iov, iovcnt)	readv(fd, iov, iovcnt)
+#define pg_writev(fd, iov, iovcnt)	writev(fd, iov, iovcnt)
+#else
+static int	pg_readv(int fd, const struct iovec *iov, int iovcnt);
+static int	pg_writev(int fd, const struct iovec *iov, int iovcnt);
+#endif
+
+
 /*--------------------
  *
  * Private Routines
@@ -295,13 +324,14 @@ static void FreeVfd(File file);
 
 static int	FileAccess(File file);
 static File OpenTemporaryFileInTablespace(Oid tblspcOid, bool rejectError);
+static void RegisterTemporaryFile(File file);
 static bool reserveAllocatedDesc(void);
 static int	FreeDesc(AllocateDesc *desc);
 static struct dirent *ReadDirExtended(DIR *dir, const char *dirname, int elevel);
 
 static void AtProcExit_Files(int code, Datum arg);
 static void CleanupTempFiles(bool isProcExit);
-static void RemovePgTempFilesInDir(const char *tmpdirname);
+static void RemovePgTempFilesInDir(const char *tmpdirname, bool unlink_all);
 static void RemovePgTempRelationFiles(const char *tsdirname);
 static void RemovePgTempRelationFilesInDbspace(const char *dbspacedirname);
 static bool looks_like_temp_rel_name(const char *name);
@@ -1325,54 +1355,69 @@ OpenTemporaryFile(bool interXact)
 											 DEFAULTTABLESPACE_OID,
 											 true);
 
-	/* Mark it for deletion at close */
-	VfdCache[file].fdstate |= FD_TEMPORARY;
+	/* Mark it for deletion at close and temporary file size limit */
+	VfdCache[file].fdstate |= FD_TEMPORARY | FD_TEMP_FILE_LIMIT;
 
 	/* Register it with the current resource owner */
 	if (!interXact)
-	{
-		VfdCache[file].fdstate |= FD_XACT_TEMPORARY;
-
-		ResourceOwnerEnlargeFiles(CurrentResourceOwner);
-		ResourceOwnerRememberFile(CurrentResourceOwner, file);
-		VfdCache[file].resowner = CurrentResourceOwner;
-
-		/* ensure cleanup happens at eoxact */
-		have_xact_temporary_files = true;
-	}
+		RegisterTemporaryFile(file);
 
 	return file;
 }
 
 /*
- * Open a temporary file in a specific tablespace.
- * Subroutine for OpenTemporaryFile, which see for details.
+ * Register a temporary file with the current resource owner, so that it is
+ * closed at the end of the transaction.
  */
-static File
-OpenTemporaryFileInTablespace(Oid tblspcOid, bool rejectError)
+static void
+RegisterTemporaryFile(File file)
 {
-	char		tempdirpath[MAXPGPATH];
-	char		tempfilepath[MAXPGPATH];
-	File		file;
+	VfdCache[file].fdstate |= FD_XACT_TEMPORARY;
 
+	ResourceOwnerEnlargeFiles(CurrentResourceOwner);
+	ResourceOwnerRememberFile(CurrentResourceOwner, file);
+	VfdCache[file].resowner = CurrentResourceOwner;
+
+	/* ensure cleanup happens at eoxact */
+	have_xact_temporary_files = true;
+}
+
+/*
+ * Return the path of the temp directory in a given tablespace.
+ */
+void
+TempTablespacePath(char *path, Oid tablespace)
+{
 	/*
 	 * Identify the tempfile directory for this tablespace.
 	 *
 	 * If someone tries to specify pg_global, use pg_default instead.
 	 */
-	if (tblspcOid == DEFAULTTABLESPACE_OID ||
-		tblspcOid == GLOBALTABLESPACE_OID)
-	{
-		/* The default tablespace is {datadir}/base */
-		snprintf(tempdirpath, sizeof(tempdirpath), "base/%s",
-				 PG_TEMP_FILES_DIR);
-	}
+	if (tablespace == InvalidOid ||
+		tablespace == DEFAULTTABLESPACE_OID ||
+		tablespace == GLOBALTABLESPACE_OID)
+		snprintf(path, MAXPGPATH, "base/%s", PG_TEMP_FILES_DIR);
 	else
 	{
 		/* All other tablespaces are accessed via symlinks */
-		snprintf(tempdirpath, sizeof(tempdirpath), "pg_tblspc/%u/%s/%s",
-				 tblspcOid, TABLESPACE_VERSION_DIRECTORY, PG_TEMP_FILES_DIR);
+		snprintf(path, MAXPGPATH, "pg_tblspc/%u/%s/%s",
+				 tablespace, TABLESPACE_VERSION_DIRECTORY,
+				 PG_TEMP_FILES_DIR);
 	}
+}
+
+/*
+ * Open a temporary file in a specific tablespace.
+ * Subroutine for OpenTemporaryFile, which see for details.
+ */
+static File
+OpenTemporaryFileInTablespace(Oid tblspcOid, bool rejectError)
+{
+	char		tempdirpath[MAXPGPATH];
+	char		tempfilepath[MAXPGPATH];
+	File		file;
+
+	TempTablespacePath(tempdirpath, tblspcOid);
 
 	/*
 	 * Generate a tempfile name that should be unique within the current
@@ -1411,6 +1456,210 @@ OpenTemporaryFileInTablespace(Oid tblspcOid, bool rejectError)
 	return file;
 }
 
+/*
+ * Create a directory for temporary files that several processes will share,
+ * as a subdirectory of the temp directory 'basedir'.  Other processes can
+ * then create, open and delete files in it by name.
+ *
+ * The caller is responsible for removing the directory again, with
+ * PathNameDeleteTemporaryDir.  Directories named with PG_TEMP_FILE_PREFIX
+ * are also removed, with their contents, by RemovePgTempFiles after a crash.
+ */
+void
+PathNameCreateTemporaryDir(const char *basedir, const char *directory)
+{
+	if (mkdir(directory, S_IRWXU) < 0)
+	{
+		if (errno == EEXIST)
+			return;
+
+		/*
+		 * Failed.  Try to create basedir first in case it's missing. Tolerate
+		 * EEXIST to close a race against another process following the same
+		 * algorithm.
+		 */
+		if (mkdir(basedir, S_IRWXU) < 0 && errno != EEXIST)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("cannot create temporary directory \"%s\": %m",
+							basedir)));
+
+		/* Try again. */
+		if (mkdir(directory, S_IRWXU) < 0 && errno != EEXIST)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("cannot create temporary subdirectory \"%s\": %m",
+							directory)));
+	}
+}
+
+/*
+ * Delete a directory made by PathNameCreateTemporaryDir, and any files in
+ * it.  Errors are only logged.
+ */
+void
+PathNameDeleteTemporaryDir(const char *dirname)
+{
+	DIR		   *dir;
+	struct dirent *de;
+	char		path[MAXPGPATH];
+
+	dir = AllocateDir(dirname);
+	if (dir == NULL)
+	{
+		/* it's fine if it doesn't exist */
+		if (errno != ENOENT)
+			elog(LOG, "could not open temporary directory \"%s\": %m",
+				 dirname);
+		return;
+	}
+
+	while ((de = ReadDir(dir, dirname)) != NULL)
+	{
+		if (strcmp(de->d_name, ".") == 0 ||
+			strcmp(de->d_name, "..") == 0)
+			continue;
+
+		snprintf(path, sizeof(path), "%s/%s", dirname, de->d_name);
+		PathNameDeleteTemporaryFile(path, false);
+	}
+
+	FreeDir(dir);
+
+	if (rmdir(dirname) < 0 && errno != ENOENT)
+		elog(LOG, "could not remove temporary directory \"%s\": %m",
+			 dirname);
+}
+
+/*
+ * Create a new file in a directory made by PathNameCreateTemporaryDir.
+ *
+ * Unlike a file made by OpenTemporaryFile, the file isn't deleted when it is
+ * closed, so that another process can open it afterwards; deleting it is up
+ * to the caller.  It does count toward temp_file_limit while it's open in
+ * this process, and it's closed automatically at the end of the transaction.
+ *
+ * If the file can't be created, we throw an error if error_on_failure is
+ * true, else return -1.
+ */
+File
+PathNameCreateTemporaryFile(const char *path, bool error_on_failure)
+{
+	File		file;
+
+	/*
+	 * Open the file.  Note: we don't use O_EXCL, in case there is an orphaned
+	 * temp file that can be reused.
+	 */
+	file = PathNameOpenFile((FileName) path,
+							O_RDWR | O_CREAT | O_TRUNC | PG_BINARY,
+							0600);
+	if (file <= 0)
+	{
+		if (error_on_failure)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not create temporary file \"%s\": %m",
+							path)));
+		else
+			return file;
+	}
+
+	/* Mark it for temp_file_limit accounting */
+	VfdCache[file].fdstate |= FD_TEMP_FILE_LIMIT;
+
+	/* Register it for automatic close */
+	RegisterTemporaryFile(file);
+
+	return file;
+}
+
+/*
+ * Open a file that was created with PathNameCreateTemporaryFile, possibly
+ * in another process.  Returns -1 if the file doesn't exist; throws an error
+ * on any other failure.
+ *
+ * The file is opened for writing as well as reading, since a process that
+ * takes over another's temporary file may want to recycle its space.  It is
+ * closed automatically at the end of the transaction.
+ */
+File
+PathNameOpenTemporaryFile(const char *path)
+{
+	File		file;
+
+	file = PathNameOpenFile((FileName) path, O_RDWR | PG_BINARY, 0600);
+
+	/* If no such file, then we don't raise an error. */
+	if (file <= 0 && errno != ENOENT)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open temporary file \"%s\": %m",
+						path)));
+
+	if (file > 0)
+	{
+		/* Register it for automatic close. */
+		RegisterTemporaryFile(file);
+	}
+
+	return file;
+}
+
+/*
+ * Delete a file made by PathNameCreateTemporaryFile, reporting its size to
+ * the statistics collector and the log as FileClose does for ordinary
+ * temporary files.  Returns true if the file existed.
+ */
+bool
+PathNameDeleteTemporaryFile(const char *path, bool error_on_failure)
+{
+	struct stat filestats;
+	int			stat_errno;
+
+	/* Get the final size for pgstat reporting. */
+	if (stat(path, &filestats) != 0)
+		stat_errno = errno;
+	else
+		stat_errno = 0;
+
+	/*
+	 * Unlike FileClose's automatic file deletion code, we tolerate
+	 * non-existence to support BufFileDeleteShared which doesn't know how
+	 * many segments it has to delete until it runs out.
+	 */
+	if (stat_errno == ENOENT)
+		return false;
+
+	if (unlink(path) < 0)
+	{
+		if (errno != ENOENT)
+			ereport(error_on_failure ? ERROR : LOG,
+					(errcode_for_file_access(),
+					 errmsg("cannot unlink temporary file \"%s\": %m",
+							path)));
+		return false;
+	}
+
+	if (stat_errno == 0)
+	{
+		pgstat_report_tempfile(filestats.st_size);
+
+		if (log_temp_files >= 0 &&
+			(filestats.st_size / 1024) >= log_temp_files)
+			ereport(LOG,
+					(errmsg("temporary file: path \"%s\", size %lu",
+							path, (unsigned long) filestats.st_size)));
+	}
+	else
+	{
+		errno = stat_errno;
+		elog(LOG, "could not stat file \"%s\": %m", path);
+	}
+
+	return true;
+}
+
 /*
  * close a file when done with it
  */
@@ -1439,6 +1688,14 @@ FileClose(File file)
 		vfdP->fd = VFD_CLOSED;
 	}
 
+	if (vfdP->fdstate & FD_TEMP_FILE_LIMIT)
+	{
+		/* Subtract its size from current usage (do first in case of error) */
+		temporary_files_size -= vfdP->fileSize;
+		vfdP->fileSize = 0;
+		vfdP->fdstate &= ~FD_TEMP_FILE_LIMIT;
+	}
+
 	/*
 	 * Delete the file if it was temporary, and make a log entry if wanted
 	 */
@@ -1456,10 +1713,6 @@ FileClose(File file)
 		 */
 		vfdP->fdstate &= ~FD_TEMPORARY;
 
-		/* Subtract its size from current usage (do first in case of error) */
-		temporary_files_size -= vfdP->fileSize;
-		vfdP->fileSize = 0;
-
 		/* first try the stat() */
 		if (stat(vfdP->fileName, &filestats))
 			stat_errno = errno;
@@ -1641,7 +1894,7 @@ FileWrite(File file, char *buffer, int amount)
 	 * message if we do that.  All current callers would just throw error
 	 * immediately anyway, so this is safe at present.
 	 */
-	if (temp_file_limit >= 0 && (VfdCache[file].fdstate & FD_TEMPORARY))
+	if (temp_file_limit >= 0 && (VfdCache[file].fdstate & FD_TEMP_FILE_LIMIT))
 	{
 		off_t		newPos = VfdCache[file].seekPos + amount;
 
@@ -1671,7 +1924,7 @@ retry:
 		VfdCache[file].seekPos += returnCode;
 
 		/* maintain fileSize and temporary_files_size if it's a temp file */
-		if (VfdCache[file].fdstate & FD_TEMPORARY)
+		if (VfdCache[file].fdstate & FD_TEMP_FILE_LIMIT)
 		{
 			off_t		newPos = VfdCache[file].seekPos;
 
@@ -1712,6 +1965,174 @@ retry:
 	return returnCode;
 }
 
+#ifdef WIN32
+/*
+ * Emulate readv/writev with a read or write per buffer.  A short transfer
+ * ends the loop, just as it ends a real readv/writev.
+ */
+static int
+pg_readv(int fd, const struct iovec *iov, int iovcnt)
+{
+	int			sum = 0;
+	int			i;
+
+	for (i = 0; i < iovcnt; i++)
+	{
+		int			rc = read(fd, iov[i].iov_base, iov[i].iov_len);
+
+		if (rc < 0)
+			return sum > 0 ? sum : rc;
+		sum += rc;
+		if (rc < iov[i].iov_len)
+			break;
+	}
+	return sum;
+}
+
+static int
+pg_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+	int			sum = 0;
+	int			i;
+
+	for (i = 0; i < iovcnt; i++)
+	{
+		int			rc = write(fd, iov[i].iov_base, iov[i].iov_len);
+
+		if (rc < 0)
+			return sum > 0 ? sum : rc;
+		sum += rc;
+		if (rc < iov[i].iov_len)
+			break;
+	}
+	return sum;
+}
+#endif
+
+/*
+ * FileReadv/FileWritev --- like FileRead/FileWrite, but transfer into or out
+ * of several buffers with a single system call.  This lets the caller read
+ * or write a run of consecutive blocks living in non-adjacent memory, such
+ * as shared buffers.
+ *
+ * FileWritev doesn't enforce temp_file_limit, so it mustn't be used on
+ * temporary files.
+ */
+int
+FileReadv(File file, const struct iovec *iov, int iovcnt)
+{
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+	Assert(iovcnt > 0 && iovcnt <= PG_IOV_MAX);
+
+	DO_DB(elog(LOG, "FileReadv: %d (%s) " INT64_FORMAT " %d",
+			   file, VfdCache[file].fileName,
+			   (int64) VfdCache[file].seekPos,
+			   iovcnt));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+retry:
+	returnCode = pg_readv(VfdCache[file].fd, iov, iovcnt);
+
+	if (returnCode >= 0)
+		VfdCache[file].seekPos += returnCode;
+	else
+	{
+		/*
+		 * See comments in FileRead()
+		 */
+#ifdef WIN32
+		DWORD		error = GetLastError();
+
+		switch (error)
+		{
+			case ERROR_NO_SYSTEM_RESOURCES:
+				pg_usleep(1000L);
+				errno = EINTR;
+				break;
+			default:
+				_dosmaperr(error);
+				break;
+		}
+#endif
+		/* OK to retry if interrupted */
+		if (errno == EINTR)
+			goto retry;
+
+		/* Trouble, so assume we don't know the file position anymore */
+		VfdCache[file].seekPos = FileUnknownPos;
+	}
+
+	return returnCode;
+}
+
+int
+FileWritev(File file, const struct iovec *iov, int iovcnt)
+{
+	int			returnCode;
+	int			amount = 0;
+	int			i;
+
+	Assert(FileIsValid(file));
+	Assert(iovcnt > 0 && iovcnt <= PG_IOV_MAX);
+	Assert(!(VfdCache[file].fdstate & FD_TEMP_FILE_LIMIT));
+
+	for (i = 0; i < iovcnt; i++)
+		amount += iov[i].iov_len;
+
+	DO_DB(elog(LOG, "FileWritev: %d (%s) " INT64_FORMAT " %d %d",
+			   file, VfdCache[file].fileName,
+			   (int64) VfdCache[file].seekPos,
+			   iovcnt, amount));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+retry:
+	errno = 0;
+	returnCode = pg_writev(VfdCache[file].fd, iov, iovcnt);
+
+	/* if write didn't set errno, assume problem is no disk space */
+	if (returnCode != amount && errno == 0)
+		errno = ENOSPC;
+
+	if (returnCode >= 0)
+		VfdCache[file].seekPos += returnCode;
+	else
+	{
+		/*
+		 * See comments in FileRead()
+		 */
+#ifdef WIN32
+		DWORD		error = GetLastError();
+
+		switch (error)
+		{
+			case ERROR_NO_SYSTEM_RESOURCES:
+				pg_usleep(1000L);
+				errno = EINTR;
+				break;
+			default:
+				_dosmaperr(error);
+				break;
+		}
+#endif
+		/* OK to retry if interrupted */
+		if (errno == EINTR)
+			goto retry;
+
+		/* Trouble, so assume we don't know the file position anymore */
+		VfdCache[file].seekPos = FileUnknownPos;
+	}
+
+	return returnCode;
+}
+
 int
 FileSync(File file)
 {
@@ -1828,7 +2249,7 @@ FileTruncate(File file, off_t offset)
 	if (returnCode == 0 && VfdCache[file].fileSize > offset)
 	{
 		/* adjust our state for truncation of a temp file */
-		Assert(VfdCache[file].fdstate & FD_TEMPORARY);
+		Assert(VfdCache[file].fdstate & FD_TEMP_FILE_LIMIT);
 		temporary_files_size -= VfdCache[file].fileSize - offset;
 		VfdCache[file].fileSize = offset;
 	}
@@ -2427,6 +2848,25 @@ TempTablespacesAreSet(void)
 	return (numTempTableSpaces >= 0);
 }
 
+/*
+ * GetTempTablespaces
+ *
+ * Populate an array with the OIDs of the tablespaces that should be used for
+ * temporary files.  Return the number that were copied into the output
+ * array.
+ */
+int
+GetTempTablespaces(Oid *tableSpaces, int numSpaces)
+{
+	int			i;
+
+	Assert(TempTablespacesAreSet());
+	for (i = 0; i < numTempTableSpaces && i < numSpaces; ++i)
+		tableSpaces[i] = tempTableSpaces[i];
+
+	return i;
+}
+
 /*
  * GetNextTempTableSpace
  *
@@ -2530,7 +2970,8 @@ CleanupTempFiles(bool isProcExit)
 		{
 			unsigned short fdstate = VfdCache[i].fdstate;
 
-			if ((fdstate & FD_TEMPORARY) && VfdCache[i].fileName != NULL)
+			if ((fdstate & (FD_TEMPORARY | FD_TEMP_FILE_LIMIT)) &&
+				VfdCache[i].fileName != NULL)
 			{
 				/*
 				 * If we're in the process of exiting a backend process, close
@@ -2585,7 +3026,7 @@ RemovePgTempFiles(void)
 	 * First process temp files in pg_default ($PGDATA/base)
 	 */
 	snprintf(temp_path, sizeof(temp_path), "base/%s", PG_TEMP_FILES_DIR);
-	RemovePgTempFilesInDir(temp_path);
+	RemovePgTempFilesInDir(temp_path, false);
 	RemovePgTempRelationFiles("base");
 
 	/*
@@ -2601,7 +3042,7 @@ RemovePgTempFiles(void)
 
 		snprintf(temp_path, sizeof(temp_path), "pg_tblspc/%s/%s/%s",
 			spc_de->d_name, TABLESPACE_VERSION_DIRECTORY, PG_TEMP_FILES_DIR);
-		RemovePgTempFilesInDir(temp_path);
+		RemovePgTempFilesInDir(temp_path, false);
 
 		snprintf(temp_path, sizeof(temp_path), "pg_tblspc/%s/%s",
 				 spc_de->d_name, TABLESPACE_VERSION_DIRECTORY);
@@ -2615,13 +3056,17 @@ RemovePgTempFiles(void)
 	 * DataDir as well.
 	 */
 #ifdef EXEC_BACKEND
-	RemovePgTempFilesInDir(PG_TEMP_FILES_DIR);
+	RemovePgTempFilesInDir(PG_TEMP_FILES_DIR, false);
 #endif
 }
 
-/* Process one pgsql_tmp directory for RemovePgTempFiles */
+/*
+ * Process one pgsql_tmp directory for RemovePgTempFiles.  If unlink_all is
+ * true, remove everything in it, since it's a directory of shared temporary
+ * files whose names need not carry PG_TEMP_FILE_PREFIX.
+ */
 static void
-RemovePgTempFilesInDir(const char *tmpdirname)
+RemovePgTempFilesInDir(const char *tmpdirname, bool unlink_all)
 {
 	DIR		   *temp_dir;
 	struct dirent *temp_de;
@@ -2647,10 +3092,22 @@ RemovePgTempFilesInDir(const char *tmpdirname)
 		snprintf(rm_path, sizeof(rm_path), "%s/%s",
 				 tmpdirname, temp_de->d_name);
 
-		if (strncmp(temp_de->d_name,
+		if (unlink_all ||
+			strncmp(temp_de->d_name,
 					PG_TEMP_FILE_PREFIX,
 					strlen(PG_TEMP_FILE_PREFIX)) == 0)
-			unlink(rm_path);	/* note we ignore any error */
+		{
+			struct stat statbuf;
+
+			/* a directory of shared temporary files; empty it first */
+			if (lstat(rm_path, &statbuf) == 0 && S_ISDIR(statbuf.st_mode))
+			{
+				RemovePgTempFilesInDir(rm_path, true);
+				rmdir(rm_path); /* note we ignore any error */
+			}
+			else
+				unlink(rm_path);	/* note we ignore any error */
+		}
 		else
 			elog(LOG,
 				 "unexpected file found in temporary-files directory: \"%s\"",
@@ -0,0 +1,279 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedfileset.c
+ *	  Shared temporary file management.
+ *
+ * SharedFileSets provide a temporary namespace (think directory) so that
+ * files can be discovered by name, and a shared ownership semantics so that
+ * shared files survive until the last user detaches.
+ *
+ * A SharedFileSet lives in a DSM segment.  The process that creates it
+ * initializes it with SharedFileSetInit, and every other process that wants
+ * to use it calls SharedFileSetAttach.  Any of them can then create files
+ * in the set with SharedFileSetCreate, and open files created by others
+ * with SharedFileSetOpen, once their creator has finished writing them.
+ * The files aren't deleted when they're closed; instead, all the files in
+ * the set are deleted when the last process detaches from the segment.
+ *
+ * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/file/sharedfileset.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "catalog/pg_tablespace.h"
+#include "commands/tablespace.h"
+#include "miscadmin.h"
+#include "storage/dsm.h"
+#include "storage/sharedfileset.h"
+
+static void SharedFileSetOnDetach(dsm_segment *segment, Datum datum);
+static bool SharedFileSetPath(char *path, SharedFileSet *fileset, Oid tablespace);
+static void SharedFilePath(char *path, SharedFileSet *fileset, const char *name);
+static Oid	ChooseTablespace(const SharedFileSet *fileset, const char *name);
+
+/*
+ * Initialize a space for temporary files that can be opened by other
+ * backends.  Other backends must attach to it before accessing it.
+ * Associate this SharedFileSet with 'seg'.  Any contained files will be
+ * deleted when the last backend detaches.
+ *
+ * Files will be distributed over the tablespaces configured in
+ * temp_tablespaces.
+ *
+ * Under the covers the set is one or more directories which will eventually
+ * be deleted when there are no backends attached.
+ */
+void
+SharedFileSetInit(SharedFileSet *fileset, dsm_segment *seg)
+{
+	static uint32 counter = 0;
+	char		path[MAXPGPATH];
+	int			i;
+
+	SpinLockInit(&fileset->mutex);
+	fileset->refcnt = 1;
+	fileset->creator_pid = MyProcPid;
+	fileset->number = counter;
+	counter = (counter + 1) % INT_MAX;
+
+	/*
+	 * Capture the tablespace OIDs so that all backends agree on them.  As in
+	 * OpenTemporaryFile, InvalidOid stands for the database's default
+	 * tablespace.
+	 */
+	PrepareTempTablespaces();
+	fileset->ntablespaces =
+		GetTempTablespaces(&fileset->tablespaces[0],
+						   lengthof(fileset->tablespaces));
+	if (fileset->ntablespaces == 0)
+	{
+		fileset->tablespaces[0] = InvalidOid;
+		fileset->ntablespaces = 1;
+	}
+	for (i = 0; i < fileset->ntablespaces; i++)
+	{
+		if (!OidIsValid(fileset->tablespaces[i]))
+			fileset->tablespaces[i] = MyDatabaseTableSpace ?
+				MyDatabaseTableSpace : DEFAULTTABLESPACE_OID;
+
+		/*
+		 * Make sure the directory path fits now, while we can still raise an
+		 * error; SharedFileSetDeleteAll runs in cleanup paths and can't.
+		 */
+		if (!SharedFileSetPath(path, fileset, fileset->tablespaces[i]))
+			elog(ERROR, "shared file set path for tablespace %u is too long",
+				 fileset->tablespaces[i]);
+	}
+
+	/* Register our cleanup callback. */
+	on_dsm_detach(seg, SharedFileSetOnDetach, PointerGetDatum(fileset));
+}
+
+/*
+ * Attach to a set of directories that was created with SharedFileSetInit.
+ */
+void
+SharedFileSetAttach(SharedFileSet *fileset, dsm_segment *seg)
+{
+	bool		success;
+
+	SpinLockAcquire(&fileset->mutex);
+	if (fileset->refcnt == 0)
+		success = false;
+	else
+	{
+		++fileset->refcnt;
+		success = true;
+	}
+	SpinLockRelease(&fileset->mutex);
+
+	if (!success)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not attach to a SharedFileSet that is already destroyed")));
+
+	/* Register our cleanup callback. */
+	on_dsm_detach(seg, SharedFileSetOnDetach, PointerGetDatum(fileset));
+}
+
+/*
+ * Create a new file in the given set.
+ */
+File
+SharedFileSetCreate(SharedFileSet *fileset, const char *name)
+{
+	char		path[MAXPGPATH];
+	File		file;
+
+	SharedFilePath(path, fileset, name);
+	file = PathNameCreateTemporaryFile(path, false);
+
+	/* If we failed, see if we need to create the directory on demand. */
+	if (file <= 0)
+	{
+		char		tempdirpath[MAXPGPATH];
+		char		filesetpath[MAXPGPATH];
+		Oid			tablespace = ChooseTablespace(fileset, name);
+
+		TempTablespacePath(tempdirpath, tablespace);
+		if (!SharedFileSetPath(filesetpath, fileset, tablespace))
+			elog(ERROR, "shared file set path for tablespace %u is too long",
+				 tablespace);
+		PathNameCreateTemporaryDir(tempdirpath, filesetpath);
+		file = PathNameCreateTemporaryFile(path, true);
+	}
+
+	return file;
+}
+
+/*
+ * Open a file that was created with SharedFileSetCreate(), possibly in
+ * another backend.  Returns -1 if there is no such file.
+ */
+File
+SharedFileSetOpen(SharedFileSet *fileset, const char *name)
+{
+	char		path[MAXPGPATH];
+
+	SharedFilePath(path, fileset, name);
+
+	return PathNameOpenTemporaryFile(path);
+}
+
+/*
+ * Delete a file that was created with SharedFileSetCreate().
+ * Return true if the file existed, false if didn't.
+ */
+bool
+SharedFileSetDelete(SharedFileSet *fileset, const char *name,
+					bool error_on_failure)
+{
+	char		path[MAXPGPATH];
+
+	SharedFilePath(path, fileset, name);
+
+	return PathNameDeleteTemporaryFile(path, error_on_failure);
+}
+
+/*
+ * Delete all files in the set.
+ */
+void
+SharedFileSetDeleteAll(SharedFileSet *fileset)
+{
+	char		dirpath[MAXPGPATH];
+	int			i;
+
+	/*
+	 * Delete the directory we created in each tablespace.  Doesn't fail
+	 * because we use this in error cleanup paths, but can generate LOG
+	 * message on IO error.
+	 */
+	for (i = 0; i < fileset->ntablespaces; ++i)
+	{
+		if (SharedFileSetPath(dirpath, fileset, fileset->tablespaces[i]))
+			PathNameDeleteTemporaryDir(dirpath);
+	}
+}
+
+/*
+ * Callback function that will be invoked when this backend detaches from a
+ * DSM segment holding a SharedFileSet that it has created or attached to.  If
+ * we are the last to detach, then try to remove the directories and
+ * everything in them.  We can't raise an error on failures, because this
+ * runs in error cleanup paths.
+ */
+static void
+SharedFileSetOnDetach(dsm_segment *segment, Datum datum)
+{
+	bool		unlink_all = false;
+	SharedFileSet *fileset = (SharedFileSet *) DatumGetPointer(datum);
+
+	SpinLockAcquire(&fileset->mutex);
+	Assert(fileset->refcnt > 0);
+	if (--fileset->refcnt == 0)
+		unlink_all = true;
+	SpinLockRelease(&fileset->mutex);
+
+	/*
+	 * If we are the last to detach, we delete the directory in all
+	 * tablespaces.  Note that we are still actually attached for the rest of
+	 * this function so we can safely access its data.
+	 */
+	if (unlink_all)
+		SharedFileSetDeleteAll(fileset);
+}
+
+/*
+ * Build the path for the directory holding the files backing a SharedFileSet
+ * in a given tablespace.  Returns false if the path didn't fit in MAXPGPATH,
+ * which SharedFileSetInit has already ruled out.  This must not raise an
+ * error itself, because SharedFileSetDeleteAll uses it in cleanup paths.
+ */
+static bool
+SharedFileSetPath(char *path, SharedFileSet *fileset, Oid tablespace)
+{
+	char		tempdirpath[MAXPGPATH];
+
+	TempTablespacePath(tempdirpath, tablespace);
+	return snprintf(path, MAXPGPATH, "%s/%s%lu.%u.sharedfileset",
+					tempdirpath, PG_TEMP_FILE_PREFIX,
+					(unsigned long) fileset->creator_pid,
+					fileset->number) < MAXPGPATH;
+}
+
+/*
+ * Choose the tablespace that holds a given file of the set.  This only
+ * depends on the name, so every backend finds the file in the same place.
+ */
+static Oid
+ChooseTablespace(const SharedFileSet *fileset, const char *name)
+{
+	uint32		hash = DatumGetUInt32(hash_any((const unsigned char *) name,
+											   strlen(name)));
+
+	return fileset->tablespaces[hash % fileset->ntablespaces];
+}
+
+/*
+ * Compute the full path of a file in a SharedFileSet.
+ */
+static void
+SharedFilePath(char *path, SharedFileSet *fileset, const char *name)
+{
+	char		dirpath[MAXPGPATH];
+	Oid			tablespace = ChooseTablespace(fileset, name);
+
+	if (!SharedFileSetPath(dirpath, fileset, tablespace))
+		elog(ERROR, "shared file set path for tablespace %u is too long",
+			 tablespace);
+	if (snprintf(path, MAXPGPATH, "%s/%s", dirpath, name) >= MAXPGPATH)
+		elog(ERROR, "path of shared file \"%s\" is too long", name);
+}
@@ -21,9 +21,11 @@
 #include "access/nbtree.h"
 #include "access/subtrans.h"
 #include "access/twophase.h"
+#include "access/xlogprefetch.h"
 #include "commands/async.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "port/pg_numa.h"
 #include "postmaster/autovacuum.h"
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/bgwriter.h"
@@ -126,6 +128,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, PredicateLockShmemSize());
 		size = add_size(size, ProcGlobalShmemSize());
 		size = add_size(size, XLOGShmemSize());
+		size = add_size(size, XLogPrefetchShmemSize());
 		size = add_size(size, CLOGShmemSize());
 		size = add_size(size, CommitTsShmemSize());
 		size = add_size(size, SUBTRANSShmemSize());
@@ -168,6 +171,19 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		 */
 		seghdr = PGSharedMemoryCreate(size, makePrivate, port, &shim);
 
+		/*
+		 * If asked to, spread the segment over all NUMA nodes before anyone
+		 * touches it; otherwise each page would end up on the node of the
+		 * process that happens to touch it first.  With
+		 * shared_memory_numa = local, the buffer pool is then placed
+		 * node-by-node by StrategyPlaceBuffers.
+		 */
+		if (shared_memory_numa != SHMEM_NUMA_OFF &&
+			pg_numa_interleave(seghdr, seghdr->totalsize,
+							   UsedShmemPageSize) != 0)
+			ereport(LOG,
+					(errmsg("could not interleave shared memory across NUMA nodes: %m")));
+
 		InitShmemAccess(seghdr);
 
 		/*
@@ -218,6 +234,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 	 * Set up xlog, clog, and buffers
 	 */
 	XLOGShmemInit();
+	XLogPrefetchShmemInit();
 	CLOGShmemInit();
 	CommitTsShmemInit();
 	SUBTRANSShmemInit();
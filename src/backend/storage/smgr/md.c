@@ -28,6 +28,8 @@
 #include "miscadmin.h"
 #include "access/xlog.h"
 #include "catalog/catalog.h"
+#include "pgstat.h"
+#include "port/pg_iovec.h"
 #include "portability/instr_time.h"
 #include "postmaster/bgwriter.h"
 #include "storage/fd.h"
@@ -158,6 +160,13 @@ static MemoryContext pendingOpsCxt;		/* context for the above  */
 static CycleCtr mdsync_cycle_ctr = 0;
 static CycleCtr mdckpt_cycle_ctr = 0;
 
+/*
+ * With direct I/O, the buffers we read into and write from must be aligned
+ * to PG_IO_ALIGN_SIZE.  Shared and local buffers are, but some callers pass
+ * a palloc'd page; those are copied through this bounce buffer.
+ */
+static char *md_bounce_buffer = NULL;
+
 
 /*** behavior for mdopen & _mdfd_getseg ***/
 /* ereport if segment not present */
@@ -190,12 +199,16 @@ static void _fdvec_resize(SMgrRelation reln,
 			  int nseg);
 static char *_mdfd_segpath(SMgrRelation reln, ForkNumber forknum,
 			  BlockNumber segno);
+static int	mdiovec(BlockNumber blocknum, char **buffers, BlockNumber nblocks,
+		struct iovec *iov);
 static MdfdVec *_mdfd_openseg(SMgrRelation reln, ForkNumber forkno,
 			  BlockNumber segno, int oflags);
 static MdfdVec *_mdfd_getseg(SMgrRelation reln, ForkNumber forkno,
 			 BlockNumber blkno, bool skipFsync, int behavior);
 static BlockNumber _mdnblocks(SMgrRelation reln, ForkNumber forknum,
 		   MdfdVec *seg);
+static int	mdfileflags(void);
+static char *mdiobuffer(char *buffer);
 
 
 /*
@@ -303,7 +316,7 @@ mdcreate(SMgrRelation reln, ForkNumber forkNum, bool isRedo)
 
 	path = relpath(reln->smgr_rnode, forkNum);
 
-	fd = PathNameOpenFile(path, O_RDWR | O_CREAT | O_EXCL | PG_BINARY, 0600);
+	fd = PathNameOpenFile(path, mdfileflags() | O_CREAT | O_EXCL, 0600);
 
 	if (fd < 0)
 	{
@@ -316,7 +329,7 @@ mdcreate(SMgrRelation reln, ForkNumber forkNum, bool isRedo)
 		 * already, even if isRedo is not set.  (See also mdopen)
 		 */
 		if (isRedo || IsBootstrapProcessingMode())
-			fd = PathNameOpenFile(path, O_RDWR | PG_BINARY, 0600);
+			fd = PathNameOpenFile(path, mdfileflags(), 0600);
 		if (fd < 0)
 		{
 			/* be sure to report the error reported by create, not open */
@@ -497,6 +510,7 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	char	   *iobuf;
 
 	/* This assert is too expensive to have on normally ... */
 #ifdef CHECK_WRITE_VS_EXTEND
@@ -536,7 +550,11 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 				 errmsg("could not seek to block %u in file \"%s\": %m",
 						blocknum, FilePathName(v->mdfd_vfd))));
 
-	if ((nbytes = FileWrite(v->mdfd_vfd, buffer, BLCKSZ)) != BLCKSZ)
+	iobuf = mdiobuffer(buffer);
+	if (iobuf != buffer)
+		memcpy(iobuf, buffer, BLCKSZ);
+
+	if ((nbytes = FileWrite(v->mdfd_vfd, iobuf, BLCKSZ)) != BLCKSZ)
 	{
 		if (nbytes < 0)
 			ereport(ERROR,
@@ -582,7 +600,7 @@ mdopen(SMgrRelation reln, ForkNumber forknum, int behavior)
 
 	path = relpath(reln->smgr_rnode, forknum);
 
-	fd = PathNameOpenFile(path, O_RDWR | PG_BINARY, 0600);
+	fd = PathNameOpenFile(path, mdfileflags(), 0600);
 
 	if (fd < 0)
 	{
@@ -593,7 +611,7 @@ mdopen(SMgrRelation reln, ForkNumber forknum, int behavior)
 		 * substitute for mdcreate() in bootstrap mode only. (See mdcreate)
 		 */
 		if (IsBootstrapProcessingMode())
-			fd = PathNameOpenFile(path, O_RDWR | O_CREAT | O_EXCL | PG_BINARY, 0600);
+			fd = PathNameOpenFile(path, mdfileflags() | O_CREAT | O_EXCL, 0600);
 		if (fd < 0)
 		{
 			if ((behavior & EXTENSION_RETURN_NULL) &&
@@ -661,7 +679,18 @@ mdprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
 	off_t		seekpos;
 	MdfdVec    *v;
 
-	v = _mdfd_getseg(reln, forknum, blocknum, false, EXTENSION_FAIL);
+	/* With direct I/O, this would just fill the kernel cache uselessly */
+	if (direct_io & DIRECT_IO_DATA)
+		return;
+
+	/*
+	 * A prefetch is only a hint, so don't complain if the file or segment
+	 * doesn't exist.  That happens during recovery, when we prefetch blocks
+	 * of relations that are created or dropped by WAL not yet replayed.
+	 */
+	v = _mdfd_getseg(reln, forknum, blocknum, false, EXTENSION_RETURN_NULL);
+	if (v == NULL)
+		return;
 
 	seekpos = (off_t) BLCKSZ *(blocknum % ((BlockNumber) RELSEG_SIZE));
 
@@ -733,6 +762,7 @@ mdread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	char	   *iobuf;
 
 	TRACE_POSTGRESQL_SMGR_MD_READ_START(forknum, blocknum,
 										reln->smgr_rnode.node.spcNode,
@@ -753,7 +783,10 @@ mdread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 				 errmsg("could not seek to block %u in file \"%s\": %m",
 						blocknum, FilePathName(v->mdfd_vfd))));
 
-	nbytes = FileRead(v->mdfd_vfd, buffer, BLCKSZ);
+	iobuf = mdiobuffer(buffer);
+	nbytes = FileRead(v->mdfd_vfd, iobuf, BLCKSZ);
+	if (iobuf != buffer && nbytes > 0)
+		memcpy(buffer, iobuf, nbytes);
 
 	TRACE_POSTGRESQL_SMGR_MD_READ_DONE(forknum, blocknum,
 									   reln->smgr_rnode.node.spcNode,
@@ -804,6 +837,7 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	char	   *iobuf;
 
 	/* This assert is too expensive to have on normally ... */
 #ifdef CHECK_WRITE_VS_EXTEND
@@ -829,7 +863,11 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 				 errmsg("could not seek to block %u in file \"%s\": %m",
 						blocknum, FilePathName(v->mdfd_vfd))));
 
-	nbytes = FileWrite(v->mdfd_vfd, buffer, BLCKSZ);
+	iobuf = mdiobuffer(buffer);
+	if (iobuf != buffer)
+		memcpy(iobuf, buffer, BLCKSZ);
+
+	nbytes = FileWrite(v->mdfd_vfd, iobuf, BLCKSZ);
 
 	TRACE_POSTGRESQL_SMGR_MD_WRITE_DONE(forknum, blocknum,
 										reln->smgr_rnode.node.spcNode,
@@ -860,6 +898,147 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 		register_dirty_segment(reln, forknum, v);
 }
 
+/*
+ *	mdreadv() -- Read the specified run of consecutive blocks from a relation.
+ *
+ *		buffers[i] receives block blocknum + i.  Each run of blocks within
+ *		one segment is read with a single readv() call; anything that can't
+ *		be (a short read, or a buffer that direct I/O couldn't use in place)
+ *		is left to mdread(), so the error behavior is exactly mdread()'s.
+ */
+void
+mdreadv(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		char **buffers, BlockNumber nblocks)
+{
+	struct iovec iov[PG_IOV_MAX];
+
+	while (nblocks > 0)
+	{
+		off_t		seekpos;
+		int			nbytes;
+		int			niov;
+		MdfdVec    *v;
+
+		niov = mdiovec(blocknum, buffers, nblocks, iov);
+		if (niov <= 1)
+		{
+			mdread(reln, forknum, blocknum, buffers[0]);
+			niov = 1;
+		}
+		else
+		{
+			v = _mdfd_getseg(reln, forknum, blocknum, false,
+							 EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY);
+
+			seekpos = (off_t) BLCKSZ *(blocknum % ((BlockNumber) RELSEG_SIZE));
+
+			if (FileSeek(v->mdfd_vfd, seekpos, SEEK_SET) != seekpos)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not seek to block %u in file \"%s\": %m",
+								blocknum, FilePathName(v->mdfd_vfd))));
+
+			nbytes = FileReadv(v->mdfd_vfd, iov, niov);
+			if (nbytes < 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not read blocks %u..%u in file \"%s\": %m",
+								blocknum, blocknum + niov - 1,
+								FilePathName(v->mdfd_vfd))));
+
+			/*
+			 * On a short read, keep the blocks that were read in full and let
+			 * the next round deal with the rest; mdread() will report the
+			 * problem if it persists.
+			 */
+			if (nbytes != niov * BLCKSZ)
+			{
+				niov = nbytes / BLCKSZ;
+				if (niov == 0)
+				{
+					mdread(reln, forknum, blocknum, buffers[0]);
+					niov = 1;
+				}
+			}
+		}
+
+		blocknum += niov;
+		buffers += niov;
+		nblocks -= niov;
+	}
+}
+
+/*
+ *	mdwritev() -- Write a run of consecutive blocks, as mdwrite() would.
+ *
+ *		buffers[i] holds the contents of block blocknum + i.
+ */
+void
+mdwritev(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		 char **buffers, BlockNumber nblocks, bool skipFsync)
+{
+	struct iovec iov[PG_IOV_MAX];
+
+	/* This assert is too expensive to have on normally ... */
+#ifdef CHECK_WRITE_VS_EXTEND
+	Assert(blocknum + nblocks <= mdnblocks(reln, forknum));
+#endif
+
+	while (nblocks > 0)
+	{
+		off_t		seekpos;
+		int			nbytes;
+		int			niov;
+		MdfdVec    *v;
+
+		niov = mdiovec(blocknum, buffers, nblocks, iov);
+		if (niov <= 1)
+		{
+			mdwrite(reln, forknum, blocknum, buffers[0], skipFsync);
+			niov = 1;
+		}
+		else
+		{
+			v = _mdfd_getseg(reln, forknum, blocknum, skipFsync,
+							 EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY);
+
+			seekpos = (off_t) BLCKSZ *(blocknum % ((BlockNumber) RELSEG_SIZE));
+
+			if (FileSeek(v->mdfd_vfd, seekpos, SEEK_SET) != seekpos)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not seek to block %u in file \"%s\": %m",
+								blocknum, FilePathName(v->mdfd_vfd))));
+
+			nbytes = FileWritev(v->mdfd_vfd, iov, niov);
+			if (nbytes != niov * BLCKSZ)
+			{
+				if (nbytes < 0)
+					ereport(ERROR,
+							(errcode_for_file_access(),
+							 errmsg("could not write blocks %u..%u in file \"%s\": %m",
+									blocknum, blocknum + niov - 1,
+									FilePathName(v->mdfd_vfd))));
+				/* short write: complain appropriately */
+				ereport(ERROR,
+						(errcode(ERRCODE_DISK_FULL),
+						 errmsg("could not write blocks %u..%u in file \"%s\": wrote only %d of %d bytes",
+								blocknum, blocknum + niov - 1,
+								FilePathName(v->mdfd_vfd),
+								nbytes, niov * BLCKSZ),
+						 errhint("Check free disk space.")));
+			}
+
+			if (!skipFsync && !SmgrIsTemp(reln))
+				register_dirty_segment(reln, forknum, v);
+		}
+
+		blocknum += niov;
+		buffers += niov;
+		nblocks -= niov;
+	}
+}
+
 /*
  *	mdnblocks() -- Get the number of blocks stored in a relation.
  *
@@ -1057,6 +1236,8 @@ mdsync(void)
 	HASH_SEQ_STATUS hstat;
 	PendingOperationEntry *entry;
 	int			absorb_counter;
+	int			nsegs;
+	int			nsegs_done;
 
 	/* Statistics on sync times */
 	int			processed = 0;
@@ -1119,6 +1300,21 @@ mdsync(void)
 		}
 	}
 
+	/*
+	 * Count the segments to fsync, so that we can tell the checkpointer how
+	 * far along we are.  (A request that gets canceled still counts.)
+	 */
+	nsegs = 0;
+	nsegs_done = 0;
+	hash_seq_init(&hstat, pendingOpsTable);
+	while ((entry = (PendingOperationEntry *) hash_seq_search(&hstat)) != NULL)
+	{
+		ForkNumber	forknum;
+
+		for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+			nsegs += bms_num_members(entry->requests[forknum]);
+	}
+
 	/* Advance counter so that new hashtable entries are distinguishable */
 	mdsync_cycle_ctr++;
 
@@ -1243,6 +1439,7 @@ mdsync(void)
 							longest = elapsed;
 						total_elapsed += elapsed;
 						processed++;
+						pgstat_count_checkpoint_sync(elapsed);
 						if (log_checkpoints)
 							elog(DEBUG1, "checkpoint sync: number=%d file=%s time=%.3f msec",
 								 processed,
@@ -1292,6 +1489,10 @@ mdsync(void)
 					if (entry->canceled[forknum])
 						break;
 				}				/* end retry loop */
+
+				/* Spread the fsyncs out over the rest of the checkpoint */
+				if (++nsegs_done < nsegs)
+					CheckpointSyncDelay((double) nsegs_done / nsegs);
 			}
 			bms_free(requests);
 		}
@@ -1779,7 +1980,7 @@ _mdfd_openseg(SMgrRelation reln, ForkNumber forknum, BlockNumber segno,
 	fullpath = _mdfd_segpath(reln, forknum, segno);
 
 	/* open the file */
-	fd = PathNameOpenFile(fullpath, O_RDWR | PG_BINARY | oflags, 0600);
+	fd = PathNameOpenFile(fullpath, mdfileflags() | oflags, 0600);
 
 	pfree(fullpath);
 
@@ -1950,3 +2151,66 @@ _mdnblocks(SMgrRelation reln, ForkNumber forknum, MdfdVec *seg)
 	/* note that this calculation will ignore any partial block at EOF */
 	return (BlockNumber) (len / BLCKSZ);
 }
+
+/*
+ * Flags for opening relation segment files
+ */
+static int
+mdfileflags(void)
+{
+	int			flags = O_RDWR | PG_BINARY;
+
+	if (direct_io & DIRECT_IO_DATA)
+		flags |= PG_O_DIRECT;
+
+	return flags;
+}
+
+/*
+ * Get a buffer suitable for transferring a block to or from 'buffer' with
+ * the current direct_io setting: either 'buffer' itself, or, if that isn't
+ * suitably aligned, the bounce buffer.  The caller must copy the data.
+ */
+static char *
+mdiobuffer(char *buffer)
+{
+	if (!(direct_io & DIRECT_IO_DATA) ||
+		(uintptr_t) buffer % PG_IO_ALIGN_SIZE == 0)
+		return buffer;
+
+	if (md_bounce_buffer == NULL)
+	{
+		char	   *p;
+
+		p = MemoryContextAlloc(TopMemoryContext, BLCKSZ + PG_IO_ALIGN_SIZE);
+		md_bounce_buffer = (char *) TYPEALIGN(PG_IO_ALIGN_SIZE, p);
+	}
+	return md_bounce_buffer;
+}
+
+/*
+ * Set up iov[] for the longest leading part of a run of blocks that can be
+ * transferred with one readv() or writev() call: it must stay within one
+ * segment file, and under direct I/O every buffer must be usable in place.
+ * Returns the number of iov[] entries set.
+ */
+static int
+mdiovec(BlockNumber blocknum, char **buffers, BlockNumber nblocks,
+		struct iovec *iov)
+{
+	BlockNumber limit;
+	int			i;
+
+	limit = Min(nblocks, PG_IOV_MAX);
+	limit = Min(limit, RELSEG_SIZE - blocknum % ((BlockNumber) RELSEG_SIZE));
+
+	for (i = 0; i < limit; i++)
+	{
+		if (mdiobuffer(buffers[i]) != buffers[i])
+			break;
+		iov[i].iov_base = buffers[i];
+		iov[i].iov_len = BLCKSZ;
+	}
+
+	return i;
+}
@@ -53,6 +53,11 @@ typedef struct f_smgr
 										  BlockNumber blocknum, char *buffer);
 	void		(*smgr_write) (SMgrRelation reln, ForkNumber forknum,
 						 BlockNumber blocknum, char *buffer, bool skipFsync);
+	void		(*smgr_readv) (SMgrRelation reln, ForkNumber forknum,
+						BlockNumber blocknum, char **buffers, BlockNumber nblocks);
+	void		(*smgr_writev) (SMgrRelation reln, ForkNumber forknum,
+						BlockNumber blocknum, char **buffers, BlockNumber nblocks,
+											bool skipFsync);
 	void		(*smgr_writeback) (SMgrRelation reln, ForkNumber forknum,
 								  BlockNumber blocknum, BlockNumber nblocks);
 	BlockNumber (*smgr_nblocks) (SMgrRelation reln, ForkNumber forknum);
@@ -68,8 +73,8 @@ typedef struct f_smgr
 static const f_smgr smgrsw[] = {
 	/* magnetic disk */
 	{mdinit, NULL, mdclose, mdcreate, mdexists, mdunlink, mdextend,
-		mdprefetch, mdread, mdwrite, mdwriteback, mdnblocks, mdtruncate,
-		mdimmedsync, mdpreckpt, mdsync, mdpostckpt
+		mdprefetch, mdread, mdwrite, mdreadv, mdwritev, mdwriteback,
+		mdnblocks, mdtruncate, mdimmedsync, mdpreckpt, mdsync, mdpostckpt
 	}
 };
 
@@ -651,6 +656,35 @@ smgrwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 											  buffer, skipFsync);
 }
 
+/*
+ *	smgrreadv() -- read a run of consecutive blocks of a relation.
+ *
+ *		buffers[i] receives block blocknum + i.  This is equivalent to
+ *		calling smgrread() for each block, but lets the storage manager
+ *		combine the reads into fewer, larger I/O requests.
+ */
+void
+smgrreadv(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		  char **buffers, BlockNumber nblocks)
+{
+	(*(smgrsw[reln->smgr_which].smgr_readv)) (reln, forknum, blocknum,
+											  buffers, nblocks);
+}
+
+/*
+ *	smgrwritev() -- write out a run of consecutive blocks of a relation.
+ *
+ *		Equivalent to calling smgrwrite() for each block, with the same
+ *		restrictions; buffers[i] holds the contents of block blocknum + i.
+ */
+void
+smgrwritev(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		   char **buffers, BlockNumber nblocks, bool skipFsync)
+{
+	(*(smgrsw[reln->smgr_which].smgr_writev)) (reln, forknum, blocknum,
+											   buffers, nblocks, skipFsync);
+}
+
 
 /*
  *	smgrwriteback() -- Trigger kernel writeback for the supplied range of
@@ -1496,6 +1496,54 @@ pg_stat_get_checkpoint_sync_time(PG_FUNCTION_ARGS)
 	PG_RETURN_FLOAT8((double) pgstat_fetch_global()->checkpoint_sync_time);
 }
 
+/*
+ * Checkpoint fsync latency at the given percentile, in milliseconds.  This
+ * is the upper bound of the histogram bucket the percentile falls into, so
+ * it may overstate the latency by up to a factor of two, but never exceeds
+ * the longest fsync seen.  NULL if there have been no fsyncs.
+ */
+Datum
+pg_stat_get_checkpoint_sync_percentile(PG_FUNCTION_ARGS)
+{
+	float8		fraction = PG_GETARG_FLOAT8(0);
+	PgStat_GlobalStats *stats;
+	PgStat_Counter total = 0;
+	PgStat_Counter sum = 0;
+	uint64		result;
+	int			i;
+
+	if (!(fraction >= 0.0 && fraction <= 1.0))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("percentile value %g is not between 0 and 1",
+						fraction)));
+
+	stats = pgstat_fetch_global();
+
+	for (i = 0; i < PGSTAT_SYNC_HIST_BUCKETS; i++)
+		total += stats->checkpoint_sync_hist[i];
+	if (total == 0)
+		PG_RETURN_NULL();
+
+	for (i = 0; i < PGSTAT_SYNC_HIST_BUCKETS - 1; i++)
+	{
+		sum += stats->checkpoint_sync_hist[i];
+		if (sum > 0 && sum >= fraction * total)
+			break;
+	}
+
+	result = Min((uint64) 1 << (i + 1), (uint64) stats->checkpoint_sync_max);
+
+	PG_RETURN_FLOAT8((double) result / 1000.0);
+}
+
+Datum
+pg_stat_get_checkpoint_sync_max(PG_FUNCTION_ARGS)
+{
+	/* kept in microseconds */
+	PG_RETURN_FLOAT8((double) pgstat_fetch_global()->checkpoint_sync_max / 1000.0);
+}
+
 Datum
 pg_stat_get_bgwriter_stat_reset_time(PG_FUNCTION_ARGS)
 {
@@ -28,9 +28,11 @@
 
 #include "access/commit_ts.h"
 #include "access/gin.h"
+#include "access/parallelredo.h"
 #include "access/transam.h"
 #include "access/twophase.h"
 #include "access/xact.h"
+#include "access/xlogprefetch.h"
 #include "catalog/namespace.h"
 #include "commands/async.h"
 #include "commands/prepare.h"
@@ -383,6 +385,19 @@ static const struct config_enum_entry huge_pages_options[] = {
 	{NULL, 0, false}
 };
 
+static const struct config_enum_entry shared_memory_numa_options[] = {
+	{"off", SHMEM_NUMA_OFF, false},
+	{"interleave", SHMEM_NUMA_INTERLEAVE, false},
+	{"local", SHMEM_NUMA_LOCAL, false},
+	{NULL, 0, false}
+};
+
+static const struct config_enum_entry buffer_replacement_policy_options[] = {
+	{"clock", BUFFER_REPLACEMENT_CLOCK, false},
+	{"2q", BUFFER_REPLACEMENT_2Q, false},
+	{NULL, 0, false}
+};
+
 static const struct config_enum_entry force_parallel_mode_options[] = {
 	{"off", FORCE_PARALLEL_OFF, false},
 	{"on", FORCE_PARALLEL_ON, false},
@@ -421,6 +436,7 @@ extern const struct config_enum_entry wal_level_options[];
 extern const struct config_enum_entry archive_mode_options[];
 extern const struct config_enum_entry sync_method_options[];
 extern const struct config_enum_entry dynamic_shared_memory_options[];
+extern const struct config_enum_entry direct_io_options[];
 
 /*
  * GUC option variables that are exported from this module
@@ -481,6 +497,7 @@ int			ssl_renegotiation_limit;
  * need to be duplicated in all the different implementations of pg_shmem.c.
  */
 int			huge_pages;
+int			shared_memory_numa;
 
 /*
  * These variables are all dummies that don't do anything, except in some
@@ -895,6 +912,33 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_gathermerge", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of gather merge plans."),
+			NULL
+		},
+		&enable_gathermerge,
+		true,
+		NULL, NULL, NULL
+	},
+	{
+		{"enable_parallel_hash", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of parallel hash plans."),
+			NULL
+		},
+		&enable_parallel_hash,
+		true,
+		NULL, NULL, NULL
+	},
+	{
+		{"enable_async_append", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the executor's use of async-aware append plans."),
+			NULL
+		},
+		&enable_async_append,
+		true,
+		NULL, NULL, NULL
+	},
 
 	{
 		{"geqo", PGC_USERSET, QUERY_TUNING_GEQO,
@@ -1028,6 +1072,16 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"wal_record_compression", PGC_SUSET, WAL_SETTINGS,
+			gettext_noop("Compresses WAL records that don't contain full-page writes."),
+			NULL
+		},
+		&wal_record_compression,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"log_checkpoints", PGC_SIGHUP, LOGGING_WHAT,
 			gettext_noop("Logs each checkpoint."),
@@ -1400,6 +1454,17 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"vacuum_eager_freeze", PGC_USERSET, CLIENT_CONN_STATEMENT,
+			gettext_noop("Freezes whole pages during VACUUM when that is cheap, regardless of tuple age."),
+			gettext_noop("Pages that VACUUM marks all-visible, or modifies anyway, are frozen "
+						 "completely, and some pages marked all-visible earlier are frozen by "
+						 "each VACUUM, to reduce the work left for anti-wraparound vacuums.")
+		},
+		&vacuum_eager_freeze,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"array_nulls", PGC_USERSET, COMPAT_OPTIONS_PREVIOUS,
 			gettext_noop("Enable input of NULL elements in arrays."),
@@ -2030,6 +2095,16 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"autovacuum_parallel_workers", PGC_SIGHUP, AUTOVACUUM,
+			gettext_noop("Sets the number of parallel workers each autovacuum worker may use to vacuum indexes."),
+			NULL
+		},
+		&autovacuum_parallel_workers,
+		0, 0, 1024,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"max_files_per_process", PGC_POSTMASTER, RESOURCES_KERNEL,
 			gettext_noop("Sets the maximum number of simultaneously open files for each server process."),
@@ -2288,6 +2363,16 @@ static struct config_int ConfigureNamesInt[] =
 		check_wal_buffers, NULL, NULL
 	},
 
+	{
+		{"wal_insert_locks", PGC_POSTMASTER, WAL_SETTINGS,
+			gettext_noop("Sets the number of locks used for concurrent WAL insertion."),
+			NULL
+		},
+		&wal_insert_locks,
+		8, 1, MAX_XLOGINSERT_LOCKS,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_writer_delay", PGC_SIGHUP, WAL_SETTINGS,
 			gettext_noop("Time between WAL flushes performed in the WAL writer."),
@@ -2310,6 +2395,17 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"recovery_prefetch_distance", PGC_SIGHUP, WAL_SETTINGS,
+			gettext_noop("How far ahead in the WAL to look for blocks to prefetch during recovery."),
+			gettext_noop("Zero disables prefetching."),
+			GUC_UNIT_KB
+		},
+		&recovery_prefetch_distance,
+		0, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 	{
 		/* see max_connections */
 		{"max_wal_senders", PGC_POSTMASTER, REPLICATION_SENDING,
@@ -2347,11 +2443,11 @@ static struct config_int ConfigureNamesInt[] =
 		{"commit_delay", PGC_SUSET, WAL_SETTINGS,
 			gettext_noop("Sets the delay in microseconds between transaction commit and "
 						 "flushing WAL to disk."),
-			NULL
+			gettext_noop("-1 adapts the delay to the time WAL flushes take.")
 			/* we have no microseconds designation, so can't supply units here */
 		},
 		&CommitDelay,
-		0, 0, 100000,
+		0, -1, 100000,
 		NULL, NULL, NULL
 	},
 
@@ -2461,6 +2557,17 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"io_combine_limit", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Limit on the number of consecutive blocks read or written with one I/O request."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&io_combine_limit,
+		16, 1, MAX_IO_COMBINE_LIMIT,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"max_worker_processes",
 			PGC_POSTMASTER,
@@ -2485,6 +2592,18 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"max_parallel_redo_workers",
+			PGC_POSTMASTER,
+			RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Maximum number of worker processes used to replay WAL during recovery."),
+			NULL,
+		},
+		&max_parallel_redo_workers,
+		0, 0, 1024,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"log_rotation_age", PGC_SIGHUP, LOGGING_WHERE,
 			gettext_noop("Automatic log file rotation will occur after N minutes."),
@@ -2617,6 +2736,15 @@ static struct config_int ConfigureNamesInt[] =
 		50, 0, INT_MAX,
 		NULL, NULL, NULL
 	},
+	{
+		{"autovacuum_vacuum_insert_threshold", PGC_SIGHUP, AUTOVACUUM,
+			gettext_noop("Minimum number of tuple inserts prior to vacuum, or -1 to disable insert vacuums."),
+			NULL
+		},
+		&autovacuum_vac_ins_thresh,
+		1000, -1, INT_MAX,
+		NULL, NULL, NULL
+	},
 	{
 		{"autovacuum_analyze_threshold", PGC_SIGHUP, AUTOVACUUM,
 			gettext_noop("Minimum number of tuple inserts, updates, or deletes prior to analyze."),
@@ -2668,6 +2796,16 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"max_parallel_maintenance_workers", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Sets the maximum number of parallel processes per maintenance operation."),
+			NULL
+		},
+		&max_parallel_maintenance_workers,
+		2, 0, 1024,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"max_parallel_workers", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
 			gettext_noop("Sets the maximum number of parallel workers than can be active at one time."),
@@ -2970,6 +3108,15 @@ static struct config_real ConfigureNamesReal[] =
 		0.2, 0.0, 100.0,
 		NULL, NULL, NULL
 	},
+	{
+		{"autovacuum_vacuum_insert_scale_factor", PGC_SIGHUP, AUTOVACUUM,
+			gettext_noop("Number of tuple inserts prior to vacuum as a fraction of reltuples."),
+			NULL
+		},
+		&autovacuum_vac_ins_scale,
+		0.2, 0.0, 100.0,
+		NULL, NULL, NULL
+	},
 	{
 		{"autovacuum_analyze_scale_factor", PGC_SIGHUP, AUTOVACUUM,
 			gettext_noop("Number of tuple inserts, updates, or deletes prior to analyze as a fraction of reltuples."),
@@ -2990,6 +3137,16 @@ static struct config_real ConfigureNamesReal[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"checkpoint_sync_fraction", PGC_SIGHUP, WAL_CHECKPOINTS,
+			gettext_noop("Part of the checkpoint duration set aside for spreading out fsync calls."),
+			NULL
+		},
+		&CheckPointSyncFraction,
+		0.2, 0.0, 1.0,
+		NULL, NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, 0.0, 0.0, 0.0, NULL, NULL, NULL
@@ -3777,6 +3934,16 @@ static struct config_enum ConfigureNamesEnum[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"direct_io", PGC_POSTMASTER, RESOURCES_DISK,
+			gettext_noop("Selects which files are accessed with direct I/O, bypassing the kernel's cache."),
+			NULL
+		},
+		&direct_io,
+		0, direct_io_options,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_sync_method", PGC_SIGHUP, WAL_SETTINGS,
 			gettext_noop("Selects the method used for forcing WAL updates to disk."),
@@ -3818,6 +3985,26 @@ static struct config_enum ConfigureNamesEnum[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"shared_memory_numa", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Placement of shared memory on NUMA nodes."),
+			NULL
+		},
+		&shared_memory_numa,
+		SHMEM_NUMA_OFF, shared_memory_numa_options,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"buffer_replacement_policy", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Selects the algorithm used to choose shared buffers for replacement."),
+			NULL
+		},
+		&buffer_replacement_policy,
+		BUFFER_REPLACEMENT_CLOCK, buffer_replacement_policy_options,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"force_parallel_mode", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Forces use of parallel query facilities."),
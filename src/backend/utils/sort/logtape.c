@@ -57,6 +57,15 @@
  * of releasing many blocks followed by re-using many blocks, due to
  * the larger read buffer.
  *
+ * A tape can also be handed over from one process to another, which is how
+ * the processes taking part in a parallel sort pass their sorted runs to
+ * the one that merges them.  The exporting process builds its tape set in a
+ * shared BufFile (see LogicalTapeSetCreateShared and LogicalTapeExport), and
+ * the importing process appends that file to the end of its own tape set's
+ * file (see LogicalTapeImport).  The block pointers stored in an imported
+ * tape are relative to the file it was written in, so we remember for each
+ * tape the offset at which its blocks now start.
+ *
  * Since all the bookkeeping and buffer memory is allocated with palloc(),
  * and the underlying file(s) are made with OpenTemporaryFile, all resources
  * for a logical tape set are certain to be cleaned up even if processing
@@ -134,6 +143,12 @@ typedef struct LogicalTape
 	long		curBlockNumber;
 	long		nextBlockNumber;
 
+	/*
+	 * Offset to add to the block pointers stored in the tape's blocks.  This
+	 * is zero, except for a tape imported from another tape set's file.
+	 */
+	long		offsetBlockNumber;
+
 	/*
 	 * Buffer for current data block(s).
 	 */
@@ -163,6 +178,7 @@ struct LogicalTapeSet
 	 */
 	long		nBlocksAllocated;		/* # of blocks allocated */
 	long		nBlocksWritten; /* # of blocks used in underlying file */
+	long		nHoleBlocks;	/* # of unused blocks left by imports */
 
 	/*
 	 * We store the numbers of recycled-and-available blocks in freeBlocks[].
@@ -192,6 +208,7 @@ static void ltsWriteBlock(LogicalTapeSet *lts, long blocknum, void *buffer);
 static void ltsReadBlock(LogicalTapeSet *lts, long blocknum, void *buffer);
 static long ltsGetFreeBlock(LogicalTapeSet *lts);
 static void ltsReleaseBlock(LogicalTapeSet *lts, long blocknum);
+static LogicalTapeSet *ltsCreate(int ntapes, BufFile *pfile);
 
 
 /*
@@ -286,7 +303,8 @@ ltsReadFillBuffer(LogicalTapeSet *lts, LogicalTape *lt)
 			break;
 		}
 		else
-			lt->nextBlockNumber = TapeBlockGetTrailer(thisbuf)->next;
+			lt->nextBlockNumber = TapeBlockGetTrailer(thisbuf)->next +
+				lt->offsetBlockNumber;
 
 		/* Advance to next block, if we have buffer space left */
 	} while (lt->buffer_size - lt->nbytes > BLCKSZ);
@@ -377,6 +395,27 @@ ltsReleaseBlock(LogicalTapeSet *lts, long blocknum)
  */
 LogicalTapeSet *
 LogicalTapeSetCreate(int ntapes)
+{
+	return ltsCreate(ntapes, BufFileCreateTemp(false));
+}
+
+/*
+ * Create a set of logical tapes in a shared temporary file, which is a
+ * member of the given SharedFileSet under the given name.  Its tapes can
+ * be exported with LogicalTapeExport, to be imported by another process.
+ */
+LogicalTapeSet *
+LogicalTapeSetCreateShared(int ntapes, SharedFileSet *fileset,
+						   const char *name)
+{
+	return ltsCreate(ntapes, BufFileCreateShared(fileset, name));
+}
+
+/*
+ * Common code for creating a tape set, on top of the given file.
+ */
+static LogicalTapeSet *
+ltsCreate(int ntapes, BufFile *pfile)
 {
 	LogicalTapeSet *lts;
 	LogicalTape *lt;
@@ -388,9 +427,10 @@ LogicalTapeSetCreate(int ntapes)
 	Assert(ntapes > 0);
 	lts = (LogicalTapeSet *) palloc(offsetof(LogicalTapeSet, tapes) +
 									ntapes * sizeof(LogicalTape));
-	lts->pfile = BufFileCreateTemp(false);
+	lts->pfile = pfile;
 	lts->nBlocksAllocated = 0L;
 	lts->nBlocksWritten = 0L;
+	lts->nHoleBlocks = 0L;
 	lts->forgetFreeSpace = false;
 	lts->blocksSorted = true;	/* a zero-length array is sorted ... */
 	lts->freeBlocksLen = 32;	/* reasonable initial guess */
@@ -412,6 +452,7 @@ LogicalTapeSetCreate(int ntapes)
 		lt->dirty = false;
 		lt->firstBlockNumber = -1L;
 		lt->curBlockNumber = -1L;
+		lt->offsetBlockNumber = 0L;
 		lt->buffer = NULL;
 		lt->buffer_size = 0;
 		lt->pos = 0;
@@ -638,6 +679,7 @@ LogicalTapeRewindForWrite(LogicalTapeSet *lts, int tapenum)
 	lt->dirty = false;
 	lt->firstBlockNumber = -1L;
 	lt->curBlockNumber = -1L;
+	lt->offsetBlockNumber = 0L;
 	lt->pos = 0;
 	lt->nbytes = 0;
 	if (lt->buffer)
@@ -747,7 +789,8 @@ LogicalTapeFreeze(LogicalTapeSet *lts, int tapenum)
 	if (TapeBlockIsLast(lt->buffer))
 		lt->nextBlockNumber = -1L;
 	else
-		lt->nextBlockNumber = TapeBlockGetTrailer(lt->buffer)->next;
+		lt->nextBlockNumber = TapeBlockGetTrailer(lt->buffer)->next +
+			lt->offsetBlockNumber;
 	lt->nbytes = TapeBlockGetNBytes(lt->buffer);
 }
 
@@ -802,18 +845,21 @@ LogicalTapeBackspace(LogicalTapeSet *lts, int tapenum, size_t size)
 			lt->pos = 0;
 			return seekpos;
 		}
+		prev += lt->offsetBlockNumber;
 
 		ltsReadBlock(lts, prev, (void *) lt->buffer);
 
-		if (TapeBlockGetTrailer(lt->buffer)->next != lt->curBlockNumber)
+		if (TapeBlockGetTrailer(lt->buffer)->next + lt->offsetBlockNumber !=
+			lt->curBlockNumber)
 			elog(ERROR, "broken tape, next of block %ld is %ld, expected %ld",
 				 prev,
-				 TapeBlockGetTrailer(lt->buffer)->next,
+				 TapeBlockGetTrailer(lt->buffer)->next + lt->offsetBlockNumber,
 				 lt->curBlockNumber);
 
 		lt->nbytes = TapeBlockPayloadSize;
 		lt->curBlockNumber = prev;
-		lt->nextBlockNumber = TapeBlockGetTrailer(lt->buffer)->next;
+		lt->nextBlockNumber = TapeBlockGetTrailer(lt->buffer)->next +
+			lt->offsetBlockNumber;
 
 		seekpos += TapeBlockPayloadSize;
 	}
@@ -852,7 +898,8 @@ LogicalTapeSeek(LogicalTapeSet *lts, int tapenum,
 		ltsReadBlock(lts, blocknum, (void *) lt->buffer);
 		lt->curBlockNumber = blocknum;
 		lt->nbytes = TapeBlockPayloadSize;
-		lt->nextBlockNumber = TapeBlockGetTrailer(lt->buffer)->next;
+		lt->nextBlockNumber = TapeBlockGetTrailer(lt->buffer)->next +
+			lt->offsetBlockNumber;
 	}
 
 	if (offset > lt->nbytes)
@@ -882,11 +929,74 @@ LogicalTapeTell(LogicalTapeSet *lts, int tapenum,
 	*offset = lt->pos;
 }
 
+/*
+ * Export a frozen tape of a tape set made by LogicalTapeSetCreateShared,
+ * so that another process can import it with LogicalTapeImport.
+ *
+ * Returns the tape's first block number, which the importing process needs
+ * to know.
+ */
+long
+LogicalTapeExport(LogicalTapeSet *lts, int tapenum)
+{
+	LogicalTape *lt;
+
+	Assert(tapenum >= 0 && tapenum < lts->nTapes);
+	lt = &lts->tapes[tapenum];
+	Assert(lt->frozen);
+
+	BufFileExportShared(lts->pfile);
+
+	return lt->firstBlockNumber;
+}
+
+/*
+ * Import a tape exported by another process into an unused tape of this
+ * tape set.  'name' is the name of the other process' tape set file within
+ * the SharedFileSet, and 'firstBlockNumber' is the value LogicalTapeExport
+ * returned.
+ *
+ * The file is appended to our own underlying file, and the tape is left in
+ * the state of a tape that has just been written, ready to be rewound for
+ * reading.  Its blocks are recycled as they are read, like ours, so tapes
+ * must be imported before anything is written to the tape set.
+ */
+void
+LogicalTapeImport(LogicalTapeSet *lts, int tapenum, SharedFileSet *fileset,
+				  const char *name, long firstBlockNumber)
+{
+	LogicalTape *lt;
+	BufFile    *file;
+	long		nblocks;
+	long		offset;
+
+	Assert(tapenum >= 0 && tapenum < lts->nTapes);
+	lt = &lts->tapes[tapenum];
+	Assert(lt->writing && !lt->dirty && lt->firstBlockNumber == -1L);
+	Assert(lts->nBlocksAllocated == lts->nBlocksWritten);
+
+	file = BufFileOpenShared(fileset, name);
+	nblocks = BufFileNumBlocks(file);
+	offset = BufFileAppend(lts->pfile, file);
+
+	lt->firstBlockNumber = firstBlockNumber + offset;
+	lt->offsetBlockNumber = offset;
+
+	/*
+	 * Anything we write from now on goes after the imported blocks.  The
+	 * hole between our previous end of file and the start of the imported
+	 * file is never allocated, so never read or written.
+	 */
+	lts->nHoleBlocks += offset - lts->nBlocksAllocated;
+	lts->nBlocksAllocated = offset + nblocks;
+	lts->nBlocksWritten = offset + nblocks;
+}
+
 /*
  * Obtain total disk space currently used by a LogicalTapeSet, in blocks.
  */
 long
 LogicalTapeSetBlocks(LogicalTapeSet *lts)
 {
-	return lts->nBlocksAllocated;
+	return lts->nBlocksAllocated - lts->nHoleBlocks;
 }
@@ -111,6 +111,14 @@
  * above.  Nonetheless, with large workMem we can have many tapes (but not
  * too many -- see the comments in tuplesort_merge_order).
  *
+ * A sort can also be split across several processes.  Each process sorts
+ * its share of the input and, instead of reading the output back, exports
+ * it as a single run on a tape in a shared file set (tuplesort_export_run).
+ * One process then imports all the runs into a fresh sort, in place of any
+ * input tuples, and merges them as if it had written them itself
+ * (tuplesort_import_runs).  The final merge then needs no further I/O,
+ * just as in the serial case.
+ *
  *
  * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -133,6 +141,8 @@
 #include "executor/executor.h"
 #include "miscadmin.h"
 #include "pg_trace.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
 #include "utils/datum.h"
 #include "utils/logtape.h"
 #include "utils/lsyscache.h"
@@ -236,6 +246,24 @@ typedef enum
 	TSS_FINALMERGE				/* Performing final merge on-the-fly */
 } TupSortStatus;
 
+/*
+ * State shared between the processes taking part in a sort that is split
+ * across processes, kept in a DSM segment.
+ *
+ * Each exporting process writes its sorted output as a single run on a tape
+ * in the shared file set, and records the tape's first block here under the
+ * run number it was given.  The importing process then opens those files
+ * and merges the runs.  firstblocks[] entries are -1 until the corresponding
+ * run has been exported.
+ */
+struct Sharedsort
+{
+	slock_t		mutex;			/* protects firstblocks[] */
+	int			nruns;			/* allocated length of firstblocks[] */
+	SharedFileSet fileset;		/* temp files holding the exported runs */
+	long		firstblocks[FLEXIBLE_ARRAY_MEMBER];
+};
+
 /*
  * Parameters for calculation of number of tapes to use --- see inittapes()
  * and tuplesort_merge_order().
@@ -483,6 +511,15 @@ struct Tuplesortstate
 	/* we need typelen in order to know how to copy the Datums. */
 	int			datumTypeLen;
 
+	/*
+	 * These variables are set by tuplesort_set_export, if the sorted output
+	 * is to be exported as a run for another process to merge.  The tapes
+	 * are then created in the shared file set, rather than in a private
+	 * temporary file.
+	 */
+	Sharedsort *shared;			/* shared state, or NULL if not exporting */
+	int			exportRun;		/* run number to export our output as */
+
 	/*
 	 * Resource snapshot for time of sort start.
 	 */
@@ -585,6 +622,7 @@ static void inittapes(Tuplesortstate *state);
 static void selectnewtape(Tuplesortstate *state);
 static void init_slab_allocator(Tuplesortstate *state, int numSlots);
 static void mergeruns(Tuplesortstate *state);
+static void tuplesort_run_name(char *buf, int run);
 static void mergeonerun(Tuplesortstate *state);
 static void beginmerge(Tuplesortstate *state);
 static bool mergereadnext(Tuplesortstate *state, int srcTape, SortTuple *stup);
@@ -744,6 +782,9 @@ tuplesort_begin_common(int workMem, bool randomAccess)
 
 	state->result_tape = -1;	/* flag that result tape has not been formed */
 
+	state->shared = NULL;		/* not exporting, unless told otherwise */
+	state->exportRun = -1;
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -1116,6 +1157,7 @@ tuplesort_set_bound(Tuplesortstate *state, int64 bound)
 	Assert(state->status == TSS_INITIAL);
 	Assert(state->memtupcount == 0);
 	Assert(!state->bounded);
+	Assert(state->shared == NULL);
 
 #ifdef DEBUG_BOUNDED_SORT
 	/* Honor GUC setting that disables the feature (for easy testing) */
@@ -1144,6 +1186,29 @@ tuplesort_set_bound(Tuplesortstate *state, int64 bound)
 	state->sortKeys->abbrev_full_comparator = NULL;
 }
 
+/*
+ * tuplesort_set_export
+ *
+ *	Arrange for the sorted output to be exported to another process, as run
+ *	number 'run' of the given shared sort, by tuplesort_export_run.
+ *
+ * Must be called before inserting any tuples.  The state must have been
+ * created with the same sort definition as the one that will import the
+ * run, since the importer merges the runs with its own comparator.
+ */
+void
+tuplesort_set_export(Tuplesortstate *state, Sharedsort *shared, int run)
+{
+	/* Assert we're called before loading any tuples */
+	Assert(state->status == TSS_INITIAL);
+	Assert(state->memtupcount == 0);
+	Assert(!state->bounded);
+	Assert(run >= 0 && run < shared->nruns);
+
+	state->shared = shared;
+	state->exportRun = run;
+}
+
 /*
  * tuplesort_end
  *
@@ -1838,6 +1903,255 @@ tuplesort_performsort(Tuplesortstate *state)
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * tuplesort_export_run
+ *
+ *	Finish sorting the input of a state set up by tuplesort_set_export, and
+ *	export the result as a single sorted run.  This is used instead of
+ *	tuplesort_performsort; afterwards the state can only be ended.
+ *
+ * The run is always written out to a tape in the shared file set, even if
+ * all the tuples fit in memory.  tuplesort_end closes our files, but they
+ * are not deleted until the shared file set is.
+ */
+void
+tuplesort_export_run(Tuplesortstate *state)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	Sharedsort *shared = state->shared;
+	long		firstblock;
+
+	Assert(shared != NULL);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG, "exporting sorted run %d: %s",
+			 state->exportRun, pg_rusage_show(&state->ru_start));
+#endif
+
+	switch (state->status)
+	{
+		case TSS_INITIAL:
+
+			/*
+			 * We were able to accumulate all the tuples within the allowed
+			 * amount of memory, but we must write them out anyway.  Set up
+			 * the tapes exactly as if we had run out of memory.
+			 */
+			inittapes(state);
+			/* FALL THRU */
+
+		case TSS_BUILDRUNS:
+
+			/*
+			 * Flush all tuples remaining in memory out to tape, and merge
+			 * down to a single run.  mergeruns never leaves the last merge
+			 * to be done on-the-fly when exporting, so this leaves us with
+			 * the whole output frozen on the result tape.
+			 */
+			dumptuples(state, true);
+			mergeruns(state);
+			Assert(state->status == TSS_SORTEDONTAPE);
+			break;
+
+		default:
+			elog(ERROR, "invalid tuplesort state");
+			break;
+	}
+
+	firstblock = LogicalTapeExport(state->tapeset, state->result_tape);
+
+	SpinLockAcquire(&shared->mutex);
+	shared->firstblocks[state->exportRun] = firstblock;
+	SpinLockRelease(&shared->mutex);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG, "sorted run %d exported: %s",
+			 state->exportRun, pg_rusage_show(&state->ru_start));
+#endif
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * tuplesort_import_runs
+ *
+ *	Import the first 'nruns' runs exported to the shared sort, and merge
+ *	them.  This is used instead of loading tuples and calling
+ *	tuplesort_performsort; afterwards, the sorted output can be fetched in
+ *	the usual way.
+ *
+ * The state must be freshly created, with the same sort definition as the
+ * states that exported the runs.  All of the runs must have been exported
+ * already.
+ */
+void
+tuplesort_import_runs(Tuplesortstate *state, Sharedsort *shared, int nruns)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	int			maxTapes,
+				j;
+	int64		tapeSpace;
+
+	/* Assert we're called before loading any tuples */
+	Assert(state->status == TSS_INITIAL);
+	Assert(state->memtupcount == 0);
+	Assert(!state->bounded);
+	Assert(state->shared == NULL);
+	Assert(nruns > 0 && nruns <= shared->nruns);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG, "importing %d sorted runs: %s",
+			 nruns, pg_rusage_show(&state->ru_start));
+#endif
+
+	/*
+	 * One tape per imported run, plus one output tape in case the merge
+	 * can't be done in a single pass.  Account for the tape buffers the
+	 * same way inittapes() does.
+	 */
+	maxTapes = nruns + 1;
+	state->maxTapes = maxTapes;
+	state->tapeRange = nruns;
+
+	tapeSpace = (int64) maxTapes *TAPE_BUFFER_OVERHEAD;
+
+	if (tapeSpace + GetMemoryChunkSpace(state->memtuples) <
+		state->allowedMem)
+		USEMEM(state, tapeSpace);
+
+	/* Our own tape file may need to be written, if we merge in passes */
+	PrepareTempTablespaces();
+
+	state->tapeset = LogicalTapeSetCreate(maxTapes);
+
+	state->mergeactive = (bool *) palloc0(maxTapes * sizeof(bool));
+	state->tp_fib = (int *) palloc0(maxTapes * sizeof(int));
+	state->tp_runs = (int *) palloc0(maxTapes * sizeof(int));
+	state->tp_dummy = (int *) palloc0(maxTapes * sizeof(int));
+	state->tp_tapenum = (int *) palloc0(maxTapes * sizeof(int));
+
+	for (j = 0; j < nruns; j++)
+	{
+		char		name[MAXPGPATH];
+		long		firstblock;
+
+		SpinLockAcquire(&shared->mutex);
+		firstblock = shared->firstblocks[j];
+		SpinLockRelease(&shared->mutex);
+
+		if (firstblock < 0)
+			elog(ERROR, "sorted run %d has not been exported", j);
+
+		tuplesort_run_name(name, j);
+		LogicalTapeImport(state->tapeset, j, &shared->fileset, name,
+						  firstblock);
+	}
+
+	/*
+	 * Set up the Algorithm D variables as though we had just finished
+	 * building runs, with exactly one run on each input tape.  That is a
+	 * perfect distribution for a single merge pass, so no dummy runs are
+	 * needed.
+	 */
+	for (j = 0; j < maxTapes; j++)
+	{
+		state->tp_fib[j] = 1;
+		state->tp_runs[j] = 1;
+		state->tp_dummy[j] = 0;
+		state->tp_tapenum[j] = j;
+	}
+	state->tp_fib[state->tapeRange] = 0;
+	state->tp_runs[state->tapeRange] = 0;
+
+	state->replaceActive = false;
+	state->currentRun = nruns;
+	state->Level = 1;
+	state->destTape = 0;
+	state->status = TSS_BUILDRUNS;
+
+	/* mergeruns sets the correct state->status */
+	mergeruns(state);
+	state->eof_reached = false;
+	state->markpos_block = 0L;
+	state->markpos_offset = 0;
+	state->markpos_eof = false;
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+	{
+		if (state->status == TSS_FINALMERGE)
+			elog(LOG, "import done (except %d-way final merge): %s",
+				 state->activeTapes,
+				 pg_rusage_show(&state->ru_start));
+		else
+			elog(LOG, "import done: %s",
+				 pg_rusage_show(&state->ru_start));
+	}
+#endif
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * tuplesort_estimate_shared
+ *
+ *	Estimate the amount of shared memory needed for a shared sort with
+ *	room for 'nruns' exported runs.
+ */
+Size
+tuplesort_estimate_shared(int nruns)
+{
+	Assert(nruns > 0);
+
+	return add_size(offsetof(Sharedsort, firstblocks),
+					mul_size(sizeof(long), nruns));
+}
+
+/*
+ * tuplesort_initialize_shared
+ *
+ *	Initialize the shared state of a sort, in memory allocated in the given
+ *	DSM segment.  The shared file set holding the exported runs goes away
+ *	when the last process detaches from the segment.
+ */
+void
+tuplesort_initialize_shared(Sharedsort *shared, int nruns, dsm_segment *seg)
+{
+	int			i;
+
+	Assert(nruns > 0);
+
+	SpinLockInit(&shared->mutex);
+	shared->nruns = nruns;
+	for (i = 0; i < nruns; i++)
+		shared->firstblocks[i] = -1L;
+
+	SharedFileSetInit(&shared->fileset, seg);
+}
+
+/*
+ * tuplesort_attach_shared
+ *
+ *	Attach to the shared state of a sort, set up by another process.
+ */
+void
+tuplesort_attach_shared(Sharedsort *shared, dsm_segment *seg)
+{
+	SharedFileSetAttach(&shared->fileset, seg);
+}
+
+/*
+ * Construct the name under which a run is exported to the shared file set.
+ */
+static void
+tuplesort_run_name(char *buf, int run)
+{
+	snprintf(buf, MAXPGPATH, "run%d", run);
+}
+
 /*
  * Internal routine to fetch the next tuple in either forward or back
  * direction into *stup.  Returns FALSE if no more tuples.
@@ -2389,7 +2703,18 @@ inittapes(Tuplesortstate *state)
 	/*
 	 * Create the tape set and allocate the per-tape data arrays.
 	 */
-	state->tapeset = LogicalTapeSetCreate(maxTapes);
+	if (state->shared)
+	{
+		char		name[MAXPGPATH];
+
+		/* Write the tapes where the importing process can find them */
+		tuplesort_run_name(name, state->exportRun);
+		state->tapeset = LogicalTapeSetCreateShared(maxTapes,
+													&state->shared->fileset,
+													name);
+	}
+	else
+		state->tapeset = LogicalTapeSetCreate(maxTapes);
 
 	state->mergeactive = (bool *) palloc0(maxTapes * sizeof(bool));
 	state->tp_fib = (int *) palloc0(maxTapes * sizeof(int));
@@ -2671,8 +2996,10 @@ mergeruns(Tuplesortstate *state)
 		 * (real or dummy) run left on each input tape, then only one merge
 		 * pass remains.  If we don't have to produce a materialized sorted
 		 * tape, we can stop at this point and do the final merge on-the-fly.
+		 * (An exported run must be materialized, for the importing process
+		 * to read.)
 		 */
-		if (!state->randomAccess)
+		if (!state->randomAccess && state->shared == NULL)
 		{
 			bool		allOneRun = true;
 
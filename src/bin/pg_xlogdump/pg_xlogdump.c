@@ -63,6 +63,9 @@ typedef struct Stats
 typedef struct XLogDumpStats
 {
 	uint64		count;
+	uint64		compressed_count;	/* # of compressed records */
+	uint64		compressed_len; /* their total length as stored */
+	uint64		decompressed_len;	/* ... and once decompressed */
 	Stats		rmgr_stats[RM_NEXT_ID];
 	Stats		record_stats[RM_NEXT_ID][MAX_XLINFO_TYPES];
 } XLogDumpStats;
@@ -394,6 +397,13 @@ XLogDumpCountRecord(XLogDumpConfig *config, XLogDumpStats *stats,
 			fpi_len += record->blocks[block_id].bimg_len;
 	}
 
+	if (XLogRecIsCompressed(record))
+	{
+		stats->compressed_count++;
+		stats->compressed_len += XLogRecGetTotalLen(record);
+		stats->decompressed_len += XLogRecGetDecodedLen(record);
+	}
+
 	/* Update per-rmgr statistics */
 
 	stats->rmgr_stats[rmid].count++;
@@ -439,6 +449,8 @@ XLogDumpDisplayRecord(XLogDumpConfig *config, XLogReaderState *record)
 		   XLogRecGetXid(record),
 		   (uint32) (record->ReadRecPtr >> 32), (uint32) record->ReadRecPtr,
 		   (uint32) (xl_prev >> 32), (uint32) xl_prev);
+	if (XLogRecIsCompressed(record))
+		printf("compressed from: %u, ", XLogRecGetDecodedLen(record));
 	printf("desc: %s ", id);
 
 	/* the desc routine will printf the description directly to stdout */
@@ -665,6 +677,13 @@ XLogDumpDisplayStats(XLogDumpConfig *config, XLogDumpStats *stats)
 		   total_rec_len, psprintf("[%.02f%%]", rec_len_pct),
 		   total_fpi_len, psprintf("[%.02f%%]", fpi_len_pct),
 		   total_len, "[100%]");
+
+	if (stats->compressed_count > 0)
+		printf("\nCompressed records: " UINT64_FORMAT ", size " UINT64_FORMAT
+			   " (uncompressed " UINT64_FORMAT ", %.02f%%)\n",
+			   stats->compressed_count, stats->compressed_len,
+			   stats->decompressed_len,
+			   100 * (double) stats->compressed_len / stats->decompressed_len);
 }
 
 static void
@@ -1888,6 +1888,8 @@ psql_completion(const char *text, int start, int end)
 			"autovacuum_multixact_freeze_table_age",
 			"autovacuum_vacuum_cost_delay",
 			"autovacuum_vacuum_cost_limit",
+			"autovacuum_vacuum_insert_scale_factor",
+			"autovacuum_vacuum_insert_threshold",
 			"autovacuum_vacuum_scale_factor",
 			"autovacuum_vacuum_threshold",
 			"fillfactor",
@@ -1902,6 +1904,8 @@ psql_completion(const char *text, int start, int end)
 			"toast.autovacuum_multixact_freeze_table_age",
 			"toast.autovacuum_vacuum_cost_delay",
 			"toast.autovacuum_vacuum_cost_limit",
+			"toast.autovacuum_vacuum_insert_scale_factor",
+			"toast.autovacuum_vacuum_insert_threshold",
 			"toast.autovacuum_vacuum_scale_factor",
 			"toast.autovacuum_vacuum_threshold",
 			"toast.log_autovacuum_min_duration",
@@ -0,0 +1,371 @@
+/* ----------
+ * pg_lzfast.c -
+ *
+ *		This is a fast LZ77-family compressor for PostgreSQL, meant for
+ *		places where compression speed matters more than the compression
+ *		ratio, such as WAL records.  Compared to pg_lzcompress.c, it looks
+ *		at only one candidate match per position, and skips ahead faster
+ *		over data that doesn't seem to compress, so it is several times
+ *		faster at the price of somewhat larger output.
+ *
+ *		Entry routines:
+ *
+ *			int32
+ *			lzfast_compress(const char *source, int32 slen, char *dest,
+ *							int32 dlen);
+ *
+ *				source is the input data to be compressed.
+ *
+ *				slen is the length of the input data.
+ *
+ *				dest is the output area for the compressed result.
+ *
+ *				dlen is the size of the output area.  Callers normally
+ *					pass less than slen, to get compressed data only if
+ *					it is worth it.
+ *
+ *				The return value is the number of bytes written in the
+ *				buffer dest, or -1 if the result would not fit in dlen
+ *				bytes; in the latter case the contents of dest are
+ *				undefined.
+ *
+ *			int32
+ *			lzfast_decompress(const char *source, int32 slen, char *dest,
+ *							  int32 rawsize)
+ *
+ *				source is the compressed input.
+ *
+ *				slen is the length of the compressed input.
+ *
+ *				dest is the area where the uncompressed data will be
+ *					written to. It is the callers responsibility to
+ *					provide enough space.
+ *
+ *				rawsize is the length of the uncompressed data.
+ *
+ *				The return value is the number of bytes written in the
+ *				buffer dest, or -1 if decompression fails.  Corrupt input
+ *				is always detected as far as it would make us read or
+ *				write out of bounds.
+ *
+ *		The compression format:
+ *
+ *			The compressed data is a sequence of items, each consisting
+ *			of a control byte, a run of literal bytes, and a reference to
+ *			earlier data.  The high four bits of the control byte are the
+ *			number of literal bytes, the low four bits are the length of
+ *			the match minus 4, the minimum match length.  If either value
+ *			is 15, it is continued in additional bytes following the
+ *			control byte (for the literal count) or the offset (for the
+ *			match length): each such byte is added to the value, and the
+ *			value continues as long as the byte is 255.  The literal bytes
+ *			follow the control byte and the literal count; then comes the
+ *			offset of the match, a 2-byte little-endian number giving the
+ *			distance back from the current output position, from which
+ *			the match is copied.  Matches may overlap the output they
+ *			produce, so that a run of a repeated short string can be
+ *			encoded as a single match.
+ *
+ *			The last item contains only literals, possibly zero of them,
+ *			and no match: the end of the input tells the decompressor that
+ *			it is done.
+ *
+ *		The compression algorithm:
+ *
+ *			We keep a hash table, indexed by a hash of the next 4 input
+ *			bytes, remembering the last input position where each hash
+ *			value was seen.  At each position, we look up the candidate
+ *			from the table, and use it if the 4 bytes really match and it
+ *			is no further back than the largest offset we can encode.  The
+ *			match is then extended as far as it goes.  If there is no
+ *			match, we advance, taking larger steps the longer we've gone
+ *			without finding a match, so that incompressible data is
+ *			skipped over quickly.
+ *
+ * Copyright (c) 1999-2017, PostgreSQL Global Development Group
+ *
+ * src/common/pg_lzfast.c
+ * ----------
+ */
+#ifndef FRONTEND
+#include "postgres.h"
+#else
+#include "postgres_fe.h"
+#endif
+
+#include "common/pg_lzfast.h"
+
+
+/* ----------
+ * Local definitions
+ * ----------
+ */
+#define LZFAST_MIN_MATCH		4
+#define LZFAST_MAX_OFFSET		65535
+#define LZFAST_MAX_HASH_BITS	12
+#define LZFAST_MIN_HASH_BITS	6
+#define LZFAST_SKIP_TRIGGER		6	/* skip faster after 2^this misses */
+
+
+/* ----------
+ * Statically allocated work area for the hash table, as pg_lzcompress.c
+ * does for its history.  Entries are input positions, or -1 for none.
+ * ----------
+ */
+static int32 hash_table[1 << LZFAST_MAX_HASH_BITS];
+
+
+/* ----------
+ * lzfast_read32 -
+ *
+ *		Fetch 4 input bytes, without assuming they are aligned.
+ * ----------
+ */
+static inline uint32
+lzfast_read32(const unsigned char *p)
+{
+	uint32		v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+/* ----------
+ * lzfast_hash -
+ *
+ *		Multiplicative hash of 4 input bytes, giving hash_bits bits.
+ * ----------
+ */
+static inline uint32
+lzfast_hash(uint32 v, int hash_bits)
+{
+	return (v * 2654435761U) >> (32 - hash_bits);
+}
+
+/* ----------
+ * lzfast_put_length -
+ *
+ *		Output the continuation bytes of a length whose 4-bit field in the
+ *		control byte is 15.
+ * ----------
+ */
+static inline unsigned char *
+lzfast_put_length(unsigned char *dp, int32 len)
+{
+	while (len >= 255)
+	{
+		*dp++ = 255;
+		len -= 255;
+	}
+	*dp++ = (unsigned char) len;
+	return dp;
+}
+
+/* ----------
+ * lzfast_emit -
+ *
+ *		Output an item with literals lit[0 .. litlen-1], followed by a
+ *		match of length mlen at distance offset, or no match if mlen is 0.
+ *		Returns the new output position, or NULL if the item wouldn't fit
+ *		before dend.
+ * ----------
+ */
+static unsigned char *
+lzfast_emit(unsigned char *dp, unsigned char *dend,
+			const unsigned char *lit, int32 litlen,
+			int32 offset, int32 mlen)
+{
+	unsigned char *ctrlp;
+	int32		mcode = mlen - LZFAST_MIN_MATCH;
+
+	/* check space for the worst case first */
+	if (dend - dp < 1 + litlen / 255 + 1 + litlen + 2 + mlen / 255 + 1)
+		return NULL;
+
+	ctrlp = dp++;
+	if (litlen >= 15)
+	{
+		*ctrlp = 15 << 4;
+		dp = lzfast_put_length(dp, litlen - 15);
+	}
+	else
+		*ctrlp = litlen << 4;
+	memcpy(dp, lit, litlen);
+	dp += litlen;
+
+	if (mlen == 0)
+		return dp;
+
+	*dp++ = offset & 0xff;
+	*dp++ = (offset >> 8) & 0xff;
+	if (mcode >= 15)
+	{
+		*ctrlp |= 15;
+		dp = lzfast_put_length(dp, mcode - 15);
+	}
+	else
+		*ctrlp |= mcode;
+
+	return dp;
+}
+
+
+/* ----------
+ * lzfast_compress -
+ *
+ *		Compresses source into dest, if the result fits in dlen bytes.
+ *		Returns the number of bytes written in buffer dest, or -1 if not.
+ * ----------
+ */
+int32
+lzfast_compress(const char *source, int32 slen, char *dest, int32 dlen)
+{
+	const unsigned char *sp = (const unsigned char *) source;
+	const unsigned char *send = sp + slen;
+	const unsigned char *ip = sp;
+	const unsigned char *anchor = sp;
+	unsigned char *dp = (unsigned char *) dest;
+	unsigned char *dend = dp + dlen;
+	int			hash_bits;
+	int32		misses = 0;
+
+	/*
+	 * Size the hash table to the input, so that small inputs don't pay for
+	 * initializing the whole thing.
+	 */
+	hash_bits = LZFAST_MIN_HASH_BITS;
+	while (hash_bits < LZFAST_MAX_HASH_BITS && (1 << hash_bits) < slen)
+		hash_bits++;
+	memset(hash_table, 0xff, sizeof(int32) << hash_bits);
+
+	while (send - ip >= LZFAST_MIN_MATCH)
+	{
+		uint32		seq = lzfast_read32(ip);
+		uint32		h = lzfast_hash(seq, hash_bits);
+		int32		ref = hash_table[h];
+		int32		pos = ip - sp;
+
+		hash_table[h] = pos;
+
+		if (ref >= 0 && pos - ref <= LZFAST_MAX_OFFSET &&
+			lzfast_read32(sp + ref) == seq)
+		{
+			const unsigned char *mp = sp + ref;
+			int32		mlen = LZFAST_MIN_MATCH;
+
+			while (ip + mlen < send && ip[mlen] == mp[mlen])
+				mlen++;
+
+			dp = lzfast_emit(dp, dend, anchor, ip - anchor, ip - mp, mlen);
+			if (dp == NULL)
+				return -1;
+
+			ip += mlen;
+			anchor = ip;
+			misses = 0;
+		}
+		else
+			ip += 1 + (misses++ >> LZFAST_SKIP_TRIGGER);
+	}
+
+	/* The rest of the input goes out as literals */
+	dp = lzfast_emit(dp, dend, anchor, send - anchor, 0, 0);
+	if (dp == NULL)
+		return -1;
+
+	return (char *) dp - dest;
+}
+
+
+/* ----------
+ * lzfast_decompress -
+ *
+ *		Decompresses source into dest. Returns the number of bytes
+ *		decompressed in the destination buffer, or -1 if decompression
+ *		fails.
+ * ----------
+ */
+int32
+lzfast_decompress(const char *source, int32 slen, char *dest, int32 rawsize)
+{
+	const unsigned char *sp = (const unsigned char *) source;
+	const unsigned char *send = sp + slen;
+	unsigned char *dp = (unsigned char *) dest;
+	unsigned char *dend = dp + rawsize;
+
+	while (sp < send)
+	{
+		int			ctrl = *sp++;
+		int32		len;
+		int32		offset;
+		unsigned char b;
+
+		/* copy the literals */
+		len = ctrl >> 4;
+		if (len == 15)
+		{
+			do
+			{
+				if (sp >= send)
+					return -1;
+				b = *sp++;
+				len += b;
+			} while (b == 255 && len <= rawsize);
+		}
+		if (len > send - sp || len > dend - dp)
+			return -1;
+		memcpy(dp, sp, len);
+		dp += len;
+		sp += len;
+
+		/* the last item has no match */
+		if (sp >= send)
+			break;
+
+		/* copy the match */
+		if (send - sp < 2)
+			return -1;
+		offset = sp[0] | (sp[1] << 8);
+		sp += 2;
+		if (offset == 0 || offset > (char *) dp - dest)
+			return -1;
+
+		len = ctrl & 15;
+		if (len == 15)
+		{
+			do
+			{
+				if (sp >= send)
+					return -1;
+				b = *sp++;
+				len += b;
+			} while (b == 255 && len <= rawsize);
+		}
+		len += LZFAST_MIN_MATCH;
+		if (len > dend - dp)
+			return -1;
+
+		if (offset >= len)
+		{
+			memcpy(dp, dp - offset, len);
+			dp += len;
+		}
+		else
+		{
+			/* overlapping copy, must go byte by byte */
+			while (len-- > 0)
+			{
+				*dp = *(dp - offset);
+				dp++;
+			}
+		}
+	}
+
+	/*
+	 * Check we decompressed the right amount.
+	 */
+	if (dp != dend)
+		return -1;
+
+	return rawsize;
+}
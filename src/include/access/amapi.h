@@ -187,6 +187,8 @@ typedef struct IndexAmRoutine
 	bool		amclusterable;
 	/* does AM handle predicate locks? */
 	bool		ampredlocks;
+	/* does AM store tuple information only at block granularity? */
+	bool		amsummarizing;
 	/* type of data stored in index, or InvalidOid if variable */
 	Oid			amkeytype;
 
@@ -153,6 +153,8 @@ extern void index_parallelrescan(IndexScanDesc scan);
 extern IndexScanDesc index_beginscan_parallel(Relation heaprel,
 						 Relation indexrel, int nkeys, int norderbys,
 						 ParallelIndexScanDesc pscan);
+extern void index_setprefetch(IndexScanDesc scan);
+extern void index_prefetch_heap(IndexScanDesc scan, ItemPointer tid);
 extern ItemPointer index_getnext_tid(IndexScanDesc scan,
 				  ScanDirection direction);
 extern HeapTuple index_fetch_heap(IndexScanDesc scan);
@@ -551,6 +551,12 @@ typedef struct BTScanPosData
 	int			lastItem;		/* last valid index in items[] */
 	int			itemIndex;		/* current index in items[] */
 
+	/*
+	 * prefetchItem is the next entry whose heap page we should prefetch, if
+	 * the scan does heap prefetching (see _bt_prefetch_heap).
+	 */
+	int			prefetchItem;
+
 	BTScanPosItem items[MaxIndexTuplesPerPage]; /* MUST BE LAST */
 } BTScanPosData;
 
@@ -767,6 +773,9 @@ extern void _bt_spooldestroy(BTSpool *btspool);
 extern void _bt_spool(BTSpool *btspool, ItemPointer self,
 		  Datum *values, bool *isnull);
 extern void _bt_leafbuild(BTSpool *btspool, BTSpool *spool2);
+extern double _bt_parallel_build(Relation heap, Relation index,
+				   struct IndexInfo *indexInfo, int nworkers,
+				   double *indtuples);
 
 /*
  * prototypes for functions in nbtxlog.c
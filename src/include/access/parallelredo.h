@@ -0,0 +1,37 @@
+/*-------------------------------------------------------------------------
+ *
+ * parallelredo.h
+ *	  Replay of WAL records by background worker processes
+ *
+ * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/access/parallelredo.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PARALLELREDO_H
+#define PARALLELREDO_H
+
+#include "access/xlogreader.h"
+#include "storage/block.h"
+#include "storage/relfilenode.h"
+
+/* GUC variable */
+extern int	max_parallel_redo_workers;
+
+/* true in a parallel redo worker process */
+extern bool IsParallelRedoWorker;
+
+/* functions called by the startup process */
+extern void ParallelRedoStart(void);
+extern bool ParallelRedoDispatch(XLogReaderState *record);
+extern void ParallelRedoSync(void);
+extern void ParallelRedoEnd(void);
+
+/* functions called by parallel redo workers */
+extern void ParallelRedoWorkerMain(Datum main_arg);
+extern void ParallelRedoReportInvalidPage(RelFileNode node, ForkNumber forkno,
+							  BlockNumber blkno, bool present);
+
+#endif   /* PARALLELREDO_H */
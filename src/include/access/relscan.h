@@ -38,6 +38,7 @@ typedef struct ParallelHeapScanDescData
 	slock_t		phs_mutex;		/* mutual exclusion for block number fields */
 	BlockNumber phs_startblock; /* starting block number */
 	BlockNumber phs_cblock;		/* current block number */
+	bool		phs_snapshot_any;	/* SnapshotAny, not phs_snapshot_data? */
 	char		phs_snapshot_data[FLEXIBLE_ARRAY_MEMBER];
 }	ParallelHeapScanDescData;
 
@@ -77,6 +78,24 @@ typedef struct HeapScanDescData
 	OffsetNumber rs_vistuples[MaxHeapTuplesPerPage];	/* their offsets */
 }	HeapScanDescData;
 
+/*
+ * State for prefetching the heap pages that an index scan is about to visit,
+ * see index_prefetch_heap().  The index AM passes in the TIDs it will return
+ * next, as far ahead as it can see up to "distance" TIDs.  The last few
+ * blocks prefetched are remembered, so that runs of TIDs pointing into the
+ * same heap page cost only one prefetch request.
+ */
+#define INDEX_PREFETCH_HISTORY	8
+
+typedef struct IndexPrefetchData
+{
+	int			distance;		/* how many TIDs to look ahead */
+	bool		skip_visible;	/* index-only scan: skip all-visible pages */
+	Buffer		vmbuffer;		/* visibility map buffer, if skip_visible */
+	int			next;			/* next slot of recent[] to replace */
+	BlockNumber recent[INDEX_PREFETCH_HISTORY];		/* recently prefetched */
+} IndexPrefetchData;
+
 /*
  * We use the same IndexScanDescData structure for both amgettuple-based
  * and amgetbitmap-based index scans.  Some fields are only relevant in
@@ -128,6 +147,9 @@ typedef struct IndexScanDescData
 	/* state data for traversing HOT chains in index_getnext */
 	bool		xs_continue_hot;	/* T if must keep walking HOT chain */
 
+	/* heap prefetching state, or NULL if not prefetching */
+	IndexPrefetchData *xs_prefetch;
+
 	/* parallel index scan information, in shared memory */
 	ParallelIndexScanDesc parallel_scan;
 }	IndexScanDescData;
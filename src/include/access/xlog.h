@@ -93,11 +93,18 @@ extern PGDLLIMPORT XLogRecPtr XactLastCommitEnd;
 
 extern bool reachedConsistency;
 
+/*
+ * Upper limit for wal_insert_locks.  Some operations acquire all the
+ * insertion locks at once, so this must stay well below MAX_SIMUL_LWLOCKS.
+ */
+#define MAX_XLOGINSERT_LOCKS	128
+
 /* these variables are GUC parameters related to XLOG */
 extern int	min_wal_size;
 extern int	max_wal_size;
 extern int	wal_keep_segments;
 extern int	XLOGbuffers;
+extern int	wal_insert_locks;
 extern int	XLogArchiveTimeout;
 extern int	wal_retrieve_retry_interval;
 extern char *XLogArchiveCommand;
@@ -105,6 +112,7 @@ extern bool EnableHotStandby;
 extern bool fullPageWrites;
 extern bool wal_log_hints;
 extern bool wal_compression;
+extern bool wal_record_compression;
 extern bool log_checkpoints;
 
 extern int	CheckPointSegments;
@@ -0,0 +1,32 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogprefetch.h
+ *	  Prefetching of data blocks referenced by WAL during recovery
+ *
+ * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/access/xlogprefetch.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef XLOGPREFETCH_H
+#define XLOGPREFETCH_H
+
+#include "access/xlogreader.h"
+
+/* GUC variable */
+extern int	recovery_prefetch_distance;
+
+/* opaque type, private to xlogprefetch.c */
+typedef struct XLogPrefetcher XLogPrefetcher;
+
+extern Size XLogPrefetchShmemSize(void);
+extern void XLogPrefetchShmemInit(void);
+
+extern XLogPrefetcher *XLogPrefetcherAllocate(void);
+extern void XLogPrefetcherFree(XLogPrefetcher *prefetcher);
+extern void XLogPrefetcherReadAhead(XLogPrefetcher *prefetcher,
+						XLogReaderState *replay);
+
+#endif   /* XLOGPREFETCH_H */
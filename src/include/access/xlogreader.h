@@ -122,6 +122,7 @@ struct XLogReaderState
 	 * ----------------------------------------
 	 */
 	XLogRecord *decoded_record; /* currently decoded record */
+	uint32		decoded_len;	/* its length, after decompression */
 
 	char	   *main_data;		/* record's main data portion */
 	uint32		main_data_len;	/* main data portion's length */
@@ -165,6 +166,12 @@ struct XLogReaderState
 	char	   *readRecordBuf;
 	uint32		readRecordBufSize;
 
+	/*
+	 * Buffer for the decompressed contents of the current record, if it is
+	 * compressed; XLR_MAX_COMPRESS_LEN bytes, allocated on first use
+	 */
+	char	   *decompressBuf;
+
 	/* Buffer to hold error message */
 	char	   *errormsg_buf;
 };
@@ -193,6 +200,9 @@ extern bool DecodeXLogRecord(XLogReaderState *state, XLogRecord *record,
 				 char **errmsg);
 
 #define XLogRecGetTotalLen(decoder) ((decoder)->decoded_record->xl_tot_len)
+#define XLogRecGetDecodedLen(decoder) ((decoder)->decoded_len)
+#define XLogRecIsCompressed(decoder) \
+	(((decoder)->decoded_record->xl_info & XLR_COMPRESSED) != 0)
 #define XLogRecGetPrev(decoder) ((decoder)->decoded_record->xl_prev)
 #define XLogRecGetInfo(decoder) ((decoder)->decoded_record->xl_info)
 #define XLogRecGetRmid(decoder) ((decoder)->decoded_record->xl_rmid)
@@ -70,6 +70,24 @@ typedef struct XLogRecord
  */
 #define XLR_SPECIAL_REL_UPDATE	0x01
 
+/*
+ * If XLR_COMPRESSED is set, everything following the XLogRecord struct has
+ * been compressed with lzfast_compress().  The XLogRecord struct is then
+ * followed by the uncompressed length of the rest of the record, as an
+ * unaligned uint32, and the compressed data.  Decompressing it yields the
+ * block headers, main data header and data, exactly as they would appear in
+ * an uncompressed record.  xl_tot_len and xl_crc refer to the record as
+ * stored, that is, compressed.
+ *
+ * Records are compressed this way only if wal_record_compression is enabled,
+ * they don't include any full-page images, and the uncompressed part is
+ * between XLR_MIN_COMPRESS_LEN and XLR_MAX_COMPRESS_LEN bytes.
+ */
+#define XLR_COMPRESSED			0x04
+
+#define XLR_MIN_COMPRESS_LEN	32
+#define XLR_MAX_COMPRESS_LEN	(2 * BLCKSZ)
+
 /*
  * Header info for block data appended to an XLOG record.
  *
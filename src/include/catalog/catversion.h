@@ -53,6 +53,6 @@
  */
 
 /*							yyyymmddN */
-#define CATALOG_VERSION_NO	201701301
+#define CATALOG_VERSION_NO	201702033
 
 #endif
@@ -2776,6 +2776,8 @@ DATA(insert OID = 3099 (  pg_stat_get_wal_senders	PGNSP PGUID 12 1 10 0 0 f f f
 DESCR("statistics: information about currently active replication");
 DATA(insert OID = 3317 (  pg_stat_get_wal_receiver	PGNSP PGUID 12 1 0 0 0 f f f f f f s r 0 0 2249 "" "{23,25,3220,23,3220,23,1184,1184,3220,1184,25,25}" "{o,o,o,o,o,o,o,o,o,o,o,o}" "{pid,status,receive_start_lsn,receive_start_tli,received_lsn,received_tli,last_msg_send_time,last_msg_receipt_time,latest_end_lsn,latest_end_time,slot_name,conninfo}" _null_ _null_ pg_stat_get_wal_receiver _null_ _null_ _null_ ));
 DESCR("statistics: information about WAL receiver");
+DATA(insert OID = 6108 (  pg_stat_get_recovery_prefetch PGNSP PGUID 12 1 0 0 0 f f f f t f v s 0 0 2249 "" "{20,20,20,20,23}" "{o,o,o,o,o}" "{prefetch,hit,skip_fpw,skip_repeat,wal_distance}" _null_ _null_ pg_stat_get_recovery_prefetch _null_ _null_ _null_ ));
+DESCR("statistics: information about WAL prefetching in recovery");
 DATA(insert OID = 6118 (  pg_stat_get_subscription	PGNSP PGUID 12 1 0 0 0 f f f f f f s r 1 0 2249 "26" "{26,26,23,3220,1184,1184,3220,1184}" "{i,o,o,o,o,o,o,o}" "{subid,subid,pid,received_lsn,last_msg_send_time,last_msg_receipt_time,latest_end_lsn,latest_end_time}" _null_ _null_ pg_stat_get_subscription _null_ _null_ _null_ ));
 DESCR("statistics: information about subscription");
 DATA(insert OID = 2026 (  pg_backend_pid				PGNSP PGUID 12 1 0 0 0 f f f f t f s r 0 0 23 "" _null_ _null_ _null_ _null_ _null_ pg_backend_pid _null_ _null_ _null_ ));
@@ -2864,6 +2866,10 @@ DATA(insert OID = 3160 ( pg_stat_get_checkpoint_write_time PGNSP PGUID 12 1 0 0
 DESCR("statistics: checkpoint time spent writing buffers to disk, in milliseconds");
 DATA(insert OID = 3161 ( pg_stat_get_checkpoint_sync_time PGNSP PGUID 12 1 0 0 0 f f f f t f s r 0 0 701 "" _null_ _null_ _null_ _null_ _null_ pg_stat_get_checkpoint_sync_time _null_ _null_ _null_ ));
 DESCR("statistics: checkpoint time spent synchronizing buffers to disk, in milliseconds");
+DATA(insert OID = 6102 ( pg_stat_get_checkpoint_sync_percentile PGNSP PGUID 12 1 0 0 0 f f f f t f s r 1 0 701 "701" _null_ _null_ _null_ _null_ _null_ pg_stat_get_checkpoint_sync_percentile _null_ _null_ _null_ ));
+DESCR("statistics: checkpoint fsync latency at the given percentile, in milliseconds");
+DATA(insert OID = 6103 ( pg_stat_get_checkpoint_sync_max PGNSP PGUID 12 1 0 0 0 f f f f t f s r 0 0 701 "" _null_ _null_ _null_ _null_ _null_ pg_stat_get_checkpoint_sync_max _null_ _null_ _null_ ));
+DESCR("statistics: longest checkpoint fsync, in milliseconds");
 DATA(insert OID = 2775 ( pg_stat_get_buf_written_backend PGNSP PGUID 12 1 0 0 0 f f f f t f s r 0 0 20 "" _null_ _null_ _null_ _null_ _null_ pg_stat_get_buf_written_backend _null_ _null_ _null_ ));
 DESCR("statistics: number of buffers written by backends");
 DATA(insert OID = 3063 ( pg_stat_get_buf_fsync_backend PGNSP PGUID 12 1 0 0 0 f f f f t f s r 0 0 20 "" _null_ _null_ _null_ _null_ _null_ pg_stat_get_buf_fsync_backend _null_ _null_ _null_ ));
@@ -3078,6 +3084,10 @@ DATA(insert OID = 3329 (  pg_show_all_file_settings PGNSP PGUID 12 1 1000 0 0 f
 DESCR("show config file settings");
 DATA(insert OID = 3401 (  pg_hba_file_rules PGNSP PGUID 12 1 1000 0 0 f f f f t t v s 0 0 2249 "" "{23,25,1009,1009,25,25,25,1009,25}" "{o,o,o,o,o,o,o,o,o}" "{line_number,type,database,user_name,address,netmask,auth_method,options,error}" _null_ _null_ pg_hba_file_rules _null_ _null_ _null_ ));
 DESCR("show pg_hba.conf rules");
+DATA(insert OID = 6105 (  pg_get_shmem_numa PGNSP PGUID 12 1 10 0 0 f f f f t t v s 0 0 2249 "" "{23,23,20,20}" "{o,o,o,o}" "{node,buffers,buffer_allocs,remote_allocs}" _null_ _null_ pg_get_shmem_numa _null_ _null_ _null_ ));
+DESCR("show shared buffer pool partitions on NUMA nodes");
+DATA(insert OID = 6107 (  pg_stat_get_buffer_replacement PGNSP PGUID 12 1 0 0 0 f f f f t f v s 0 0 2249 "" "{20,20,20,20}" "{o,o,o,o}" "{evictions,probation_evictions,promotions,clean_evictions}" _null_ _null_ pg_stat_get_buffer_replacement _null_ _null_ _null_ ));
+DESCR("statistics: work of the buffer replacement policy");
 DATA(insert OID = 1371 (  pg_lock_status   PGNSP PGUID 12 1 1000 0 0 f f f f t t v s 0 0 2249 "" "{25,26,26,23,21,25,28,26,26,21,25,23,25,16,16}" "{o,o,o,o,o,o,o,o,o,o,o,o,o,o,o}" "{locktype,database,relation,page,tuple,virtualxid,transactionid,classid,objid,objsubid,virtualtransaction,pid,mode,granted,fastpath}" _null_ _null_ pg_lock_status _null_ _null_ _null_ ));
 DESCR("view system lock information");
 DATA(insert OID = 2561 (  pg_blocking_pids PGNSP PGUID 12 1 0 0 0 f f f f t f v s 1 0 1007 "23" _null_ _null_ _null_ _null_ _null_ pg_blocking_pids _null_ _null_ _null_ ));
@@ -18,6 +18,7 @@
 #include "catalog/pg_statistic.h"
 #include "catalog/pg_type.h"
 #include "nodes/parsenodes.h"
+#include "port/atomics.h"
 #include "storage/buf.h"
 #include "storage/lock.h"
 #include "utils/relcache.h"
@@ -145,6 +146,8 @@ typedef struct VacuumParams
 	int			log_min_duration;		/* minimum execution threshold in ms
 										 * at which  verbose logs are
 										 * activated, -1 to use default */
+	int			nworkers;		/* # of parallel workers to vacuum indexes
+								 * with, 0 to vacuum them serially */
 } VacuumParams;
 
 /* GUC parameters */
@@ -154,6 +157,12 @@ extern int	vacuum_freeze_min_age;
 extern int	vacuum_freeze_table_age;
 extern int	vacuum_multixact_freeze_min_age;
 extern int	vacuum_multixact_freeze_table_age;
+extern bool vacuum_eager_freeze;
+
+/* cost-based delay state of a parallel vacuum, see vacuum_delay_point */
+extern pg_atomic_uint32 *VacuumSharedCostBalance;
+extern pg_atomic_uint32 *VacuumActiveNWorkers;
+extern int	VacuumCostBalanceLocal;
 
 
 /* in commands/vacuum.c */
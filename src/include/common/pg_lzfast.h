@@ -0,0 +1,23 @@
+/* ----------
+ * pg_lzfast.h -
+ *
+ *	Definitions for the builtin fast LZ compressor
+ *
+ * src/include/common/pg_lzfast.h
+ * ----------
+ */
+
+#ifndef _PG_LZFAST_H_
+#define _PG_LZFAST_H_
+
+
+/* ----------
+ * Global function declarations
+ * ----------
+ */
+extern int32 lzfast_compress(const char *source, int32 slen, char *dest,
+				int32 dlen);
+extern int32 lzfast_decompress(const char *source, int32 slen, char *dest,
+				  int32 rawsize);
+
+#endif   /* _PG_LZFAST_H_ */
@@ -0,0 +1,149 @@
+/*-------------------------------------------------------------------------
+ *
+ * execExpr.h
+ *	  Low level infrastructure related to flattened expression evaluation
+ *
+ *
+ * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/executor/execExpr.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXEC_EXPR_H
+#define EXEC_EXPR_H
+
+#include "nodes/execnodes.h"
+
+/*
+ * Discriminator for ExprEvalSteps.
+ *
+ * Identifies the operation to be executed and which member in the
+ * ExprEvalStep->d union is valid.
+ *
+ * The order of entries needs to be kept in sync with the dispatch_table[]
+ * array in execExprInterp.c:ExecInterpExpr().
+ */
+typedef enum ExprEvalOp
+{
+	/* entire expression has been evaluated completely, return */
+	EEOP_DONE,
+
+	/* apply slot_getsomeattrs on corresponding tuple slot */
+	EEOP_INNER_FETCHSOME,
+	EEOP_OUTER_FETCHSOME,
+	EEOP_SCAN_FETCHSOME,
+
+	/*
+	 * Compute non-system Var value from already-deformed slot.  The _FIRST
+	 * variants are emitted by ExecCompileExpr; on their first execution they
+	 * check the Var against the slot and replace themselves with the plain
+	 * variant (or with EEOP_CONST, for a dropped column).
+	 */
+	EEOP_INNER_VAR_FIRST,
+	EEOP_INNER_VAR,
+	EEOP_OUTER_VAR_FIRST,
+	EEOP_OUTER_VAR,
+	EEOP_SCAN_VAR_FIRST,
+	EEOP_SCAN_VAR,
+
+	/* evaluate a Const */
+	EEOP_CONST,
+
+	/*
+	 * Evaluate function call (including OpExprs etc).  EEOP_FUNCEXPR is
+	 * emitted by ExecCompileExpr; the first evaluation replaces it with
+	 * EEOP_FUNCEXPR_STRICT if the function turns out to be strict.
+	 */
+	EEOP_FUNCEXPR,
+	EEOP_FUNCEXPR_STRICT,
+
+	/*
+	 * Evaluate boolean AND expression, one step per subexpression. FIRST/LAST
+	 * subexpressions are special-cased for performance.
+	 */
+	EEOP_BOOL_AND_STEP_FIRST,
+	EEOP_BOOL_AND_STEP,
+	EEOP_BOOL_AND_STEP_LAST,
+
+	/* similarly for boolean OR expression */
+	EEOP_BOOL_OR_STEP_FIRST,
+	EEOP_BOOL_OR_STEP,
+	EEOP_BOOL_OR_STEP_LAST,
+
+	/* evaluate boolean NOT expression */
+	EEOP_BOOL_NOT_STEP,
+
+	/* non-existent operation, used e.g. to check array lengths */
+	EEOP_LAST
+} ExprEvalOp;
+
+
+typedef struct ExprEvalStep
+{
+	/*
+	 * Instruction to be executed.  During instruction preparation this is an
+	 * ExprEvalOp, but once the expression has been readied for execution it
+	 * may be replaced with the address of the code implementing the
+	 * instruction (see EEO_USE_COMPUTED_GOTO in execExprInterp.c).
+	 */
+	intptr_t	opcode;
+
+	/* where to store the result of this step */
+	Datum	   *resvalue;
+	bool	   *resnull;
+
+	/*
+	 * Inline data for the operation.  Inline data is faster to access, but
+	 * also bloats the size of all instructions.  The union should be kept to
+	 * no more than 32 bytes on 64-bit systems.
+	 */
+	union
+	{
+		/* for EEOP_INNER/OUTER/SCAN_FETCHSOME */
+		struct
+		{
+			/* attribute number up to which to fetch (inclusive) */
+			int			last_var;
+		}			fetch;
+
+		/* for EEOP_INNER/OUTER/SCAN_VAR[_FIRST] */
+		struct
+		{
+			/* attnum is attr number - 1, for convenience */
+			int			attnum;
+			/* original Var, used for the one-time type check */
+			Var		   *var;
+		}			var;
+
+		/* for EEOP_CONST */
+		struct
+		{
+			/* constant's value */
+			Datum		value;
+			bool		isnull;
+		}			constval;
+
+		/* for EEOP_FUNCEXPR and EEOP_FUNCEXPR_STRICT */
+		struct
+		{
+			Expr	   *expr;	/* FuncExpr or OpExpr being called */
+			FmgrInfo   *finfo;	/* function's lookup data */
+			FunctionCallInfo fcinfo_data;		/* arguments etc */
+			int			nargs;	/* number of arguments */
+		}			func;
+
+		/* for EEOP_BOOL_*_STEP */
+		struct
+		{
+			bool	   *anynull;	/* track if any input was NULL */
+			int			jumpdone;	/* jump here if result determined */
+		}			boolexpr;
+	}			d;
+} ExprEvalStep;
+
+
+extern ExprState *ExecCompileExpr(Expr *node);
+
+#endif   /* EXEC_EXPR_H */
@@ -16,6 +16,10 @@
 
 #include "nodes/execnodes.h"
 #include "storage/buffile.h"
+#include "storage/condition_variable.h"
+#include "storage/sharedfileset.h"
+#include "storage/spin.h"
+#include "utils/dsa.h"
 
 /* ----------------------------------------------------------------
  *				hash-join hash table structures
@@ -54,6 +58,18 @@
  * inner batch file.  Subsequently, while reading either inner or outer batch
  * files, we might find tuples that no longer belong to the current batch;
  * if so, we just dump them out to the correct batch file.
+ *
+ * Parallel-aware hash joins instead build a single hash table in the query's
+ * dynamic shared memory area, which all participating processes fill
+ * together and then probe.  In that case the bucket array, the tuples and
+ * the chunks that hold them live in DSA memory and are linked together with
+ * dsa_pointers, and the control block holds only backend-private copies of
+ * the shared sizing information.  A shared hash table always has exactly one
+ * batch, and may use at most work_mem.  If the inner relation turns out not
+ * to fit, the remaining inner tuples are written to shared temporary files
+ * instead, and each participant then loads all of them into an ordinary
+ * private hash table, which can have multiple batches as described above;
+ * see ParallelHashJoinState below.
  * ----------------------------------------------------------------
  */
 
@@ -63,7 +79,12 @@
 
 typedef struct HashJoinTupleData
 {
-	struct HashJoinTupleData *next;		/* link to next tuple in same bucket */
+	/* link to next tuple in same bucket */
+	union
+	{
+		struct HashJoinTupleData *unshared;
+		dsa_pointer shared;
+	}			next;
 	uint32		hashvalue;		/* tuple's hash code */
 	/* Tuple data, in MinimalTuple format, follows on a MAXALIGN boundary */
 }	HashJoinTupleData;
@@ -112,8 +133,12 @@ typedef struct HashMemoryChunkData
 	size_t		maxlen;			/* size of the buffer holding the tuples */
 	size_t		used;			/* number of buffer bytes already used */
 
-	struct HashMemoryChunkData *next;	/* pointer to the next chunk (linked
-										 * list) */
+	/* pointer to the next chunk (linked list) */
+	union
+	{
+		struct HashMemoryChunkData *unshared;
+		dsa_pointer shared;
+	}			next;
 
 	char		data[FLEXIBLE_ARRAY_MEMBER];	/* buffer allocated at the end */
 }	HashMemoryChunkData;
@@ -121,8 +146,60 @@ typedef struct HashMemoryChunkData
 typedef struct HashMemoryChunkData *HashMemoryChunk;
 
 #define HASH_CHUNK_SIZE			(32 * 1024L)
+#define HASH_CHUNK_HEADER_SIZE	(offsetof(HashMemoryChunkData, data))
 #define HASH_CHUNK_THRESHOLD	(HASH_CHUNK_SIZE / 4)
 
+/*
+ * State of a shared hash table build.
+ *
+ *		PHJ_BUILD_HASHING	participants are inserting inner tuples; any
+ *							process that reaches the hash join now attaches
+ *							and helps
+ *		PHJ_BUILD_GROWING	the last participant to finish hashing is
+ *							enlarging the bucket array; nobody may attach
+ *		PHJ_BUILD_DONE		all attached participants have finished, the
+ *							table is complete and may be probed
+ */
+typedef enum
+{
+	PHJ_BUILD_HASHING,
+	PHJ_BUILD_GROWING,
+	PHJ_BUILD_DONE
+} ParallelHashBuildState;
+
+/*
+ * Shared state for a parallel-aware hash join, kept in the DSM segment.
+ *
+ * The bucket array and the chunks are allocated in the query's DSA area.
+ * Inserting into a bucket is done with a compare-and-swap on the bucket's
+ * head pointer, so participants don't need any lock while hashing; the
+ * mutex protects only the counters, the chunk list and the build state.
+ * Processes that finish hashing wait on the condition variable until the
+ * last attached participant has finished too.
+ *
+ * Chunks may only be allocated while space_used stays within space_allowed.
+ * Once that fails, overflowed is set, and each participant writes the inner
+ * tuples it can't fit into chunks to an overflow file of its own in fileset
+ * (named by ExecParallelHashOverflowFileName, numbered from 0 to nfiles - 1).
+ */
+typedef struct ParallelHashJoinState
+{
+	dsa_pointer buckets;		/* array of dsa_pointer_atomic */
+	int			nbuckets;		/* # buckets in the shared table */
+	int			log2_nbuckets;	/* its log2 */
+	dsa_pointer chunks;			/* list of all chunks holding tuples */
+	ParallelHashBuildState build_state; /* see above */
+	int			nparticipants;	/* # processes currently hashing */
+	double		total_tuples;	/* # tuples inserted so far */
+	Size		space_used;		/* memory used by chunks and buckets */
+	Size		space_allowed;	/* upper limit for space_used */
+	bool		overflowed;		/* did the inner relation not fit? */
+	int			nfiles;			/* # overflow files created */
+	slock_t		mutex;			/* protects all of the above */
+	ConditionVariable build_cv; /* signaled when build_state changes */
+	SharedFileSet fileset;		/* holds the overflow files */
+} ParallelHashJoinState;
+
 typedef struct HashJoinTableData
 {
 	int			nbuckets;		/* # buckets in the in-memory hash table */
@@ -134,8 +211,13 @@ typedef struct HashJoinTableData
 	int			log2_nbuckets_optimal;	/* log2(nbuckets_optimal) */
 
 	/* buckets[i] is head of list of tuples in i'th in-memory bucket */
-	struct HashJoinTupleData **buckets;
-	/* buckets array is per-batch storage, as are all the tuples */
+	union
+	{
+		/* unshared array is per-batch storage, as are all the tuples */
+		struct HashJoinTupleData **unshared;
+		/* shared array is per-query DSA area, as are all the tuples */
+		dsa_pointer_atomic *shared;
+	}			buckets;
 
 	bool		keepNulls;		/* true to store unmatchable NULL tuples */
 
@@ -186,6 +268,13 @@ typedef struct HashJoinTableData
 
 	/* used for dense allocation of tuples (into linked chunks) */
 	HashMemoryChunk chunks;		/* one list for the whole batch */
+
+	/* used only for a parallel-aware (shared) hash table */
+	dsa_area   *area;			/* the query's DSA area */
+	ParallelHashJoinState *parallel_state;		/* shared control state */
+	HashMemoryChunk current_chunk;	/* this backend's chunk being filled */
+	dsa_pointer current_chunk_shared;	/* DSA address of current_chunk */
+	BufFile    *overflow_file;	/* this backend's overflow file, if any */
 }	HashJoinTableData;
 
 #endif   /* HASHJOIN_H */
@@ -16,6 +16,7 @@
 
 #include "access/parallel.h"
 #include "nodes/execnodes.h"
+#include "storage/latch.h"
 
 extern ForeignScanState *ExecInitForeignScan(ForeignScan *node, EState *estate, int eflags);
 extern TupleTableSlot *ExecForeignScan(ForeignScanState *node);
@@ -29,4 +30,9 @@ extern void ExecForeignScanInitializeDSM(ForeignScanState *node,
 extern void ExecForeignScanInitializeWorker(ForeignScanState *node,
 								shm_toc *toc);
 
+extern bool ExecForeignScanAsyncCapable(ForeignScanState *node);
+extern void ExecAsyncForeignScanConfigureWait(ForeignScanState *node,
+								  WaitEventSet *set);
+extern void ExecAsyncForeignScanNotify(ForeignScanState *node);
+
 #endif   /* NODEFOREIGNSCAN_H */
@@ -21,6 +21,7 @@
 #include "lib/pairingheap.h"
 #include "nodes/params.h"
 #include "nodes/plannodes.h"
+#include "storage/condition_variable.h"
 #include "utils/hsearch.h"
 #include "utils/reltrigger.h"
 #include "utils/sortsupport.h"
@@ -594,6 +595,24 @@ struct ExprState
 	ExprStateEvalFunc evalfunc; /* routine to run to execute node */
 };
 
+/* ----------------
+ *		CompiledExprState node
+ *
+ * An expression subtree that ExecCompileExpr has flattened into a linear
+ * array of steps (see executor/execExpr.h).  The steps are run by a single
+ * interpreter loop, rather than by recursing through per-node evalfuncs.
+ * ----------------
+ */
+typedef struct CompiledExprState
+{
+	ExprState	xprstate;
+	struct ExprEvalStep *steps; /* array of execution steps */
+	int			steps_len;		/* number of steps currently in use */
+	int			steps_alloc;	/* allocated length of steps array */
+	Datum		resvalue;		/* value of the whole expression */
+	bool		resnull;
+} CompiledExprState;
+
 /* ----------------
  *		GenericExprState node
  *
@@ -1178,6 +1197,11 @@ typedef struct ModifyTableState
  *
  *		nplans			how many plans are in the array
  *		whichplan		which plan is being executed (0 .. n-1)
+ *		nasyncplans		how many of the plans are run asynchronously
+ *		asyncplans		is each plan run asynchronously?
+ *		asyncdone		has each asynchronous plan returned EOF?
+ *		nasyncremaining	how many asynchronous plans are not done yet
+ *		asyncnext		asynchronous plan to try first for the next tuple
  * ----------------
  */
 typedef struct AppendState
@@ -1186,6 +1210,11 @@ typedef struct AppendState
 	PlanState **appendplans;	/* array of PlanStates for my inputs */
 	int			as_nplans;
 	int			as_whichplan;
+	int			as_nasyncplans;
+	bool	   *as_asyncplans;
+	bool	   *as_asyncdone;
+	int			as_nasyncremaining;
+	int			as_asyncnext;
 } AppendState;
 
 /* ----------------
@@ -1455,6 +1484,50 @@ typedef struct BitmapIndexScanState
 	IndexScanDesc biss_ScanDesc;
 } BitmapIndexScanState;
 
+/* ----------------
+ *	 SharedBitmapState information
+ *
+ *		BM_INITIAL		TIDBitmap creation is not yet started, so first worker
+ *						to see this state will set the state to BM_INPROGRESS
+ *						and that process will be responsible for creating
+ *						TIDBitmap.
+ *		BM_INPROGRESS	TIDBitmap creation is in progress; workers need to
+ *						sleep until it's finished.
+ *		BM_FINISHED		TIDBitmap creation is done, so now all workers can
+ *						proceed to iterate over TIDBitmap.
+ * ----------------
+ */
+typedef enum
+{
+	BM_INITIAL,
+	BM_INPROGRESS,
+	BM_FINISHED
+} SharedBitmapState;
+
+/* ----------------
+ *	 ParallelBitmapHeapState information
+ *
+ *		tbmiterator		   shared iterator for scanning current pages
+ *		prefetch_iterator  shared iterator for prefetching ahead of current page
+ *		mutex			   mutual exclusion for the prefetching variables
+ *						   and state
+ *		prefetch_pages	   # pages prefetch iterator is ahead of current
+ *		prefetch_target    current target prefetch distance
+ *		state			   current state of the TIDBitmap
+ *		cv				   condition variable to wait for bitmap creation
+ * ----------------
+ */
+typedef struct ParallelBitmapHeapState
+{
+	dsa_pointer tbmiterator;
+	dsa_pointer prefetch_iterator;
+	slock_t		mutex;
+	int			prefetch_pages;
+	int			prefetch_target;
+	SharedBitmapState state;
+	ConditionVariable cv;
+} ParallelBitmapHeapState;
+
 /* ----------------
  *	 BitmapHeapScanState information
  *
@@ -1468,6 +1541,10 @@ typedef struct BitmapIndexScanState
  *		prefetch_pages	   # pages prefetch iterator is ahead of current
  *		prefetch_target    current target prefetch distance
  *		prefetch_maximum   maximum value for prefetch_target
+ *		initialized		   is node ready to iterate
+ *		shared_tbmiterator	   shared iterator
+ *		shared_prefetch_iterator shared iterator for prefetching
+ *		pstate			   shared state for parallel bitmap scan
  * ----------------
  */
 typedef struct BitmapHeapScanState
@@ -1483,6 +1560,10 @@ typedef struct BitmapHeapScanState
 	int			prefetch_pages;
 	int			prefetch_target;
 	int			prefetch_maximum;
+	bool		initialized;
+	TBMSharedIterator *shared_tbmiterator;
+	TBMSharedIterator *shared_prefetch_iterator;
+	ParallelBitmapHeapState *pstate;
 } BitmapHeapScanState;
 
 /* ----------------
@@ -1497,7 +1578,7 @@ typedef struct BitmapHeapScanState
 typedef struct TidScanState
 {
 	ScanState	ss;				/* its first field is NodeTag */
-	List	   *tss_tidquals;	/* list of ExprState nodes */
+	List	   *tss_tidquals;	/* list of ExprState nodes, or NULLs */
 	bool		tss_isCurrentOf;
 	int			tss_NumTids;
 	int			tss_TidPtr;
@@ -1616,6 +1697,12 @@ typedef struct WorkTableScanState
  *	 ForeignScanState information
  *
  *		ForeignScan nodes are used to scan foreign-data tables.
+ *
+ *		async_mode is set by a parent Append that runs the scan
+ *		asynchronously.  In that mode the FDW may return an empty slot
+ *		before the end of the scan, setting async_waiting to say that it
+ *		is only waiting for the remote side; it clears async_waiting again
+ *		once its ForeignAsyncNotify callback has received the data.
  * ----------------
  */
 typedef struct ForeignScanState
@@ -1623,6 +1710,8 @@ typedef struct ForeignScanState
 	ScanState	ss;				/* its first field is NodeTag */
 	List	   *fdw_recheck_quals;		/* original quals not in ss.ps.qual */
 	Size		pscan_len;		/* size of parallel coordination information */
+	bool		async_mode;		/* executing asynchronously? */
+	bool		async_waiting;	/* no tuple ready yet, but not EOF either */
 	/* use struct pointer to avoid including fdwapi.h here */
 	struct FdwRoutine *fdwroutine;
 	void	   *fdw_state;		/* foreign-data wrapper can keep state here */
@@ -2003,6 +2092,36 @@ typedef struct GatherState
 	bool		need_to_scan_locally;
 } GatherState;
 
+/* ----------------
+ * GatherMergeState information
+ *
+ *		Gather merge nodes launch 1 or more parallel workers, run a
+ *		subplan which produces sorted output in each worker, and then
+ *		merge the results into a single sorted stream.
+ * ----------------
+ */
+struct GMReaderTupleBuffer;		/* private in nodeGatherMerge.c */
+
+typedef struct GatherMergeState
+{
+	PlanState	ps;				/* its first field is NodeTag */
+	bool		initialized;	/* workers launched? */
+	bool		gm_initialized; /* gather_merge_init() done? */
+	bool		need_to_scan_locally;	/* need to read from local plan? */
+	/* these fields are set up once: */
+	TupleDesc	tupDesc;		/* descriptor for subplan result tuples */
+	int			gm_nkeys;		/* number of sort columns */
+	SortSupport gm_sortkeys;	/* array of length gm_nkeys */
+	struct ParallelExecutorInfo *pei;
+	/* all remaining fields are reinitialized during a rescan */
+	int			nworkers_launched;	/* original number of workers */
+	int			nreaders;		/* number of active workers */
+	TupleTableSlot **gm_slots;	/* array with nreaders+1 entries */
+	struct TupleQueueReader **reader;	/* array with nreaders active entries */
+	struct GMReaderTupleBuffer *gm_tuple_buffers;	/* nreaders tuple buffers */
+	struct binaryheap *gm_heap; /* binary heap of slot indices */
+} GatherMergeState;
+
 /* ----------------
  *	 HashState information
  * ----------------
@@ -2013,6 +2132,8 @@ typedef struct HashState
 	HashJoinTable hashtable;	/* hash table for the hashjoin */
 	List	   *hashkeys;		/* list of ExprState nodes */
 	/* hashkeys is same as parent's hj_InnerHashKeys */
+	struct ParallelHashJoinState *parallel_state;	/* shared state, if
+													 * parallel-aware */
 } HashState;
 
 /* ----------------
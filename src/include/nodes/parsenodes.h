@@ -2983,6 +2983,7 @@ typedef struct VacuumStmt
 	int			options;		/* OR of VacuumOption flags */
 	RangeVar   *relation;		/* single table to process, or NULL */
 	List	   *va_cols;		/* list of column names, or NIL for all */
+	int			nworkers;		/* # of parallel workers for indexes */
 } VacuumStmt;
 
 /* ----------------------
@@ -23,6 +23,9 @@
 #define TIDBITMAP_H
 
 #include "storage/itemptr.h"
+#ifndef FRONTEND
+#include "utils/dsa.h"
+#endif
 
 
 /*
@@ -33,6 +36,7 @@ typedef struct TIDBitmap TIDBitmap;
 
 /* Likewise, TBMIterator is private */
 typedef struct TBMIterator TBMIterator;
+typedef struct TBMSharedIterator TBMSharedIterator;
 
 /* Result structure for tbm_iterate */
 typedef struct
@@ -44,10 +48,17 @@ typedef struct
 	OffsetNumber offsets[FLEXIBLE_ARRAY_MEMBER];
 } TBMIterateResult;
 
-/* function prototypes in nodes/tidbitmap.c */
+/*
+ * function prototypes in nodes/tidbitmap.c
+ *
+ * These are hidden from frontend code, which gets here by way of the index AM
+ * headers (for the WAL record definitions) but can't include dsa.h.
+ */
+#ifndef FRONTEND
 
-extern TIDBitmap *tbm_create(long maxbytes);
+extern TIDBitmap *tbm_create(long maxbytes, dsa_area *dsa);
 extern void tbm_free(TIDBitmap *tbm);
+extern void tbm_free_shared_area(dsa_area *dsa, dsa_pointer dp);
 
 extern void tbm_add_tuples(TIDBitmap *tbm,
 			   const ItemPointer tids, int ntids,
@@ -60,7 +71,14 @@ extern void tbm_intersect(TIDBitmap *a, const TIDBitmap *b);
 extern bool tbm_is_empty(const TIDBitmap *tbm);
 
 extern TBMIterator *tbm_begin_iterate(TIDBitmap *tbm);
+extern dsa_pointer tbm_prepare_shared_iterate(TIDBitmap *tbm);
 extern TBMIterateResult *tbm_iterate(TBMIterator *iterator);
+extern TBMIterateResult *tbm_shared_iterate(TBMSharedIterator *iterator);
 extern void tbm_end_iterate(TBMIterator *iterator);
+extern void tbm_end_shared_iterate(TBMSharedIterator *iterator);
+extern TBMSharedIterator *tbm_attach_shared_iterate(dsa_area *dsa,
+						  dsa_pointer dp);
+
+#endif   /* FRONTEND */
 
 #endif   /* TIDBITMAP_H */
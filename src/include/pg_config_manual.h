@@ -236,6 +236,14 @@
  */
 #define PG_CACHE_LINE_SIZE		128
 
+/*
+ * Alignment of buffers used for direct I/O (see direct_io).  Kernels require
+ * the memory address, file offset and length of each O_DIRECT transfer to be
+ * a multiple of the device's logical block size, which is at most 4kB on
+ * common hardware.  The shared buffer pool is aligned to this.
+ */
+#define PG_IO_ALIGN_SIZE		4096
+
 /*
  *------------------------------------------------------------------------
  * The following symbols are for enabling debugging code, not for
@@ -402,6 +402,13 @@ typedef struct PgStat_MsgArchiver
 	TimestampTz m_timestamp;
 } PgStat_MsgArchiver;
 
+/*
+ * Checkpoint fsync latencies are kept as a histogram with power-of-two
+ * buckets: bucket i counts fsyncs that took less than 2^(i+1) microseconds
+ * (and, except for bucket 0, at least 2^i).
+ */
+#define PGSTAT_SYNC_HIST_BUCKETS	32
+
 /* ----------
  * PgStat_MsgBgWriter			Sent by the bgwriter to update statistics.
  * ----------
@@ -420,6 +427,8 @@ typedef struct PgStat_MsgBgWriter
 	PgStat_Counter m_buf_alloc;
 	PgStat_Counter m_checkpoint_write_time;		/* times in milliseconds */
 	PgStat_Counter m_checkpoint_sync_time;
+	PgStat_Counter m_checkpoint_sync_hist[PGSTAT_SYNC_HIST_BUCKETS];
+	PgStat_Counter m_checkpoint_sync_max;		/* in microseconds */
 } PgStat_MsgBgWriter;
 
 /* ----------
@@ -566,7 +575,7 @@ typedef union PgStat_Msg
  * ------------------------------------------------------------
  */
 
-#define PGSTAT_FILE_FORMAT_ID	0x01A5BC9D
+#define PGSTAT_FILE_FORMAT_ID	0x01A5BC9F
 
 /* ----------
  * PgStat_StatDBEntry			The collector's data per database
@@ -629,6 +638,7 @@ typedef struct PgStat_StatTabEntry
 	PgStat_Counter n_live_tuples;
 	PgStat_Counter n_dead_tuples;
 	PgStat_Counter changes_since_analyze;
+	PgStat_Counter inserts_since_vacuum;
 
 	PgStat_Counter blocks_fetched;
 	PgStat_Counter blocks_hit;
@@ -691,6 +701,8 @@ typedef struct PgStat_GlobalStats
 	PgStat_Counter buf_written_backend;
 	PgStat_Counter buf_fsync_backend;
 	PgStat_Counter buf_alloc;
+	PgStat_Counter checkpoint_sync_hist[PGSTAT_SYNC_HIST_BUCKETS];
+	PgStat_Counter checkpoint_sync_max;	/* in microseconds */
 	TimestampTz stat_reset_timestamp;
 } PgStat_GlobalStats;
 
@@ -778,7 +790,8 @@ typedef enum
  */
 typedef enum
 {
-	WAIT_EVENT_BGWORKER_SHUTDOWN = PG_WAIT_IPC,
+	WAIT_EVENT_APPEND_READY = PG_WAIT_IPC,
+	WAIT_EVENT_BGWORKER_SHUTDOWN,
 	WAIT_EVENT_BGWORKER_STARTUP,
 	WAIT_EVENT_EXECUTE_GATHER,
 	WAIT_EVENT_MQ_INTERNAL,
@@ -786,6 +799,8 @@ typedef enum
 	WAIT_EVENT_MQ_RECEIVE,
 	WAIT_EVENT_MQ_SEND,
 	WAIT_EVENT_PARALLEL_FINISH,
+	WAIT_EVENT_PARALLEL_BITMAP_SCAN,
+	WAIT_EVENT_PARALLEL_HASH_BUILD,
 	WAIT_EVENT_SAFE_SNAPSHOT,
 	WAIT_EVENT_SYNC_REP
 } WaitEventIPC;
@@ -1200,6 +1215,7 @@ extern void pgstat_twophase_postabort(TransactionId xid, uint16 info,
 
 extern void pgstat_send_archiver(const char *xlog, bool failed);
 extern void pgstat_send_bgwriter(void);
+extern void pgstat_count_checkpoint_sync(uint64 elapsed_us);
 
 /* ----------
  * Support functions for the SQL-callable functions to
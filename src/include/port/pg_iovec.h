@@ -0,0 +1,39 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_iovec.h
+ *	  Header for the vectored I/O functions in fd.c.
+ *
+ * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/port/pg_iovec.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PG_IOVEC_H
+#define PG_IOVEC_H
+
+#include <limits.h>
+
+#ifndef WIN32
+#include <sys/uio.h>
+#else
+/* Windows has no readv/writev; fd.c emulates them with this struct */
+struct iovec
+{
+	void	   *iov_base;
+	size_t		iov_len;
+};
+#endif
+
+/*
+ * Maximum number of buffers passed to one vectored read or write.  POSIX
+ * only promises 16, but all platforms we care about allow far more.
+ */
+#if defined(IOV_MAX) && IOV_MAX < 32
+#define PG_IOV_MAX IOV_MAX
+#else
+#define PG_IOV_MAX 32
+#endif
+
+#endif   /* PG_IOVEC_H */
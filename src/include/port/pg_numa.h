@@ -0,0 +1,29 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_numa.h
+ *	  Basic NUMA (non-uniform memory access) support.
+ *
+ * These routines let the backend find out about the machine's NUMA nodes
+ * and control on which node ranges of shared memory are placed.  On
+ * platforms without NUMA support they report a single node and placement
+ * requests are no-ops.
+ *
+ * Portions Copyright (c) 1996-2017, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/port/pg_numa.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PG_NUMA_H
+#define PG_NUMA_H
+
+/* highest number of NUMA nodes we can deal with */
+#define PG_NUMA_MAX_NODES	1024
+
+extern int	pg_numa_get_nodes(int *nodes, int maxnodes);
+extern int	pg_numa_current_node(void);
+extern int	pg_numa_interleave(void *ptr, Size size, Size pagesize);
+extern int	pg_numa_bind(void *ptr, Size size, Size pagesize, int node);
+
+#endif   /* PG_NUMA_H */
@@ -311,11 +311,22 @@ extern BufferDesc *StrategyGetBuffer(BufferAccessStrategy strategy,
 extern void StrategyFreeBuffer(BufferDesc *buf);
 extern bool StrategyRejectBuffer(BufferAccessStrategy strategy,
 					 BufferDesc *buf);
-
-extern int	StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc);
+extern int	StrategyMaxReadBlocks(BufferAccessStrategy strategy);
+extern void StrategyBufferRenamed(BufferDesc *buf, bool evicted,
+					  uint32 oldHash, uint32 newHash);
+
+extern int	StrategyNumPartitions(void);
+extern void StrategyPartitionBuffers(int partition, int *first_buffer,
+						 int *num_buffers);
+extern int	StrategySyncStart(int partition, uint32 *complete_passes,
+				  uint32 *num_buf_alloc);
+extern int	StrategyCleanSweep(int partition);
+extern int	StrategyCleanBufferCount(int partition);
+extern bool StrategyPushCleanBuffer(int partition, int buf_id);
 extern void StrategyNotifyBgWriter(int bgwprocno);
 
 extern Size StrategyShmemSize(void);
+extern void StrategyPlaceBuffers(void);
 extern void StrategyInitialize(bool init);
 
 /* buf_table.c */
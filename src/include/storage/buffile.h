@@ -30,6 +30,9 @@
 
 typedef struct BufFile BufFile;
 
+/* SharedFileSet is defined in storage/sharedfileset.h */
+struct SharedFileSet;
+
 /*
  * prototypes for functions in buffile.c
  */
@@ -41,5 +44,12 @@ extern size_t BufFileWrite(BufFile *file, void *ptr, size_t size);
 extern int	BufFileSeek(BufFile *file, int fileno, off_t offset, int whence);
 extern void BufFileTell(BufFile *file, int *fileno, off_t *offset);
 extern int	BufFileSeekBlock(BufFile *file, long blknum);
+extern long BufFileNumBlocks(BufFile *file);
+
+extern BufFile *BufFileCreateShared(struct SharedFileSet *fileset, const char *name);
+extern void BufFileExportShared(BufFile *file);
+extern BufFile *BufFileOpenShared(struct SharedFileSet *fileset, const char *name);
+extern void BufFileDeleteShared(struct SharedFileSet *fileset, const char *name);
+extern long BufFileAppend(BufFile *target, BufFile *source);
 
 #endif   /* BUFFILE_H */
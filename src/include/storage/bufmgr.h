@@ -34,6 +34,13 @@ typedef enum BufferAccessStrategyType
 	BAS_VACUUM					/* VACUUM */
 } BufferAccessStrategyType;
 
+/* Possible values of buffer_replacement_policy */
+typedef enum BufferReplacementPolicy
+{
+	BUFFER_REPLACEMENT_CLOCK,	/* Clock sweep over the whole pool */
+	BUFFER_REPLACEMENT_2Q		/* New pages go through a FIFO first */
+} BufferReplacementPolicy;
+
 /* Possible modes for ReadBufferExtended() */
 typedef enum
 {
@@ -50,6 +57,9 @@ typedef enum
 /* forward declared, to avoid having to expose buf_internals.h here */
 struct WritebackContext;
 
+/* forward declared, to avoid including smgr.h here */
+struct SMgrRelationData;
+
 /* in globals.c ... this duplicates miscadmin.h */
 extern PGDLLIMPORT int NBuffers;
 
@@ -63,10 +73,14 @@ extern int	target_prefetch_pages;
 extern int	checkpoint_flush_after;
 extern int	backend_flush_after;
 extern int	bgwriter_flush_after;
+extern int	io_combine_limit;
 
 /* in buf_init.c */
 extern PGDLLIMPORT char *BufferBlocks;
 
+/* in freelist.c */
+extern int	buffer_replacement_policy;
+
 /* in guc.c */
 extern int	effective_io_concurrency;
 
@@ -78,6 +92,9 @@ extern PGDLLIMPORT int32 *LocalRefCount;
 /* upper limit for effective_io_concurrency */
 #define MAX_IO_CONCURRENCY 1000
 
+/* upper limit for io_combine_limit; should not exceed PG_IOV_MAX */
+#define MAX_IO_COMBINE_LIMIT 32
+
 /* special block number for ReadBuffer() */
 #define P_NEW	InvalidBlockNumber		/* grow the file to get a new page */
 
@@ -165,6 +182,8 @@ extern PGDLLIMPORT int32 *LocalRefCount;
 extern bool ComputeIoConcurrency(int io_concurrency, double *target);
 extern void PrefetchBuffer(Relation reln, ForkNumber forkNum,
 			   BlockNumber blockNum);
+extern bool PrefetchSharedBuffer(struct SMgrRelationData *smgr_reln,
+					 ForkNumber forkNum, BlockNumber blockNum);
 extern Buffer ReadBuffer(Relation reln, BlockNumber blockNum);
 extern Buffer ReadBufferExtended(Relation reln, ForkNumber forkNum,
 				   BlockNumber blockNum, ReadBufferMode mode,
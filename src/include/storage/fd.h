@@ -50,9 +50,16 @@ typedef char *FileName;
 
 typedef int File;
 
+struct iovec;					/* see port/pg_iovec.h */
 
-/* GUC parameter */
+
+/* GUC parameters */
 extern int	max_files_per_process;
+extern int	direct_io;
+
+/* direct_io flags: which kinds of files bypass the kernel's page cache */
+#define DIRECT_IO_DATA		0x01	/* relation data files */
+#define DIRECT_IO_WAL		0x02	/* WAL segment files */
 
 /*
  * This is private to fd.c, but exported for save/restore_backend_variables()
@@ -67,10 +74,18 @@ extern int	max_safe_fds;
 /* Operations on virtual Files --- equivalent to Unix kernel file ops */
 extern File PathNameOpenFile(FileName fileName, int fileFlags, int fileMode);
 extern File OpenTemporaryFile(bool interXact);
+extern File PathNameCreateTemporaryFile(const char *name, bool error_on_failure);
+extern File PathNameOpenTemporaryFile(const char *name);
+extern bool PathNameDeleteTemporaryFile(const char *name, bool error_on_failure);
+extern void PathNameCreateTemporaryDir(const char *base, const char *name);
+extern void PathNameDeleteTemporaryDir(const char *name);
+extern void TempTablespacePath(char *path, Oid tablespace);
 extern void FileClose(File file);
 extern int	FilePrefetch(File file, off_t offset, int amount);
 extern int	FileRead(File file, char *buffer, int amount);
 extern int	FileWrite(File file, char *buffer, int amount);
+extern int	FileReadv(File file, const struct iovec *iov, int iovcnt);
+extern int	FileWritev(File file, const struct iovec *iov, int iovcnt);
 extern int	FileSync(File file);
 extern off_t FileSeek(File file, off_t offset, int whence);
 extern int	FileTruncate(File file, off_t offset);
@@ -107,6 +122,7 @@ extern void closeAllVfds(void);
 extern void SetTempTablespaces(Oid *tableSpaces, int numSpaces);
 extern bool TempTablespacesAreSet(void);
 extern Oid	GetNextTempTableSpace(void);
+extern int	GetTempTablespaces(Oid *tableSpaces, int numSpaces);
 extern void AtEOXact_Files(void);
 extern void AtEOSubXact_Files(bool isCommit, SubTransactionId mySubid,
 				  SubTransactionId parentSubid);
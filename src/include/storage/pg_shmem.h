@@ -41,8 +41,9 @@ typedef struct PGShmemHeader	/* standard header for all Postgres shmem */
 #endif
 } PGShmemHeader;
 
-/* GUC variable */
+/* GUC variables */
 extern int	huge_pages;
+extern int	shared_memory_numa;
 
 /* Possible values for huge_pages */
 typedef enum
@@ -52,12 +53,21 @@ typedef enum
 	HUGE_PAGES_TRY
 }	HugePagesType;
 
+/* Possible values for shared_memory_numa */
+typedef enum
+{
+	SHMEM_NUMA_OFF,
+	SHMEM_NUMA_INTERLEAVE,
+	SHMEM_NUMA_LOCAL
+}	ShmemNumaType;
+
 #ifndef WIN32
 extern unsigned long UsedShmemSegID;
 #else
 extern HANDLE UsedShmemSegID;
 #endif
 extern void *UsedShmemSegAddr;
+extern Size UsedShmemPageSize;
 
 #ifdef EXEC_BACKEND
 extern void PGSharedMemoryReAttach(void);
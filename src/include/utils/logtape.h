@@ -16,6 +16,8 @@
 #ifndef LOGTAPE_H
 #define LOGTAPE_H
 
+#include "storage/sharedfileset.h"
+
 /* LogicalTapeSet is an opaque type whose details are not known outside logtape.c. */
 
 typedef struct LogicalTapeSet LogicalTapeSet;
@@ -25,6 +27,8 @@ typedef struct LogicalTapeSet LogicalTapeSet;
  */
 
 extern LogicalTapeSet *LogicalTapeSetCreate(int ntapes);
+extern LogicalTapeSet *LogicalTapeSetCreateShared(int ntapes,
+						   SharedFileSet *fileset, const char *name);
 extern void LogicalTapeSetClose(LogicalTapeSet *lts);
 extern void LogicalTapeSetForgetFreeSpace(LogicalTapeSet *lts);
 extern size_t LogicalTapeRead(LogicalTapeSet *lts, int tapenum,
@@ -41,6 +45,10 @@ extern void LogicalTapeSeek(LogicalTapeSet *lts, int tapenum,
 				long blocknum, int offset);
 extern void LogicalTapeTell(LogicalTapeSet *lts, int tapenum,
 				long *blocknum, int *offset);
+extern long LogicalTapeExport(LogicalTapeSet *lts, int tapenum);
+extern void LogicalTapeImport(LogicalTapeSet *lts, int tapenum,
+				  SharedFileSet *fileset, const char *name,
+				  long firstBlockNumber);
 extern long LogicalTapeSetBlocks(LogicalTapeSet *lts);
 
 #endif   /* LOGTAPE_H */
@@ -23,6 +23,7 @@
 #include "access/itup.h"
 #include "executor/tuptable.h"
 #include "fmgr.h"
+#include "storage/dsm.h"
 #include "utils/relcache.h"
 
 
@@ -31,6 +32,13 @@
  */
 typedef struct Tuplesortstate Tuplesortstate;
 
+/*
+ * Sharedsort is the state, kept in a DSM segment, that lets several
+ * processes each sort part of the input and export the result as a sorted
+ * run, for one of them to import and merge.  It is also opaque.
+ */
+typedef struct Sharedsort Sharedsort;
+
 /*
  * We provide multiple interfaces to what is essentially the same code,
  * since different callers have different data to be sorted and want to
@@ -80,6 +88,8 @@ extern Tuplesortstate *tuplesort_begin_datum(Oid datumType,
 					  int workMem, bool randomAccess);
 
 extern void tuplesort_set_bound(Tuplesortstate *state, int64 bound);
+extern void tuplesort_set_export(Tuplesortstate *state, Sharedsort *shared,
+					 int run);
 
 extern void tuplesort_puttupleslot(Tuplesortstate *state,
 					   TupleTableSlot *slot);
@@ -91,6 +101,9 @@ extern void tuplesort_putdatum(Tuplesortstate *state, Datum val,
 				   bool isNull);
 
 extern void tuplesort_performsort(Tuplesortstate *state);
+extern void tuplesort_export_run(Tuplesortstate *state);
+extern void tuplesort_import_runs(Tuplesortstate *state, Sharedsort *shared,
+					  int nruns);
 
 extern bool tuplesort_gettupleslot(Tuplesortstate *state, bool forward,
 					   TupleTableSlot *slot, Datum *abbrev);
@@ -111,6 +124,17 @@ extern void tuplesort_get_stats(Tuplesortstate *state,
 
 extern int	tuplesort_merge_order(int64 allowedMem);
 
+/*
+ * Routines for setting up the shared state of a sort that is split across
+ * processes.  The process that creates the DSM segment initializes it; the
+ * others attach to it.
+ */
+
+extern Size tuplesort_estimate_shared(int nruns);
+extern void tuplesort_initialize_shared(Sharedsort *shared, int nruns,
+							dsm_segment *seg);
+extern void tuplesort_attach_shared(Sharedsort *shared, dsm_segment *seg);
+
 /*
  * These routines may only be called if randomAccess was specified 'true'.
  * Likewise, backwards scan in gettuple/getdatum is only allowed if
@@ -0,0 +1,75 @@
+# Test WAL replay with parallel redo workers, on a standby and in crash
+# recovery.
+use strict;
+use warnings;
+
+use PostgresNode;
+use TestLib;
+use Test::More tests => 4;
+
+my $node_master = get_new_node('master');
+$node_master->init(allows_streaming => 1);
+$node_master->append_conf('postgresql.conf', qq{
+max_parallel_redo_workers = 2
+autovacuum = off
+});
+$node_master->start;
+
+$node_master->backup('master_backup');
+my $node_standby = get_new_node('standby');
+$node_standby->init_from_backup($node_master, 'master_backup',
+	has_streaming => 1);
+$node_standby->start;
+
+# Generate a mix of records that are handed off to the workers (heap
+# inserts, updates and deletes, btree leaf inserts) and barriers (page
+# splits, commits, truncation).
+$node_master->safe_psql('postgres', qq{
+create table tab_int (a int primary key, b int);
+insert into tab_int select g, 0 from generate_series(1, 20000) g;
+update tab_int set b = b + 1 where a % 3 = 0;
+delete from tab_int where a % 7 = 0;
+create table tab_trunc (a int);
+insert into tab_trunc select generate_series(1, 1000);
+begin;
+insert into tab_trunc select generate_series(1, 1000);
+truncate tab_trunc;
+insert into tab_trunc select generate_series(1, 10);
+commit;
+});
+
+my $expected = $node_master->safe_psql('postgres',
+	"select count(*), sum(a), sum(b) from tab_int");
+
+$node_master->wait_for_catchup($node_standby, 'replay',
+	$node_master->lsn('insert'));
+
+my $result = $node_standby->safe_psql('postgres',
+	"select count(*), sum(a), sum(b) from tab_int");
+is($result, $expected, 'heap contents match on standby');
+
+$result = $node_standby->safe_psql('postgres', qq{
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+select count(*), sum(a), sum(b) from tab_int where a > 0;
+});
+is($result, $expected, 'index contents match on standby');
+
+$result = $node_standby->safe_psql('postgres',
+	"select count(*) from tab_trunc");
+is($result, '10', 'truncation replayed on standby');
+
+# Now crash the master and let it replay the same WAL again.
+$node_master->safe_psql('postgres',
+	"update tab_int set b = b + 1 where a % 5 = 0");
+$expected = $node_master->safe_psql('postgres',
+	"select count(*), sum(a), sum(b) from tab_int");
+$node_master->stop('immediate');
+$node_master->start;
+
+$result = $node_master->safe_psql('postgres', qq{
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+select count(*), sum(a), sum(b) from tab_int where a > 0;
+});
+is($result, $expected, 'contents match after crash recovery');
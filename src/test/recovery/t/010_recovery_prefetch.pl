@@ -0,0 +1,91 @@
+# Test WAL replay with prefetching of referenced blocks.
+use strict;
+use warnings;
+
+use PostgresNode;
+use TestLib;
+use Test::More tests => 5;
+
+my $node_master = get_new_node('master');
+$node_master->init(has_archiving => 1, allows_streaming => 1);
+$node_master->start;
+
+$node_master->backup('master_backup');
+my $node_standby = get_new_node('standby');
+$node_standby->init_from_backup($node_master, 'master_backup',
+	has_streaming => 1);
+$node_standby->append_conf('postgresql.conf', qq{
+recovery_prefetch_distance = 256kB
+});
+$node_standby->start;
+
+# Dirty enough pages that not all of them are still in the standby's
+# buffers when later records refer to them.
+$node_master->safe_psql('postgres', qq{
+create table tab_int (a int primary key, b int);
+insert into tab_int select g, 0 from generate_series(1, 20000) g;
+checkpoint;
+update tab_int set b = b + 1 where a % 3 = 0;
+delete from tab_int where a % 7 = 0;
+create table tab_drop (a int);
+insert into tab_drop select generate_series(1, 1000);
+drop table tab_drop;
+});
+
+my $expected = $node_master->safe_psql('postgres',
+	"select count(*), sum(a), sum(b) from tab_int");
+
+$node_master->wait_for_catchup($node_standby, 'replay',
+	$node_master->lsn('insert'));
+
+my $result = $node_standby->safe_psql('postgres',
+	"select count(*), sum(a), sum(b) from tab_int");
+is($result, $expected, 'contents match on standby');
+
+$result = $node_standby->safe_psql('postgres',
+	"select count(*) from pg_stat_recovery_prefetch");
+is($result, '1', 'pg_stat_recovery_prefetch has one row');
+
+# Prefetching can be switched off without a restart.
+$node_standby->append_conf('postgresql.conf', qq{
+recovery_prefetch_distance = 0
+});
+$node_standby->reload;
+$node_master->safe_psql('postgres',
+	"update tab_int set b = b + 1 where a % 5 = 0");
+$expected = $node_master->safe_psql('postgres',
+	"select count(*), sum(a), sum(b) from tab_int");
+$node_master->wait_for_catchup($node_standby, 'replay',
+	$node_master->lsn('insert'));
+$result = $node_standby->safe_psql('postgres',
+	"select count(*), sum(a), sum(b) from tab_int");
+is($result, $expected, 'contents match after disabling prefetch');
+
+# In archive recovery, the segment being replayed is restored as
+# RECOVERYXLOG, and the prefetcher must find it there.
+my $node_restore = get_new_node('restore');
+$node_restore->init_from_backup($node_master, 'master_backup',
+	has_restoring => 1);
+$node_restore->append_conf('postgresql.conf', qq{
+recovery_prefetch_distance = 256kB
+wal_retrieve_retry_interval = '100ms'
+});
+$node_restore->start;
+
+my $current_lsn = $node_master->safe_psql('postgres',
+	"select pg_current_xlog_location()");
+$expected = $node_master->safe_psql('postgres',
+	"select count(*), sum(a), sum(b) from tab_int");
+$node_master->safe_psql('postgres', "select pg_switch_xlog()");
+
+$node_restore->poll_query_until('postgres',
+	"select '$current_lsn'::pg_lsn <= pg_last_xlog_replay_location()")
+  or die "Timed out while waiting for restoring standby to catch up";
+
+$result = $node_restore->safe_psql('postgres',
+	"select count(*), sum(a), sum(b) from tab_int");
+is($result, $expected, 'contents match on standby restoring from archive');
+
+$result = $node_restore->safe_psql('postgres',
+	"select prefetch + hit + skip_fpw + skip_repeat > 0 from pg_stat_recovery_prefetch");
+is($result, 't', 'blocks in restored WAL were looked at');
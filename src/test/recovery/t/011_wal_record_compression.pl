@@ -0,0 +1,92 @@
+# Test replay of WAL records compressed with wal_record_compression, on a
+# standby and in crash recovery.
+use strict;
+use warnings;
+
+use PostgresNode;
+use TestLib;
+use Test::More tests => 5;
+
+my $node_master = get_new_node('master');
+$node_master->init(allows_streaming => 1);
+$node_master->append_conf('postgresql.conf', qq{
+autovacuum = off
+});
+$node_master->start;
+
+$node_master->backup('master_backup');
+my $node_standby = get_new_node('standby');
+$node_standby->init_from_backup($node_master, 'master_backup',
+	has_streaming => 1);
+$node_standby->start;
+
+# Insert the same rows into two new tables, without and with compression.
+# The pages are new, so the records carry no full-page images, and the
+# compressed ones should take less WAL.
+my $start_lsn = $node_master->lsn('insert');
+$node_master->safe_psql('postgres', qq{
+set wal_record_compression = off;
+create table tab_plain (a int, b text);
+insert into tab_plain select g, repeat('abcd', 40) || g
+  from generate_series(1, 5000) g;
+});
+my $mid_lsn = $node_master->lsn('insert');
+$node_master->safe_psql('postgres', qq{
+set wal_record_compression = on;
+create table tab_comp (a int, b text);
+insert into tab_comp select g, repeat('abcd', 40) || g
+  from generate_series(1, 5000) g;
+});
+my $end_lsn = $node_master->lsn('insert');
+
+my $result = $node_master->safe_psql('postgres',
+	"select pg_xlog_location_diff('$end_lsn', '$mid_lsn') < "
+	  . "pg_xlog_location_diff('$mid_lsn', '$start_lsn')");
+is($result, 't', 'compressed records take less WAL');
+
+# Now a mix of other compressed records: index inserts, updates, deletes.
+$node_master->safe_psql('postgres', qq{
+set wal_record_compression = on;
+create index tab_comp_a_idx on tab_comp (a);
+update tab_comp set b = b || 'x' where a % 3 = 0;
+delete from tab_comp where a % 7 = 0;
+insert into tab_comp select g, repeat('efgh', 40) || g
+  from generate_series(5001, 6000) g;
+});
+
+my $query = qq{
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+select count(*), sum(a), md5(string_agg(b, ',' order by a))
+  from tab_comp where a > 0;
+};
+my $expected = $node_master->safe_psql('postgres', $query);
+my $expected_plain = $node_master->safe_psql('postgres',
+	"select count(*), md5(string_agg(b, ',' order by a)) from tab_plain");
+
+$node_master->wait_for_catchup($node_standby, 'replay',
+	$node_master->lsn('insert'));
+
+$result = $node_standby->safe_psql('postgres',
+	"select count(*), md5(string_agg(b, ',' order by a)) from tab_plain");
+is($result, $expected_plain, 'uncompressed records replayed on standby');
+
+$result = $node_standby->safe_psql('postgres', $query);
+is($result, $expected, 'compressed records replayed on standby');
+
+# Crash the master and let it replay compressed WAL itself.
+$node_master->safe_psql('postgres', qq{
+set wal_record_compression = on;
+update tab_comp set b = b || 'y' where a % 5 = 0;
+});
+$expected = $node_master->safe_psql('postgres', $query);
+$node_master->stop('immediate');
+$node_master->start;
+
+$result = $node_master->safe_psql('postgres', $query);
+is($result, $expected, 'contents match after crash recovery');
+
+$node_master->wait_for_catchup($node_standby, 'replay',
+	$node_master->lsn('insert'));
+$result = $node_standby->safe_psql('postgres', $query);
+is($result, $expected, 'standby still matches after master crash');
@@ -0,0 +1,89 @@
+# Test reads and writes of runs of blocks with one I/O request: sequential
+# scans under the bulk-read strategy, and checkpoints followed by crash
+# recovery.
+use strict;
+use warnings;
+
+use PostgresNode;
+use TestLib;
+use Test::More tests => 6;
+
+# Keep shared_buffers small, so that the table is well over NBuffers / 4 and
+# sequential scans use the bulk-read strategy.
+my $node = get_new_node('master');
+$node->init;
+$node->append_conf('postgresql.conf', qq{
+shared_buffers = 1MB
+max_connections = 10
+autovacuum = off
+});
+$node->start;
+
+$node->safe_psql('postgres', qq{
+create table tab_io (a int, b text);
+insert into tab_io select g, repeat('x', 100) || g
+  from generate_series(1, 20000) g;
+create index tab_io_a_idx on tab_io (a);
+});
+
+my $relpages = $node->safe_psql('postgres',
+	"select pg_relation_size('tab_io') / current_setting('block_size')::int");
+my $nbuffers = $node->safe_psql('postgres',
+	"select setting from pg_settings where name = 'shared_buffers'");
+ok($relpages > $nbuffers, 'table is larger than shared_buffers');
+
+# A sequential scan reads the table in runs, an index scan block by block.
+my $seqscan = qq{
+set enable_indexscan = off;
+set enable_bitmapscan = off;
+select count(*), sum(a), md5(string_agg(b, ',' order by a)) from tab_io;
+};
+my $idxscan = qq{
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+select count(*), sum(a), md5(string_agg(b, ',' order by a))
+  from tab_io where a > 0;
+};
+
+my $expected = $node->safe_psql('postgres', $idxscan);
+my $result = $node->safe_psql('postgres', $seqscan);
+is($result, $expected, 'sequential scan with combined reads');
+
+$result = $node->safe_psql('postgres',
+	"set io_combine_limit = 1; $seqscan");
+is($result, $expected, 'sequential scan without combined reads');
+
+# Have the next checkpoint write most of the table, then crash and read it
+# back from disk.
+$node->safe_psql('postgres', qq{
+update tab_io set b = b || 'y' where a % 3 <> 0;
+checkpoint;
+});
+$expected = $node->safe_psql('postgres', $idxscan);
+$node->stop('immediate');
+$node->start;
+
+$result = $node->safe_psql('postgres', $seqscan);
+is($result, $expected, 'contents match after checkpoint and crash');
+
+# Pull scattered blocks into the pool first, so that the runs read by the
+# scan end early at blocks that are already cached.
+$node->restart;
+$node->safe_psql('postgres', qq{
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+select count(*) from tab_io
+  where a in (1000, 4000, 7000, 10000, 13000, 16000, 19000);
+});
+$result = $node->safe_psql('postgres', $seqscan);
+is($result, $expected, 'sequential scan over partly cached table');
+
+# Two bulk-read scans in the same query, each with its own ring.
+$node->safe_psql('postgres',
+	"create table tab_io_copy as select * from tab_io");
+$result = $node->safe_psql('postgres', qq{
+set enable_indexscan = off;
+set enable_bitmapscan = off;
+select count(*) from tab_io t1 join tab_io_copy t2 using (a, b);
+});
+is($result, '20000', 'join of two tables scanned with combined reads');
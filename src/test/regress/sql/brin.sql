@@ -421,3 +421,30 @@ UPDATE brintest SET textcol = '' WHERE textcol IS NOT NULL;
 SELECT brin_summarize_new_values('brintest'); -- error, not an index
 SELECT brin_summarize_new_values('tenk1_unique1'); -- error, not a BRIN index
 SELECT brin_summarize_new_values('brinidx'); -- ok, no change expected
+
+-- A change to a column covered only by a BRIN index doesn't prevent a HOT
+-- update, but the summary must still be updated
+CREATE TABLE brin_hot (id int PRIMARY KEY, val int);
+INSERT INTO brin_hot SELECT g, g FROM generate_series(1, 100) g;
+CREATE INDEX brin_hot_val_idx ON brin_hot USING brin (val);
+BEGIN;
+UPDATE brin_hot SET val = -val WHERE id <= 10;
+SELECT pg_stat_get_xact_tuples_hot_updated('brin_hot'::regclass);
+UPDATE brin_hot SET id = id + 1000 WHERE id = 50;  -- not HOT
+SELECT pg_stat_get_xact_tuples_hot_updated('brin_hot'::regclass);
+COMMIT;
+SET enable_seqscan = off;
+SELECT count(*) FROM brin_hot WHERE val < 0;
+RESET enable_seqscan;
+DROP TABLE brin_hot;
+
+-- VACUUM summarizes new page ranges even when it leaves the index entries of
+-- a few dead tuples for later
+CREATE TABLE brin_bypass (a int, b text) WITH (autovacuum_enabled = off);
+CREATE INDEX brin_bypass_a_idx ON brin_bypass USING brin (a)
+  WITH (pages_per_range = 1);
+INSERT INTO brin_bypass SELECT g, repeat('x', 500) FROM generate_series(1, 1500) g;
+DELETE FROM brin_bypass WHERE a = 1;
+VACUUM brin_bypass;
+SELECT brin_summarize_new_values('brin_bypass_a_idx'); -- nothing left to do
+DROP TABLE brin_bypass;
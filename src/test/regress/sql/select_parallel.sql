@@ -39,6 +39,65 @@ explain (costs off)
 	select  sum(parallel_restricted(unique1)) from tenk1
 	group by(parallel_restricted(unique1));
 
+-- test gather merge
+set enable_hashagg to off;
+
+explain (costs off)
+   select  string4, count((unique2)) from tenk1 group by string4 order by string4;
+
+select  string4, count((unique2)) from tenk1 group by string4 order by string4;
+
+reset enable_hashagg;
+
+-- test parallel bitmap heap scan
+set enable_seqscan to off;
+set enable_indexscan to off;
+
+explain (costs off)
+	select  count((unique1)) from tenk1 where hundred > 1;
+
+select  count((unique1)) from tenk1 where hundred > 1;
+
+reset enable_seqscan;
+reset enable_indexscan;
+
+-- test parallel hash join with a shared hash table
+set enable_mergejoin to off;
+set enable_nestloop to off;
+
+explain (costs off)
+	select  count(*) from tenk1 t1 join tenk1 t2 on t1.unique1 = t2.unique1;
+
+select  count(*) from tenk1 t1 join tenk1 t2 on t1.unique1 = t2.unique1;
+
+-- the inner side is underestimated and doesn't fit in work_mem, so the
+-- shared hash table overflows and the participants build private ones
+set work_mem = '64kB';
+
+explain (costs off)
+	select  count(*) from tenk1 t1 join tenk1 t2 on t1.unique1 = t2.unique1
+	where t2.unique1 % 1 = 0;
+
+select  count(*) from tenk1 t1 join tenk1 t2 on t1.unique1 = t2.unique1
+	where t2.unique1 % 1 = 0;
+
+reset work_mem;
+reset enable_mergejoin;
+reset enable_nestloop;
+
+-- test parallel btree index build
+set max_parallel_maintenance_workers = 4;
+create index tenk1_parallel_idx on tenk1 (hundred, unique2);
+set enable_seqscan to off;
+set enable_bitmapscan to off;
+
+select  count(*), sum(unique2) from tenk1 where hundred = 42;
+
+reset enable_seqscan;
+reset enable_bitmapscan;
+drop index tenk1_parallel_idx;
+reset max_parallel_maintenance_workers;
+
 set force_parallel_mode=1;
 
 explain (costs off)
@@ -48,3 +107,38 @@ explain (costs off)
 select stringu1::int2 from tenk1 where unique1 = 1;
 
 rollback;
+
+-- test parallel btree builds of expression and partial indexes, and the
+-- serial fallback, checking each index through an index or index-only scan
+create table parallel_build (a int, b int);
+insert into parallel_build select i, i % 100 from generate_series(1, 20000) i;
+alter table parallel_build set (parallel_workers = 2);
+vacuum analyze parallel_build;
+set max_parallel_maintenance_workers = 2;
+set max_parallel_workers_per_gather = 0;
+set enable_seqscan to off;
+set enable_bitmapscan to off;
+
+create index parallel_build_expr on parallel_build ((a % 1000), b);
+explain (costs off)
+  select count(*), sum(b) from parallel_build where a % 1000 = 42;
+select count(*), sum(b) from parallel_build where a % 1000 = 42;
+drop index parallel_build_expr;
+
+create index parallel_build_part on parallel_build (a) where b = 7;
+explain (costs off)
+  select count(*), sum(a) from parallel_build where b = 7 and a < 1000;
+select count(*), sum(a) from parallel_build where b = 7 and a < 1000;
+drop index parallel_build_part;
+
+set max_parallel_maintenance_workers = 0;
+create index parallel_build_serial on parallel_build ((a % 1000), b);
+explain (costs off)
+  select count(*), sum(b) from parallel_build where a % 1000 = 42;
+select count(*), sum(b) from parallel_build where a % 1000 = 42;
+
+reset enable_seqscan;
+reset enable_bitmapscan;
+reset max_parallel_workers_per_gather;
+reset max_parallel_maintenance_workers;
+drop table parallel_build;
@@ -32,6 +32,23 @@ select count(*) = 0 as ok from pg_prepared_statements;
 -- See also prepared_xacts.sql
 select count(*) >= 0 as ok from pg_prepared_xacts;
 
+-- There is always at least one buffer pool partition, and together they
+-- hold all the buffers
+select count(*) >= 1 as ok,
+       sum(buffers) = (select setting::int8 from pg_settings
+                       where name = 'shared_buffers') as ok2
+  from pg_shmem_numa;
+
+select count(*) = 1 as ok from pg_stat_buffer_replacement;
+
+select count(*) = 1 as ok from pg_stat_recovery_prefetch;
+
+-- The checkpoint fsync percentiles are null until there have been fsyncs
+select coalesce(checkpoint_sync_p50 <= checkpoint_sync_p99 and
+                checkpoint_sync_p99 <= checkpoint_sync_max, true) as ok
+  from pg_stat_bgwriter;
+select pg_stat_get_checkpoint_sync_percentile(2);
+
 -- This is to record the prevailing planner enable_foo settings during
 -- a regression test run.
 select name, setting from pg_settings where name like 'enable%';
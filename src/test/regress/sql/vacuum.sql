@@ -64,3 +64,27 @@ VACUUM (DISABLE_PAGE_SKIPPING) vaccluster;
 
 DROP TABLE vaccluster;
 DROP TABLE vactst;
+
+-- PARALLEL option
+CREATE TABLE vacparallel (a INT, b INT);
+CREATE INDEX vacparallel_a ON vacparallel (a);
+CREATE INDEX vacparallel_b ON vacparallel (b);
+CREATE INDEX vacparallel_ab ON vacparallel (a, b);
+INSERT INTO vacparallel SELECT i, i % 10 FROM generate_series(1, 1000) i;
+DELETE FROM vacparallel WHERE a % 3 = 0;
+VACUUM (PARALLEL 2) vacparallel;
+VACUUM (PARALLEL 0, ANALYZE) vacparallel;
+SET enable_seqscan = off;
+SELECT count(*) FROM vacparallel WHERE b = 1;
+RESET enable_seqscan;
+VACUUM (PARALLEL 2, FULL) vacparallel;
+DROP TABLE vacparallel;
+-- index cleanup, whichever process does it, updates the indexes' stats
+CREATE TABLE vacparallel_v (a INT, b INT);
+CREATE INDEX vacparallel_v_a ON vacparallel_v (a);
+CREATE INDEX vacparallel_v_b ON vacparallel_v (b);
+INSERT INTO vacparallel_v SELECT i, i % 10 FROM generate_series(1, 100) i;
+VACUUM (PARALLEL 1) vacparallel_v;
+SELECT relname, reltuples FROM pg_class
+  WHERE relname LIKE 'vacparallel_v%' ORDER BY relname;
+DROP TABLE vacparallel_v;
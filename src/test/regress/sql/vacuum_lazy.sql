@@ -0,0 +1,30 @@
+--
+-- Lazy VACUUM's treatment of the heap
+--
+-- These need dead tuples to be removable, and pages to become all-visible,
+-- so this must not run concurrently with other tests.
+--
+
+-- Index vacuuming is bypassed when few pages have dead tuples
+CREATE TABLE vacbypass (a INT, b TEXT) WITH (autovacuum_enabled = off);
+INSERT INTO vacbypass SELECT i, repeat('x', 500) FROM generate_series(1, 1500) i;
+CREATE INDEX vacbypass_a_idx ON vacbypass (a);
+DELETE FROM vacbypass WHERE a <= 10;
+\set VERBOSITY terse
+VACUUM (VERBOSE) vacbypass;
+\set VERBOSITY default
+-- the heap tuples are gone, but the index still has their entries
+SELECT relpages, reltuples FROM pg_class WHERE relname = 'vacbypass';
+SELECT reltuples FROM pg_class WHERE relname = 'vacbypass_a_idx';
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*) FROM vacbypass WHERE a <= 20;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+-- the next VACUUM that vacuums the indexes removes them too
+DELETE FROM vacbypass WHERE a BETWEEN 16 AND 20 OR a > 1490;
+VACUUM (DISABLE_PAGE_SKIPPING) vacbypass;
+SELECT relpages, reltuples FROM pg_class WHERE relname = 'vacbypass';
+SELECT reltuples FROM pg_class WHERE relname = 'vacbypass_a_idx';
+SELECT count(*) FROM vacbypass;
+DROP TABLE vacbypass;